@@ -0,0 +1,393 @@
+// BenchmarkContainers: KeyArray and the structures it is measured against
+// Author: Eli (Eliyahu) Shif
+
+#ifndef BENCHMARKCONTAINERS_HPP
+#define BENCHMARKCONTAINERS_HPP
+
+#include "KeyArray.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Every container below hands out int keys for inserted values and
+ *        offers the same small interface, so one benchmark body runs them all:
+ *            explicit C(size_t capacity);    // expected number of keys
+ *            int insert(const T&);  void remove(int key);
+ *            T& at(int key);  bool hasKey(int key) const;
+ *            bool contains(const T&) const;  size_t size() const;
+ *            template <Fn> void forEach(Fn&&) const;   // fn(value) per live key
+ *            void save(path) const;  void load(path);
+ *
+ *        The alternatives are written the way a user would write them by
+ *        hand, without tuning beyond what the standard containers give.
+ */
+
+
+// Trivially copyable value of `Bytes` bytes, compared word by word
+template <size_t Bytes>
+struct Payload {
+    static_assert(Bytes % sizeof(uint64_t) == 0, "Payload size must be a multiple of 8 bytes");
+
+    uint64_t words[Bytes / sizeof(uint64_t)];
+
+    explicit Payload(uint64_t seed = 0) {
+        for (uint64_t& word : words) word = seed;
+    }
+
+    bool operator==(const Payload& other) const {
+        for (size_t i = 0; i < Bytes / sizeof(uint64_t); ++i) {
+            if (words[i] != other.words[i]) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const Payload& other) const { return !(*this == other); }
+};
+
+
+/**
+ * @brief KeyArray itself, growing through the incremental resize.
+ */
+template <typename T>
+class KeyArrayContainer {
+public:
+    static constexpr const char* Name = "KeyArray";
+
+    explicit KeyArrayContainer(size_t capacity) : array(static_cast<int>(capacity)) {
+        array.enableDynamicResizing();
+    }
+
+    int insert(const T& value) { return array.insert(value); }
+    void remove(int key) { array.remove(key); }
+    T& at(int key) { return array.at(key); }
+    bool hasKey(int key) const { return array.hasKey(key); }
+    bool contains(const T& value) const { return array.contains(value); }
+    size_t size() const { return array.size(); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        array.forEachLive([&](int, const T& value) { fn(value); });
+    }
+
+    void save(const std::string& path) const { array.saveToFile(path); }
+    void load(const std::string& path) { array.loadFromFile(path); }
+
+private:
+    KeyArray<T> array;
+};
+
+
+/**
+ * @brief std::unordered_map<int, T> with keys recycled through a free list.
+ */
+template <typename T>
+class UnorderedMapContainer {
+public:
+    static constexpr const char* Name = "UnorderedMap";
+
+    explicit UnorderedMapContainer(size_t capacity) { values.reserve(capacity); }
+
+    int insert(const T& value) {
+        int key;
+        if (freeKeys.empty()) {
+            key = nextKey++;
+        } else {
+            key = freeKeys.back();
+            freeKeys.pop_back();
+        }
+        values.emplace(key, value);
+        return key;
+    }
+
+    void remove(int key) {
+        if (values.erase(key) == 0) throw std::out_of_range("Key not found.");
+        freeKeys.push_back(key);
+    }
+
+    T& at(int key) { return values.at(key); }
+    bool hasKey(int key) const { return values.count(key) != 0; }
+
+    bool contains(const T& value) const {
+        for (const auto& entry : values) {
+            if (entry.second == value) return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return values.size(); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& entry : values) fn(entry.second);
+    }
+
+    // Writes (key, value) pairs, then the free keys
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        writeCount(out, values.size());
+        for (const auto& entry : values) {
+            out.write(reinterpret_cast<const char*>(&entry.first), sizeof(int));
+            out.write(reinterpret_cast<const char*>(&entry.second), sizeof(T));
+        }
+        writeCount(out, freeKeys.size());
+        out.write(reinterpret_cast<const char*>(freeKeys.data()), freeKeys.size() * sizeof(int));
+        out.write(reinterpret_cast<const char*>(&nextKey), sizeof(int));
+        if (!out) throw std::runtime_error("Failed to write file: " + path);
+    }
+
+    void load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        values.clear();
+        size_t count = readCount(in);
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            int key;
+            T value;
+            in.read(reinterpret_cast<char*>(&key), sizeof(int));
+            in.read(reinterpret_cast<char*>(&value), sizeof(T));
+            values.emplace(key, value);
+        }
+        freeKeys.resize(readCount(in));
+        in.read(reinterpret_cast<char*>(freeKeys.data()), freeKeys.size() * sizeof(int));
+        in.read(reinterpret_cast<char*>(&nextKey), sizeof(int));
+        if (!in) throw std::runtime_error("Failed to read file: " + path);
+    }
+
+private:
+    static void writeCount(std::ofstream& out, size_t count) {
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+
+    static size_t readCount(std::ifstream& in) {
+        size_t count = 0;
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        return count;
+    }
+
+    std::unordered_map<int, T> values;
+    std::vector<int> freeKeys;
+    int nextKey = 0;
+};
+
+
+/**
+ * @brief std::vector of values with a live flag per slot and a stack of free
+ *        slots. Growth is std::vector's: one reallocation copying every slot.
+ */
+template <typename T>
+class FreeListVectorContainer {
+public:
+    static constexpr const char* Name = "FreeListVector";
+
+    explicit FreeListVectorContainer(size_t capacity) {
+        values.reserve(capacity);
+        live.reserve(capacity);
+    }
+
+    int insert(const T& value) {
+        if (freeKeys.empty()) {
+            values.push_back(value);
+            live.push_back(1);
+            ++count;
+            return static_cast<int>(values.size() - 1);
+        }
+        int key = freeKeys.back();
+        freeKeys.pop_back();
+        values[key] = value;
+        live[key] = 1;
+        ++count;
+        return key;
+    }
+
+    void remove(int key) {
+        if (!hasKey(key)) throw std::out_of_range("Key not found.");
+        live[key] = 0;
+        freeKeys.push_back(key);
+        --count;
+    }
+
+    T& at(int key) {
+        if (!hasKey(key)) throw std::out_of_range("Key not found.");
+        return values[key];
+    }
+
+    bool hasKey(int key) const {
+        return key >= 0 && static_cast<size_t>(key) < values.size() && live[key];
+    }
+
+    bool contains(const T& value) const {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (live[i] && values[i] == value) return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return count; }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (live[i]) fn(values[i]);
+        }
+    }
+
+    // Writes the three arrays as they are
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        size_t slots = values.size();
+        size_t freeCount = freeKeys.size();
+        out.write(reinterpret_cast<const char*>(&slots), sizeof(slots));
+        out.write(reinterpret_cast<const char*>(&freeCount), sizeof(freeCount));
+        out.write(reinterpret_cast<const char*>(values.data()), slots * sizeof(T));
+        out.write(reinterpret_cast<const char*>(live.data()), slots);
+        out.write(reinterpret_cast<const char*>(freeKeys.data()), freeCount * sizeof(int));
+        if (!out) throw std::runtime_error("Failed to write file: " + path);
+    }
+
+    void load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        size_t slots = 0;
+        size_t freeCount = 0;
+        in.read(reinterpret_cast<char*>(&slots), sizeof(slots));
+        in.read(reinterpret_cast<char*>(&freeCount), sizeof(freeCount));
+        values.resize(slots);
+        live.resize(slots);
+        freeKeys.resize(freeCount);
+        in.read(reinterpret_cast<char*>(values.data()), slots * sizeof(T));
+        in.read(reinterpret_cast<char*>(live.data()), slots);
+        in.read(reinterpret_cast<char*>(freeKeys.data()), freeCount * sizeof(int));
+        if (!in) throw std::runtime_error("Failed to read file: " + path);
+        count = slots - freeCount;
+    }
+
+private:
+    std::vector<T> values;
+    std::vector<unsigned char> live;
+    std::vector<int> freeKeys;
+    size_t count = 0;
+};
+
+
+/**
+ * @brief Slot map: values are kept dense (removal moves the last value into
+ *        the hole) and keys index a slot table pointing into the dense array.
+ *        Iteration touches live values only; every access is one indirection.
+ */
+template <typename T>
+class SlotMapContainer {
+public:
+    static constexpr const char* Name = "SlotMap";
+
+    explicit SlotMapContainer(size_t capacity) {
+        dense.reserve(capacity);
+        denseToKey.reserve(capacity);
+        keyToDense.reserve(capacity);
+    }
+
+    int insert(const T& value) {
+        int key;
+        if (freeKeys.empty()) {
+            key = static_cast<int>(keyToDense.size());
+            keyToDense.push_back(NoSlot);
+        } else {
+            key = freeKeys.back();
+            freeKeys.pop_back();
+        }
+        keyToDense[key] = static_cast<int>(dense.size());
+        dense.push_back(value);
+        denseToKey.push_back(key);
+        return key;
+    }
+
+    void remove(int key) {
+        if (!hasKey(key)) throw std::out_of_range("Key not found.");
+        int hole = keyToDense[key];
+        int last = static_cast<int>(dense.size() - 1);
+        if (hole != last) {
+            dense[hole] = std::move(dense[last]);
+            denseToKey[hole] = denseToKey[last];
+            keyToDense[denseToKey[hole]] = hole;
+        }
+        dense.pop_back();
+        denseToKey.pop_back();
+        keyToDense[key] = NoSlot;
+        freeKeys.push_back(key);
+    }
+
+    T& at(int key) {
+        if (!hasKey(key)) throw std::out_of_range("Key not found.");
+        return dense[keyToDense[key]];
+    }
+
+    bool hasKey(int key) const {
+        return key >= 0 && static_cast<size_t>(key) < keyToDense.size() && keyToDense[key] != NoSlot;
+    }
+
+    bool contains(const T& value) const {
+        for (const T& candidate : dense) {
+            if (candidate == value) return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return dense.size(); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const T& value : dense) fn(value);
+    }
+
+    // Writes the dense values with their keys, then the table size and free keys
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        size_t live = dense.size();
+        size_t slots = keyToDense.size();
+        size_t freeCount = freeKeys.size();
+        out.write(reinterpret_cast<const char*>(&live), sizeof(live));
+        out.write(reinterpret_cast<const char*>(&slots), sizeof(slots));
+        out.write(reinterpret_cast<const char*>(&freeCount), sizeof(freeCount));
+        out.write(reinterpret_cast<const char*>(dense.data()), live * sizeof(T));
+        out.write(reinterpret_cast<const char*>(denseToKey.data()), live * sizeof(int));
+        out.write(reinterpret_cast<const char*>(freeKeys.data()), freeCount * sizeof(int));
+        if (!out) throw std::runtime_error("Failed to write file: " + path);
+    }
+
+    // The slot table is rebuilt from the dense keys
+    void load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        size_t live = 0;
+        size_t slots = 0;
+        size_t freeCount = 0;
+        in.read(reinterpret_cast<char*>(&live), sizeof(live));
+        in.read(reinterpret_cast<char*>(&slots), sizeof(slots));
+        in.read(reinterpret_cast<char*>(&freeCount), sizeof(freeCount));
+        dense.resize(live);
+        denseToKey.resize(live);
+        freeKeys.resize(freeCount);
+        in.read(reinterpret_cast<char*>(dense.data()), live * sizeof(T));
+        in.read(reinterpret_cast<char*>(denseToKey.data()), live * sizeof(int));
+        in.read(reinterpret_cast<char*>(freeKeys.data()), freeCount * sizeof(int));
+        if (!in) throw std::runtime_error("Failed to read file: " + path);
+
+        keyToDense.assign(slots, NoSlot);
+        for (size_t i = 0; i < live; ++i) keyToDense[denseToKey[i]] = static_cast<int>(i);
+    }
+
+private:
+    // Marks a free key in the slot table
+    static constexpr int NoSlot = -1;
+
+    std::vector<T> dense;
+    std::vector<int> denseToKey;
+    std::vector<int> keyToDense;
+    std::vector<int> freeKeys;
+};
+
+
+#endif // BENCHMARKCONTAINERS_HPP
@@ -0,0 +1,325 @@
+// KeyArray Benchmarks
+// Author: Eli (Eliyahu) Shif
+// Description: Measures KeyArray against std::unordered_map, a std::vector
+// with a free list and a slot map, for several value sizes. Throughput comes
+// from Google Benchmark; the *Latency benchmarks also time every operation
+// and report its tail (p99 ... max) through LatencyHistogram.
+
+#include "BenchmarkContainers.hpp"
+#include "LatencyHistogram.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Fixed seed, so every container sees the same key sequence
+constexpr uint32_t Seed = 20250101;
+
+
+// 🔹 Helpers
+// ────────────────────────────────────────────────────────────────
+
+// Fills a container with `count` values and returns their keys
+template <typename Container, typename T>
+std::vector<int> fill(Container& container, size_t count) {
+    std::vector<int> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back(container.insert(T(i)));
+    }
+    return keys;
+}
+
+// Removes random keys until `percent` of them are left; returns the survivors
+// (the removed ones go to `removed` if given)
+std::vector<int> thin(std::vector<int> keys, size_t percent, std::mt19937& rng,
+                      std::vector<int>* removed = nullptr) {
+    std::shuffle(keys.begin(), keys.end(), rng);
+    size_t keep = keys.size() * percent / 100;
+    if (removed) removed->assign(keys.begin() + keep, keys.end());
+    keys.resize(keep);
+    return keys;
+}
+
+// Names a run as container/value size, e.g. "KeyArray/64"
+template <typename Container, typename T>
+std::string runName() {
+    return std::string(Container::Name) + "/" + std::to_string(sizeof(T));
+}
+
+// Returns a file path in the temporary directory for this container and value size
+template <typename Container, typename T>
+std::string scratchFile() {
+    std::string name = "keyarray_bench_" + std::string(Container::Name) + "_" + std::to_string(sizeof(T)) + ".bin";
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+
+// 🔹 Throughput
+// ────────────────────────────────────────────────────────────────
+
+// Half full; every iteration frees a random live key and inserts into a fresh one
+template <typename Container, typename T>
+void BM_Churn(benchmark::State& state) {
+    size_t capacity = static_cast<size_t>(state.range(0));
+    Container container(capacity);
+    std::mt19937 rng(Seed);
+    std::vector<int> live = fill<Container, T>(container, capacity / 2);
+
+    uint64_t next = live.size();
+    for (auto _ : state) {
+        size_t victim = rng() % live.size();
+        container.remove(live[victim]);
+        live[victim] = container.insert(T(next++));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+
+// Reads live keys in a shuffled order
+template <typename Container, typename T>
+void BM_AtRandom(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    Container container(count);
+    std::mt19937 rng(Seed);
+    std::vector<int> keys = fill<Container, T>(container, count);
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(container.at(keys[i]).words[0]);
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// Reads live keys in insertion order
+template <typename Container, typename T>
+void BM_AtSequential(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    Container container(count);
+    std::vector<int> keys = fill<Container, T>(container, count);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(container.at(keys[i]).words[0]);
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// Probes a mix of live and removed keys; range(1) is the percentage of misses
+template <typename Container, typename T>
+void BM_HasKey(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    size_t missPercent = static_cast<size_t>(state.range(1));
+    Container container(count);
+    std::mt19937 rng(Seed);
+
+    std::vector<int> removed;
+    std::vector<int> live = thin(fill<Container, T>(container, count), 50, rng, &removed);
+    for (int key : removed) container.remove(key);
+
+    std::vector<int> probes(4096);
+    for (int& probe : probes) {
+        const std::vector<int>& from = (rng() % 100 < missPercent) ? removed : live;
+        probe = from[rng() % from.size()];
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(container.hasKey(probes[i]));
+        i = (i + 1) & (probes.size() - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// Searches for a value that is not there, the worst case of the linear scan
+template <typename Container, typename T>
+void BM_Contains(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    Container container(count);
+    fill<Container, T>(container, count);
+    T absent(static_cast<uint64_t>(count) + 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(container.contains(absent));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+
+// Visits every live value; range(1) is the occupancy in percent
+template <typename Container, typename T>
+void BM_Iterate(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    size_t occupancy = static_cast<size_t>(state.range(1));
+    Container container(count);
+    std::mt19937 rng(Seed);
+
+    std::vector<int> removed;
+    thin(fill<Container, T>(container, count), occupancy, rng, &removed);
+    for (int key : removed) container.remove(key);
+
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        container.forEach([&](const T& value) { sum += value.words[0]; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * container.size());
+}
+
+
+// Writes the container to a file and reads it back into a fresh one
+template <typename Container, typename T>
+void BM_SaveLoad(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    Container container(count);
+    fill<Container, T>(container, count);
+    std::string path = scratchFile<Container, T>();
+
+    for (auto _ : state) {
+        container.save(path);
+        Container restored(count);
+        restored.load(path);
+        benchmark::DoNotOptimize(restored.size());
+    }
+    std::filesystem::remove(path);
+    state.SetBytesProcessed(state.iterations() * count * sizeof(T) * 2);
+}
+
+
+// 🔹 Latency
+// ────────────────────────────────────────────────────────────────
+
+// BM_Churn with every remove and insert timed on its own
+template <typename Container, typename T>
+void BM_ChurnLatency(benchmark::State& state) {
+    size_t capacity = static_cast<size_t>(state.range(0));
+    Container container(capacity);
+    std::mt19937 rng(Seed);
+    std::vector<int> live = fill<Container, T>(container, capacity / 2);
+    LatencyHistogram histogram;
+
+    uint64_t next = live.size();
+    for (auto _ : state) {
+        size_t victim = rng() % live.size();
+        histogram.measure([&] { container.remove(live[victim]); });
+        histogram.measure([&] { live[victim] = container.insert(T(next++)); });
+    }
+    histogram.report(state, runName<Container, T>());
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+
+// Grows from 16 keys to range(0), timing each insert: the maximum shows what
+// a single insert costs when the container has to grow
+template <typename Container, typename T>
+void BM_GrowthLatency(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    LatencyHistogram histogram;
+
+    for (auto _ : state) {
+        Container container(16);
+        for (size_t i = 0; i < count; ++i) {
+            histogram.measure([&] { benchmark::DoNotOptimize(container.insert(T(i))); });
+        }
+        benchmark::DoNotOptimize(container.size());
+    }
+    histogram.report(state, runName<Container, T>());
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+
+// Random reads of live keys, each timed
+template <typename Container, typename T>
+void BM_AtLatency(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    Container container(count);
+    std::mt19937 rng(Seed);
+    std::vector<int> keys = fill<Container, T>(container, count);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    LatencyHistogram histogram;
+
+    size_t i = 0;
+    for (auto _ : state) {
+        histogram.measure([&] { benchmark::DoNotOptimize(container.at(keys[i]).words[0]); });
+        if (++i == keys.size()) i = 0;
+    }
+    histogram.report(state, runName<Container, T>());
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// 🔹 Parallel Sweeps
+// ────────────────────────────────────────────────────────────────
+
+// Sums every live value of a half-empty KeyArray with parallelReduceLive;
+// range(1) is the thread count, each chunk running on a thread of its own
+void BM_ParallelReduce(benchmark::State& state) {
+    using T = Payload<8>;
+    size_t count = static_cast<size_t>(state.range(0));
+    KeyArray<T> array(static_cast<int>(count));
+    std::mt19937 rng(Seed);
+
+    std::vector<int> removed;
+    thin(fill<KeyArray<T>, T>(array, count), 50, rng, &removed);
+    for (int key : removed) array.remove(key);
+
+    KeyArrayScanPolicy policy;
+    policy.threads = static_cast<unsigned>(state.range(1));
+    array.setScanPolicy(policy);
+    auto executor = [](std::function<void()> task) { std::thread(std::move(task)).detach(); };
+
+    for (auto _ : state) {
+        uint64_t sum = array.parallelReduceLive(executor, uint64_t(0),
+                                                [](int, const T& value) { return value.words[0]; },
+                                                [](uint64_t a, uint64_t b) { return a + b; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * array.size());
+}
+
+} // namespace
+
+
+// 🔹 Registration
+// ────────────────────────────────────────────────────────────────
+
+// Registers a benchmark for every container and payload size; `args` is
+// applied to each registration (e.g. ->Arg(1 << 16))
+#define KEYARRAY_BENCH_FOR(T, bench, args)                                         \
+    BENCHMARK_TEMPLATE(bench, KeyArrayContainer<T>, T) args;                       \
+    BENCHMARK_TEMPLATE(bench, UnorderedMapContainer<T>, T) args;                   \
+    BENCHMARK_TEMPLATE(bench, FreeListVectorContainer<T>, T) args;                 \
+    BENCHMARK_TEMPLATE(bench, SlotMapContainer<T>, T) args
+
+#define KEYARRAY_BENCH(bench, args)                                                \
+    KEYARRAY_BENCH_FOR(Payload<8>, bench, args);                                   \
+    KEYARRAY_BENCH_FOR(Payload<64>, bench, args);                                  \
+    KEYARRAY_BENCH_FOR(Payload<256>, bench, args)
+
+KEYARRAY_BENCH(BM_Churn, ->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20));
+KEYARRAY_BENCH(BM_AtRandom, ->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20));
+KEYARRAY_BENCH(BM_AtSequential, ->Arg(1 << 16));
+KEYARRAY_BENCH(BM_HasKey, ->ArgsProduct({{1 << 16}, {0, 50, 90}}));
+KEYARRAY_BENCH(BM_Contains, ->Arg(1 << 16));
+KEYARRAY_BENCH(BM_Iterate, ->ArgsProduct({{1 << 16}, {10, 50, 90, 100}}));
+KEYARRAY_BENCH(BM_SaveLoad, ->Arg(1 << 16)->Unit(benchmark::kMicrosecond));
+KEYARRAY_BENCH(BM_ChurnLatency, ->Arg(1 << 16));
+KEYARRAY_BENCH(BM_GrowthLatency, ->Arg(1 << 20)->Unit(benchmark::kMillisecond)->Iterations(5));
+KEYARRAY_BENCH(BM_AtLatency, ->Arg(1 << 16));
+BENCHMARK(BM_ParallelReduce)->ArgsProduct({{1 << 22}, {1, 2, 4, 8}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+// LatencyHistogram: Per-operation latency recording for the benchmarks
+// Author: Eli (Eliyahu) Shif
+
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/**
+ * @brief LatencyHistogram counts operation latencies in log-linear buckets:
+ *        every power of two of nanoseconds is split into SubBuckets equal
+ *        parts, so any recorded latency is known to within 1/SubBuckets
+ *        (12.5%) from a few nanoseconds up to minutes, in fixed memory.
+ *        The exact maximum is kept on the side, because the worst single
+ *        operation is what an O(1) worst-case guarantee is about.
+ *
+ *        report() publishes p50, p99, p99.9, p99.99 and max (in ns) as
+ *        benchmark counters. With KEYARRAY_BENCH_HISTOGRAM set in the
+ *        environment the non-empty buckets are also printed to stderr.
+ */
+class LatencyHistogram {
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // Adds one operation that took `nanoseconds`
+    void record(uint64_t nanoseconds) {
+        ++buckets[bucketOf(nanoseconds)];
+        ++total;
+        if (nanoseconds > maximum) maximum = nanoseconds;
+    }
+
+    // Times fn() and records it
+    template <typename Fn>
+    void measure(Fn&& fn) {
+        Clock::time_point start = Clock::now();
+        fn();
+        Clock::time_point stop = Clock::now();
+        record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+    }
+
+    // Returns the upper bound of the bucket holding the q-th quantile
+    uint64_t quantile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BucketCount; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return upperBoundOf(b) < maximum ? upperBoundOf(b) : maximum;
+        }
+        return maximum;
+    }
+
+    uint64_t max() const { return maximum; }
+    uint64_t count() const { return total; }
+
+    // Publishes the tail of the distribution on the benchmark's report line;
+    // `title` heads the printed histogram
+    void report(benchmark::State& state, const std::string& title) const {
+        state.counters["p50_ns"] = static_cast<double>(quantile(0.50));
+        state.counters["p99_ns"] = static_cast<double>(quantile(0.99));
+        state.counters["p99.9_ns"] = static_cast<double>(quantile(0.999));
+        state.counters["p99.99_ns"] = static_cast<double>(quantile(0.9999));
+        state.counters["max_ns"] = static_cast<double>(maximum);
+
+        if (std::getenv("KEYARRAY_BENCH_HISTOGRAM")) print(title);
+    }
+
+    // Prints one line per non-empty bucket: upper bound, count, cumulative share
+    void print(const std::string& title) const {
+        std::fprintf(stderr, "%s: %llu operations\n", title.c_str(), static_cast<unsigned long long>(total));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BucketCount; ++b) {
+            if (buckets[b] == 0) continue;
+            seen += buckets[b];
+            std::fprintf(stderr, "  <= %12llu ns  %12llu  %9.5f%%\n",
+                         static_cast<unsigned long long>(upperBoundOf(b)),
+                         static_cast<unsigned long long>(buckets[b]),
+                         100.0 * static_cast<double>(seen) / static_cast<double>(total));
+        }
+    }
+
+private:
+
+    static constexpr size_t SubBucketBits = 3;
+    static constexpr size_t SubBuckets = size_t(1) << SubBucketBits;
+    static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    // Values below SubBuckets get a bucket each; above, the top SubBucketBits
+    // bits after the leading one pick the sub-bucket of its power of two
+    static size_t bucketOf(uint64_t value) {
+        if (value < SubBuckets) return static_cast<size_t>(value);
+        unsigned magnitude = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        size_t shift = magnitude - SubBucketBits;
+        size_t sub = static_cast<size_t>(value >> shift) & (SubBuckets - 1);
+        return (shift + 1) * SubBuckets + sub;
+    }
+
+    // Largest value that falls into bucket b
+    static uint64_t upperBoundOf(size_t b) {
+        if (b < SubBuckets) return b;
+        size_t shift = b / SubBuckets - 1;
+        uint64_t sub = b % SubBuckets;
+        return (((SubBuckets + sub + 1) << shift) - 1);
+    }
+
+    std::array<uint64_t, BucketCount> buckets{};
+    uint64_t total = 0;
+    uint64_t maximum = 0;
+};
+
+
+#endif // LATENCYHISTOGRAM_HPP
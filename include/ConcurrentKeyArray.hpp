@@ -0,0 +1,725 @@
+// ConcurrentKeyArray: Thread-safe KeyArray with lock-free reads during growth
+// Author: Eli (Eliyahu) Shif
+
+#ifndef CONCURRENTKEYARRAY_HPP
+#define CONCURRENTKEYARRAY_HPP
+
+#include "ConcurrentKeyPool.hpp"
+#include "KeyArrayEpoch.hpp"
+#include "KeyMagazine.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief ConcurrentKeyArray offers the insert/remove/at API of KeyArray to
+ *        many threads at once, without a lock on any path.
+ *
+ *        Keys come from a ConcurrentKeyPool (atomic bump plus an ABA-safe
+ *        free list). Every slot carries an atomic state next to its value:
+ *        insert constructs the value and then publishes it with a release
+ *        store, so a reader that sees the slot live also sees the value.
+ *        remove claims the slot with a CAS first, so a key is destroyed and
+ *        recycled exactly once even if several threads remove it.
+ *
+ *        Slots live in fixed pages of PageSize that never move; a page
+ *        directory maps indices to pages. Growing (enableDynamicResizing or
+ *        reserve) appends pages, publishes a new directory with an atomic
+ *        swap and retires the old one to KeyArrayEpoch, which frees it once
+ *        every reader that entered before the swap has left. Readers never
+ *        wait for a resize: hasKey, at and try_get are an epoch guard, one
+ *        directory load and one acquire load of the slot state.
+ *
+ *        Since values never move, a reference returned by at() stays valid
+ *        until that key is removed; reading a value while another thread
+ *        removes the same key is a race the caller has to rule out.
+ *
+ *        Threads that insert and remove at high rates should go through a
+ *        ThreadCache (see threadCache()), which keeps a magazine of keys and
+ *        a local element count, so most operations touch no shared word.
+ *
+ *        clear() and the destructor require that no other thread uses the array.
+ */
+template <typename T>
+class ConcurrentKeyArray {
+public:
+
+    // Slots per page (a power of two)
+    static constexpr unsigned PageShift = 10;
+    static constexpr size_t PageSize = size_t(1) << PageShift;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Construction & Initialization
+    // ─────────────────────────────────────────────────────────────
+
+    // Constructs a ConcurrentKeyArray from 0 to limitKey - 1
+    explicit ConcurrentKeyArray(int limitKey = 100, const std::string& name = "");
+
+    // Constructs a ConcurrentKeyArray over [min(a, b), max(a, b)), as KeyArray(a, b) does
+    ConcurrentKeyArray(int a, int b, const std::string& name = "");
+
+    // Shared by many threads in place; never copied or moved
+    ConcurrentKeyArray(const ConcurrentKeyArray&) = delete;
+    ConcurrentKeyArray& operator=(const ConcurrentKeyArray&) = delete;
+
+    // Destroys all live elements
+    ~ConcurrentKeyArray();
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Core Functionality (thread-safe)
+    // ─────────────────────────────────────────────────────────────
+
+    // Inserts a value and returns the assigned key
+    int insert(const T& value);
+
+    // Moves a value in and returns the assigned key
+    int insert(T&& value);
+
+    // Constructs a value in place and returns the assigned key
+    template <typename... Args>
+    int emplace(Args&&... args);
+
+    // Removes a value by key
+    void remove(int key);
+
+    // Checks if a given key is currently in use
+    bool hasKey(int key) const;
+
+    // Access a value by key (modifiable)
+    T& at(int key);
+
+    // Access a value by key (read-only)
+    const T& at(int key) const;
+
+    // Access a live key without any check (undefined if the key is not live)
+    T& operator[](int key) noexcept;
+    const T& operator[](int key) const noexcept;
+
+    // Returns a pointer to the value, or nullptr if the key is not in use
+    T* try_get(int key) noexcept;
+    const T* try_get(int key) const noexcept;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Growth (thread-safe)
+    // ─────────────────────────────────────────────────────────────
+
+    // Lets insert double the capacity instead of failing when keys run out
+    void enableDynamicResizing();
+
+    // Makes insert fail again once keys run out
+    void disableDynamicResizing();
+
+    // Returns whether insert may grow the array
+    bool isDynamicResizingEnabled() const;
+
+    // Grows to at least `capacity` slots; readers and writers carry on meanwhile
+    void reserve(size_t capacity);
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 State
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the number of stored elements (a snapshot under concurrent use)
+    size_t size() const;
+
+    // Returns true if the structure holds no element (a snapshot)
+    bool empty() const;
+
+    // Returns the number of slots
+    size_t capacity() const;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Maintenance (not thread-safe)
+    // ─────────────────────────────────────────────────────────────
+
+    // Destroys all elements and makes every key available again
+    void clear();
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Properties
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the offset used for key indexing
+    int getOffset() const;
+
+    // Returns the highest usable key
+    int getMaxKeyBound() const;
+
+    // Returns the name of this instance
+    const std::string& getName() const;
+
+    // Prints the structure to the output stream (not thread-safe)
+    template <typename U>
+    friend std::ostream& operator<<(std::ostream& os, const ConcurrentKeyArray<U>& array);
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Per-Thread Caching
+    // ─────────────────────────────────────────────────────────────
+
+    class ThreadCache;
+
+    // Creates a per-thread front end that caches keys in a magazine
+    ThreadCache threadCache(const KeyMagazinePolicy& policy = {});
+
+private:
+
+    // States of a slot
+    enum SlotState : uint8_t { Empty = 0, Live = 1 };
+
+    // One slot: its state sits on the value's cache line
+    struct Slot {
+        std::atomic<uint8_t> state{ Empty };
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    // Page table published to readers; replaced (never modified) on growth
+    struct Directory {
+        size_t capacity;
+        std::unique_ptr<Slot*[]> pages;
+    };
+
+    // Maps an external key to a slot index (out-of-range keys wrap to huge values)
+    size_t slotOf(int key) const noexcept;
+
+    // Returns the slot at an index of the current directory, or nullptr if out of range
+    // (callers hold an epoch guard)
+    Slot* findSlot(size_t index) const noexcept;
+
+    // Returns the value held in a slot
+    static T& valueOf(Slot& slot) noexcept;
+
+    // Constructs a value into a popped slot and publishes it; returns the key.
+    // If the constructor throws, the caller still owns the slot index.
+    template <typename... Args>
+    int publish(int index, Args&&... args);
+
+    // Claims a live slot and destroys its value; throws std::out_of_range if not live
+    size_t retire(int key);
+
+    // Grows if no other thread did since capacity was `seen`; returns false
+    // if resizing is disabled or the key range is exhausted
+    bool growBeyond(size_t seen);
+
+    // Grows to at least `wanted` slots (growth mutex held)
+    bool growLocked(size_t wanted);
+
+    // Destroys every live value (single-threaded)
+    void destroyAll();
+
+    // Key offset (external key = slot index + offset)
+    int offset;
+
+    // Instance name
+    std::string name;
+
+    // Current page table (read under KeyArrayEpoch guards)
+    std::atomic<Directory*> directory;
+
+    // Number of slots in the current directory
+    std::atomic<size_t> slotCount;
+
+    // Owns every page; only touched with growMutex held or single-threaded
+    std::vector<std::unique_ptr<Slot[]>> pages;
+
+    // Serializes growth
+    std::mutex growMutex;
+
+    // Whether running out of keys grows the array
+    std::atomic<bool> resizingEnabled{ false };
+
+    // Hands out slot indices
+    ConcurrentKeyPool pool;
+
+    // Number of live elements, kept away from the pool's hot words
+    alignas(ConcurrentKeyPool::CacheLineSize) std::atomic<size_t> elementCount{ 0 };
+};
+
+
+/**
+ * @brief ThreadCache is one thread's front end to a ConcurrentKeyArray. Keys
+ *        come from and return to its KeyMagazine, and size changes are
+ *        published to the shared count once per batchSize operations, so the
+ *        common insert/remove touches only the slot itself.
+ *
+ *        Keys cached here cannot be used by other threads, so an array can
+ *        report itself full while caches still hold keys; flush() (or the
+ *        destructor) hands them back and publishes the count. A ThreadCache
+ *        must not outlive its array.
+ */
+template <typename T>
+class ConcurrentKeyArray<T>::ThreadCache {
+public:
+
+    // Returns cached keys and publishes the pending size change
+    ~ThreadCache();
+
+    // Moving hands the cached keys and the pending size change over
+    ThreadCache(ThreadCache&& other) noexcept;
+    ThreadCache(const ThreadCache&) = delete;
+    ThreadCache& operator=(const ThreadCache&) = delete;
+
+    // Inserts a value and returns the assigned key
+    int insert(const T& value);
+
+    // Moves a value in and returns the assigned key
+    int insert(T&& value);
+
+    // Constructs a value in place and returns the assigned key
+    template <typename... Args>
+    int emplace(Args&&... args);
+
+    // Removes a value by key (any live key, not only those inserted here)
+    void remove(int key);
+
+    // Returns every cached key and publishes the pending size change
+    void flush();
+
+    // Flushes if the thread did nothing since the previous call; returns true if it did
+    bool flushIfIdle();
+
+    // Returns the number of keys cached by this thread
+    size_t cached() const;
+
+private:
+
+    friend class ConcurrentKeyArray;
+
+    ThreadCache(ConcurrentKeyArray& array, const KeyMagazinePolicy& policy);
+
+    // Adds to the local size change, publishing it once it reaches a batch
+    void count(std::ptrdiff_t change);
+
+    // Array served by this cache
+    ConcurrentKeyArray* array;
+
+    // Local key stack
+    KeyMagazine magazine;
+
+    // Size change not yet added to the shared count
+    std::ptrdiff_t countDelta = 0;
+
+    // Publish the size change once it reaches this magnitude
+    std::ptrdiff_t countBatch;
+};
+
+
+// ===============================
+// ConcurrentKeyArray<T>: Implementations
+// ===============================
+
+// Constructs a ConcurrentKeyArray from 0 to limitKey - 1
+template <typename T>
+ConcurrentKeyArray<T>::ConcurrentKeyArray(int limitKey, const std::string& name)
+    : ConcurrentKeyArray(0, limitKey, name) {}
+
+// Constructs a ConcurrentKeyArray over [min(a, b), max(a, b)); the pool starts
+// without keys and is extended with the first pages, so a = b gives an empty array
+template <typename T>
+ConcurrentKeyArray<T>::ConcurrentKeyArray(int a, int b, const std::string& name)
+    : offset(std::min(a, b)), name(name), directory(new Directory{ 0, nullptr }), slotCount(0),
+      pool(0, ConcurrentKeyPool::NoKeys{}) {
+
+    std::lock_guard<std::mutex> lock(growMutex);
+    try {
+        growLocked(static_cast<size_t>(int64_t(std::max(a, b)) - std::min(a, b)));
+    } catch (...) {
+        delete directory.load(std::memory_order_relaxed);
+        throw;
+    }
+}
+
+// Retired directories only hold page pointers, so they may outlive the array
+template <typename T>
+ConcurrentKeyArray<T>::~ConcurrentKeyArray() {
+    destroyAll();
+    delete directory.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+int ConcurrentKeyArray<T>::insert(const T& value) {
+    return emplace(value);
+}
+
+template <typename T>
+int ConcurrentKeyArray<T>::insert(T&& value) {
+    return emplace(std::move(value));
+}
+
+// Throws std::runtime_error if no key is available and the array cannot
+// grow; if the constructor throws, the key returns to the pool.
+template <typename T>
+template <typename... Args>
+int ConcurrentKeyArray<T>::emplace(Args&&... args) {
+    int index;
+    for (size_t seen = capacity(); !pool.tryPop(index); seen = capacity()) {
+        if (!growBeyond(seen)) {
+            throw std::runtime_error("KeyPool is empty. No available keys.");
+        }
+    }
+
+    int key;
+    try {
+        key = publish(index, std::forward<Args>(args)...);
+    } catch (...) {
+        pool.push(index);
+        throw;
+    }
+    elementCount.fetch_add(1, std::memory_order_relaxed);
+    return key;
+}
+
+// Throws std::out_of_range if the key is not in use
+template <typename T>
+void ConcurrentKeyArray<T>::remove(int key) {
+    size_t index = retire(key);
+    elementCount.fetch_sub(1, std::memory_order_relaxed);
+    pool.push(static_cast<int>(index));
+}
+
+template <typename T>
+bool ConcurrentKeyArray<T>::hasKey(int key) const {
+    KeyArrayEpoch::Guard guard;
+    Slot* slot = findSlot(slotOf(key));
+    return slot && slot->state.load(std::memory_order_acquire) == Live;
+}
+
+// Throws std::out_of_range if the key is not in use
+template <typename T>
+T& ConcurrentKeyArray<T>::at(int key) {
+    T* value = try_get(key);
+    if (!value) {
+        throw std::out_of_range("Invalid key");
+    }
+    return *value;
+}
+
+template <typename T>
+const T& ConcurrentKeyArray<T>::at(int key) const {
+    const T* value = try_get(key);
+    if (!value) {
+        throw std::out_of_range("Invalid key");
+    }
+    return *value;
+}
+
+template <typename T>
+T& ConcurrentKeyArray<T>::operator[](int key) noexcept {
+    KeyArrayEpoch::Guard guard;
+    return valueOf(*findSlot(slotOf(key)));
+}
+
+template <typename T>
+const T& ConcurrentKeyArray<T>::operator[](int key) const noexcept {
+    KeyArrayEpoch::Guard guard;
+    return valueOf(*findSlot(slotOf(key)));
+}
+
+// The guard only protects the directory; the slot itself never moves, so
+// the pointer stays usable after the guard is gone
+template <typename T>
+T* ConcurrentKeyArray<T>::try_get(int key) noexcept {
+    KeyArrayEpoch::Guard guard;
+    Slot* slot = findSlot(slotOf(key));
+    return slot && slot->state.load(std::memory_order_acquire) == Live ? &valueOf(*slot) : nullptr;
+}
+
+template <typename T>
+const T* ConcurrentKeyArray<T>::try_get(int key) const noexcept {
+    KeyArrayEpoch::Guard guard;
+    Slot* slot = findSlot(slotOf(key));
+    return slot && slot->state.load(std::memory_order_acquire) == Live ? &valueOf(*slot) : nullptr;
+}
+
+template <typename T>
+void ConcurrentKeyArray<T>::enableDynamicResizing() {
+    resizingEnabled.store(true, std::memory_order_relaxed);
+}
+
+template <typename T>
+void ConcurrentKeyArray<T>::disableDynamicResizing() {
+    resizingEnabled.store(false, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool ConcurrentKeyArray<T>::isDynamicResizingEnabled() const {
+    return resizingEnabled.load(std::memory_order_relaxed);
+}
+
+// Throws std::length_error if the key range cannot hold `wanted` slots
+template <typename T>
+void ConcurrentKeyArray<T>::reserve(size_t wanted) {
+    std::lock_guard<std::mutex> lock(growMutex);
+    if (!growLocked(wanted)) {
+        throw std::length_error("ConcurrentKeyArray capacity exceeds the key range");
+    }
+}
+
+// Caches publish their changes independently, so the shared count can
+// briefly dip below zero (a remove published before its insert)
+template <typename T>
+size_t ConcurrentKeyArray<T>::size() const {
+    auto count = static_cast<std::ptrdiff_t>(elementCount.load(std::memory_order_relaxed));
+    return count < 0 ? 0 : static_cast<size_t>(count);
+}
+
+template <typename T>
+bool ConcurrentKeyArray<T>::empty() const {
+    return size() == 0;
+}
+
+template <typename T>
+size_t ConcurrentKeyArray<T>::capacity() const {
+    return slotCount.load(std::memory_order_acquire);
+}
+
+// Requires exclusive access, like the destructor
+template <typename T>
+void ConcurrentKeyArray<T>::clear() {
+    destroyAll();
+    elementCount.store(0, std::memory_order_relaxed);
+    pool.reset();
+}
+
+template <typename T>
+int ConcurrentKeyArray<T>::getOffset() const {
+    return offset;
+}
+
+template <typename T>
+int ConcurrentKeyArray<T>::getMaxKeyBound() const {
+    return offset + static_cast<int>(capacity()) - 1;
+}
+
+template <typename T>
+const std::string& ConcurrentKeyArray<T>::getName() const {
+    return name;
+}
+
+template <typename T>
+typename ConcurrentKeyArray<T>::ThreadCache ConcurrentKeyArray<T>::threadCache(const KeyMagazinePolicy& policy) {
+    return ThreadCache(*this, policy);
+}
+
+template <typename T>
+size_t ConcurrentKeyArray<T>::slotOf(int key) const noexcept {
+    return static_cast<size_t>(static_cast<int64_t>(key) - offset);
+}
+
+// High bits select the page, low bits the slot within it
+template <typename T>
+typename ConcurrentKeyArray<T>::Slot* ConcurrentKeyArray<T>::findSlot(size_t index) const noexcept {
+    const Directory* current = directory.load(std::memory_order_acquire);
+    return index < current->capacity ? &current->pages[index >> PageShift][index & (PageSize - 1)] : nullptr;
+}
+
+template <typename T>
+T& ConcurrentKeyArray<T>::valueOf(Slot& slot) noexcept {
+    return *std::launder(reinterpret_cast<T*>(slot.bytes));
+}
+
+// The release store orders the construction before any reader's acquire load.
+// A popped index is always covered by the directory: pool.extend() runs only
+// after the directory holding the new slots is published.
+template <typename T>
+template <typename... Args>
+int ConcurrentKeyArray<T>::publish(int index, Args&&... args) {
+    KeyArrayEpoch::Guard guard;
+    Slot& slot = *findSlot(static_cast<size_t>(index));
+    ::new (static_cast<void*>(slot.bytes)) T(std::forward<Args>(args)...);
+    slot.state.store(Live, std::memory_order_release);
+    return index + offset;
+}
+
+// Only the thread whose CAS takes the slot from Live destroys and recycles it
+template <typename T>
+size_t ConcurrentKeyArray<T>::retire(int key) {
+    KeyArrayEpoch::Guard guard;
+    size_t index = slotOf(key);
+    Slot* slot = findSlot(index);
+    uint8_t expected = Live;
+    if (!slot || !slot->state.compare_exchange_strong(expected, Empty, std::memory_order_acq_rel,
+                                                      std::memory_order_relaxed)) {
+        throw std::out_of_range("Key is not valid or not in use");
+    }
+
+    valueOf(*slot).~T();
+    return index;
+}
+
+// Threads that ran dry together grow once: the later ones see a capacity
+// above the one they saw and simply retry their pop
+template <typename T>
+bool ConcurrentKeyArray<T>::growBeyond(size_t seen) {
+    if (!resizingEnabled.load(std::memory_order_relaxed)) return false;
+
+    std::lock_guard<std::mutex> lock(growMutex);
+    size_t current = slotCount.load(std::memory_order_relaxed);
+    if (current > seen) return true;
+    return growLocked(std::max<size_t>(current * 2, 1));
+}
+
+// New pages are allocated first; then the new directory is published, then
+// the pool's range is raised, then the old directory is retired. Capacity is
+// capped so every key (index + offset) still fits in an int.
+template <typename T>
+bool ConcurrentKeyArray<T>::growLocked(size_t wanted) {
+    size_t limit = static_cast<size_t>(int64_t(std::numeric_limits<int>::max()) - offset) + 1;
+    size_t current = slotCount.load(std::memory_order_relaxed);
+    if (wanted <= current) return true;
+    if (current >= limit) return false;
+    wanted = std::min(wanted, limit);
+
+    size_t pageCount = (wanted + PageSize - 1) >> PageShift;
+    auto next = std::make_unique<Directory>(Directory{ wanted, std::make_unique<Slot*[]>(pageCount) });
+    pages.reserve(pageCount);
+    while (pages.size() < pageCount) {
+        pages.push_back(std::make_unique<Slot[]>(PageSize));
+    }
+    for (size_t page = 0; page < pageCount; ++page) {
+        next->pages[page] = pages[page].get();
+    }
+
+    Directory* old = directory.exchange(next.release(), std::memory_order_seq_cst);
+    slotCount.store(wanted, std::memory_order_release);
+    pool.extend(static_cast<int>(wanted - 1));
+    KeyArrayEpoch::retire(old);
+    return true;
+}
+
+// Slots past the bump mark were never used, so the scan stops there
+template <typename T>
+void ConcurrentKeyArray<T>::destroyAll() {
+    size_t used = static_cast<size_t>(pool.getCurrentValue());
+    for (size_t i = 0; i < used; ++i) {
+        Slot& slot = pages[i >> PageShift][i & (PageSize - 1)];
+        if (slot.state.load(std::memory_order_relaxed) == Live) {
+            valueOf(slot).~T();
+            slot.state.store(Empty, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+// ===============================
+// ConcurrentKeyArray<T>::ThreadCache: Implementations
+// ===============================
+
+template <typename T>
+ConcurrentKeyArray<T>::ThreadCache::ThreadCache(ConcurrentKeyArray& array, const KeyMagazinePolicy& policy)
+    : array(&array), magazine(array.pool, policy),
+      countBatch(static_cast<std::ptrdiff_t>(policy.batchSize)) {}
+
+template <typename T>
+ConcurrentKeyArray<T>::ThreadCache::ThreadCache(ThreadCache&& other) noexcept
+    : array(other.array), magazine(std::move(other.magazine)), countDelta(other.countDelta),
+      countBatch(other.countBatch) {
+    other.countDelta = 0;
+}
+
+// The magazine returns its keys when it is destroyed right after this
+template <typename T>
+ConcurrentKeyArray<T>::ThreadCache::~ThreadCache() {
+    if (countDelta != 0) {
+        array->elementCount.fetch_add(static_cast<size_t>(countDelta), std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+int ConcurrentKeyArray<T>::ThreadCache::insert(const T& value) {
+    return emplace(value);
+}
+
+template <typename T>
+int ConcurrentKeyArray<T>::ThreadCache::insert(T&& value) {
+    return emplace(std::move(value));
+}
+
+// Throws std::runtime_error if neither the magazine nor the pool has a key
+// and the array cannot grow
+template <typename T>
+template <typename... Args>
+int ConcurrentKeyArray<T>::ThreadCache::emplace(Args&&... args) {
+    int index;
+    for (size_t seen = array->capacity(); !magazine.tryPop(index); seen = array->capacity()) {
+        if (!array->growBeyond(seen)) {
+            throw std::runtime_error("KeyPool is empty. No available keys.");
+        }
+    }
+
+    int key;
+    try {
+        key = array->publish(index, std::forward<Args>(args)...);
+    } catch (...) {
+        magazine.push(index);
+        throw;
+    }
+    count(1);
+    return key;
+}
+
+// Throws std::out_of_range if the key is not in use
+template <typename T>
+void ConcurrentKeyArray<T>::ThreadCache::remove(int key) {
+    magazine.push(static_cast<int>(array->retire(key)));
+    count(-1);
+}
+
+template <typename T>
+void ConcurrentKeyArray<T>::ThreadCache::flush() {
+    magazine.flush();
+    array->elementCount.fetch_add(static_cast<size_t>(countDelta), std::memory_order_relaxed);
+    countDelta = 0;
+}
+
+template <typename T>
+bool ConcurrentKeyArray<T>::ThreadCache::flushIfIdle() {
+    if (!magazine.flushIfIdle()) return false;
+
+    array->elementCount.fetch_add(static_cast<size_t>(countDelta), std::memory_order_relaxed);
+    countDelta = 0;
+    return true;
+}
+
+template <typename T>
+size_t ConcurrentKeyArray<T>::ThreadCache::cached() const {
+    return magazine.cached();
+}
+
+// Unsigned wrap-around makes adding a negative change a subtraction
+template <typename T>
+void ConcurrentKeyArray<T>::ThreadCache::count(std::ptrdiff_t change) {
+    countDelta += change;
+    if (countDelta >= countBatch || countDelta <= -countBatch) {
+        array->elementCount.fetch_add(static_cast<size_t>(countDelta), std::memory_order_relaxed);
+        countDelta = 0;
+    }
+}
+
+
+// Prints the contents of the structure to the given output stream
+template <typename U>
+std::ostream& operator<<(std::ostream& os, const ConcurrentKeyArray<U>& array) {
+    os << "ConcurrentKeyArray (Size: " << array.size() << ") [";
+    size_t used = static_cast<size_t>(array.pool.getCurrentValue());
+    for (size_t i = 0; i < used; ++i) {
+        auto& slot = array.pages[i >> array.PageShift][i & (array.PageSize - 1)];
+        if (slot.state.load(std::memory_order_acquire) == array.Live) {
+            os << "(" << (static_cast<int>(i) + array.offset) << ": " << array.valueOf(slot) << ") ";
+        }
+    }
+    os << "]";
+    return os;
+}
+
+
+#endif // CONCURRENTKEYARRAY_HPP
@@ -0,0 +1,430 @@
+// ConcurrentKeyPool: Lock-free key pool for concurrent KeyArrays (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef CONCURRENTKEYPOOL_HPP
+#define CONCURRENTKEYPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief ConcurrentKeyPool hands out the keys of a fixed range to many
+ *        threads at once without a lock.
+ *
+ *        Never-used keys come from an atomic bump of nextKey. Recycled keys
+ *        go to a Treiber stack whose head packs the top key with a 32-bit
+ *        tag that changes on every successful pop and push, so a head that
+ *        was popped and pushed back in between (ABA) fails the CAS.
+ *
+ *        The links of the stack live in atomics owned by the pool rather
+ *        than in the free slots: a thread that lost a pop race may still
+ *        read the link of a key that has been handed out again. They are
+ *        kept in segments of doubling size that never move, so extend() can
+ *        raise the range while other threads pop and push.
+ *
+ *        The hot words (head, nextKey) sit on separate cache lines.
+ */
+class ConcurrentKeyPool {
+public:
+
+    // Size assumed for a cache line when separating contended words
+    static constexpr size_t CacheLineSize = 64;
+
+    // ──────────────────────────────────────────────
+    // 🔹 Constructors
+    // ──────────────────────────────────────────────
+
+    // Constructs a key pool with keys ranging from 0 to maxKey (inclusive)
+    explicit ConcurrentKeyPool(int maxKey = 99);
+
+    // Constructs a key pool with sorted range from min(value1, value2) to max(value1, value2)
+    ConcurrentKeyPool(int value1, int value2);
+
+    // Tag for a pool that starts without keys
+    struct NoKeys {};
+
+    // Constructs a pool whose range starts at minKey but holds no key until extend()
+    ConcurrentKeyPool(int minKey, NoKeys);
+
+    // Shared by many threads in place; never copied or moved
+    ConcurrentKeyPool(const ConcurrentKeyPool&) = delete;
+    ConcurrentKeyPool& operator=(const ConcurrentKeyPool&) = delete;
+
+    // Releases the link segments
+    ~ConcurrentKeyPool();
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Key Management (thread-safe)
+    // ──────────────────────────────────────────────
+
+    // Pops a recycled key, or the next never-used key; returns false if none is left
+    bool tryPop(int& key);
+
+    // Pops a key; throws std::out_of_range if none is left
+    int pop();
+
+    // Pushes a previously issued key back (keys outside the issued range are ignored)
+    void push(int value);
+
+    // Pops up to `count` keys into `out` with one CAS (or one bump); returns how many
+    size_t popBatch(int* out, size_t count);
+
+    // Pushes `count` previously issued keys back with one CAS
+    void pushBatch(const int* keys, size_t count);
+
+    // Returns true if no key is available (a snapshot; other threads may change it)
+    bool empty() const;
+
+    // Returns the number of keys available (a snapshot)
+    size_t available() const;
+
+    // Raises the maximum key while other threads keep popping and pushing
+    // (one extending thread at a time; never shrinks)
+    void extend(int newMaxKey);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Maintenance (not thread-safe)
+    // ──────────────────────────────────────────────
+
+    // Resets the pool to its full range, forgetting every recycled key
+    void reset();
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the current value for next available key
+    int getCurrentValue() const;
+
+    // Returns the maximum allowed key
+    int getMaxValue() const;
+
+    // Returns the lowest key of the range
+    int getMinValue() const;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Debug Output
+    // ──────────────────────────────────────────────
+
+    // Prints key pool metadata to stream
+    friend std::ostream& operator<<(std::ostream& os, const ConcurrentKeyPool& pool);
+
+
+private:
+
+    // Marks an empty stack (as the key part of the head)
+    static constexpr uint32_t NoKey = 0xFFFFFFFFu;
+
+    // Links in the first segment; segment s holds FirstSegment << s links
+    static constexpr size_t FirstSegment = 64;
+
+    // Enough segments for every int key
+    static constexpr unsigned SegmentCount = 32;
+
+    // Packs a key offset and a tag into one head word
+    static uint64_t pack(uint32_t slot, uint32_t tag);
+
+    // Returns the link of a key offset
+    std::atomic<uint32_t>& link(uint32_t slot) const;
+
+    // Allocates the segments that hold links up to key offset `last`
+    void allocateLinks(size_t last);
+
+    // Takes up to `count` never-used keys starting at `first`; returns how many
+    int bump(int count, int& first);
+
+    // Returns the index of the highest set bit
+    static unsigned highestBit(uint64_t word);
+
+    // Head of the recycled-key stack: tag in the high half, key - minKey in the low half
+    alignas(CacheLineSize) std::atomic<uint64_t> head;
+
+    // The next never-used key to assign
+    alignas(CacheLineSize) std::atomic<int> nextKey;
+
+    // The lowest key of the range
+    alignas(CacheLineSize) int minKey;
+
+    // The maximum key that can be assigned (raised by extend)
+    std::atomic<int> maxKey;
+
+    // Next link of every key in the stack, indexed by key - minKey
+    std::atomic<std::atomic<uint32_t>*> segments[SegmentCount] = {};
+};
+
+
+//
+// ░░ Implementation of ConcurrentKeyPool ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Constructors
+// ────────────────────────────────────────────────────────────────
+
+// Constructs a key pool from 0 to maxInclusive (default range)
+inline ConcurrentKeyPool::ConcurrentKeyPool(int maxInclusive)
+    : ConcurrentKeyPool(0, maxInclusive) {}
+
+
+// Constructs a key pool from min(value1, value2) to max(value1, value2)
+inline ConcurrentKeyPool::ConcurrentKeyPool(int value1, int value2) {
+    if (value1 > value2) std::swap(value1, value2);
+    minKey = value1;
+    maxKey.store(value2, std::memory_order_relaxed);
+    allocateLinks(static_cast<size_t>(value2 - value1));
+    reset();
+}
+
+
+// The maximum sits just below the range, so nothing can be bumped yet
+inline ConcurrentKeyPool::ConcurrentKeyPool(int minKey, NoKeys) {
+    this->minKey = minKey;
+    maxKey.store(minKey - 1, std::memory_order_relaxed);
+    reset();
+}
+
+
+inline ConcurrentKeyPool::~ConcurrentKeyPool() {
+    for (auto& segment : segments) {
+        delete[] segment.load(std::memory_order_relaxed);
+    }
+}
+
+
+// 🔹 Key Management
+// ────────────────────────────────────────────────────────────────
+
+// The stack is tried first so recycled keys stay hot
+inline bool ConcurrentKeyPool::tryPop(int& key) {
+    uint64_t top = head.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(top) != NoKey) {
+        uint32_t slot = static_cast<uint32_t>(top);
+        uint32_t next = link(slot).load(std::memory_order_relaxed);
+        if (head.compare_exchange_weak(top, pack(next, static_cast<uint32_t>(top >> 32) + 1),
+                                       std::memory_order_acquire, std::memory_order_acquire)) {
+            key = minKey + static_cast<int>(slot);
+            return true;
+        }
+    }
+    return bump(1, key) == 1;
+}
+
+
+// Retrieves the next available key from the pool
+inline int ConcurrentKeyPool::pop() {
+    int key;
+    if (!tryPop(key)) throw std::out_of_range("No more keys available");
+    return key;
+}
+
+
+// The release CAS publishes the link written just before it
+inline void ConcurrentKeyPool::push(int value) {
+    if (value < minKey || value >= nextKey.load(std::memory_order_relaxed)) return;
+
+    uint32_t slot = static_cast<uint32_t>(value - minKey);
+    uint64_t top = head.load(std::memory_order_relaxed);
+    do {
+        link(slot).store(static_cast<uint32_t>(top), std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(top, pack(slot, static_cast<uint32_t>(top >> 32) + 1),
+                                         std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+// Detaches a whole chain from the top of the stack: the chain is walked
+// first, then one tagged CAS moves the head past it (a concurrent change of
+// the head fails the CAS and the walk is retried). Whatever the stack cannot
+// supply is bumped from nextKey in one step.
+inline size_t ConcurrentKeyPool::popBatch(int* out, size_t count) {
+    size_t taken = 0;
+    uint64_t top = head.load(std::memory_order_acquire);
+    while (count > 0 && static_cast<uint32_t>(top) != NoKey) {
+        uint32_t slot = static_cast<uint32_t>(top);
+        taken = 0;
+        while (taken < count && slot != NoKey) {
+            out[taken++] = minKey + static_cast<int>(slot);
+            slot = link(slot).load(std::memory_order_relaxed);
+        }
+        if (head.compare_exchange_weak(top, pack(slot, static_cast<uint32_t>(top >> 32) + 1),
+                                       std::memory_order_acquire, std::memory_order_acquire)) {
+            break;
+        }
+        taken = 0;
+    }
+
+    size_t missing = std::min<size_t>(count - taken, static_cast<size_t>(std::numeric_limits<int>::max()));
+    int first;
+    int bumped = bump(static_cast<int>(missing), first);
+    for (int i = 0; i < bumped; ++i) {
+        out[taken++] = first + i;
+    }
+    return taken;
+}
+
+
+// Links the keys into a chain privately, then splices it onto the head
+inline void ConcurrentKeyPool::pushBatch(const int* keys, size_t count) {
+    int issued = nextKey.load(std::memory_order_relaxed);
+    uint32_t first = NoKey;
+    uint32_t last = NoKey;
+    for (size_t i = 0; i < count; ++i) {
+        if (keys[i] < minKey || keys[i] >= issued) continue;
+
+        uint32_t slot = static_cast<uint32_t>(keys[i] - minKey);
+        if (last == NoKey) {
+            first = slot;
+        } else {
+            link(last).store(slot, std::memory_order_relaxed);
+        }
+        last = slot;
+    }
+    if (first == NoKey) return;
+
+    uint64_t top = head.load(std::memory_order_relaxed);
+    do {
+        link(last).store(static_cast<uint32_t>(top), std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(top, pack(first, static_cast<uint32_t>(top >> 32) + 1),
+                                         std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+// Returns true if there are no keys available
+inline bool ConcurrentKeyPool::empty() const {
+    return static_cast<uint32_t>(head.load(std::memory_order_acquire)) == NoKey &&
+           nextKey.load(std::memory_order_relaxed) > maxKey.load(std::memory_order_acquire);
+}
+
+
+// Walks the stack, so this is O(recycled keys) and only exact when quiescent
+inline size_t ConcurrentKeyPool::available() const {
+    int max = maxKey.load(std::memory_order_acquire);
+    size_t count = static_cast<size_t>(std::max(0, max - nextKey.load(std::memory_order_relaxed) + 1));
+    size_t limit = static_cast<size_t>(max - minKey) + 1;
+    for (uint32_t slot = static_cast<uint32_t>(head.load(std::memory_order_acquire));
+         slot != NoKey && count < limit; slot = link(slot).load(std::memory_order_relaxed)) {
+        ++count;
+    }
+    return count;
+}
+
+
+// The links exist before the new maximum is published, so a thread that
+// bumps a new key (acquire on maxKey) can always link it
+inline void ConcurrentKeyPool::extend(int newMaxKey) {
+    if (newMaxKey <= maxKey.load(std::memory_order_relaxed)) return;
+
+    allocateLinks(static_cast<size_t>(newMaxKey - minKey));
+    maxKey.store(newMaxKey, std::memory_order_release);
+}
+
+
+// 🔹 Maintenance
+// ────────────────────────────────────────────────────────────────
+
+// Restores the initial state; no other thread may use the pool meanwhile
+inline void ConcurrentKeyPool::reset() {
+    head.store(pack(NoKey, 0), std::memory_order_relaxed);
+    nextKey.store(minKey, std::memory_order_relaxed);
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+// Returns the current value of the next key
+inline int ConcurrentKeyPool::getCurrentValue() const {
+    return nextKey.load(std::memory_order_relaxed);
+}
+
+
+// Returns the upper bound key value
+inline int ConcurrentKeyPool::getMaxValue() const {
+    return maxKey.load(std::memory_order_acquire);
+}
+
+
+// Returns the lower bound key value
+inline int ConcurrentKeyPool::getMinValue() const {
+    return minKey;
+}
+
+
+// The tag wraps after 2^32 operations on the head, which no stalled thread outlives in practice
+inline uint64_t ConcurrentKeyPool::pack(uint32_t slot, uint32_t tag) {
+    return (static_cast<uint64_t>(tag) << 32) | slot;
+}
+
+
+// 🔹 Internals
+// ────────────────────────────────────────────────────────────────
+
+// Segment s starts at key offset FirstSegment * (2^s - 1)
+inline std::atomic<uint32_t>& ConcurrentKeyPool::link(uint32_t slot) const {
+    unsigned segment = highestBit(slot / FirstSegment + 1);
+    size_t start = FirstSegment * ((size_t(1) << segment) - 1);
+    return segments[segment].load(std::memory_order_acquire)[slot - start];
+}
+
+
+// Existing segments are kept, so links already in use never move
+inline void ConcurrentKeyPool::allocateLinks(size_t last) {
+    unsigned lastSegment = highestBit(last / FirstSegment + 1);
+    for (unsigned segment = 0; segment <= lastSegment; ++segment) {
+        if (!segments[segment].load(std::memory_order_relaxed)) {
+            segments[segment].store(new std::atomic<uint32_t>[FirstSegment << segment],
+                                    std::memory_order_release);
+        }
+    }
+}
+
+
+// A CAS loop (not fetch_add) keeps nextKey from running past the range, so
+// keys added by extend() are never skipped
+inline int ConcurrentKeyPool::bump(int count, int& first) {
+    int max = maxKey.load(std::memory_order_acquire);
+    int value = nextKey.load(std::memory_order_relaxed);
+    int taken;
+    do {
+        taken = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(count, int64_t(max) - value + 1)));
+        if (taken == 0) return 0;
+    } while (!nextKey.compare_exchange_weak(value, value + taken, std::memory_order_relaxed));
+    first = value;
+    return taken;
+}
+
+
+inline unsigned ConcurrentKeyPool::highestBit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return 63u - static_cast<unsigned>(__builtin_clzll(word));
+#endif
+}
+
+
+// 🔹 Debug Output
+// ────────────────────────────────────────────────────────────────
+
+// Outputs key pool state to an output stream
+inline std::ostream& operator<<(std::ostream& os, const ConcurrentKeyPool& pool) {
+    os << "ConcurrentKeyPool: Current Value = " << pool.getCurrentValue()
+       << ", Max Value = " << pool.getMaxValue();
+    return os;
+}
+
+
+#endif // CONCURRENTKEYPOOL_HPP
@@ -0,0 +1,645 @@
+// DenseKeyArray: Sparse-set KeyArray with packed live values (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef DENSEKEYARRAY_HPP
+#define DENSEKEYARRAY_HPP
+
+#include "IntrusiveKeyPool.hpp"
+#include "KeyArrayScan.hpp"
+#include "KeyArraySpan.hpp"
+#include "KeyTraits.hpp"
+#include "OccupancyBitmap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief DenseKeyArray keeps the same keys and the same insert / remove /
+ *        at / hasKey API as KeyArray, but stores the live values packed at
+ *        the front of one array (a sparse set). A sparse table maps each
+ *        key to its position in that array, so at(key) is one extra load,
+ *        and remove() moves the last value into the hole.
+ *
+ *            DenseKeyArray<float> weights(1024);
+ *            int key = weights.insert(0.5f);
+ *            weights.at(key) *= 2;
+ *            for (float& w : weights.values()) w *= decay;   // no gaps
+ *
+ *        values() and keys() are parallel spans with no dead slots, so a
+ *        scan costs O(size) whatever the capacity, and contains() / count()
+ *        run the vectorized kernels of KeyArrayScan on every element.
+ *
+ *        Positions are not stable: remove() relocates the last value, and
+ *        insert() may reallocate the values. Keep keys, not references or
+ *        positions. T must be move-assignable. Free keys are linked through
+ *        their own sparse entries, so the key pool owns no memory.
+ */
+template <typename T, typename Order = LifoKeyOrder, typename Key = int>
+class DenseKeyArray {
+public:
+
+    using KeyType = Key;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Construction & Initialization
+    // ─────────────────────────────────────────────────────────────
+
+    // Constructs keys 0 to limitKey - 1
+    explicit DenseKeyArray(Key limitKey = 100, const std::string& name = "");
+
+    // Constructs keys from min(a, b) to max(a, b) - 1
+    DenseKeyArray(Key a, Key b, const std::string& name = "");
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Core Functionality
+    // ─────────────────────────────────────────────────────────────
+
+    // Appends a copy of a value to the dense array; returns the assigned key
+    Key insert(const T& value);
+
+    // Appends a moved value to the dense array; returns the assigned key
+    Key insert(T&& value);
+
+    // Constructs a value at the end of the dense array; returns the assigned key
+    template <typename... Args>
+    Key emplace(Args&&... args);
+
+    // Moves the last value into the removed one's position and recycles the key
+    void remove(Key key);
+
+    // Checks if a given key is currently in use
+    bool hasKey(Key key) const;
+
+    // Checks if any live value equals the given one (vectorized for arithmetic T)
+    bool contains(const T& value) const;
+
+    // Counts the live values equal to the given one (vectorized for arithmetic T)
+    size_t count(const T& value) const;
+
+    // Returns the value of a live key; throws std::out_of_range otherwise
+    T& at(Key key);
+    const T& at(Key key) const;
+
+    // Unchecked access to a live key (undefined for a dead key)
+    T& operator[](Key key) noexcept;
+    const T& operator[](Key key) const noexcept;
+
+    // Returns a pointer to the value of a live key, or nullptr
+    T* try_get(Key key) noexcept;
+    const T* try_get(Key key) const noexcept;
+
+    // Destroys every value and frees every key; the capacity is kept
+    void clear();
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Dense Access
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the live values, packed with no gaps (positions change on remove)
+    KeyArraySpan<T> values();
+    KeyArraySpan<const T> values() const;
+
+    // Returns the key of each value in values(), position for position
+    KeyArraySpan<const Key> keys() const;
+
+    // Returns the position of a live key in values(); throws std::out_of_range otherwise
+    size_t indexOf(Key key) const;
+
+    // Calls fn(key, value) for every live key, in dense order
+    template <typename Fn>
+    void forEachLive(Fn&& fn);
+    template <typename Fn>
+    void forEachLive(Fn&& fn) const;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Dynamic Resizing
+    // ─────────────────────────────────────────────────────────────
+
+    // Doubles the key space when the keys run out (only the sparse table grows)
+    void enableDynamicResizing();
+
+    // Throws once the keys run out
+    void disableDynamicResizing();
+
+    // Returns whether the key space grows on demand
+    bool isDynamicResizingEnabled() const;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Accessors
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the number of live keys
+    size_t size() const;
+
+    // Returns true if no key is live
+    bool empty() const;
+
+    // Returns the number of keys in the key space
+    size_t capacity() const;
+
+    // Returns the offset of the key space
+    Key getOffset() const;
+
+    // Returns the maximum usable key (inclusive upper bound)
+    Key getMaxKeyBound() const;
+
+    // Gets the name of this instance
+    std::string getName() const;
+
+    // Sets the name of this instance
+    void setName(const std::string& newName);
+
+    // Prints every live key with its value, in dense order
+    template <typename U, typename O, typename K>
+    friend std::ostream& operator<<(std::ostream& os, const DenseKeyArray<U, O, K>& array);
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Iteration
+    // ─────────────────────────────────────────────────────────────
+
+    // Iterator over live (key, value) pairs, walking the dense array
+    template <bool Const>
+    class DenseIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<Key, std::conditional_t<Const, const T&, T&>>;
+        using reference = value_type;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using owner_type = std::conditional_t<Const, const DenseKeyArray*, DenseKeyArray*>;
+
+        DenseIterator() = default;
+        DenseIterator(owner_type owner, size_t index) : owner(owner), index(index) {}
+
+        reference operator*() const { return { owner->denseKeys[index], owner->dense[index] }; }
+        DenseIterator& operator++() { ++index; return *this; }
+        DenseIterator operator++(int) { DenseIterator tmp = *this; ++*this; return tmp; }
+        bool operator==(const DenseIterator& other) const { return index == other.index; }
+        bool operator!=(const DenseIterator& other) const { return index != other.index; }
+
+    private:
+        owner_type owner = nullptr;
+        size_t index = 0;
+    };
+
+    // Begin iterator over live (key, value) pairs (modifiable)
+    DenseIterator<false> begin();
+
+    // End iterator (modifiable)
+    DenseIterator<false> end();
+
+    // Begin iterator over live (key, value) pairs (const)
+    DenseIterator<true> begin() const;
+
+    // End iterator (const)
+    DenseIterator<true> end() const;
+
+
+private:
+
+    using Pool = BasicIntrusiveKeyPool<Order, Key>;
+
+    // Free-list links for the key pool, stored in the sparse entries of free keys
+    struct Links {
+        std::vector<Key>* next;
+        Key nextFree(size_t index) const { return (*next)[index]; }
+        void setNextFree(size_t index, Key value) const { (*next)[index] = value; }
+    };
+
+    // Returns a pool over slots [0, capacity), empty for a capacity of 0
+    static Pool poolOf(size_t capacity);
+
+    // Converts an external key to a slot of the sparse table
+    size_t slotOf(Key key) const noexcept;
+
+    // Returns the dense position of a slot, or size() if the slot is not live.
+    // A free slot holds a free-list link instead of a position; the key check
+    // rejects it, since no live position can name a free key.
+    size_t positionOf(size_t slot) const noexcept;
+
+    // Returns the dense position of a live key; throws std::out_of_range otherwise
+    size_t livePosition(Key key) const;
+
+    // Pops a key, growing the sparse table if allowed
+    size_t acquireSlot();
+
+    // Inserts a value constructed from args, recycling the key if it throws
+    template <typename... Args>
+    Key insertValue(Args&&... args);
+
+    // Live values, packed at the front
+    std::vector<T> dense;
+
+    // Key of each dense value
+    std::vector<Key> denseKeys;
+
+    // Dense position of each live slot, free-list link of each free one
+    std::vector<Key> sparse;
+
+    // Key allocator over slots [0, capacity)
+    Pool pool;
+
+    // Logical key offset
+    Key offset;
+
+    // Optional human-readable identifier
+    std::string name;
+
+    // Whether the key space grows when the keys run out
+    bool resizingEnabled = false;
+};
+
+
+//
+// ░░ Implementation of DenseKeyArray ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Construction
+// ────────────────────────────────────────────────────────────────
+
+// Only the sparse table is sized to the key space; the dense arrays grow with use
+template <typename T, typename Order, typename Key>
+DenseKeyArray<T, Order, Key>::DenseKeyArray(Key limitKey, const std::string& name)
+    : sparse(static_cast<size_t>(std::max<Key>(0, limitKey))),
+      pool(poolOf(sparse.size())), offset(0), name(name) {}
+
+
+template <typename T, typename Order, typename Key>
+DenseKeyArray<T, Order, Key>::DenseKeyArray(Key a, Key b, const std::string& name)
+    : DenseKeyArray(static_cast<Key>(std::max(a, b) - std::min(a, b)), name) {
+    offset = std::min(a, b);
+}
+
+
+// 🔹 Core Functionality
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Order, typename Key>
+Key DenseKeyArray<T, Order, Key>::insert(const T& value) {
+    return insertValue(value);
+}
+
+
+template <typename T, typename Order, typename Key>
+Key DenseKeyArray<T, Order, Key>::insert(T&& value) {
+    return insertValue(std::move(value));
+}
+
+
+template <typename T, typename Order, typename Key>
+template <typename... Args>
+Key DenseKeyArray<T, Order, Key>::emplace(Args&&... args) {
+    return insertValue(std::forward<Args>(args)...);
+}
+
+
+// The key is appended first, so a throwing constructor only has to pop it
+template <typename T, typename Order, typename Key>
+template <typename... Args>
+Key DenseKeyArray<T, Order, Key>::insertValue(Args&&... args) {
+    size_t slot = acquireSlot();
+    Key key = static_cast<Key>(offset + static_cast<Key>(slot));
+    try {
+        denseKeys.push_back(key);
+        try {
+            dense.emplace_back(std::forward<Args>(args)...);
+        } catch (...) {
+            denseKeys.pop_back();
+            throw;
+        }
+    } catch (...) {
+        Links freeLinks{ &sparse };
+        pool.push(static_cast<Key>(slot), freeLinks);
+        throw;
+    }
+    sparse[slot] = static_cast<Key>(dense.size() - 1);
+    return key;
+}
+
+
+// Swap-with-last: one move fills the hole and the array stays packed
+template <typename T, typename Order, typename Key>
+void DenseKeyArray<T, Order, Key>::remove(Key key) {
+    size_t slot = slotOf(key);
+    size_t position = positionOf(slot);
+    if (position == dense.size()) {
+        throw std::out_of_range("Key is not valid or not in use");
+    }
+    size_t last = dense.size() - 1;
+    if (position != last) {
+        dense[position] = std::move(dense[last]);
+        denseKeys[position] = denseKeys[last];
+        sparse[slotOf(denseKeys[position])] = static_cast<Key>(position);
+    }
+    dense.pop_back();
+    denseKeys.pop_back();
+    Links freeLinks{ &sparse };
+    pool.push(static_cast<Key>(slot), freeLinks);
+}
+
+
+template <typename T, typename Order, typename Key>
+bool DenseKeyArray<T, Order, Key>::hasKey(Key key) const {
+    return positionOf(slotOf(key)) != dense.size();
+}
+
+
+// Whole 64-value runs go through the kernel; there is no mask to apply
+template <typename T, typename Order, typename Key>
+bool DenseKeyArray<T, Order, Key>::contains(const T& value) const {
+    for (size_t base = 0; base < dense.size(); base += OccupancyBitmap::WordBits) {
+        size_t run = std::min(OccupancyBitmap::WordBits, dense.size() - base);
+        if (KeyArrayScan::matchEqual(dense.data() + base, run, value) != 0) return true;
+    }
+    return false;
+}
+
+
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::count(const T& value) const {
+    size_t total = 0;
+    for (size_t base = 0; base < dense.size(); base += OccupancyBitmap::WordBits) {
+        size_t run = std::min(OccupancyBitmap::WordBits, dense.size() - base);
+        total += OccupancyBitmap::popCount(KeyArrayScan::matchEqual(dense.data() + base, run, value));
+    }
+    return total;
+}
+
+
+template <typename T, typename Order, typename Key>
+T& DenseKeyArray<T, Order, Key>::at(Key key) {
+    return dense[livePosition(key)];
+}
+
+
+template <typename T, typename Order, typename Key>
+const T& DenseKeyArray<T, Order, Key>::at(Key key) const {
+    return dense[livePosition(key)];
+}
+
+
+template <typename T, typename Order, typename Key>
+T& DenseKeyArray<T, Order, Key>::operator[](Key key) noexcept {
+    return dense[static_cast<size_t>(sparse[slotOf(key)])];
+}
+
+
+template <typename T, typename Order, typename Key>
+const T& DenseKeyArray<T, Order, Key>::operator[](Key key) const noexcept {
+    return dense[static_cast<size_t>(sparse[slotOf(key)])];
+}
+
+
+template <typename T, typename Order, typename Key>
+T* DenseKeyArray<T, Order, Key>::try_get(Key key) noexcept {
+    size_t position = positionOf(slotOf(key));
+    return position != dense.size() ? &dense[position] : nullptr;
+}
+
+
+template <typename T, typename Order, typename Key>
+const T* DenseKeyArray<T, Order, Key>::try_get(Key key) const noexcept {
+    size_t position = positionOf(slotOf(key));
+    return position != dense.size() ? &dense[position] : nullptr;
+}
+
+
+// Stale sparse entries need no reset: no position is below size() == 0
+template <typename T, typename Order, typename Key>
+void DenseKeyArray<T, Order, Key>::clear() {
+    dense.clear();
+    denseKeys.clear();
+    pool = poolOf(sparse.size());
+}
+
+
+// 🔹 Dense Access
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Order, typename Key>
+KeyArraySpan<T> DenseKeyArray<T, Order, Key>::values() {
+    return { dense.data(), dense.size() };
+}
+
+
+template <typename T, typename Order, typename Key>
+KeyArraySpan<const T> DenseKeyArray<T, Order, Key>::values() const {
+    return { dense.data(), dense.size() };
+}
+
+
+template <typename T, typename Order, typename Key>
+KeyArraySpan<const Key> DenseKeyArray<T, Order, Key>::keys() const {
+    return { denseKeys.data(), denseKeys.size() };
+}
+
+
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::indexOf(Key key) const {
+    return livePosition(key);
+}
+
+
+template <typename T, typename Order, typename Key>
+template <typename Fn>
+void DenseKeyArray<T, Order, Key>::forEachLive(Fn&& fn) {
+    for (size_t position = 0; position < dense.size(); ++position) {
+        fn(denseKeys[position], dense[position]);
+    }
+}
+
+
+template <typename T, typename Order, typename Key>
+template <typename Fn>
+void DenseKeyArray<T, Order, Key>::forEachLive(Fn&& fn) const {
+    for (size_t position = 0; position < dense.size(); ++position) {
+        fn(denseKeys[position], dense[position]);
+    }
+}
+
+
+// 🔹 Dynamic Resizing
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Order, typename Key>
+void DenseKeyArray<T, Order, Key>::enableDynamicResizing() {
+    resizingEnabled = true;
+}
+
+
+template <typename T, typename Order, typename Key>
+void DenseKeyArray<T, Order, Key>::disableDynamicResizing() {
+    resizingEnabled = false;
+}
+
+
+template <typename T, typename Order, typename Key>
+bool DenseKeyArray<T, Order, Key>::isDynamicResizingEnabled() const {
+    return resizingEnabled;
+}
+
+
+// Values never move on growth: only the sparse table is doubled. Positions are
+// stored as Key too, so the key space also stops at keysFrom(0)
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::acquireSlot() {
+    if (pool.empty()) {
+        if (!resizingEnabled) {
+            throw std::runtime_error("KeyPool is empty. No available keys.");
+        }
+        size_t capacity = sparse.size();
+        size_t limit = std::min(KeyTraits<Key>::keysFrom(offset), KeyTraits<Key>::keysFrom(0));
+        if (capacity >= limit) {
+            throw std::length_error("DenseKeyArray cannot grow beyond its key type");
+        }
+        size_t newCapacity = std::min(limit, std::max<size_t>(1, capacity * 2));
+        sparse.resize(newCapacity);
+        if (capacity == 0) {
+            pool = poolOf(newCapacity);
+        } else {
+            pool.extend(static_cast<Key>(newCapacity - 1));
+        }
+    }
+    Links freeLinks{ &sparse };
+    return static_cast<size_t>(pool.pop(freeLinks));
+}
+
+
+// 🔹 Keys
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Order, typename Key>
+typename DenseKeyArray<T, Order, Key>::Pool DenseKeyArray<T, Order, Key>::poolOf(size_t capacity) {
+    Pool fresh(0, 0);
+    if (capacity == 0) {
+        fresh.restore(0, 1, 0);
+    } else {
+        fresh.reset(0, static_cast<Key>(capacity - 1));
+    }
+    return fresh;
+}
+
+
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::slotOf(Key key) const noexcept {
+    return KeyTraits<Key>::slotOf(key, offset);
+}
+
+
+// NoKey links of signed types convert to huge positions and fail the bound
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::positionOf(size_t slot) const noexcept {
+    if (slot >= sparse.size()) return dense.size();
+    size_t position = static_cast<size_t>(sparse[slot]);
+    if (position >= dense.size() || slotOf(denseKeys[position]) != slot) return dense.size();
+    return position;
+}
+
+
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::livePosition(Key key) const {
+    size_t position = positionOf(slotOf(key));
+    if (position == dense.size()) {
+        throw std::out_of_range("Invalid key in DenseKeyArray");
+    }
+    return position;
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::size() const {
+    return dense.size();
+}
+
+
+template <typename T, typename Order, typename Key>
+bool DenseKeyArray<T, Order, Key>::empty() const {
+    return dense.empty();
+}
+
+
+template <typename T, typename Order, typename Key>
+size_t DenseKeyArray<T, Order, Key>::capacity() const {
+    return sparse.size();
+}
+
+
+template <typename T, typename Order, typename Key>
+Key DenseKeyArray<T, Order, Key>::getOffset() const {
+    return offset;
+}
+
+
+template <typename T, typename Order, typename Key>
+Key DenseKeyArray<T, Order, Key>::getMaxKeyBound() const {
+    return static_cast<Key>(offset + static_cast<Key>(sparse.size()) - 1);
+}
+
+
+template <typename T, typename Order, typename Key>
+std::string DenseKeyArray<T, Order, Key>::getName() const {
+    return name;
+}
+
+
+template <typename T, typename Order, typename Key>
+void DenseKeyArray<T, Order, Key>::setName(const std::string& newName) {
+    name = newName;
+}
+
+
+// 🔹 Iteration
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Order, typename Key>
+typename DenseKeyArray<T, Order, Key>::template DenseIterator<false> DenseKeyArray<T, Order, Key>::begin() {
+    return { this, 0 };
+}
+
+
+template <typename T, typename Order, typename Key>
+typename DenseKeyArray<T, Order, Key>::template DenseIterator<false> DenseKeyArray<T, Order, Key>::end() {
+    return { this, dense.size() };
+}
+
+
+template <typename T, typename Order, typename Key>
+typename DenseKeyArray<T, Order, Key>::template DenseIterator<true> DenseKeyArray<T, Order, Key>::begin() const {
+    return { this, 0 };
+}
+
+
+template <typename T, typename Order, typename Key>
+typename DenseKeyArray<T, Order, Key>::template DenseIterator<true> DenseKeyArray<T, Order, Key>::end() const {
+    return { this, dense.size() };
+}
+
+
+// Prints "(key: value)" per live key, in dense order
+template <typename T, typename Order, typename Key>
+std::ostream& operator<<(std::ostream& os, const DenseKeyArray<T, Order, Key>& array) {
+    os << "DenseKeyArray (Size: " << array.size() << ") [";
+    for (size_t position = 0; position < array.dense.size(); ++position) {
+        os << "(" << +array.denseKeys[position] << ": " << array.dense[position] << ") ";
+    }
+    os << "]";
+    return os;
+}
+
+
+#endif // DENSEKEYARRAY_HPP
@@ -0,0 +1,413 @@
+// IntrusiveKeyPool: Key pool threaded through free slot storage (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef INTRUSIVEKEYPOOL_HPP
+#define INTRUSIVEKEYPOOL_HPP
+
+#include "KeyOrder.hpp"
+#include "KeyTraits.hpp"
+#include "OccupancyBitmap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * @brief IntrusiveKeyPool hands out keys like KeyPool, but recycled keys are
+ *        kept in a singly linked free list stored inside the free slots
+ *        themselves (as in a slot map). It owns no memory of its own:
+ *        pop() and push() are O(1), never allocate, and only touch the slot
+ *        being recycled.
+ *
+ *        Which recycled key is reused next is the Order policy (KeyOrder.hpp):
+ *        LifoKeyOrder (the default, IntrusiveKeyPool), FifoKeyOrder for
+ *        delayed reuse, or LowestKeyOrder for dense key ranges (which keeps
+ *        a bitmap of its own instead of links).
+ *
+ *        Keys are of type Key (int by default, see KeyTraits.hpp); growth
+ *        past KeyTraits<Key>::MaxKey throws std::length_error.
+ *
+ *        Every call that follows or writes a link takes the slot storage
+ *        (`Links`) as an argument. Keys are used directly as slot indices, and
+ *        `Links` must provide:
+ *            Key  nextFree(size_t index) const;
+ *            void setNextFree(size_t index, Key next);
+ *
+ *        Use KeyPool when an external, self-contained pool is needed.
+ */
+template <typename Order = LifoKeyOrder, typename Key = int>
+class BasicIntrusiveKeyPool {
+public:
+
+    // ──────────────────────────────────────────────
+    // 🔹 Constructors
+    // ──────────────────────────────────────────────
+
+    // Constructs a key pool with keys ranging from 0 to maxKey (inclusive)
+    explicit BasicIntrusiveKeyPool(Key maxKey = 99);
+
+    // Constructs a key pool with sorted range from min(value1, value2) to max(value1, value2)
+    BasicIntrusiveKeyPool(Key value1, Key value2);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Key Management
+    // ──────────────────────────────────────────────
+
+    // Pops the next available key, preferring a recycled one (in Order)
+    template <typename Links>
+    Key pop(const Links& links);
+
+    // Pushes a previously issued key back, linking it through its own slot
+    template <typename Links>
+    void push(Key value, Links& links);
+
+    // Pushes saved recycled keys, listed in pop order, so they pop in that order again
+    template <typename It, typename Links>
+    void refill(It first, It last, Links& links);
+
+    // Reserves up to `count` never-used keys as one contiguous run starting at
+    // `first`; returns how many were reserved (the free list is not touched)
+    size_t reserveRun(size_t count, Key& first);
+
+    // Returns true if freed keys are waiting in the free list
+    bool hasRecycled() const;
+
+    // Returns the number of keys that can still be popped
+    size_t available() const;
+
+    // Checks if the pool is empty
+    bool empty() const;
+
+    // Doubles the maximum value (used for dynamic growth strategies), up to KeyTraits<Key>::MaxKey
+    void increaseMaxValue();
+
+    // Raises the maximum key, keeping every recycled key
+    void extend(Key newMaxKey);
+
+    // Resets the pool with a new key range, forgetting every recycled key
+    void reset(Key newStart = 0, Key newEnd = 99);
+
+    // Writes the free-list links held in `from` into the same slots of `to`
+    template <typename FromLinks, typename ToLinks>
+    void copyLinks(const FromLinks& from, ToLinks& to) const;
+
+    // Calls fn(key) for every recycled key, in pop order
+    template <typename Links, typename Fn>
+    void forEachFree(const Links& links, Fn&& fn) const;
+
+    // Restores a saved range with an empty free list (see push to refill it)
+    void restore(Key minKey, Key nextKey, Key maxKey);
+
+    // Closes the bump range at newMaxKey and links every key of [nextKey, newMaxKey]
+    // with isFree(key) into the free list instead (for ranges with live keys mixed in)
+    template <typename Links, typename IsFree>
+    void reclaim(Key newMaxKey, Links& links, IsFree&& isFree);
+
+    // Rebuilds the pool over [0, newMaxKey] from the live bits in one sweep of
+    // their words: keys past the highest live one become the bump range, and
+    // the free keys below it are linked so that they pop lowest first
+    template <typename Links>
+    void rebuild(const OccupancyBitmap& live, Key newMaxKey, Links& links);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the current value for next available key
+    Key getCurrentValue() const;
+
+    // Returns the maximum allowed key
+    Key getMaxValue() const;
+
+    // Returns the lowest key of the range
+    Key getMinValue() const;
+
+    // Returns the number of keys in the free list
+    size_t recycledCount() const;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Debug Output
+    // ──────────────────────────────────────────────
+
+    // Prints key pool metadata to stream
+    template <typename O, typename K>
+    friend std::ostream& operator<<(std::ostream& os, const BasicIntrusiveKeyPool<O, K>& pool);
+
+
+private:
+
+    // The next never-used key to assign
+    Key nextKey;
+
+    // The lowest key of the range
+    Key minKey;
+
+    // The maximum key that can be assigned
+    Key maxKey;
+
+    // Recycled keys, in the order they are reused
+    typename Order::template Rebind<Key> freeKeys;
+
+    // Number of never-used keys left in [nextKey, maxKey]
+    size_t bumpRemaining() const;
+};
+
+// The pool KeyArray uses by default: recycled keys are reused newest first
+using IntrusiveKeyPool = BasicIntrusiveKeyPool<LifoKeyOrder>;
+
+
+//
+// ░░ Implementation of BasicIntrusiveKeyPool ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Constructors
+// ────────────────────────────────────────────────────────────────
+
+// Constructs a key pool from 0 to maxInclusive (default range)
+template <typename Order, typename Key>
+BasicIntrusiveKeyPool<Order, Key>::BasicIntrusiveKeyPool(Key maxInclusive)
+    : nextKey(0), minKey(0), maxKey(std::min(maxInclusive, KeyTraits<Key>::MaxKey)) {}
+
+
+// Constructs a key pool from min(value1, value2) to max(value1, value2)
+template <typename Order, typename Key>
+BasicIntrusiveKeyPool<Order, Key>::BasicIntrusiveKeyPool(Key value1, Key value2) {
+    if (value1 > value2) std::swap(value1, value2);
+    nextKey = value1;
+    minKey = value1;
+    maxKey = std::min(value2, KeyTraits<Key>::MaxKey);
+}
+
+
+// 🔹 Key Management
+// ────────────────────────────────────────────────────────────────
+
+// Takes a recycled key, or bumps nextKey if there is none
+template <typename Order, typename Key>
+template <typename Links>
+Key BasicIntrusiveKeyPool<Order, Key>::pop(const Links& links) {
+    if (!freeKeys.empty()) {
+        return freeKeys.take(links);
+    }
+    if (nextKey > maxKey) throw std::out_of_range("No more keys available");
+    return nextKey++;
+}
+
+
+// Links a key back into the free list (only if it was issued by this pool)
+template <typename Order, typename Key>
+template <typename Links>
+void BasicIntrusiveKeyPool<Order, Key>::push(Key value, Links& links) {
+    if (value >= minKey && value < nextKey) {
+        freeKeys.put(value, links);
+    }
+}
+
+
+// A newest-first order takes the last push first, so the list is pushed back to front
+template <typename Order, typename Key>
+template <typename It, typename Links>
+void BasicIntrusiveKeyPool<Order, Key>::refill(It first, It last, Links& links) {
+    if constexpr (Order::TakesNewestFirst) {
+        while (last != first) push(*--last, links);
+    } else {
+        for (; first != last; ++first) push(*first, links);
+    }
+}
+
+
+// Hands out a block of the bump range in one step
+template <typename Order, typename Key>
+size_t BasicIntrusiveKeyPool<Order, Key>::reserveRun(size_t count, Key& first) {
+    first = nextKey;
+    size_t reserved = std::min(count, bumpRemaining());
+    nextKey = static_cast<Key>(nextKey + static_cast<Key>(reserved));
+    return reserved;
+}
+
+
+// Returns true if the free list is not empty
+template <typename Order, typename Key>
+bool BasicIntrusiveKeyPool<Order, Key>::hasRecycled() const {
+    return !freeKeys.empty();
+}
+
+
+// Counts recycled keys plus the remaining bump range
+template <typename Order, typename Key>
+size_t BasicIntrusiveKeyPool<Order, Key>::available() const {
+    return freeKeys.size() + bumpRemaining();
+}
+
+
+// Returns true if there are no keys available
+template <typename Order, typename Key>
+bool BasicIntrusiveKeyPool<Order, Key>::empty() const {
+    return freeKeys.empty() && nextKey > maxKey;
+}
+
+
+// Doubles the maximum key value (used for dynamic growth), stopping at the
+// largest key the type allows
+template <typename Order, typename Key>
+void BasicIntrusiveKeyPool<Order, Key>::increaseMaxValue() {
+    constexpr Key Limit = KeyTraits<Key>::MaxKey;
+    if (maxKey >= Limit) {
+        throw std::length_error("IntrusiveKeyPool cannot grow beyond its key type");
+    }
+    maxKey = maxKey > Limit / 2 ? Limit : std::max<Key>(1, static_cast<Key>(maxKey * 2));
+}
+
+
+// Raises the upper bound of the key range; never shrinks it.
+// Throws std::length_error past the largest key the type allows.
+template <typename Order, typename Key>
+void BasicIntrusiveKeyPool<Order, Key>::extend(Key newMaxKey) {
+    if (newMaxKey > KeyTraits<Key>::MaxKey) {
+        throw std::length_error("IntrusiveKeyPool cannot grow beyond its key type");
+    }
+    maxKey = std::max(maxKey, newMaxKey);
+}
+
+
+// Resets the key pool with a new range
+template <typename Order, typename Key>
+void BasicIntrusiveKeyPool<Order, Key>::reset(Key newStart, Key newEnd) {
+    if (newStart > newEnd) std::swap(newStart, newEnd);
+    nextKey = newStart;
+    minKey = newStart;
+    maxKey = std::min(newEnd, KeyTraits<Key>::MaxKey);
+    freeKeys.clear();
+}
+
+
+// Re-writes each link of the free list into the other storage
+template <typename Order, typename Key>
+template <typename FromLinks, typename ToLinks>
+void BasicIntrusiveKeyPool<Order, Key>::copyLinks(const FromLinks& from, ToLinks& to) const {
+    freeKeys.copyLinks(from, to);
+}
+
+
+// Visits the recycled keys in pop order
+template <typename Order, typename Key>
+template <typename Links, typename Fn>
+void BasicIntrusiveKeyPool<Order, Key>::forEachFree(const Links& links, Fn&& fn) const {
+    freeKeys.forEach(links, std::forward<Fn>(fn));
+}
+
+
+// Sets the bump range directly; nextKey is clamped into [minKey, maxKey + 1]
+template <typename Order, typename Key>
+void BasicIntrusiveKeyPool<Order, Key>::restore(Key newMin, Key newNext, Key newMax) {
+    reset(newMin, newMax);
+    nextKey = std::max(minKey, std::min(newNext, static_cast<Key>(maxKey + 1)));
+}
+
+
+// Pushed from the top down, so a newest-first order pops the lowest key first
+template <typename Order, typename Key>
+template <typename Links, typename IsFree>
+void BasicIntrusiveKeyPool<Order, Key>::reclaim(Key newMaxKey, Links& links, IsFree&& isFree) {
+    Key first = nextKey;
+    nextKey = static_cast<Key>(newMaxKey + 1);
+    maxKey = newMaxKey;
+    for (Key key = newMaxKey; key >= first; --key) {
+        if (isFree(key)) push(key, links);
+        if (key == first) break;
+    }
+}
+
+
+// Words are visited in the order that makes the pops ascend: top down for a
+// newest-first order, bottom up otherwise
+template <typename Order, typename Key>
+template <typename Links>
+void BasicIntrusiveKeyPool<Order, Key>::rebuild(const OccupancyBitmap& live, Key newMaxKey, Links& links) {
+    constexpr size_t WordBits = OccupancyBitmap::WordBits;
+
+    size_t top = live.wordCount();
+    while (top > 0 && live.word(top - 1) == 0) --top;
+    size_t end = top == 0 ? 0 : (top - 1) * WordBits + OccupancyBitmap::highestBit(live.word(top - 1)) + 1;
+
+    reset(0, newMaxKey);
+    nextKey = static_cast<Key>(end);
+
+    // Free bits of word w below `end`
+    auto freeBits = [&](size_t w) {
+        uint64_t bits = ~live.word(w);
+        size_t used = end - w * WordBits;
+        return used >= WordBits ? bits : bits & ((uint64_t(1) << used) - 1);
+    };
+    if constexpr (Order::TakesNewestFirst) {
+        for (size_t w = top; w-- > 0;) {
+            for (uint64_t bits = freeBits(w); bits != 0;) {
+                unsigned bit = OccupancyBitmap::highestBit(bits);
+                push(static_cast<Key>(w * WordBits + bit), links);
+                bits &= ~(uint64_t(1) << bit);
+            }
+        }
+    } else {
+        for (size_t w = 0; w < top; ++w) {
+            for (uint64_t bits = freeBits(w); bits != 0; bits &= bits - 1) {
+                push(static_cast<Key>(w * WordBits + OccupancyBitmap::countTrailingZeros(bits)), links);
+            }
+        }
+    }
+}
+
+
+// Counts the unused tail of the range without overflowing the key type
+template <typename Order, typename Key>
+size_t BasicIntrusiveKeyPool<Order, Key>::bumpRemaining() const {
+    return nextKey > maxKey ? 0 : KeyTraits<Key>::slotOf(maxKey, nextKey) + 1;
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+// Returns the current value of the next key
+template <typename Order, typename Key>
+Key BasicIntrusiveKeyPool<Order, Key>::getCurrentValue() const {
+    return nextKey;
+}
+
+
+// Returns the upper bound key value
+template <typename Order, typename Key>
+Key BasicIntrusiveKeyPool<Order, Key>::getMaxValue() const {
+    return maxKey;
+}
+
+
+// Returns the lower bound key value
+template <typename Order, typename Key>
+Key BasicIntrusiveKeyPool<Order, Key>::getMinValue() const {
+    return minKey;
+}
+
+
+// Returns the length of the free list
+template <typename Order, typename Key>
+size_t BasicIntrusiveKeyPool<Order, Key>::recycledCount() const {
+    return freeKeys.size();
+}
+
+
+// 🔹 Debug Output
+// ────────────────────────────────────────────────────────────────
+
+// Outputs key pool state to an output stream
+template <typename Order, typename Key>
+std::ostream& operator<<(std::ostream& os, const BasicIntrusiveKeyPool<Order, Key>& pool) {
+    os << "IntrusiveKeyPool: Current Value = " << +pool.nextKey << ", Max Value = " << +pool.maxKey;
+    return os;
+}
+
+
+#endif // INTRUSIVEKEYPOOL_HPP
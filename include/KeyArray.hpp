@@ -5,20 +5,90 @@
 #define KEYARRAY_HPP
 
 #include "KeyArrayBase.hpp"
-#include <queue>
+#include "KeyArrayChangeLog.hpp"
+#include "KeyArrayDirtyTracker.hpp"
+#include "KeyArrayIndex.hpp"
+#include "KeyArrayScan.hpp"
+#include "KeyArrayListener.hpp"
+#include "KeyArraySnapshot.hpp"
+#include "KeyArrayStats.hpp"
+#include "KeyHandle.hpp"
+#include "OverflowRing.hpp"
+#include "PagedSlotStorage.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <memory>
 #include <functional>
 #include <fstream>
 #include <iostream>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 /**
  * @brief KeyArray provides an extended structure over KeyArrayBase.
  *        It supports named instances, offset key mapping,
  *        optional dynamic resizing, and a fallback queue mechanism.
+ *
+ *        With generational storage (see GenerationalKeyArray) it also
+ *        issues KeyHandles, which detect stale keys on lookup.
+ *
+ *        KeyArray is final, so calls through a KeyArray are devirtualized;
+ *        operator[], at_unchecked and try_get add exception-free lookups.
+ *
+ *        Storage is a policy: SlotStorage (one contiguous buffer, resized by
+ *        incremental migration) or PagedSlotStorage (fixed-size pages, grown
+ *        in place so element references stay valid), see PagedKeyArray.
+ *
+ *        Every internal buffer (slots, bitmaps, the resize buffers and the
+ *        overflow queue) can be placed in a std::pmr::memory_resource, e.g. a
+ *        monotonic arena, a pool or a shared-memory segment.
+ *
+ *        Order picks which freed key is reused next (KeyOrder.hpp): newest
+ *        first (LifoKeyOrder, the default), oldest first (FifoKeyOrder) or
+ *        lowest first (LowestKeyOrder), trading cache warmth against delayed
+ *        reuse and a dense key range.
+ *
+ *        Key is the integer type of keys (int unless given, see KeyTraits.hpp);
+ *        free-list links in the slots take its size. Growth stops with
+ *        std::length_error once offset + capacity would pass the type's last
+ *        key. Snapshots and change logs store keys in 64 bits.
+ *
+ *        With enableBackgroundResize, the next buffer is allocated and filled
+ *        by a helper thread (or an executor) while this thread keeps working
+ *        in the current one; only the handover runs here. The array is still
+ *        used from one thread: the helper is internal.
+ *
+ *        getStats() reports occupancy and memory; built with KEYARRAY_STATS
+ *        it also counts key reuse, resizes and queue usage and samples the
+ *        latency of insert, remove and at (KeyArrayStats.hpp).
  */
-template <typename T>
-class KeyArray : public KeyArrayBase<T> {
+template <typename T, typename Storage = SlotStorage<T>, typename Order = LifoKeyOrder, typename Key = int>
+class KeyArray final : public KeyArrayBase<T, Storage, Order, Key> {
 public:
-    using KeyArrayBase<T>::KeyArrayBase;
+    using KeyArrayBase<T, Storage, Order, Key>::KeyArrayBase;
+
+    // Overflow queue, allocated from the array's memory resource
+    using OverflowQueue = OverflowRing<T>;
+
+    // Called with (oldKey, newKey) for every value a shrink moves
+    using KeyRemap = std::function<void(Key oldKey, Key newKey)>;
+
+    // Called with the key a queued value was admitted to, and the value
+    using KeyAdmit = std::function<void(Key key, const T& value)>;
+
+    // Runs a background resize task (on a pool thread, say); must not drop it
+    using ResizeExecutor = std::function<void(std::function<void()> task)>;
+
+    // Returned instead of a key for a value that went to the overflow queue
+    static constexpr Key Queued = KeyTraits<Key>::Queued;
 
         // ─────────────────────────────────────────────────────────────
     // 🔹 Construction & Initialization
@@ -28,36 +98,291 @@ public:
     KeyArray(const std::string& name = "");
 
     // Constructs a KeyArray from 0 to limitKey - 1
-    KeyArray(int limitKey, const std::string& name = "");
+    KeyArray(Key limitKey, const std::string& name = "");
 
     // Constructs a KeyArray with given offset and last key (order-independent)
-    KeyArray(int a, int b, const std::string& name = "");
+    KeyArray(Key a, Key b, const std::string& name = "");
+
+    // Constructs a KeyArray from 0 to limitKey - 1 whose buffers come from resource
+    KeyArray(Key limitKey, std::pmr::memory_resource* resource, const std::string& name = "");
+
+    // Constructs a KeyArray with given offset and last key whose buffers come from resource
+    KeyArray(Key a, Key b, std::pmr::memory_resource* resource, const std::string& name = "");
+
+    // Constructs a KeyArray holding [first, last) under keys 0 to n - 1, sized to fit
+    template <typename InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    KeyArray(InputIt first, InputIt last, const std::string& name = "");
+
+    // Copies all live elements, including those of an in-progress resize
+    KeyArray(const KeyArray& other);
+    KeyArray& operator=(const KeyArray& other);
+
+    // Takes over all storage of another KeyArray
+    KeyArray(KeyArray&& other) noexcept;
+    KeyArray& operator=(KeyArray&& other) noexcept;
+
+    // Destroys all live elements, including those of the resize buffer
+    ~KeyArray() override;
 
     // ─────────────────────────────────────────────────────────────
     // 🔹 Core KeyArray Functionality
     // ─────────────────────────────────────────────────────────────
 
     // Inserts a value and returns the assigned key
-    int insert(const T& value) override;
+    Key insert(const T& value) override;
+
+    // Moves a value in and returns the assigned key
+    Key insert(T&& value) override;
+
+    // Constructs a value in place and returns the assigned key
+    template <typename... Args>
+    Key emplace(Args&&... args);
 
     // Removes a value by key
-    void remove(int key) override;
+    void remove(Key key) override;
 
     // Checks if a given key is currently in use
-    bool hasKey(int key) const override;
+    bool hasKey(Key key) const override;
 
     // Checks if a given value exists in the structure
     bool contains(const T& value) const override;
 
     // Access a value by key (modifiable)
-    T& at(int key) override;
+    T& at(Key key) override;
 
     // Access a value by key (read-only)
-    const T& at(int key) const override;
+    const T& at(Key key) const override;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Unchecked Fast Path
+    // ─────────────────────────────────────────────────────────────
+
+    // Access a live key without any check (undefined if the key is not live)
+    T& operator[](Key key) noexcept;
+    const T& operator[](Key key) const noexcept;
+
+    // Same as operator[], spelled out for call sites that want it visible
+    T& at_unchecked(Key key) noexcept;
+    const T& at_unchecked(Key key) const noexcept;
+
+    // Returns a pointer to the value, or nullptr if the key is not in use
+    T* try_get(Key key) noexcept;
+    const T* try_get(Key key) const noexcept;
 
-    // Clears all elements and resets internal state
+    // Clears all elements and resets internal state, keeping the capacity;
+    // costs O(live + keys handed out since the last clear / 64)
     void clear() override;
 
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Batch Operations
+    // ─────────────────────────────────────────────────────────────
+
+    // Inserts every value of [first, last), writing each assigned key to outKeys
+    // (Queued for values that went to the overflow queue); returns the advanced outKeys
+    template <typename InputIt, typename OutputIt>
+    OutputIt insertBatch(InputIt first, InputIt last, OutputIt outKeys);
+
+    // Removes every key of [first, last)
+    template <typename InputIt>
+    void removeBatch(InputIt first, InputIt last);
+
+    // Removes every key of a container
+    template <typename KeyRange>
+    void removeBatch(const KeyRange& keys);
+
+    // Removes every key of a braced list
+    void removeBatch(std::initializer_list<Key> keys);
+
+    // Replaces the contents with [first, last) under keys offset to offset + n - 1,
+    // built in one pass; the capacity is kept unless n needs more
+    template <typename InputIt>
+    void assign(InputIt first, InputIt last);
+
+    // Replaces the contents with the (key, value) pairs of [first, last); the
+    // free list is rebuilt from the occupancy bitmap in one sweep
+    template <typename InputIt>
+    void assignKeyed(InputIt first, InputIt last);
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Tracked Updates
+    // ─────────────────────────────────────────────────────────────
+
+    // Applies fn(value) to a live key and reports the update to listeners
+    template <typename Fn>
+    void modify(Key key, Fn&& fn);
+
+    // Assigns a new value to a live key and reports the update to listeners
+    void update(Key key, const T& value);
+    void update(Key key, T&& value);
+
+    // Writable reference to a live key that reports the update to listeners
+    // when it goes out of scope (defined below)
+    class WriteRef;
+
+    // Returns a WriteRef to a live key; throws std::out_of_range otherwise
+    WriteRef write(Key key);
+
+    // Reports an update made through at() or operator[] to listeners
+    void markUpdated(Key key);
+
+    // Registers a listener for every mutation (not owned; must outlive its registration)
+    void addListener(KeyArrayListener<T, Key>* listener);
+
+    // Unregisters a listener
+    void removeListener(KeyArrayListener<T, Key>* listener);
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Change Log (incremental persistence)
+    // ─────────────────────────────────────────────────────────────
+
+    // Writes a base snapshot and starts logging every mutation to logPath
+    template <typename Serializer = KeyArraySerializer<T>>
+    void enableChangeLog(const std::string& snapshotPath, const std::string& logPath,
+                         const KeyArrayLogPolicy& policy = {});
+
+    // Commits and stops the change log
+    void disableChangeLog();
+
+    // Returns whether a change log is active
+    bool isChangeLogEnabled() const;
+
+    // Writes buffered log records now (group commit)
+    void commitChangeLog();
+
+    // Compacts: writes a fresh base snapshot and restarts an empty log
+    void checkpoint();
+
+    // Loads a base snapshot and replays its change log; returns the records replayed
+    template <typename Serializer = KeyArraySerializer<T>>
+    size_t recover(const std::string& snapshotPath, const std::string& logPath);
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Change Tracking (incremental replication)
+    // ─────────────────────────────────────────────────────────────
+
+    // Starts recording which keys every mutation touches, for collectChanges()
+    void enableChangeTracking();
+
+    // Stops recording and forgets the keys not yet collected
+    void disableChangeTracking();
+
+    // Returns whether changed keys are recorded
+    bool isChangeTrackingEnabled() const;
+
+    // Calls fn(key, value) once for every key inserted, updated, swapped, moved
+    // or removed since the last call, in key order, then starts over; value
+    // points at the key's current value, or is nullptr if it is no longer live.
+    // fn must not modify the array. Returns the number of keys reported
+    template <typename Fn>
+    size_t collectChanges(Fn&& fn);
+
+    // Returns the number of keys waiting for collectChanges()
+    size_t pendingChanges() const;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Value Index
+    // ─────────────────────────────────────────────────────────────
+
+    // Builds a hash index over the live values, kept current by every mutation
+    template <typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+    void enableIndex(const Hash& hash = Hash(), const Equal& equal = Equal());
+
+    // Drops the index; contains and find fall back to scanning
+    void disableIndex();
+
+    // Returns whether a value index is active
+    bool isIndexEnabled() const;
+
+    // Returns a key holding the value, or std::nullopt (O(1) with an index)
+    std::optional<Key> find(const T& value) const;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Value Scans (vectorized for arithmetic T, parallel for large arrays)
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the number of live keys holding the value
+    size_t count(const T& value) const;
+
+    // Returns the lowest live key whose value satisfies pred, or std::nullopt
+    template <typename Pred>
+    std::optional<Key> find_if(Pred pred) const;
+
+    // Returns the number of live values satisfying pred
+    template <typename Pred>
+    size_t count_if(Pred pred) const;
+
+    // Sets when scans are split across threads (pred must then be safe to call concurrently)
+    void setScanPolicy(const KeyArrayScanPolicy& policy);
+
+    // Returns the current scan policy
+    const KeyArrayScanPolicy& getScanPolicy() const;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Bulk Traversal
+    // ─────────────────────────────────────────────────────────────
+
+    // Calls fn(key, value) for every live element in ascending key order,
+    // skipping empty bitmap words whole
+    template <typename Fn>
+    void forEachLive(Fn&& fn);
+    template <typename Fn>
+    void forEachLive(Fn&& fn) const;
+
+    // Calls fn(key, value) for every live element from several threads: the
+    // slots are cut into chunks of whole bitmap cache lines (512 slots), run
+    // through executor (a std::execution policy, or a callable taking
+    // std::function<void()> tasks, see KeyArrayScan::executeChunks). One chunk
+    // per scan-policy thread; fn must be safe to call concurrently.
+    template <typename Executor, typename Fn>
+    void parallelForEachLive(Executor&& executor, Fn&& fn);
+    template <typename Executor, typename Fn>
+    void parallelForEachLive(Executor&& executor, Fn&& fn) const;
+
+    // Folds map(key, value) into init with combine(acc, mapped), in ascending key order
+    template <typename R, typename Map, typename Combine>
+    R reduceLive(R init, Map&& map, Combine&& combine) const;
+
+    // Reduces each chunk in parallel (as parallelForEachLive), then combines
+    // the chunk results into init in key order; combine must be associative
+    template <typename Executor, typename R, typename Map, typename Combine>
+    R parallelReduceLive(Executor&& executor, R init, Map&& map, Combine&& combine) const;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Generational Handles (requires generational Storage)
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns a handle for a live key
+    template <typename Handle = KeyHandle>
+    Handle handleOf(Key key) const;
+
+    // Inserts a value and returns its handle (null handle if it was queued)
+    template <typename Handle = KeyHandle>
+    Handle insertHandle(const T& value);
+
+    // Moves a value in and returns its handle (null handle if it was queued)
+    template <typename Handle = KeyHandle>
+    Handle insertHandle(T&& value);
+
+    // Constructs a value in place and returns its handle (null handle if it was queued)
+    template <typename Handle = KeyHandle, typename... Args>
+    Handle emplaceHandle(Args&&... args);
+
+    // Checks if a handle still refers to the element it was issued for
+    template <typename Word, unsigned IndexBits>
+    bool hasKey(BasicKeyHandle<Word, IndexBits> handle) const;
+
+    // Access a value by handle (modifiable); throws on stale handles
+    template <typename Word, unsigned IndexBits>
+    T& at(BasicKeyHandle<Word, IndexBits> handle);
+
+    // Access a value by handle (read-only); throws on stale handles
+    template <typename Word, unsigned IndexBits>
+    const T& at(BasicKeyHandle<Word, IndexBits> handle) const;
+
+    // Removes a value by handle; throws on stale handles
+    template <typename Word, unsigned IndexBits>
+    void remove(BasicKeyHandle<Word, IndexBits> handle);
+
     // ─────────────────────────────────────────────────────────────
     // 🔹 Dynamic Resizing
     // ─────────────────────────────────────────────────────────────
@@ -71,12 +396,72 @@ public:
     // Returns whether dynamic resizing is enabled
     bool isDynamicResizingEnabled() const;
 
-    // Performs one step of copying from old to new buffer
+    // Grows the key space to at least n keys in one step, without the
+    // incremental copy and whether or not dynamic resizing is enabled
+    void reserve(size_t n);
+
+    // Copies into each next buffer on a helper thread (on `executor` if given);
+    // this thread keeps using the current buffer and only takes part in the handover
+    void enableBackgroundResize(const ResizeExecutor& executor = nullptr);
+
+    // Resizes on this thread again; a background copy already running still completes
+    void disableBackgroundResize();
+
+    // Returns whether resizes copy in the background
+    bool isBackgroundResizeEnabled() const;
+
+    // Migrates the next copy budget worth of slots into the resize buffer
+    // (or moves as many values down for a shrink in progress)
     void continueCopyStep();
 
-    // Replaces the old buffer with the resized one
+    // Migrates all remaining slots at once and replaces the old buffer
     void switchToResizedData();
 
+    // Returns true while slots are being migrated into a larger buffer
+    bool isResizeInProgress() const;
+
+    // Sets how many slots are migrated per insert or remove (at least 1)
+    void setCopyBudget(size_t slots);
+
+    // Sets the copy budget in bytes of element storage (rounded to whole slots)
+    void setCopyBudgetBytes(size_t bytes);
+
+    // Returns the number of slots migrated per operation
+    size_t getCopyBudget() const;
+
+    // Sets the occupancy in (0, 1] at which the next buffer is allocated
+    void setResizeThreshold(double occupancy);
+
+    // Returns the occupancy at which the next buffer is allocated
+    double getResizeThreshold() const;
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Shrinking & Compaction
+    // ─────────────────────────────────────────────────────────────
+
+    // Moves every live value into the lowest keys and releases all other slots
+    // at once; remap(oldKey, newKey) is called for every value that moved
+    void shrinkToFit(const KeyRemap& remap = nullptr);
+
+    // Starts shrinking to `capacity` slots (at least size()): values above it move
+    // into free keys below it, one copy budget per insert or remove
+    void startShrink(size_t capacity, const KeyRemap& remap = nullptr);
+
+    // Moves all values still above the shrink target and releases the slots
+    void finishShrink();
+
+    // Returns true while values are being moved down for a shrink
+    bool isShrinkInProgress() const;
+
+    // Starts a shrink whenever occupancy drops below `occupancy`, never below minCapacity
+    void enableAutoShrink(const KeyRemap& remap, double occupancy = 0.25, size_t minCapacity = 64);
+
+    // Stops shrinking automatically; a shrink in progress keeps advancing
+    void disableAutoShrink();
+
+    // Returns whether automatic shrinking is enabled
+    bool isAutoShrinkEnabled() const;
+
     // ─────────────────────────────────────────────────────────────
     // 🔹 Optional Overflow Queue
     // ─────────────────────────────────────────────────────────────
@@ -84,6 +469,10 @@ public:
     // Enables queue mode (used when pool is full and dynamic resizing is off)
     void enableQueue();
 
+    // Enables a queue of at most `limit` values (0 = unbounded), reserved up front;
+    // `policy` decides what a value arriving at a full queue does
+    void enableQueue(size_t limit, OverflowPolicy policy = OverflowPolicy::Reject);
+
     // Disables the queue and stops accepting new elements into it
     void disableQueue();
 
@@ -94,10 +483,33 @@ public:
     size_t getQueueSize() const;
 
     // Returns a modifiable reference to the queue
-    std::queue<T>& getQueue();
+    OverflowQueue& getQueue();
 
     // Returns a const reference to the queue
-    const std::queue<T>& getQueue() const;
+    const OverflowQueue& getQueue() const;
+
+    // Returns the queue bound (0 = unbounded)
+    size_t getQueueLimit() const;
+
+    // Returns what a full bounded queue does with one more value
+    OverflowPolicy getOverflowPolicy() const;
+
+    // Moves the head of the queue into the next free key; returns that key, or
+    // Queued if the queue is empty or no key is free
+    Key admitQueued();
+
+    // Admits queued values until the queue is empty or no key is free; returns how many
+    size_t drainQueue();
+
+    // Makes remove() admit the head of the queue into the freed key at once,
+    // calling admitted(key, value) for every value so admitted
+    void enableAdmission(const KeyAdmit& admitted = nullptr);
+
+    // Leaves queued values in the queue when keys are freed
+    void disableAdmission();
+
+    // Returns whether remove() admits queued values
+    bool isAdmissionEnabled() const;
 
     // ─────────────────────────────────────────────────────────────
     // 🔹 Metadata and Debugging Utilities
@@ -110,31 +522,84 @@ public:
     std::string getName() const;
 
     // Swaps the values of two keys
-    void swap(int key1, int key2);
+    void swap(Key key1, Key key2);
 
-    // Saves the current state to a file
+    // Saves the current state to a binary snapshot file (see KeyArraySnapshot.hpp)
+    template <typename Serializer = KeyArraySerializer<T>>
     void saveToFile(const std::string& filename) const;
 
-    // Loads KeyArray state from a file
+    // Writes the current state as a binary snapshot to a stream
+    template <typename Serializer = KeyArraySerializer<T>>
+    void saveSnapshot(std::ostream& os) const;
+
+    // Loads KeyArray state from a snapshot file with a single read
+    template <typename Serializer = KeyArraySerializer<T>>
     void loadFromFile(const std::string& filename);
 
+    // Loads KeyArray state from a snapshot in memory (e.g. an mmap of the file)
+    template <typename Serializer = KeyArraySerializer<T>>
+    void loadSnapshot(const void* bytes, size_t size);
+
+    // Prints the structure, including elements already moved by a resize
+    template <typename U, typename S, typename O, typename K>
+    friend std::ostream& operator<<(std::ostream& os, const KeyArray<U, S, O, K>& array);
+
     // ─────────────────────────────────────────────────────────────
     // 🔹 Accessors
     // ─────────────────────────────────────────────────────────────
 
     // Returns the offset of the key space
-    int getOffset() const;
+    Key getOffset() const;
 
     // Returns the maximum usable key (inclusive upper bound)
-    int getMaxKeyBound() const;
+    Key getMaxKeyBound() const;
+
+    // Returns the number of usable keys (slots)
+    size_t getCapacity() const;
+
+    // Returns the memory resource every buffer is allocated from
+    std::pmr::memory_resource* getResource() const;
+
+    // Returns counters (with KEYARRAY_STATS), occupancy and memory in one snapshot
+    KeyArrayStats getStats() const;
+
+    // Zeroes the counters and latency samples
+    void resetStats();
+
+    // Forward iterator over live (key, value) pairs in ascending key order; dead
+    // slots are skipped a bitmap word at a time, so a full scan costs
+    // O(live + capacity / 64)
+    template <bool Const>
+    class LiveIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<Key, std::conditional_t<Const, const T&, T&>>;
+        using reference = value_type;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using owner_type = std::conditional_t<Const, const KeyArray*, KeyArray*>;
+
+        LiveIterator() = default;
+        LiveIterator(owner_type owner, size_t index) : owner(owner), index(index) {}
+
+        reference operator*() const { return { owner->keyOf(index), owner->bufferOf(index)[index] }; }
+        LiveIterator& operator++() { index = owner->nextLive(index + 1); return *this; }
+        LiveIterator operator++(int) { LiveIterator tmp = *this; ++*this; return tmp; }
+        bool operator==(const LiveIterator& other) const { return index == other.index; }
+        bool operator!=(const LiveIterator& other) const { return index != other.index; }
+
+    private:
+        owner_type owner = nullptr;
+        size_t index = 0;
+    };
 
-    // Begin iterator (modifiable)
+    // Begin iterator over live (key, value) pairs (modifiable)
     auto begin();
 
     // End iterator (modifiable)
     auto end();
 
-    // Begin iterator (const)
+    // Begin iterator over live (key, value) pairs (const)
     auto begin() const;
 
     // End iterator (const)
@@ -147,526 +612,3298 @@ public:
 
     private:
 
-    // ──────────────────────────────────────────────
-    // Basic structure configuration
-    // ──────────────────────────────────────────────
+    // Slot storage with key-sized free-list links (see KeyArrayBase)
+    using typename KeyArrayBase<T, Storage, Order, Key>::SlotBuffer;
 
-    // Logical key offset – shifts all external keys by this amount internally
-    int offset;
+    // Maps an external key to its slot index; keys below the offset wrap to
+    // huge values, so a single unsigned compare rejects both ends of the range
+    size_t slotOf(Key key) const noexcept;
 
-    // Optional human-readable identifier for the structure
-    std::string name;
+    // Maps a slot index back to its external key
+    Key keyOf(size_t index) const noexcept;
+
+    // Largest capacity whose keys (offset + slot) the key type can still name
+    size_t maxCapacity() const noexcept;
 
+    // Caps a grown capacity at maxCapacity(); throws std::length_error if that
+    // leaves fewer than `needed` slots
+    size_t cappedCapacity(size_t wanted, size_t needed) const;
 
     // ──────────────────────────────────────────────
-    // Dynamic resizing configuration
+    // Slot ownership during a resize
     // ──────────────────────────────────────────────
 
-    // Indicates whether dynamic resizing is enabled
-    bool resizingEnabled = false;
+    // Free-list links that follow each slot into the buffer that owns it
+    template <typename Owner>
+    struct SlotLinks {
+        Owner* owner;
+        Key nextFree(size_t index) const { return owner->bufferOf(index).nextFree(index); }
+        void setNextFree(size_t index, Key next) const {
+            owner->touchSlot(index);
+            owner->bufferOf(index).setNextFree(index, next);
+        }
+    };
 
-    // Indicates whether the copying process is in progress (from current to new arrays)
-    bool copyInProgress = false;
+    // True if the slot still lives in `data`: slots below the copy cursor and
+    // past the old capacity belong to `newData` (one compare, also when idle)
+    bool inOldBuffer(size_t index) const noexcept;
 
-    // The index currently being copied to the new array
-    int copyIndex = 0;
+    // Returns the buffer holding the given slot
+    SlotBuffer& bufferOf(size_t index) noexcept;
+    const SlotBuffer& bufferOf(size_t index) const noexcept;
 
-    // Temporary array to hold new values during dynamic resizing
-    std::vector<T> newData;
+    // Returns the validity bitmap of the buffer holding the given slot
+    OccupancyBitmap& bitsOf(size_t index) noexcept;
 
-    // Validity flags for the new array
-    std::vector<bool> newValid;
+    // Returns true if the slot index is in range and live in its buffer
+    bool isLiveSlot(size_t index) const noexcept;
 
-    // KeyPool for keys in the new resized array
-    KeyPool newPool;
+    // Marks the slots [first, last) live in whichever buffers own them
+    void setLiveRange(size_t first, size_t last);
 
+    // Returns the first live slot at or after `from`, or endSlot()
+    size_t nextLive(size_t from) const noexcept;
 
-    // ──────────────────────────────────────────────
-    // Overflow queue configuration
-    // ──────────────────────────────────────────────
+    // Returns the index one past the last slot of the active buffers
+    size_t endSlot() const noexcept;
 
-    // Indicates whether the overflow queue is active
-    bool queueEnabled = false;
+    // Destroys the value in a live slot and recycles its key
+    void eraseSlot(size_t index);
 
-    // Queue for holding values that couldn't be inserted due to full capacity
-    std::queue<T> overflowQueue;
+    // Allocates the resize buffer if occupancy after `incoming` inserts crosses the threshold
+    void maybeStartResize(size_t incoming);
 
+    // Allocates the resize buffer and opens its extra keys to the pool
+    void startResize();
 
-};
+    // Moves up to `slots` slots past the copy cursor into the resize buffer
+    void migrateSlots(size_t slots);
 
+    // Migrates everything left, if a resize is in progress
+    void finishResize();
 
+    // Drops the emptied old buffer once the cursor has passed all of it
+    void completeResize();
 
+    // Grows the live buffer to at least minCapacity slots in one step
+    void growTo(size_t minCapacity);
 
+    // Moves the live buffer into one of exactly newCapacity slots
+    void growExactly(size_t newCapacity);
 
+    // Grows storage that supports it (GrowsInPlace) without moving any slot
+    void growInPlace(size_t newCapacity);
 
-// ▼▼▼ Implementation of KeyArray ▼▼▼
+    // Opens the keys up to lastKey after growth from `oldCapacity` slots
+    void openKeys(size_t oldCapacity);
 
+    // Starts the slots of `buffer` from `first` up at the generation floor
+    void startAtGenerationFloor(SlotBuffer& buffer, size_t first) const;
 
+    // Slots a background copy moves per hold of its lock
+    static constexpr size_t BackgroundChunk = 4096;
 
-// ──────────────────────────────────────────────
-// Constructors
-// ──────────────────────────────────────────────
+    // State shared with the helper of a background resize
+    struct BackgroundCopy {
+        // Held by the helper for each chunk and by this thread for each mutating call
+        std::mutex lock;
 
-// Default constructor with optional name
-template <typename T>
-KeyArray<T>::KeyArray(const std::string& name)
-    : KeyArrayBase<T>(), offset(0), name(name) {}
+        // Signalled, under lock, once the helper is done
+        std::condition_variable finished;
 
+        // Helper is done (guarded by lock); `ready` repeats it for lock-free polling
+        bool done = false;
+        std::atomic<bool> ready{ false };
 
-// Constructor with maximum key value and optional name
-template <typename T>
-KeyArray<T>::KeyArray(int limitKey, const std::string& name)
-    : KeyArrayBase<T>(limitKey), offset(0), name(name) {}
+        // This thread holds lock (only ever touched by this thread)
+        bool held = false;
 
+        // Capacity of the buffer being copied
+        size_t capacity = 0;
 
-// Constructor with two values (interpreted as offset and limit)
-template <typename T>
-KeyArray<T>::KeyArray(int a, int b, const std::string& name)
-    : KeyArrayBase<T>(std::max(a, b) - std::min(a, b)), offset(std::min(a, b)), name(name) {}
+        // Capacity of the grown buffer
+        size_t targetCapacity = 0;
 
+        // Slots [0, copied) are in target (guarded by lock)
+        size_t copied = 0;
 
+        // The grown buffer and its validity flags
+        SlotBuffer target;
+        OccupancyBitmap targetValid;
 
-// ──────────────────────────────────────────────
-// Insertion
-// ──────────────────────────────────────────────
+        // Copied slots changed by this thread since, copied again at the handover
+        OccupancyBitmap dirty;
 
-// Inserts a value into the array and handles overflow queue or dynamic resizing
-template <typename T>
-int KeyArray<T>::insert(const T& value) {
-    if (this->pool.empty()) {
-        if (resizingEnabled) {
-            if (copyInProgress) {
-                // Complete the ongoing copy if the old array is full
-                while (copyInProgress) {
-                    continueCopyStep();
-                }
+        // Exception thrown by the helper, rethrown at the handover
+        std::exception_ptr error;
+
+        // The helper, unless an executor runs it
+        std::thread thread;
+    };
+
+    // Marks one mutating call: the outermost guard hands over a finished
+    // background copy, then holds the copy's lock until the call returns
+    // (also when the call itself starts the copy). Nested guards do nothing.
+    class CopyGuard {
+    public:
+        explicit CopyGuard(KeyArray& array) : array(array), outermost(!array.mutating) {
+            if (!outermost) return;
+            if (array.background && array.background->ready.load(std::memory_order_acquire)) {
+                array.awaitBackgroundResize();
             }
-            switchToResizedData();
-        } else if (queueEnabled) {
-            overflowQueue.push(value);
-            return -1; // indicator that value was added to queue
-        } else {
-            throw std::runtime_error("KeyPool is empty. No available keys.");
+            if (array.background) {
+                array.background->lock.lock();
+                array.background->held = true;
+            }
+            array.mutating = true;
         }
-    }
+        ~CopyGuard() {
+            if (!outermost) return;
+            array.mutating = false;
+            if (array.background && array.background->held) {
+                array.background->held = false;
+                array.background->lock.unlock();
+            }
+        }
+        CopyGuard(const CopyGuard&) = delete;
+        CopyGuard& operator=(const CopyGuard&) = delete;
+    private:
+        KeyArray& array;
+        bool outermost;
+    };
 
-    int actualKey = KeyArrayBase<T>::insert(value);
+public:
 
-    if (resizingEnabled) {
-        this->newData[actualKey] = value;
-        this->newValid[actualKey] = true;
+    // Holds the copy's lock like a mutating call, so the write is safe during
+    // a background resize; keep it short-lived. Like at(), it is invalidated
+    // by an insert that resizes. The report (markUpdated) runs in the
+    // destructor: its exceptions propagate unless one is already in flight.
+    class WriteRef {
+    public:
+        WriteRef(KeyArray& owner, Key key)
+            : guard(owner), owner(owner), key(key), value(owner.at(key)),
+              exceptions(std::uncaught_exceptions()) {}
+
+        ~WriteRef() noexcept(false) {
+            if (std::uncaught_exceptions() == exceptions) {
+                owner.markUpdated(key);
+                return;
+            }
+            try { owner.markUpdated(key); } catch (...) {}
+        }
 
-        if (copyInProgress)
-            continueCopyStep(); // Continue one step of copying
-    }
+        WriteRef(const WriteRef&) = delete;
+        WriteRef& operator=(const WriteRef&) = delete;
 
-    return actualKey + offset;
-}
+        T& operator*() const { return value; }
+        T* operator->() const { return &value; }
+        T& get() const { return value; }
 
+        // Assigns a new value through the reference
+        WriteRef& operator=(const T& newValue) { value = newValue; return *this; }
+        WriteRef& operator=(T&& newValue) { value = std::move(newValue); return *this; }
 
+    private:
+        CopyGuard guard;
+        KeyArray& owner;
+        Key key;
+        T& value;
+        int exceptions;
+    };
 
-// ──────────────────────────────────────────────
-// Removal
-// ──────────────────────────────────────────────
+private:
 
-// Removes an element by key, adjusted for offset
-template <typename T>
-void KeyArray<T>::remove(int key) {
-    if (key < offset || key > this->lastKey + offset) {
-        throw std::out_of_range("Key out of valid range in KeyArray");
-    }
+    // Hands the copy of the current buffer into one of newCapacity slots to the
+    // helper (or the executor)
+    void startBackgroundResize(size_t newCapacity);
 
-    int actualKey = key - offset;
-    KeyArrayBase<T>::remove(actualKey);
+    // Helper side: allocates the grown buffer and copies into it chunk by chunk
+    void runBackgroundCopy(BackgroundCopy& copy);
 
-    if (resizingEnabled) {
-        newValid[actualKey] = false;
-    }
-}
+    // Marks a slot changed if the background copy already passed it
+    void touchSlot(size_t index) noexcept;
 
+    // Waits until the helper is done, releasing this thread's hold first
+    void settleBackgroundCopy();
 
+    // Settles the background copy, then returns this array to be moved from
+    KeyArray& settledForMove() noexcept;
 
-// ──────────────────────────────────────────────
-// Key and Value Lookup
-// ──────────────────────────────────────────────
+    // Waits for the background copy and switches to the grown buffer
+    void awaitBackgroundResize();
 
-// Checks if a specific key is currently active
-template <typename T>
-bool KeyArray<T>::hasKey(int key) const {
-    if (key < offset || key > this->lastKey + offset)
-        return false;
-    return KeyArrayBase<T>::hasKey(key - offset);
-}
+    // Waits for the background copy and drops it
+    void cancelBackgroundResize();
 
+    // Copies the dirty slots again, then swaps in the grown buffer and opens its keys
+    void completeBackgroundResize();
 
-// Checks if the given value exists in the structure
-template <typename T>
-bool KeyArray<T>::contains(const T& value) const {
-    return KeyArrayBase<T>::contains(value);
-}
+    // Moves up to `slots` values from above the shrink target into free keys below it
+    void compactSlots(size_t slots);
 
+    // Moves the value in slot `from` into the lowest free key and reports the move
+    void relocateSlot(size_t from);
 
+    // Releases the slots above the shrink target once none of them is live
+    void completeShrink();
 
-// ──────────────────────────────────────────────
-// Element Access
-// ──────────────────────────────────────────────
+    // Abandons a shrink, handing the free slots above its target back to the pool
+    void cancelShrink();
 
-// Access element by key (non-const version)
-template <typename T>
-T& KeyArray<T>::at(int key) {
-    if (key < offset || key > this->lastKey + offset)
-        throw std::out_of_range("Invalid key in KeyArray");
-    return KeyArrayBase<T>::at(key - offset);
-}
+    // Starts a shrink if automatic shrinking is on and occupancy fell below its limit
+    void maybeStartShrink();
 
+    // Calls fn(listener) for every listener, then compacts the change log if it asks for it
+    template <typename Fn>
+    void notify(Fn&& fn);
 
-// Access element by key (const version)
-template <typename T>
-const T& KeyArray<T>::at(int key) const {
-    if (key < offset || key > this->lastKey + offset)
-        throw std::out_of_range("Invalid key in KeyArray");
-    return KeyArrayBase<T>::at(key - offset);
-}
+    // Reports the slots [first, last) as inserted
+    void notifyRunInserted(size_t first, size_t last);
 
+    // Reports a value that went to the overflow queue (key -1; the index skips it)
+    void notifyQueued(const T& value);
 
+    // Feeds every live element to a freshly created index
+    void buildIndex();
 
-// ──────────────────────────────────────────────
-// Clear
-// ──────────────────────────────────────────────
+    // Returns an empty overflow queue allocating from this array's resource
+    OverflowQueue emptyQueue() const;
 
-// Clears all data and resets queues and dynamic resizing
-template <typename T>
-void KeyArray<T>::clear() {
-    // Clear base structure
-    KeyArrayBase<T>::clear();
+    // Emplaces like emplace(), setting `queued` if the value went to the queue
+    // (the returned Queued alone is ambiguous when the key range includes it)
+    template <typename... Args>
+    Key emplaceOrQueue(bool& queued, Args&&... args);
 
-    // Clear overflow queue
-    std::queue<T> emptyQueue;
-    std::swap(overflowQueue, emptyQueue);
+    // Builds a value in a free slot (or the queue) for emplace, growing as needed
+    template <typename... Args>
+    Key emplaceSlot(bool& queued, Args&&... args);
 
-    // Reset dynamic resizing structures
-    newData.clear();
-    newValid.clear();
-    newPool = KeyPool();
-    copyInProgress = false;
-    copyIndex = 0;
-}
+    // Queues a value under the queue's bound and policy (the pool is empty)
+    template <typename... Args>
+    void enqueue(Args&&... args);
 
+    // Returns true if `count` more values fit the queue without rejecting one
+    bool queueAccepts(size_t count) const;
 
+    // Admits the head of the queue after remove() freed a key, if admission is on
+    void admitAfterRemove();
 
-/* =========================================================================
-   Dynamic Resizing Management
-   =========================================================================
-   These methods control the behavior of dynamic resizing. When enabled,
-   the structure doubles in size when full and gradually copies elements
-   to a secondary structure. Once copying is complete, the new structure
-   replaces the old one.
-*/
+    // Calls fn(buffer, base, live) for the part of 64-slot block `word` each buffer owns
+    template <typename Fn>
+    void forEachBlockPart(size_t word, Fn&& fn) const;
 
-// Enables dynamic resizing for the KeyArray.
-// If not already enabled, this prepares the secondary structure for gradual copying.
-template <typename T>
-void KeyArray<T>::enableDynamicResizing() {
-    if (resizingEnabled) return;
+    // Returns the bits of slots [first, last) within the block starting at base
+    static uint64_t blockRange(size_t base, size_t first, size_t last) noexcept;
 
-    resizingEnabled = true;
+    // Returns the live slots of block `word` holding the value
+    uint64_t matchBlock(size_t word, const T& value) const;
 
-    // Start preparing new storage only if copy hasn't started yet
-    if (copyIndex == offset) {
-        int currentSize = this->lastKey + 1 - offset;
-        int newLastKey = offset + currentSize * 2 - 1;
+    // Returns the live slots of block `word` whose value satisfies pred
+    template <typename Pred>
+    uint64_t matchBlockIf(size_t word, Pred& pred) const;
 
-        newData.resize(newLastKey + 1);
-        newValid.resize(newLastKey + 1, false);
+    // Returns the lowest slot set by match(word) over all blocks, or endSlot()
+    template <typename Match>
+    size_t firstMatch(Match&& match) const;
 
-        // New pool only manages new key range beyond current lastKey
-        newPool = KeyPool(this->lastKey + 1 - offset, newLastKey - offset);
-    }
+    // Returns the number of slots set by match(word) over all blocks
+    template <typename Match>
+    size_t countMatches(Match&& match) const;
 
-    copyInProgress = true;
-}
+    // Calls fn(slot, value) for the live slots of blocks [firstWord, lastWord)
+    template <typename Fn>
+    void visitLive(size_t firstWord, size_t lastWord, Fn&& fn);
+    template <typename Fn>
+    void visitLive(size_t firstWord, size_t lastWord, Fn&& fn) const;
 
-// Disables dynamic resizing.
-// If purgeData is true, it also clears all temporary storage.
-template <typename T>
-void KeyArray<T>::disableDynamicResizing(bool purgeData) {
-    resizingEnabled = false;
+    // Returns the number of bitmap words spanning every slot
+    size_t liveWords() const noexcept;
 
-    if (purgeData) {
-        newData.clear();
-        newValid.clear();
-        newPool = KeyPool();  // reset to empty pool
-        copyInProgress = false;
-        copyIndex = 0;
-    }
-}
+    // Checkpoints if the change log asks for compaction
+    void compactIfNeeded();
 
-// Returns whether dynamic resizing is enabled
-template <typename T>
-bool KeyArray<T>::isDynamicResizingEnabled() const {
-    return resizingEnabled;
-}
+    // Writes a snapshot; returns the digest of its bytes if requested (0 otherwise)
+    template <typename Serializer>
+    uint64_t writeSnapshot(std::ostream& os, bool withDigest) const;
 
-// Performs one step of the copy process during dynamic resizing.
-// Each call copies one entry from the old structure to the new one.
-template <typename T>
-void KeyArray<T>::continueCopyStep() {
-    if (!resizingEnabled || !copyInProgress) return;
+    // Writes a snapshot next to `filename` and renames it into place; returns its digest
+    template <typename Serializer>
+    uint64_t writeSnapshotFile(const std::string& filename) const;
 
-    if (copyIndex <= this->lastKey) {
-        if (this->valid[copyIndex]) {
-            newData[copyIndex] = this->data[copyIndex];
-            newValid[copyIndex] = true;
-        }
-        ++copyIndex;
-    }
+    // Installs a prepared buffer, its bitmap and its pool in place of every
+    // value (and any resize or shrink in progress), then reports the new
+    // contents to listeners; shared by assign, assignKeyed and the loads
+    void replaceContents(SlotBuffer&& loaded, OccupancyBitmap&& bits,
+                         const BasicIntrusiveKeyPool<Order, Key>& restoredPool, size_t count);
 
-    // Mark copy as complete
-    if (copyIndex > this->lastKey) {
-        copyInProgress = false;
-    }
-}
+    // Reports replaced contents to listeners as a clear followed by inserts,
+    // and restarts the change log from a fresh base snapshot
+    void announceContents();
 
-// Replaces the current storage with the newly resized structure.
-// Only allowed after copying is completed.
-template <typename T>
-void KeyArray<T>::switchToResizedData() {
-    if (!resizingEnabled || copyInProgress) {
-        throw std::runtime_error("Cannot switch data: either resizing is not enabled or copy is not finished.");
-    }
+    // Marks every live key in the change tracker, before a clear or a load drops them
+    void markLiveChanged();
 
-    // Replace internal data arrays
-    this->data = std::move(newData);
-    this->valid = std::move(newValid);
-    this->pool = std::move(newPool);
+    // ──────────────────────────────────────────────
+    // Basic structure configuration
+    // ──────────────────────────────────────────────
 
-    // Update key range
-    this->lastKey = static_cast<int>(this->data.size()) - 1;
+    // Logical key offset – shifts all external keys by this amount internally
+    Key offset;
 
-    // Reset old copying-related fields
-    newData.clear();
-    newValid.clear();
-    newPool = KeyPool();
-    copyIndex = 0;
+    // Optional human-readable identifier for the structure
+    std::string name;
 
-    // Prepare next resize round if dynamic resizing remains enabled
-    if (resizingEnabled) {
-        int currentSize = this->lastKey + 1 - offset;
-        int newLastKey = offset + currentSize * 2 - 1;
 
-        newData.resize(newLastKey + 1);
-        newValid.resize(newLastKey + 1, false);
-        newPool = KeyPool(this->lastKey + 1 - offset, newLastKey - offset);
+    // ──────────────────────────────────────────────
+    // Dynamic resizing configuration
+    // ──────────────────────────────────────────────
 
-        copyInProgress = true;
-        copyIndex = 0;
-    }
-}
+    // Indicates whether dynamic resizing is enabled
+    bool resizingEnabled = false;
 
+    // Indicates whether slots are being migrated (from current to new arrays)
+    bool copyInProgress = false;
 
-/* =========================================================================
-   Overflow Queue Management
-   =========================================================================
+    // Migration cursor: every slot below it already lives in the new array
+    size_t copyIndex = 0;
+
+    // Number of slots migrated per insert or remove
+    size_t copyBudget = 1;
+
+    // Occupancy at which the next array is allocated
+    double resizeThreshold = 0.75;
+
+    // Larger slot storage, allocated only while a resize is in progress
+    SlotBuffer newData;
+
+    // Validity flags for the slots owned by the new array
+    OccupancyBitmap newValid;
+
+    // Indicates whether resizes copy on a helper thread
+    bool backgroundResizeEnabled = false;
+
+    // Runs background copies (a new thread per resize if empty)
+    ResizeExecutor resizeExecutor;
+
+    // Background copy in flight or waiting for its handover
+    std::unique_ptr<BackgroundCopy> background;
+
+    // Set while a mutating call holds a CopyGuard
+    bool mutating = false;
+
+#if defined(KEYARRAY_STATS)
+    // Counters and latency samples; at() samples too, hence mutable
+    mutable KeyArrayStatsRecorder statsRecorder;
+#endif
+
+
+    // ──────────────────────────────────────────────
+    // Shrinking configuration
+    // ──────────────────────────────────────────────
+
+    // Indicates whether values are being moved below the shrink target
+    bool shrinkInProgress = false;
+
+    // Capacity the shrink releases down to; the pool hands out no key at or above it
+    size_t shrinkTarget = 0;
+
+    // Every live slot in [shrinkTarget, shrinkCursor) has already been moved down
+    size_t shrinkCursor = 0;
+
+    // Remap callback of the shrink in progress
+    KeyRemap shrinkRemap;
+
+    // Highest generation of any slot a shrink released; slots that come back
+    // start there, so handles issued before the shrink stay stale
+    uint32_t generationFloor = 0;
+
+    // Indicates whether shrinks start automatically
+    bool autoShrinkEnabled = false;
+
+    // Occupancy below which an automatic shrink starts
+    double shrinkOccupancy = 0.25;
+
+    // Capacity an automatic shrink never goes below
+    size_t shrinkFloor = 64;
+
+    // Remap callback for automatic shrinks (not copied with the array, like listeners)
+    KeyRemap autoShrinkRemap;
+
+
+    // ──────────────────────────────────────────────
+    // Overflow queue configuration
+    // ──────────────────────────────────────────────
+
+    // Indicates whether the overflow queue is active
+    bool queueEnabled = false;
+
+    // Maximum number of queued values (0 = unbounded)
+    size_t queueLimit = 0;
+
+    // What a value arriving at a full bounded queue does
+    OverflowPolicy overflowPolicy = OverflowPolicy::Reject;
+
+    // Queue for holding values that couldn't be inserted due to full capacity
+    OverflowQueue overflowQueue;
+
+    // Indicates whether remove() admits the head of the queue into the freed key
+    bool admissionEnabled = false;
+
+    // Admission callback (not copied with the array, like listeners)
+    KeyAdmit admitCallback;
+
+
+    // ──────────────────────────────────────────────
+    // Mutation listeners and change log
+    // ──────────────────────────────────────────────
+
+    // Registered listeners (not owned, not copied with the array)
+    std::vector<KeyArrayListener<T, Key>*> listeners;
+
+    // Active change log, also registered in listeners
+    std::unique_ptr<KeyArrayChangeLogBase<T, Key>> changeLog;
+
+    // Base snapshot written by checkpoint()
+    std::string snapshotPath;
+
+    // Snapshot writer bound to the change log's Serializer
+    uint64_t (KeyArray::*snapshotWriter)(const std::string&) const = nullptr;
+
+    // Active value index, also registered in listeners (copied empty and rebuilt)
+    std::unique_ptr<KeyArrayIndex<T, KeyArray, Key>> index;
+
+    // Active change tracker, also registered in listeners (not copied with the array)
+    std::unique_ptr<KeyArrayDirtyTracker<T, Key>> dirtyTracker;
+
+    // When value scans use several threads
+    KeyArrayScanPolicy scanPolicy;
+
+
+};
+
+
+
+
+
+
+// ▼▼▼ Implementation of KeyArray ▼▼▼
+
+
+
+// ──────────────────────────────────────────────
+// Constructors
+// ──────────────────────────────────────────────
+
+// Default constructor with optional name
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(const std::string& name)
+    : KeyArrayBase<T, Storage, Order, Key>(), offset(0), name(name) {}
+
+
+// Constructor with maximum key value and optional name
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(Key limitKey, const std::string& name)
+    : KeyArrayBase<T, Storage, Order, Key>(limitKey), offset(0), name(name) {}
+
+
+// Constructor with two values (interpreted as offset and limit)
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(Key a, Key b, const std::string& name)
+    : KeyArrayBase<T, Storage, Order, Key>(static_cast<Key>(std::max(a, b) - std::min(a, b))), offset(std::min(a, b)), name(name) {}
+
+
+// Constructor with maximum key value and a memory resource for every buffer
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(Key limitKey, std::pmr::memory_resource* resource, const std::string& name)
+    : KeyArrayBase<T, Storage, Order, Key>(limitKey, resource), offset(0), name(name),
+      newData(0, resource), newValid(0, resource),
+      overflowQueue(resource) {}
+
+
+// Constructor with offset, limit and a memory resource for every buffer
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(Key a, Key b, std::pmr::memory_resource* resource, const std::string& name)
+    : KeyArrayBase<T, Storage, Order, Key>(static_cast<Key>(std::max(a, b) - std::min(a, b)), resource), offset(std::min(a, b)), name(name),
+      newData(0, resource), newValid(0, resource),
+      overflowQueue(resource) {}
+
+
+// Bulk constructor: starts empty and builds the whole range through assign
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename InputIt, typename>
+KeyArray<T, Storage, Order, Key>::KeyArray(InputIt first, InputIt last, const std::string& name)
+    : KeyArray(Key(0), name) {
+    assign(first, last);
+}
+
+
+// Copy constructor: the resize buffer is copied slot by slot alongside the base,
+// then the free list is re-linked across both buffers. A background copy is
+// not inherited (its helper only reads the buffer copied here).
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(const KeyArray& other)
+    : KeyArrayBase<T, Storage, Order, Key>(other, typename KeyArrayBase<T, Storage, Order, Key>::WithoutLinks{}),
+      offset(other.offset), name(other.name),
+      resizingEnabled(other.resizingEnabled), copyInProgress(other.copyInProgress),
+      copyIndex(other.copyIndex), copyBudget(other.copyBudget),
+      resizeThreshold(other.resizeThreshold), newData(other.newData.capacity(), other.getResource()),
+      newValid(other.newValid), backgroundResizeEnabled(other.backgroundResizeEnabled),
+      resizeExecutor(other.resizeExecutor), generationFloor(other.generationFloor),
+      shrinkOccupancy(other.shrinkOccupancy), shrinkFloor(other.shrinkFloor),
+      queueEnabled(other.queueEnabled), queueLimit(other.queueLimit), overflowPolicy(other.overflowPolicy),
+      overflowQueue(other.overflowQueue), scanPolicy(other.scanPolicy) {
+
+    newData.copyLive(other.newData, newValid);
+
+    SlotLinks<const KeyArray> from{&other};
+    SlotLinks<KeyArray> to{this};
+    this->pool.copyLinks(from, to);
+
+    // A pending shrink is not inherited: its keys above the target are reopened
+    if (other.shrinkInProgress) {
+        this->pool.reclaim(static_cast<Key>(this->lastKey), to, [this](Key key) { return !this->valid.test(key); });
+    }
+
+    if (other.index) {
+        index = other.index->cloneEmpty();
+        listeners.push_back(index.get());
+        buildIndex();
+    }
+}
+
+
+// Copy assignment through a temporary, so a throwing copy leaves this array intact
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>& KeyArray<T, Storage, Order, Key>::operator=(const KeyArray& other) {
+    if (this != &other) {
+        KeyArray copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+// Move constructor: a background helper of `other` is waited for before its
+// buffer moves; the finished copy comes along and is handed over here
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::KeyArray(KeyArray&& other) noexcept
+    : KeyArrayBase<T, Storage, Order, Key>(std::move(other.settledForMove())), offset(other.offset), name(std::move(other.name)),
+      resizingEnabled(other.resizingEnabled), copyInProgress(other.copyInProgress),
+      copyIndex(other.copyIndex), copyBudget(other.copyBudget),
+      resizeThreshold(other.resizeThreshold), newData(std::move(other.newData)),
+      newValid(std::move(other.newValid)), backgroundResizeEnabled(other.backgroundResizeEnabled),
+      resizeExecutor(std::move(other.resizeExecutor)), background(std::move(other.background)),
+      shrinkInProgress(other.shrinkInProgress), shrinkTarget(other.shrinkTarget),
+      shrinkCursor(other.shrinkCursor), shrinkRemap(std::move(other.shrinkRemap)),
+      generationFloor(other.generationFloor), autoShrinkEnabled(other.autoShrinkEnabled), shrinkOccupancy(other.shrinkOccupancy),
+      shrinkFloor(other.shrinkFloor), autoShrinkRemap(std::move(other.autoShrinkRemap)),
+      queueEnabled(other.queueEnabled), queueLimit(other.queueLimit), overflowPolicy(other.overflowPolicy),
+      overflowQueue(std::move(other.overflowQueue)), admissionEnabled(other.admissionEnabled),
+      admitCallback(std::move(other.admitCallback)), listeners(std::move(other.listeners)), changeLog(std::move(other.changeLog)),
+      snapshotPath(std::move(other.snapshotPath)), snapshotWriter(other.snapshotWriter),
+      index(std::move(other.index)), dirtyTracker(std::move(other.dirtyTracker)), scanPolicy(other.scanPolicy) {
+
+    other.listeners.clear();
+    other.newValid.clear();
+    other.copyInProgress = false;
+    other.copyIndex = 0;
+    other.shrinkInProgress = false;
+    other.autoShrinkEnabled = false;
+    other.admissionEnabled = false;
+    KEYARRAY_STAT(statsRecorder = other.statsRecorder;)
+}
+
+
+// Move assignment
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>& KeyArray<T, Storage, Order, Key>::operator=(KeyArray&& other) noexcept {
+    if (this != &other) {
+        cancelBackgroundResize();
+        other.settleBackgroundCopy();
+        newData.destroyLive(newValid);
+        KeyArrayBase<T, Storage, Order, Key>::operator=(std::move(other));
+
+        offset = other.offset;
+        name = std::move(other.name);
+        resizingEnabled = other.resizingEnabled;
+        copyInProgress = other.copyInProgress;
+        copyIndex = other.copyIndex;
+        copyBudget = other.copyBudget;
+        resizeThreshold = other.resizeThreshold;
+        newData = std::move(other.newData);
+        newValid = std::move(other.newValid);
+        backgroundResizeEnabled = other.backgroundResizeEnabled;
+        resizeExecutor = std::move(other.resizeExecutor);
+        background = std::move(other.background);
+        shrinkInProgress = other.shrinkInProgress;
+        shrinkTarget = other.shrinkTarget;
+        shrinkCursor = other.shrinkCursor;
+        shrinkRemap = std::move(other.shrinkRemap);
+        generationFloor = other.generationFloor;
+        autoShrinkEnabled = other.autoShrinkEnabled;
+        shrinkOccupancy = other.shrinkOccupancy;
+        shrinkFloor = other.shrinkFloor;
+        autoShrinkRemap = std::move(other.autoShrinkRemap);
+        queueEnabled = other.queueEnabled;
+        queueLimit = other.queueLimit;
+        overflowPolicy = other.overflowPolicy;
+        overflowQueue = std::move(other.overflowQueue);
+        admissionEnabled = other.admissionEnabled;
+        admitCallback = std::move(other.admitCallback);
+        listeners = std::move(other.listeners);
+        changeLog = std::move(other.changeLog);
+        snapshotPath = std::move(other.snapshotPath);
+        snapshotWriter = other.snapshotWriter;
+        index = std::move(other.index);
+        dirtyTracker = std::move(other.dirtyTracker);
+        scanPolicy = other.scanPolicy;
+        KEYARRAY_STAT(statsRecorder = other.statsRecorder;)
+
+        other.listeners.clear();
+        other.newValid.clear();
+        other.copyInProgress = false;
+        other.copyIndex = 0;
+        other.shrinkInProgress = false;
+        other.autoShrinkEnabled = false;
+        other.admissionEnabled = false;
+    }
+    return *this;
+}
+
+
+// Destructor: the base destroys the elements left in data, migrated ones are destroyed here
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>::~KeyArray() {
+    cancelBackgroundResize();
+    newData.destroyLive(newValid);
+}
+
+
+
+// ──────────────────────────────────────────────
+// Insertion
+// ──────────────────────────────────────────────
+
+// Inserts a copy of the value (see emplace)
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArray<T, Storage, Order, Key>::insert(const T& value) {
+    return emplace(value);
+}
+
+
+// Moves the value into the array (see emplace)
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArray<T, Storage, Order, Key>::insert(T&& value) {
+    return emplace(std::move(value));
+}
+
+
+// Constructs a value in place and handles overflow queue or dynamic resizing
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename... Args>
+Key KeyArray<T, Storage, Order, Key>::emplace(Args&&... args) {
+    bool queued;
+    return emplaceOrQueue(queued, std::forward<Args>(args)...);
+}
+
+// `args` may refer to a value of this array. A background copy may hand over
+// (destroying the old buffer) and an empty pool drains a pending resize
+// before the slot is known, so in those cases the value is built first and
+// moved in; otherwise it is constructed exactly once, in its slot.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename... Args>
+Key KeyArray<T, Storage, Order, Key>::emplaceOrQueue(bool& queued, Args&&... args) {
+    KEYARRAY_STAT(auto sampled = statsRecorder.sample(statsRecorder.totals.insertLatency);)
+    if constexpr (std::is_move_constructible_v<T>) {
+        if (!mutating && (background || (copyInProgress && this->pool.empty()))) {
+            T value(std::forward<Args>(args)...);
+            return emplaceSlot(queued, std::move(value));
+        }
+    }
+    return emplaceSlot(queued, std::forward<Args>(args)...);
+}
+
+// A pending resize or shrink advances by one copy budget only after the value
+// is built, since `args` may refer to a value that step moves; if the step
+// throws, the new element is taken out again and the array is left without it.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename... Args>
+Key KeyArray<T, Storage, Order, Key>::emplaceSlot(bool& queued, Args&&... args) {
+    CopyGuard guard(*this);
+    queued = false;
+
+    // Holes below the shrink target ran out: the slots above it are needed again
+    if (shrinkInProgress && this->pool.empty()) {
+        cancelShrink();
+    }
+
+    if (this->pool.empty()) {
+        if (resizingEnabled) {
+            // Only reached with a threshold of 1, a budget changed mid-resize,
+            // or a background copy that has not caught up
+            KEYARRAY_STAT(if (isResizeInProgress()) ++statsRecorder.totals.forcedDrains;)
+            finishResize();
+            if (this->pool.empty()) startResize();
+        } else if (queueEnabled) {
+            enqueue(std::forward<Args>(args)...);
+            queued = true;
+            return Queued; // indicator that value was added to queue
+        } else {
+            throw std::runtime_error("KeyPool is empty. No available keys.");
+        }
+    } else {
+        maybeStartResize(1);
+    }
+
+    SlotLinks<KeyArray> links{this};
+    KEYARRAY_STAT(++(this->pool.hasRecycled() ? statsRecorder.totals.recycledKeys : statsRecorder.totals.freshKeys);)
+    Key actualKey = this->pool.pop(links);
+    try {
+        bufferOf(actualKey).construct(actualKey, std::forward<Args>(args)...);
+    } catch (...) {
+        this->pool.push(actualKey, links);
+        throw;
+    }
+    touchSlot(actualKey);
+    bitsOf(actualKey).set(actualKey);
+    ++this->elementCount;
+
+    // The new key lies below any shrink target, so compaction never moves it;
+    // a shrink whose free keys ran out is cancelled there
+    try {
+        migrateSlots(copyBudget);
+        compactSlots(copyBudget);
+    } catch (...) {
+        bufferOf(actualKey).destroy(actualKey);
+        touchSlot(actualKey);
+        bitsOf(actualKey).reset(actualKey);
+        --this->elementCount;
+        this->pool.push(actualKey, links);
+        throw;
+    }
+
+    Key key = keyOf(actualKey);
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onInsert(key, bufferOf(actualKey)[actualKey]); });
+    return key;
+}
+
+
+
+// ──────────────────────────────────────────────
+// Removal
+// ──────────────────────────────────────────────
+
+// Removes and destroys an element by key, adjusted for offset
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::remove(Key key) {
+    KEYARRAY_STAT(auto sampled = statsRecorder.sample(statsRecorder.totals.removeLatency);)
+    CopyGuard guard(*this);
+    size_t actualKey = slotOf(key);
+    if (!isLiveSlot(actualKey)) {
+        throw std::out_of_range("Key is not valid or not in use");
+    }
+
+    migrateSlots(copyBudget);
+    eraseSlot(actualKey);
+    admitAfterRemove();
+    compactSlots(copyBudget);
+    maybeStartShrink();
+}
+
+
+// Destroys the value in whichever buffer holds it and links the key back
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::eraseSlot(size_t index) {
+    // Listeners see the value before it goes; compaction waits for the removal
+    for (KeyArrayListener<T, Key>* listener : listeners) {
+        listener->onRemove(keyOf(index), bufferOf(index)[index]);
+    }
+
+    bufferOf(index).destroy(index);
+    touchSlot(index);
+    bitsOf(index).reset(index);
+    --this->elementCount;
+
+    SlotLinks<KeyArray> links{this};
+    this->pool.push(static_cast<Key>(index), links);
+
+    compactIfNeeded();
+}
+
+
+
+// ──────────────────────────────────────────────
+// Batch Insertion and Removal
+// ──────────────────────────────────────────────
+
+// Inserts a whole range. For forward iterators the free keys are counted once
+// and, if they do not suffice, the array grows at most once for the whole
+// batch. A pending resize or shrink advances by one copy budget per value,
+// after every value is built, so that step never moves a value the range
+// still refers to (growing for the batch does move values first); if the
+// step throws, the values stay inserted under the keys already written. Recycled keys are used first, then one contiguous run is
+// reserved from the pool and its validity bits are set a word at a time.
+// Values that still do not fit go to the overflow queue (if enabled) with
+// key Queued; a rejecting bounded queue that cannot take them all fails the batch
+// before anything is inserted. Single-pass input iterators fall back to one emplace per value.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename InputIt, typename OutputIt>
+OutputIt KeyArray<T, Storage, Order, Key>::insertBatch(InputIt first, InputIt last, OutputIt outKeys) {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        for (; first != last; ++first) {
+            *outKeys++ = emplace(*first);
+        }
+        return outKeys;
+    } else {
+        CopyGuard guard(*this);
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        if (shrinkInProgress && count > this->pool.available()) {
+            cancelShrink();
+        }
+        if (count > this->pool.available()) {
+            if (resizingEnabled) {
+                KEYARRAY_STAT(if (isResizeInProgress()) ++statsRecorder.totals.forcedDrains;)
+                growTo(this->elementCount + count);
+            } else if (!queueEnabled) {
+                throw std::runtime_error("KeyPool is empty. No available keys.");
+            } else if (!queueAccepts(count - this->pool.available())) {
+                throw std::runtime_error("Overflow queue is full.");
+            }
+        } else {
+            maybeStartResize(count);
+        }
+
+        // Recycled keys first, so the array stays dense
+        SlotLinks<KeyArray> links{this};
+        while (first != last && this->pool.hasRecycled()) {
+            Key key = this->pool.pop(links);
+            try {
+                bufferOf(key).construct(key, *first);
+            } catch (...) {
+                this->pool.push(key, links);
+                throw;
+            }
+            touchSlot(key);
+            bitsOf(key).set(key);
+            ++this->elementCount;
+            KEYARRAY_STAT(++statsRecorder.totals.recycledKeys;)
+            *outKeys++ = keyOf(key);
+            ++first;
+            notify([&](KeyArrayListener<T, Key>& listener) { listener.onInsert(keyOf(key), bufferOf(key)[key]); });
+        }
+
+        // Then one contiguous run from the bump range
+        Key runKey = 0;
+        size_t run = this->pool.reserveRun(static_cast<size_t>(std::distance(first, last)), runKey);
+        size_t runStart = static_cast<size_t>(runKey);
+        size_t built = 0;
+        try {
+            for (; built < run; ++built, ++first) {
+                bufferOf(runStart + built).construct(runStart + built, *first);
+                touchSlot(runStart + built);
+                *outKeys++ = keyOf(runStart + built);
+            }
+        } catch (...) {
+            // Keep what was built, hand the rest of the run back to the pool
+            setLiveRange(runStart, runStart + built);
+            this->elementCount += built;
+            for (size_t slot = runStart + run; slot-- > runStart + built;) {
+                this->pool.push(static_cast<Key>(slot), links);
+            }
+            notifyRunInserted(runStart, runStart + built);
+            throw;
+        }
+        setLiveRange(runStart, runStart + run);
+        this->elementCount += run;
+        KEYARRAY_STAT(statsRecorder.totals.freshKeys += static_cast<uint64_t>(run);)
+        notifyRunInserted(runStart, runStart + run);
+
+        // Whatever is left overflows into the queue
+        for (; first != last; ++first) {
+            enqueue(*first);
+            *outKeys++ = Queued;
+        }
+
+        // Only now, since the range may refer to values these steps move
+        constexpr size_t AllSlots = std::numeric_limits<size_t>::max();
+        size_t steps = std::max<size_t>(count, 1);
+        migrateSlots(copyBudget > AllSlots / steps ? AllSlots : copyBudget * steps);
+        compactSlots(copyBudget > AllSlots / steps ? AllSlots : copyBudget * steps);
+        return outKeys;
+    }
+}
+
+
+// Removes a range of keys, stopping with std::out_of_range at the first key
+// that is not in use (keys before it stay removed). A shrink only moves values
+// once the whole batch is gone, so no key of the batch changes under it.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename InputIt>
+void KeyArray<T, Storage, Order, Key>::removeBatch(InputIt first, InputIt last) {
+    CopyGuard guard(*this);
+    size_t removed = 0;
+    for (; first != last; ++first, ++removed) {
+        size_t index = slotOf(*first);
+        if (!isLiveSlot(index)) {
+            throw std::out_of_range("Invalid key in KeyArray batch");
+        }
+
+        migrateSlots(copyBudget);
+        eraseSlot(index);
+        admitAfterRemove();
+    }
+
+    constexpr size_t AllSlots = std::numeric_limits<size_t>::max();
+    size_t steps = std::max<size_t>(removed, 1);
+    compactSlots(copyBudget > AllSlots / steps ? AllSlots : copyBudget * steps);
+    maybeStartShrink();
+}
+
+
+// Removes every key held by a container
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename KeyRange>
+void KeyArray<T, Storage, Order, Key>::removeBatch(const KeyRange& keys) {
+    removeBatch(std::begin(keys), std::end(keys));
+}
+
+
+// Removes every key of a braced list
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::removeBatch(std::initializer_list<Key> keys) {
+    removeBatch(keys.begin(), keys.end());
+}
+
+// Values are built aside in key order into a buffer of max(capacity, n) slots,
+// so a throwing value leaves the array unchanged; keys past n stay in the bump
+// range. Single-pass input is buffered first to learn its length.
+// Throws std::length_error if n exceeds the keys the key type can name.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename InputIt>
+void KeyArray<T, Storage, Order, Key>::assign(InputIt first, InputIt last) {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        std::vector<T> buffered(first, last);
+        assign(std::make_move_iterator(buffered.begin()), std::make_move_iterator(buffered.end()));
+    } else {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        size_t capacity = cappedCapacity(std::max(count, static_cast<size_t>(this->lastKey + 1)), count);
+
+        SlotBuffer loaded(capacity, getResource());
+        OccupancyBitmap bits(capacity, getResource());
+        size_t built = 0;
+        try {
+            for (; built < count; ++built, ++first) {
+                loaded.construct(built, *first);
+            }
+        } catch (...) {
+            for (size_t j = 0; j < built; ++j) loaded.destroy(j);
+            throw;
+        }
+        bits.setRange(0, count);
+
+        BasicIntrusiveKeyPool<Order, Key> restoredPool = this->poolUpTo(-1);
+        try {
+            if (capacity > 0) restoredPool.rebuild(bits, static_cast<Key>(capacity - 1), loaded);
+        } catch (...) {
+            loaded.destroyLive(bits);
+            throw;
+        }
+        replaceContents(std::move(loaded), std::move(bits), restoredPool, count);
+        announceContents();
+    }
+}
+
+// A first pass validates the keys and sizes the buffer, a second builds the
+// values; the pool then comes from one sweep of the bitmap, so the free keys
+// pop lowest first.
+// Throws std::out_of_range for a key outside [offset, offset + maxCapacity())
+// and std::invalid_argument for a repeated key; the array is then unchanged.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename InputIt>
+void KeyArray<T, Storage, Order, Key>::assignKeyed(InputIt first, InputIt last) {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        std::vector<typename std::iterator_traits<InputIt>::value_type> buffered(first, last);
+        assignKeyed(std::make_move_iterator(buffered.begin()), std::make_move_iterator(buffered.end()));
+    } else {
+        size_t needed = 0;
+        for (InputIt it = first; it != last; ++it) {
+            size_t slot = slotOf(static_cast<Key>((*it).first));
+            if (slot >= maxCapacity()) {
+                throw std::out_of_range("Key is outside the key range");
+            }
+            needed = std::max(needed, slot + 1);
+        }
+        size_t capacity = std::max(needed, static_cast<size_t>(this->lastKey + 1));
+
+        SlotBuffer loaded(capacity, getResource());
+        OccupancyBitmap bits(capacity, getResource());
+        size_t count = 0;
+        BasicIntrusiveKeyPool<Order, Key> restoredPool = this->poolUpTo(-1);
+        try {
+            for (; first != last; ++first, ++count) {
+                auto&& entry = *first;
+                size_t slot = slotOf(static_cast<Key>(entry.first));
+                if (bits.test(slot)) {
+                    throw std::invalid_argument("Duplicate key in assignKeyed");
+                }
+                loaded.construct(slot, std::forward<decltype(entry)>(entry).second);
+                bits.set(slot);
+            }
+            if (capacity > 0) restoredPool.rebuild(bits, static_cast<Key>(capacity - 1), loaded);
+        } catch (...) {
+            loaded.destroyLive(bits);
+            throw;
+        }
+        replaceContents(std::move(loaded), std::move(bits), restoredPool, count);
+        announceContents();
+    }
+}
+
+
+
+// ──────────────────────────────────────────────
+// Key and Value Lookup
+// ──────────────────────────────────────────────
+
+// Checks if a specific key is currently active
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::hasKey(Key key) const {
+    return isLiveSlot(slotOf(key));
+}
+
+
+// Checks if the given value exists in the structure, in both buffers while resizing;
+// one hash probe instead of the scan when an index is active
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::contains(const T& value) const {
+    if (index) return index->find(value, *this).has_value();
+
+    return firstMatch([&](size_t word) { return matchBlock(word, value); }) < endSlot();
+}
+
+
+
+// ──────────────────────────────────────────────
+// Element Access
+// ──────────────────────────────────────────────
+
+// Access element by key (non-const version); range and validity are checked once
+template <typename T, typename Storage, typename Order, typename Key>
+T& KeyArray<T, Storage, Order, Key>::at(Key key) {
+    KEYARRAY_STAT(auto sampled = statsRecorder.sample(statsRecorder.totals.atLatency);)
+    size_t index = slotOf(key);
+    if (!isLiveSlot(index))
+        throw std::out_of_range("Invalid key in KeyArray");
+    return bufferOf(index)[index];
+}
+
+
+// Access element by key (const version); range and validity are checked once
+template <typename T, typename Storage, typename Order, typename Key>
+const T& KeyArray<T, Storage, Order, Key>::at(Key key) const {
+    KEYARRAY_STAT(auto sampled = statsRecorder.sample(statsRecorder.totals.atLatency);)
+    size_t index = slotOf(key);
+    if (!isLiveSlot(index))
+        throw std::out_of_range("Invalid key in KeyArray");
+    return bufferOf(index)[index];
+}
+
+
+// Unchecked access (non-const version)
+template <typename T, typename Storage, typename Order, typename Key>
+T& KeyArray<T, Storage, Order, Key>::operator[](Key key) noexcept {
+    size_t index = slotOf(key);
+    return bufferOf(index)[index];
+}
+
+
+// Unchecked access (const version)
+template <typename T, typename Storage, typename Order, typename Key>
+const T& KeyArray<T, Storage, Order, Key>::operator[](Key key) const noexcept {
+    size_t index = slotOf(key);
+    return bufferOf(index)[index];
+}
+
+
+// Unchecked access (non-const version)
+template <typename T, typename Storage, typename Order, typename Key>
+T& KeyArray<T, Storage, Order, Key>::at_unchecked(Key key) noexcept {
+    size_t index = slotOf(key);
+    return bufferOf(index)[index];
+}
+
+
+// Unchecked access (const version)
+template <typename T, typename Storage, typename Order, typename Key>
+const T& KeyArray<T, Storage, Order, Key>::at_unchecked(Key key) const noexcept {
+    size_t index = slotOf(key);
+    return bufferOf(index)[index];
+}
+
+
+// Checked access without exceptions (non-const version)
+template <typename T, typename Storage, typename Order, typename Key>
+T* KeyArray<T, Storage, Order, Key>::try_get(Key key) noexcept {
+    size_t index = slotOf(key);
+    return isLiveSlot(index) ? &bufferOf(index)[index] : nullptr;
+}
+
+
+// Checked access without exceptions (const version)
+template <typename T, typename Storage, typename Order, typename Key>
+const T* KeyArray<T, Storage, Order, Key>::try_get(Key key) const noexcept {
+    size_t index = slotOf(key);
+    return isLiveSlot(index) ? &bufferOf(index)[index] : nullptr;
+}
+
+
+// Unsigned subtraction wraps instead of overflowing
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::slotOf(Key key) const noexcept {
+    return KeyTraits<Key>::slotOf(key, offset);
+}
+
+
+// Every slot index is below maxCapacity(), so the sum is a valid key
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArray<T, Storage, Order, Key>::keyOf(size_t index) const noexcept {
+    return static_cast<Key>(static_cast<Key>(index) + offset);
+}
+
+
+// Both the slot index (a pool key) and offset + slot must stay at or below MaxKey
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::maxCapacity() const noexcept {
+    return std::min(KeyTraits<Key>::keysFrom(offset), KeyTraits<Key>::keysFrom(0));
+}
+
+
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::cappedCapacity(size_t wanted, size_t needed) const {
+    size_t limit = maxCapacity();
+    if (needed > limit) {
+        throw std::length_error("KeyArray cannot grow beyond its key type");
+    }
+    return std::min(wanted, limit);
+}
+
+
+// Slots in [copyIndex, old capacity) are still in data. When no resize is in
+// progress copyIndex is 0, so this is the plain range check against data.
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::inOldBuffer(size_t index) const noexcept {
+    return index - copyIndex < this->valid.size() - copyIndex;
+}
+
+
+// Selects data or newData by slot ownership (non-const version)
+template <typename T, typename Storage, typename Order, typename Key>
+typename KeyArray<T, Storage, Order, Key>::SlotBuffer& KeyArray<T, Storage, Order, Key>::bufferOf(size_t index) noexcept {
+    return inOldBuffer(index) ? this->data : newData;
+}
+
+
+// Selects data or newData by slot ownership (const version)
+template <typename T, typename Storage, typename Order, typename Key>
+const typename KeyArray<T, Storage, Order, Key>::SlotBuffer& KeyArray<T, Storage, Order, Key>::bufferOf(size_t index) const noexcept {
+    return inOldBuffer(index) ? this->data : newData;
+}
+
+
+// Selects valid or newValid by slot ownership
+template <typename T, typename Storage, typename Order, typename Key>
+OccupancyBitmap& KeyArray<T, Storage, Order, Key>::bitsOf(size_t index) noexcept {
+    return inOldBuffer(index) ? this->valid : newValid;
+}
+
+
+// Out-of-range indices fall through to newValid, which is empty when idle
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isLiveSlot(size_t index) const noexcept {
+    if (inOldBuffer(index)) return this->valid.test(index);
+    return index < newValid.size() && newValid.test(index);
+}
+
+
+// Splits the range at the copy cursor and at the old capacity; when idle both
+// outer parts are empty and this is a single setRange on valid
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::setLiveRange(size_t first, size_t last) {
+    size_t oldCapacity = this->valid.size();
+    newValid.setRange(first, std::min(last, copyIndex));
+    this->valid.setRange(std::max(first, copyIndex), std::min(last, oldCapacity));
+    newValid.setRange(std::max(first, oldCapacity), last);
+}
+
+
+// Walks the migrated prefix, then the old buffer, then the grown tail
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::nextLive(size_t from) const noexcept {
+    if (from < copyIndex) {
+        size_t index = newValid.findNext(from);
+        if (index < copyIndex) return index;
+        from = copyIndex;
+    }
+
+    size_t index = this->valid.findNext(from);
+    if (index < this->valid.size() || !copyInProgress) return index;
+    return newValid.findNext(std::max(from, this->valid.size()));
+}
+
+
+// The bound of the largest buffer in use
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::endSlot() const noexcept {
+    return copyInProgress ? newValid.size() : this->valid.size();
+}
+
+
+
+// ──────────────────────────────────────────────
+// Clear
+// ──────────────────────────────────────────────
+
+// Clears all data and resets queues and dynamic resizing. A pending resize
+// needs no further copying once empty: the larger buffer simply takes over.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::clear() {
+    cancelBackgroundResize();
+    markLiveChanged();
+
+    // Live slots end at the pool's bump cursor, except while a shrink still
+    // has values above its target
+    size_t used = shrinkInProgress ? this->data.capacity() : static_cast<size_t>(this->pool.getCurrentValue());
+
+    // Adopt the resize buffer, keeping every slot's generation
+    if (copyInProgress) {
+        newData.destroyLive(newValid, used);
+        newValid.clearBelow(used);
+        this->data.destroyLive(this->valid, used);
+        this->valid.clearBelow(used);
+        newData.copyGenerations(this->data, copyIndex, this->data.capacity());
+
+        this->data = std::move(newData);
+        this->valid = std::move(newValid);
+        newData = SlotBuffer(0, getResource());
+        newValid.clear();
+        copyInProgress = false;
+        copyIndex = 0;
+    }
+
+    // Nothing is left to move; the pool reopens the whole capacity
+    shrinkInProgress = false;
+    shrinkRemap = nullptr;
+
+    // Clear base structure, touching only the slots in use
+    this->clearSlots(used);
+
+    // Clear overflow queue
+    clearQueue();
+
+    notify([](KeyArrayListener<T, Key>& listener) { listener.onClear(); });
+}
+
+
+
+/* =========================================================================
+   Tracked Updates & Change Log
+   =========================================================================
+   Every mutation is reported to the registered KeyArrayListeners. Writes
+   through at() or operator[] are invisible to the array, so they are
+   reported with markUpdated(), or made through modify()/update().
+
+   The change log is such a listener: it appends one record per mutation to
+   a buffered log (group commit), so persisting costs O(changes). checkpoint()
+   compacts by writing a new base snapshot and restarting the log; it also
+   runs automatically once the log outgrows KeyArrayLogPolicy::compactBytes.
+   The log names its base snapshot by digest, and snapshots are renamed into
+   place, so a crash between the two steps never replays a log twice.
+*/
+
+// Applies fn to the value in place, then reports it.
+// Throws std::out_of_range if the key is not in use.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::modify(Key key, Fn&& fn) {
+    CopyGuard guard(*this);
+    T& value = at(key);
+    std::forward<Fn>(fn)(value);
+    touchSlot(slotOf(key));
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onUpdate(key, value); });
+}
+
+// Copy-assigns a new value and reports it
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::update(Key key, const T& value) {
+    CopyGuard guard(*this);
+    T& target = at(key);
+    target = value;
+    touchSlot(slotOf(key));
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onUpdate(key, target); });
+}
+
+// Move-assigns a new value and reports it
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::update(Key key, T&& value) {
+    CopyGuard guard(*this);
+    T& target = at(key);
+    target = std::move(value);
+    touchSlot(slotOf(key));
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onUpdate(key, target); });
+}
+
+// Reports the current value of a key as updated
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::markUpdated(Key key) {
+    CopyGuard guard(*this);
+    const T& value = at(key);
+    touchSlot(slotOf(key));
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onUpdate(key, value); });
+}
+
+// The reference is built in place (guaranteed elision), so WriteRef needs no move.
+// Throws std::out_of_range if the key is not in use.
+template <typename T, typename Storage, typename Order, typename Key>
+typename KeyArray<T, Storage, Order, Key>::WriteRef KeyArray<T, Storage, Order, Key>::write(Key key) {
+    return WriteRef(*this, key);
+}
+
+// Adds a listener (registering the same listener twice reports twice)
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::addListener(KeyArrayListener<T, Key>* listener) {
+    listeners.push_back(listener);
+}
+
+// Removes every registration of a listener
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::removeListener(KeyArrayListener<T, Key>* listener) {
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+// Replaces any active log; the base snapshot is written first so the new
+// log starts from the current contents
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+void KeyArray<T, Storage, Order, Key>::enableChangeLog(const std::string& snapshotFile, const std::string& logFile,
+                                           const KeyArrayLogPolicy& policy) {
+    disableChangeLog();
+    finishShrink();
+
+    uint64_t digest = writeSnapshotFile<Serializer>(snapshotFile);
+    changeLog = std::make_unique<KeyArrayChangeLog<T, Serializer, Key>>(logFile, digest, policy);
+    snapshotPath = snapshotFile;
+    snapshotWriter = &KeyArray::writeSnapshotFile<Serializer>;
+    listeners.push_back(changeLog.get());
+}
+
+// Commits pending records and detaches the log
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableChangeLog() {
+    if (!changeLog) return;
+
+    removeListener(changeLog.get());
+    changeLog->commit();
+    changeLog.reset();
+    snapshotPath.clear();
+    snapshotWriter = nullptr;
+}
+
+// Returns whether a change log is active
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isChangeLogEnabled() const {
+    return changeLog != nullptr;
+}
+
+// Group-commits the buffered records now
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::commitChangeLog() {
+    if (changeLog) changeLog->commit();
+}
+
+// Buffered records are dropped: the new snapshot already contains them.
+// Throws std::runtime_error if no change log is active.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::checkpoint() {
+    if (!changeLog) {
+        throw std::runtime_error("Cannot checkpoint: change log is not enabled.");
+    }
+    changeLog->restart((this->*snapshotWriter)(snapshotPath));
+}
+
+// Replaces any active index
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Hash, typename Equal>
+void KeyArray<T, Storage, Order, Key>::enableIndex(const Hash& hash, const Equal& equal) {
+    disableIndex();
+
+    index = std::make_unique<KeyArrayHashIndex<T, KeyArray, Hash, Equal, Key>>(hash, equal);
+    listeners.push_back(index.get());
+    buildIndex();
+}
+
+// Detaches and frees the index
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableIndex() {
+    if (!index) return;
+
+    removeListener(index.get());
+    index.reset();
+}
+
+// Returns whether a value index is active
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isIndexEnabled() const {
+    return index != nullptr;
+}
+
+// Without an index, scans both buffers like contains and returns the lowest key
+template <typename T, typename Storage, typename Order, typename Key>
+std::optional<Key> KeyArray<T, Storage, Order, Key>::find(const T& value) const {
+    if (index) return index->find(value, *this);
+
+    size_t slot = firstMatch([&](size_t word) { return matchBlock(word, value); });
+    if (slot >= endSlot()) return std::nullopt;
+    return keyOf(slot);
+}
+
+// ──────────────────────────────────────────────
+// Value Scans
+// ──────────────────────────────────────────────
+
+// Counts a block's matches with one popcount
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::count(const T& value) const {
+    return countMatches([&](size_t word) { return matchBlock(word, value); });
+}
+
+// Parallel scans still return the lowest matching key
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Pred>
+std::optional<Key> KeyArray<T, Storage, Order, Key>::find_if(Pred pred) const {
+    size_t slot = firstMatch([&](size_t word) { return matchBlockIf(word, pred); });
+    if (slot >= endSlot()) return std::nullopt;
+    return keyOf(slot);
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Pred>
+size_t KeyArray<T, Storage, Order, Key>::count_if(Pred pred) const {
+    return countMatches([&](size_t word) { return matchBlockIf(word, pred); });
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::setScanPolicy(const KeyArrayScanPolicy& policy) {
+    scanPolicy = policy;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+const KeyArrayScanPolicy& KeyArray<T, Storage, Order, Key>::getScanPolicy() const {
+    return scanPolicy;
+}
+
+// While resizing, a block can be split at copyIndex (below it the slots live in
+// newData) and at the old capacity (from there on only newData has slots)
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::forEachBlockPart(size_t word, Fn&& fn) const {
+    size_t base = word * OccupancyBitmap::WordBits;
+    uint64_t oldOwned = copyInProgress ? blockRange(base, copyIndex, this->valid.size()) : ~uint64_t(0);
+
+    if (word < this->valid.wordCount()) {
+        uint64_t live = this->valid.word(word) & oldOwned;
+        if (live) fn(this->data, base, live);
+    }
+    if (copyInProgress && word < newValid.wordCount()) {
+        uint64_t live = newValid.word(word) & ~oldOwned;
+        if (live) fn(newData, base, live);
+    }
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+uint64_t KeyArray<T, Storage, Order, Key>::blockRange(size_t base, size_t first, size_t last) noexcept {
+    size_t end = base + OccupancyBitmap::WordBits;
+    size_t low = std::min(std::max(first, base), end) - base;
+    size_t high = std::min(std::max(last, base), end) - base;
+    if (low >= high) return 0;
+
+    uint64_t below = high == OccupancyBitmap::WordBits ? ~uint64_t(0) : (uint64_t(1) << high) - 1;
+    return below & ~((uint64_t(1) << low) - 1);
+}
+
+// Plain runs of arithmetic values go through the vector kernel, dead slots
+// included, and the live bits mask the result; anything else is compared
+// slot by slot over the live bits only
+template <typename T, typename Storage, typename Order, typename Key>
+uint64_t KeyArray<T, Storage, Order, Key>::matchBlock(size_t word, const T& value) const {
+    uint64_t found = 0;
+    forEachBlockPart(word, [&](const SlotBuffer& buffer, size_t base, uint64_t live) {
+        if constexpr (KeyArrayScan::Vectorized<T>) {
+            size_t run = std::min(OccupancyBitmap::WordBits, buffer.capacity() - base);
+            if (const T* values = buffer.valueRun(base, run)) {
+                found |= KeyArrayScan::matchEqual(values, run, value) & live;
+                return;
+            }
+        }
+        for (; live; live &= live - 1) {
+            unsigned bit = OccupancyBitmap::countTrailingZeros(live);
+            if (buffer[base + bit] == value) found |= uint64_t(1) << bit;
+        }
+    });
+    return found;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Pred>
+uint64_t KeyArray<T, Storage, Order, Key>::matchBlockIf(size_t word, Pred& pred) const {
+    uint64_t found = 0;
+    forEachBlockPart(word, [&](const SlotBuffer& buffer, size_t base, uint64_t live) {
+        for (; live; live &= live - 1) {
+            unsigned bit = OccupancyBitmap::countTrailingZeros(live);
+            if (pred(static_cast<const T&>(buffer[base + bit]))) found |= uint64_t(1) << bit;
+        }
+    });
+    return found;
+}
+
+// Threads skip whatever lies past the best match found so far
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Match>
+size_t KeyArray<T, Storage, Order, Key>::firstMatch(Match&& match) const {
+    size_t end = endSlot();
+    size_t words = (end + OccupancyBitmap::WordBits - 1) / OccupancyBitmap::WordBits;
+    unsigned threads = KeyArrayScan::threadsFor(end, scanPolicy);
+
+    if (threads <= 1) {
+        for (size_t word = 0; word < words; ++word) {
+            if (uint64_t found = match(word)) {
+                return word * OccupancyBitmap::WordBits + OccupancyBitmap::countTrailingZeros(found);
+            }
+        }
+        return end;
+    }
+
+    std::atomic<size_t> best{ end };
+    KeyArrayScan::parallelChunks(words, threads, [&](unsigned, size_t first, size_t last) {
+        for (size_t word = first; word < last; ++word) {
+            size_t base = word * OccupancyBitmap::WordBits;
+            size_t current = best.load(std::memory_order_relaxed);
+            if (base >= current) return;
+
+            if (uint64_t found = match(word)) {
+                size_t slot = base + OccupancyBitmap::countTrailingZeros(found);
+                while (slot < current && !best.compare_exchange_weak(current, slot, std::memory_order_relaxed)) {}
+                return;
+            }
+        }
+    });
+    return best.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Match>
+size_t KeyArray<T, Storage, Order, Key>::countMatches(Match&& match) const {
+    size_t end = endSlot();
+    size_t words = (end + OccupancyBitmap::WordBits - 1) / OccupancyBitmap::WordBits;
+    unsigned threads = KeyArrayScan::threadsFor(end, scanPolicy);
+
+    if (threads <= 1) {
+        size_t total = 0;
+        for (size_t word = 0; word < words; ++word) {
+            total += OccupancyBitmap::popCount(match(word));
+        }
+        return total;
+    }
+
+    std::vector<size_t> totals(threads, 0);
+    KeyArrayScan::parallelChunks(words, threads, [&](unsigned chunk, size_t first, size_t last) {
+        size_t total = 0;
+        for (size_t word = first; word < last; ++word) {
+            total += OccupancyBitmap::popCount(match(word));
+        }
+        totals[chunk] = total;
+    });
+
+    size_t total = 0;
+    for (size_t part : totals) total += part;
+    return total;
+}
+
+// ──────────────────────────────────────────────
+// Bulk Traversal
+// ──────────────────────────────────────────────
+
+// Values may be written, so a background copy is finished first
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::forEachLive(Fn&& fn) {
+    awaitBackgroundResize();
+    visitLive(0, liveWords(), [&](size_t slot, T& value) { fn(keyOf(slot), value); });
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::forEachLive(Fn&& fn) const {
+    visitLive(0, liveWords(), [&](size_t slot, const T& value) { fn(keyOf(slot), value); });
+}
+
+// Chunks never share a bitmap line, and writes go to values only, so threads
+// touching neighbouring chunks do not contend
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Executor, typename Fn>
+void KeyArray<T, Storage, Order, Key>::parallelForEachLive(Executor&& executor, Fn&& fn) {
+    awaitBackgroundResize();
+    KeyArrayScan::executeChunks(std::forward<Executor>(executor), liveWords(), KeyArrayScan::threadsOf(scanPolicy),
+                                [&](unsigned, size_t first, size_t last) {
+        visitLive(first, last, [&](size_t slot, T& value) { fn(keyOf(slot), value); });
+    });
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Executor, typename Fn>
+void KeyArray<T, Storage, Order, Key>::parallelForEachLive(Executor&& executor, Fn&& fn) const {
+    KeyArrayScan::executeChunks(std::forward<Executor>(executor), liveWords(), KeyArrayScan::threadsOf(scanPolicy),
+                                [&](unsigned, size_t first, size_t last) {
+        visitLive(first, last, [&](size_t slot, const T& value) { fn(keyOf(slot), value); });
+    });
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename R, typename Map, typename Combine>
+R KeyArray<T, Storage, Order, Key>::reduceLive(R init, Map&& map, Combine&& combine) const {
+    visitLive(0, liveWords(), [&](size_t slot, const T& value) {
+        init = combine(std::move(init), map(keyOf(slot), value));
+    });
+    return init;
+}
+
+// A chunk starts from its first mapped value, so combine needs no identity
+// element; empty chunks contribute nothing
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Executor, typename R, typename Map, typename Combine>
+R KeyArray<T, Storage, Order, Key>::parallelReduceLive(Executor&& executor, R init, Map&& map, Combine&& combine) const {
+    unsigned threads = KeyArrayScan::threadsOf(scanPolicy);
+    std::vector<std::optional<R>> partials(threads);
+    KeyArrayScan::executeChunks(std::forward<Executor>(executor), liveWords(), threads,
+                                [&](unsigned chunk, size_t first, size_t last) {
+        std::optional<R>& partial = partials[chunk];
+        visitLive(first, last, [&](size_t slot, const T& value) {
+            if (partial) {
+                partial = combine(std::move(*partial), map(keyOf(slot), value));
+            } else {
+                partial.emplace(map(keyOf(slot), value));
+            }
+        });
+    });
+
+    for (std::optional<R>& partial : partials) {
+        if (partial) init = combine(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+// The parts of a block are merged first: during a resize the migrated slots
+// of a block lie below the ones still in data, so keys stay in ascending order
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::visitLive(size_t firstWord, size_t lastWord, Fn&& fn) {
+    for (size_t word = firstWord; word < lastWord; ++word) {
+        uint64_t live = 0;
+        forEachBlockPart(word, [&](const SlotBuffer&, size_t, uint64_t part) { live |= part; });
+        for (size_t base = word * OccupancyBitmap::WordBits; live; live &= live - 1) {
+            size_t slot = base + OccupancyBitmap::countTrailingZeros(live);
+            fn(slot, bufferOf(slot)[slot]);
+        }
+    }
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::visitLive(size_t firstWord, size_t lastWord, Fn&& fn) const {
+    for (size_t word = firstWord; word < lastWord; ++word) {
+        uint64_t live = 0;
+        forEachBlockPart(word, [&](const SlotBuffer&, size_t, uint64_t part) { live |= part; });
+        for (size_t base = word * OccupancyBitmap::WordBits; live; live &= live - 1) {
+            size_t slot = base + OccupancyBitmap::countTrailingZeros(live);
+            fn(slot, bufferOf(slot)[slot]);
+        }
+    }
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::liveWords() const noexcept {
+    return (endSlot() + OccupancyBitmap::WordBits - 1) / OccupancyBitmap::WordBits;
+}
+
+// Covers both buffers of a resize in progress
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::buildIndex() {
+    for (size_t i = nextLive(0); i < endSlot(); i = nextLive(i + 1)) {
+        index->onInsert(keyOf(i), bufferOf(i)[i]);
+    }
+}
+
+// Any active log is committed and detached first, so replayed records are
+// not logged again
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+size_t KeyArray<T, Storage, Order, Key>::recover(const std::string& snapshotFile, const std::string& logFile) {
+    disableChangeLog();
+
+    std::ifstream file(snapshotFile, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open file for loading.");
+    }
+    std::vector<unsigned char> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        throw std::runtime_error("Unable to read snapshot file.");
+    }
+
+    loadSnapshot<Serializer>(bytes.data(), bytes.size());
+
+    // Admissions and drops are records of their own: neither may happen by itself
+    size_t limit = queueLimit;
+    bool admission = admissionEnabled;
+    queueLimit = 0;
+    admissionEnabled = false;
+    try {
+        size_t applied = KeyArrayChangeLog<T, Serializer, Key>::replay(logFile, keyArrayDigest(bytes.data(), bytes.size()), *this);
+        queueLimit = limit;
+        admissionEnabled = admission;
+        return applied;
+    } catch (...) {
+        queueLimit = limit;
+        admissionEnabled = admission;
+        throw;
+    }
+}
+
+// Starts with no pending keys; the bits cover the current capacity
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableChangeTracking() {
+    if (dirtyTracker) return;
+
+    dirtyTracker = std::make_unique<KeyArrayDirtyTracker<T, Key>>(offset, getCapacity());
+    listeners.push_back(dirtyTracker.get());
+}
+
+// Detaches and frees the tracker
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableChangeTracking() {
+    if (!dirtyTracker) return;
+
+    removeListener(dirtyTracker.get());
+    dirtyTracker.reset();
+}
+
+// Returns whether changed keys are recorded
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isChangeTrackingEnabled() const {
+    return dirtyTracker != nullptr;
+}
+
+// Each marked key is looked up once, whatever it went through since the last
+// call: O(changed + capacity / 64). If fn throws, every key is reported again
+// by the next call. Throws std::runtime_error if tracking is not enabled.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+size_t KeyArray<T, Storage, Order, Key>::collectChanges(Fn&& fn) {
+    if (!dirtyTracker) {
+        throw std::runtime_error("Cannot collect changes: change tracking is not enabled.");
+    }
+    size_t reported = dirtyTracker->size();
+    const KeyArray& self = *this;
+    dirtyTracker->drain([&](Key key) { fn(key, self.try_get(key)); });
+    return reported;
+}
+
+// Returns the number of keys waiting for collectChanges() (0 when not tracking)
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::pendingChanges() const {
+    return dirtyTracker ? dirtyTracker->size() : 0;
+}
+
+// No listeners, no work beyond one empty check
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Fn>
+void KeyArray<T, Storage, Order, Key>::notify(Fn&& fn) {
+    if (listeners.empty()) return;
+
+    for (KeyArrayListener<T, Key>* listener : listeners) {
+        fn(*listener);
+    }
+    compactIfNeeded();
+}
+
+// Checkpoints once the change log has grown past its compaction limit
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::compactIfNeeded() {
+    if (changeLog && changeLog->needsCompaction()) {
+        checkpoint();
+    }
+}
+
+// Reports a freshly built run of a batch insert
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::notifyRunInserted(size_t first, size_t last) {
+    if (listeners.empty()) return;
+
+    // The whole run is already live, so compaction waits for its last record
+    for (size_t index = first; index < last; ++index) {
+        for (KeyArrayListener<T, Key>* listener : listeners) {
+            listener->onInsert(keyOf(index), bufferOf(index)[index]);
+        }
+    }
+    compactIfNeeded();
+}
+
+// Queued values have no key: every listener but the index and the dirty
+// tracker sees key Queued (which may also be a real key below a negative offset)
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::notifyQueued(const T& value) {
+    notify([&](KeyArrayListener<T, Key>& listener) {
+        if (&listener != index.get() && &listener != dirtyTracker.get()) listener.onInsert(Queued, value);
+    });
+}
+
+
+template <typename T, typename Storage, typename Order, typename Key>
+typename KeyArray<T, Storage, Order, Key>::OverflowQueue KeyArray<T, Storage, Order, Key>::emptyQueue() const {
+    OverflowQueue empty(getResource());
+    empty.reserve(queueLimit);
+    return empty;
+}
+
+// Writes to a temporary file first, so the previous snapshot survives a crash
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+uint64_t KeyArray<T, Storage, Order, Key>::writeSnapshotFile(const std::string& filename) const {
+    std::string temporary = filename + ".tmp";
+    uint64_t digest;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Unable to open file for saving.");
+        }
+        digest = writeSnapshot<Serializer>(file, true);
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Unable to write snapshot file.");
+        }
+    }
+
+    // POSIX rename replaces atomically; other platforms need the target gone
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(filename.c_str());
+        if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+            throw std::runtime_error("Unable to replace snapshot file.");
+        }
+    }
+    return digest;
+}
+
+
+
+/* =========================================================================
+   Generational Handles
+   =========================================================================
+   Available when Storage keeps a generation per slot. The generation sits
+   next to the value and is odd exactly while the slot is live, so a handle
+   check is one bounds test plus one compare on the value's cache line, with
+   no lookup in the occupancy bitmap.
+*/
+
+// Builds a handle from a live key and the current generation of its slot.
+// Throws std::out_of_range if the key is not in use or exceeds the handle's index range.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Handle>
+Handle KeyArray<T, Storage, Order, Key>::handleOf(Key key) const {
+    static_assert(Storage::HasGenerations, "Handles require generational storage (see GenerationalKeyArray)");
+    if (!hasKey(key)) {
+        throw std::out_of_range("Invalid key in KeyArray");
+    }
+
+    size_t index = slotOf(key);
+    if (index > Handle::MaxIndex) {
+        throw std::out_of_range("Key does not fit in the handle's index bits");
+    }
+    return Handle(index, bufferOf(index).generation(index));
+}
+
+// Inserts a copy of the value and returns its handle
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Handle>
+Handle KeyArray<T, Storage, Order, Key>::insertHandle(const T& value) {
+    return emplaceHandle<Handle>(value);
+}
+
+// Moves the value in and returns its handle
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Handle>
+Handle KeyArray<T, Storage, Order, Key>::insertHandle(T&& value) {
+    return emplaceHandle<Handle>(std::move(value));
+}
+
+// Constructs a value in place and returns its handle; queued values get a null handle
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Handle, typename... Args>
+Handle KeyArray<T, Storage, Order, Key>::emplaceHandle(Args&&... args) {
+    bool queued;
+    Key key = emplaceOrQueue(queued, std::forward<Args>(args)...);
+    if (queued) return Handle();
+    return handleOf<Handle>(key);
+}
+
+// A handle is live if its slot is in range and the (truncated) generations match.
+// Live generations are odd, so the null handle and any handle carrying an even
+// generation (such as slot 0 before its first insert) are rejected up front
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Word, unsigned IndexBits>
+bool KeyArray<T, Storage, Order, Key>::hasKey(BasicKeyHandle<Word, IndexBits> handle) const {
+    static_assert(Storage::HasGenerations, "Handles require generational storage (see GenerationalKeyArray)");
+    using Handle = BasicKeyHandle<Word, IndexBits>;
+
+    Word index = handle.index();
+    return (handle.generation() & 1) != 0 && this->lastKey >= 0 && index <= static_cast<Word>(this->lastKey) &&
+           (bufferOf(index).generation(index) & Handle::GenerationMask) == handle.generation();
+}
+
+// Access element by handle (non-const version)
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Word, unsigned IndexBits>
+T& KeyArray<T, Storage, Order, Key>::at(BasicKeyHandle<Word, IndexBits> handle) {
+    if (!hasKey(handle))
+        throw std::out_of_range("Stale or invalid handle in KeyArray");
+    return bufferOf(handle.index())[handle.index()];
+}
+
+// Access element by handle (const version)
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Word, unsigned IndexBits>
+const T& KeyArray<T, Storage, Order, Key>::at(BasicKeyHandle<Word, IndexBits> handle) const {
+    if (!hasKey(handle))
+        throw std::out_of_range("Stale or invalid handle in KeyArray");
+    return bufferOf(handle.index())[handle.index()];
+}
+
+// Removes an element by handle, bumping its generation so the handle goes stale
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Word, unsigned IndexBits>
+void KeyArray<T, Storage, Order, Key>::remove(BasicKeyHandle<Word, IndexBits> handle) {
+    if (!hasKey(handle))
+        throw std::out_of_range("Stale or invalid handle in KeyArray");
+    remove(keyOf(handle.index()));
+}
+
+
+
+/* =========================================================================
+   Dynamic Resizing Management
+   =========================================================================
+   When enabled, the structure doubles in size once occupancy crosses the
+   resize threshold. Only then is the larger buffer allocated and its extra
+   keys handed to the pool. Each insert or remove then moves the next
+   `copyBudget` slots past a cursor into the new buffer; a slot is owned by
+   exactly one buffer (below the cursor or past the old capacity: new, else
+   old), so nothing is written twice and lookups pick the buffer with a
+   single compare. Once the cursor reaches the old capacity, the old buffer
+   is released.
+
+   Resizing starts with at least the old capacity in fresh keys and every
+   insert migrates at least one slot, so the copy always finishes before the
+   pool can run dry: no insert ever has to drain the whole copy at once.
+*/
+
+// Enables dynamic resizing for the KeyArray.
+// The resize buffer is allocated lazily, on the insert that crosses the threshold.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableDynamicResizing() {
+    resizingEnabled = true;
+}
+
+// Disables dynamic resizing; a resize already in progress keeps advancing
+// with later operations. If purgeData is true, it is completed immediately
+// so that only one buffer remains.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableDynamicResizing(bool purgeData) {
+    resizingEnabled = false;
+
+    if (purgeData) {
+        finishResize();
+    }
+}
+
+// Returns whether dynamic resizing is enabled
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isDynamicResizingEnabled() const {
+    return resizingEnabled;
+}
+
+// Grows in one step whatever the resizing mode; never shrinks. A shrink in
+// progress is abandoned if its target is below n. With a change log the new
+// capacity is checkpointed, since replayed inserts may need it.
+// Throws std::length_error if n exceeds the keys the key type can name.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::reserve(size_t n) {
+    CopyGuard guard(*this);
+    if (shrinkInProgress && n > static_cast<size_t>(this->pool.getMaxValue()) + 1) {
+        cancelShrink();
+    }
+    finishResize();
+    if (n <= this->data.capacity()) return;
+
+    growExactly(cappedCapacity(n, n));
+    if (changeLog) {
+        checkpoint();
+    }
+}
+
+// The helper copies values, so they have to be copy-constructible
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableBackgroundResize(const ResizeExecutor& executor) {
+    static_assert(std::is_copy_constructible_v<T>, "Background resizing copies values");
+    backgroundResizeEnabled = true;
+    resizeExecutor = executor;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableBackgroundResize() {
+    backgroundResizeEnabled = false;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isBackgroundResizeEnabled() const {
+    return backgroundResizeEnabled;
+}
+
+// Performs one budgeted step of the migration (no-op if no resize is in progress)
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::continueCopyStep() {
+    CopyGuard guard(*this);
+    migrateSlots(copyBudget);
+    compactSlots(copyBudget);
+}
+
+// Completes the migration in one go (waiting for a background copy to finish
+// and handing over to its buffer) and releases the old buffer.
+// Throws std::runtime_error if no resize is in progress.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::switchToResizedData() {
+    if (!isResizeInProgress()) {
+        throw std::runtime_error("Cannot switch data: no resize is in progress.");
+    }
+    finishResize();
+}
+
+// Returns whether a resize is in progress
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isResizeInProgress() const {
+    return copyInProgress || background;
+}
+
+// Sets the number of slots migrated per operation.
+// Throws std::invalid_argument if slots is zero.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::setCopyBudget(size_t slots) {
+    if (slots == 0) {
+        throw std::invalid_argument("Copy budget must be at least one slot.");
+    }
+    copyBudget = slots;
+}
+
+// Sets the copy budget in bytes; always migrates at least one slot per operation
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::setCopyBudgetBytes(size_t bytes) {
+    copyBudget = std::max<size_t>(1, bytes / sizeof(T));
+}
+
+// Returns the number of slots migrated per operation
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::getCopyBudget() const {
+    return copyBudget;
+}
+
+// Sets the occupancy that triggers the next resize.
+// Throws std::invalid_argument unless 0 < occupancy <= 1.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::setResizeThreshold(double occupancy) {
+    if (!(occupancy > 0.0 && occupancy <= 1.0)) {
+        throw std::invalid_argument("Resize threshold must be in (0, 1].");
+    }
+    resizeThreshold = occupancy;
+}
+
+// Returns the occupancy that triggers the next resize
+template <typename T, typename Storage, typename Order, typename Key>
+double KeyArray<T, Storage, Order, Key>::getResizeThreshold() const {
+    return resizeThreshold;
+}
+
+// Starts a resize once the occupancy after `incoming` inserts would exceed the threshold
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::maybeStartResize(size_t incoming) {
+    // Storage that grows in place allocates nothing ahead of time
+    if constexpr (Storage::GrowsInPlace) return;
+    if (!resizingEnabled || copyInProgress || background || shrinkInProgress) return;
+    // At the key type's limit the free keys left are used up before growing fails
+    if (this->data.capacity() >= maxCapacity()) return;
+
+    double capacity = static_cast<double>(this->data.capacity());
+    if (static_cast<double>(this->elementCount + incoming) > resizeThreshold * capacity) {
+        startResize();
+    }
+}
+
+// Allocates a buffer of twice the capacity. The new keys are usable at once:
+// their slots lie past the old capacity, so they already belong to newData.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::startResize() {
+    size_t capacity = this->data.capacity();
+    size_t newCapacity = cappedCapacity(std::max<size_t>(1, capacity * 2), capacity + 1);
+    KEYARRAY_STAT(++statsRecorder.totals.resizes;)
+
+    // Paged storage just appends pages; nothing moves, so there is nothing to migrate
+    if constexpr (Storage::GrowsInPlace) {
+        growInPlace(newCapacity);
+        return;
+    }
+
+    // The helper needs the keys still free to finish before this thread runs dry
+    if constexpr (std::is_copy_constructible_v<T>) {
+        if (backgroundResizeEnabled && !this->pool.empty()) {
+            startBackgroundResize(newCapacity);
+            return;
+        }
+    }
+
+    newData = SlotBuffer(newCapacity, getResource());
+    startAtGenerationFloor(newData, capacity);
+    newValid.assign(newCapacity);
+    copyInProgress = true;
+    copyIndex = 0;
+
+    this->lastKey = static_cast<std::ptrdiff_t>(newCapacity) - 1;
+    openKeys(capacity);
+
+    if (this->data.capacity() == 0) {
+        completeResize();
+    }
+}
+
+// Moves the live values of the next `slots` slots, then carries over the
+// generations and free-list links of the whole span. Values are only
+// destroyed in the old buffer once every move of the span succeeded, so a
+// throwing copy (for types without a noexcept move) changes nothing.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::migrateSlots(size_t slots) {
+    if (!copyInProgress) return;
+
+    size_t oldCapacity = this->valid.size();
+    size_t first = copyIndex;
+    size_t last = oldCapacity - first <= slots ? oldCapacity : first + slots;
+    KEYARRAY_STAT(++statsRecorder.totals.copySteps;)
+    KEYARRAY_STAT(statsRecorder.totals.slotsMigrated += last - first;)
+
+    size_t i = this->valid.findNext(first);
+    try {
+        for (; i < last; i = this->valid.findNext(i + 1)) {
+            newData.construct(i, std::move_if_noexcept(this->data[i]));
+        }
+    } catch (...) {
+        for (size_t j = this->valid.findNext(first); j < i; j = this->valid.findNext(j + 1)) {
+            newData.destroy(j);
+        }
+        throw;
+    }
+    newData.copyGenerations(this->data, first, last);
+
+    for (i = first; i < last; ++i) {
+        if (this->valid.test(i)) {
+            this->data.destroy(i);
+            this->valid.reset(i);
+            newValid.set(i);
+        } else {
+            newData.copyLink(this->data, i);
+        }
+    }
+    copyIndex = last;
+
+    if (copyIndex == oldCapacity) {
+        completeResize();
+    }
+}
+
+// Migrates the rest of the old buffer in one call (or waits for the background copy)
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::finishResize() {
+    awaitBackgroundResize();
+    migrateSlots(std::numeric_limits<size_t>::max());
+}
+
+// Every value has been moved out, so the old buffer is released without a scan
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::completeResize() {
+    this->data = std::move(newData);
+    this->valid = std::move(newValid);
+
+    newData = SlotBuffer(0, getResource());
+    newValid.clear();
+    copyInProgress = false;
+    copyIndex = 0;
+}
+
+// Grows in one step, bypassing the incremental copy: a pending resize is
+// completed, then live values are moved straight into a buffer of the
+// requested size. Used when a batch needs more keys than one doubling provides.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::growTo(size_t minCapacity) {
+    finishResize();
+
+    size_t capacity = this->data.capacity();
+    if (capacity >= minCapacity) return;
+    growExactly(cappedCapacity(std::max(minCapacity, capacity * 2), minCapacity));
+}
+
+// Live values are moved straight into the new buffer; free-list links and
+// generations are carried over, so no key changes
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::growExactly(size_t newCapacity) {
+    size_t capacity = this->data.capacity();
+    KEYARRAY_STAT(++statsRecorder.totals.resizes;)
+
+    if constexpr (Storage::GrowsInPlace) {
+        growInPlace(newCapacity);
+        return;
+    }
+
+    SlotBuffer grown(newCapacity, getResource());
+
+    size_t i = this->valid.findNext(0);
+    try {
+        for (; i < capacity; i = this->valid.findNext(i + 1)) {
+            grown.construct(i, std::move_if_noexcept(this->data[i]));
+        }
+    } catch (...) {
+        for (size_t j = this->valid.findNext(0); j < i; j = this->valid.findNext(j + 1)) {
+            grown.destroy(j);
+        }
+        throw;
+    }
+    grown.copyGenerations(this->data, 0, capacity);
+    startAtGenerationFloor(grown, capacity);
+    this->pool.copyLinks(this->data, grown);
+
+    this->data.destroyLive(this->valid);
+    this->data = std::move(grown);
+    this->valid.resize(newCapacity);
+
+    this->lastKey = static_cast<std::ptrdiff_t>(newCapacity) - 1;
+    openKeys(capacity);
+}
+
+
+/* -------------------------------------------------------------------------
+   Background resize
+
+   The helper copies the whole current buffer into one twice its size,
+   4096 slots per hold of the copy's lock, while this thread keeps using the
+   current buffer with the keys it already has: the pool grows only at the
+   handover. Every mutating call holds the same lock (uncontended but for
+   one chunk at most) and marks each slot it changes below the copy cursor
+   as dirty. The handover, at the first mutating call after the helper is
+   done, copies the dirty slots again, swaps the buffers and opens the new
+   keys; a call that finds the pool empty first waits for the helper.
+
+   Values must not be written through references while a copy runs:
+   update(), modify() and swap() write under the lock. Values are copied, not
+   moved, so the old ones (destroyed at the handover) stay valid until then.
+   The helper allocates from the array's memory resource, which then has to
+   be thread-safe.
+   ------------------------------------------------------------------------- */
+
+// Called inside a mutating call, which takes the lock once the task is handed
+// off (an executor may also run it right away, on this thread)
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::startBackgroundResize(size_t newCapacity) {
+    background = std::make_unique<BackgroundCopy>();
+    background->capacity = this->data.capacity();
+    background->targetCapacity = newCapacity;
+
+    BackgroundCopy* copy = background.get();
+    try {
+        if (resizeExecutor) {
+            resizeExecutor([this, copy] { runBackgroundCopy(*copy); });
+        } else {
+            copy->thread = std::thread([this, copy] { runBackgroundCopy(*copy); });
+        }
+    } catch (...) {
+        background.reset();
+        throw;
+    }
+
+    if (mutating) {
+        copy->lock.lock();
+        copy->held = true;
+    }
+}
+
+// Reads only the current buffer and writes only the copy's own; the flag is
+// set and signalled under the lock, so a waiter may free the copy right after
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::runBackgroundCopy(BackgroundCopy& copy) {
+    try {
+        size_t oldCapacity = copy.capacity;
+        size_t newCapacity = copy.targetCapacity;
+        copy.target = SlotBuffer(newCapacity, getResource());
+        copy.targetValid = OccupancyBitmap(newCapacity, getResource());
+        copy.dirty = OccupancyBitmap(oldCapacity, getResource());
+
+        for (size_t first = 0; first < oldCapacity; first += BackgroundChunk) {
+            std::lock_guard<std::mutex> hold(copy.lock);
+            size_t last = std::min(oldCapacity, first + BackgroundChunk);
+            for (size_t i = first; i < last; ++i) {
+                if (this->valid.test(i)) {
+                    copy.target.construct(i, this->data[i]);
+                    copy.targetValid.set(i);
+                } else {
+                    copy.target.copyLink(this->data, i);
+                }
+            }
+            copy.target.copyGenerations(this->data, first, last);
+            copy.copied = last;
+        }
+    } catch (...) {
+        copy.error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> hold(copy.lock);
+    copy.done = true;
+    copy.ready.store(true, std::memory_order_release);
+    copy.finished.notify_all();
+}
+
+// Runs under this thread's hold of the lock, which makes `copied` safe to read
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::touchSlot(size_t index) noexcept {
+    if (background && index < background->copied) {
+        background->dirty.set(index);
+    }
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::settleBackgroundCopy() {
+    if (!background) return;
+
+    BackgroundCopy& copy = *background;
+    if (copy.held) {
+        copy.held = false;
+        copy.lock.unlock();
+    }
+    {
+        std::unique_lock<std::mutex> hold(copy.lock);
+        copy.finished.wait(hold, [&copy] { return copy.done; });
+    }
+    if (copy.thread.joinable()) copy.thread.join();
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArray<T, Storage, Order, Key>& KeyArray<T, Storage, Order, Key>::settledForMove() noexcept {
+    settleBackgroundCopy();
+    return *this;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::awaitBackgroundResize() {
+    if (!background) return;
+    settleBackgroundCopy();
+    completeBackgroundResize();
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::cancelBackgroundResize() {
+    if (!background) return;
+    settleBackgroundCopy();
+    background->target.destroyLive(background->targetValid);
+    background.reset();
+}
+
+// A failed copy is dropped and its exception rethrown here; the array stays
+// as it was and the next insert past the threshold tries again. If copying a
+// dirty slot throws, the grown buffer is dropped the same way.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::completeBackgroundResize() {
+    std::unique_ptr<BackgroundCopy> copy = std::move(background);
+    try {
+        if (copy->error) std::rethrow_exception(copy->error);
+
+        copy->dirty.forEachSet([&](size_t i) {
+            if (copy->targetValid.test(i)) {
+                copy->target.destroy(i);
+                copy->targetValid.reset(i);
+            }
+            if (this->valid.test(i)) {
+                copy->target.construct(i, std::move_if_noexcept(this->data[i]));
+                copy->targetValid.set(i);
+            } else {
+                copy->target.copyLink(this->data, i);
+            }
+            copy->target.copyGenerations(this->data, i, i + 1);
+        });
+    } catch (...) {
+        copy->target.destroyLive(copy->targetValid);
+        throw;
+    }
+
+    size_t capacity = this->data.capacity();
+    startAtGenerationFloor(copy->target, capacity);
+    this->data.destroyLive(this->valid);
+    this->data = std::move(copy->target);
+    this->valid = std::move(copy->targetValid);
+
+    this->lastKey = static_cast<std::ptrdiff_t>(this->data.capacity()) - 1;
+    openKeys(capacity);
+}
+
+
+// Appends storage without touching existing slots and opens the new keys
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::growInPlace(size_t newCapacity) {
+    size_t capacity = this->data.capacity();
+    this->data.grow(newCapacity);
+    startAtGenerationFloor(this->data, capacity);
+    this->valid.resize(newCapacity);
+
+    this->lastKey = static_cast<std::ptrdiff_t>(newCapacity) - 1;
+    openKeys(capacity);
+}
+
+// The pool of an empty array parks its bump cursor past key 0 (see poolUpTo),
+// where extending would leave it, so growth from zero starts a fresh range
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::openKeys(size_t oldCapacity) {
+    if (oldCapacity == 0) {
+        this->pool = this->poolUpTo(this->lastKey);
+    } else {
+        this->pool.extend(static_cast<Key>(this->lastKey));
+    }
+}
+
+// Fresh slots count from zero, which handles to a slot released by an
+// earlier shrink may already carry
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::startAtGenerationFloor(SlotBuffer& buffer, size_t first) const {
+    if constexpr (Storage::HasGenerations) {
+        if (generationFloor != 0) buffer.fillGenerations(first, buffer.capacity(), generationFloor);
+    } else {
+        (void)buffer;
+        (void)first;
+    }
+}
+
+
+/* =========================================================================
+   Shrinking & Compaction
+   =========================================================================
+   A shrink to capacity C moves every value living at or above C into a free
+   key below it, then releases the slots from C up. At the start the pool is
+   rebuilt to hand out only the free keys below C, so inserts made meanwhile
+   fill the low range too, and keys freed above C are simply not recycled.
+   The free keys are pushed from the top down, so the order in which inserts
+   and moved values get them follows Order: lowest first for the LIFO and
+   lowest-first orders, highest first for FIFO. Moves advance one copy
+   budget per insert or remove, behind a cursor that only rises (nothing new
+   becomes live above C); each move is reported to listeners as onMove and
+   to the remap callback, since the value's key changes. If inserts use up
+   the keys below C first, the shrink is abandoned and the slots above C are
+   reopened.
+
+   Releasing reallocates contiguous storage (one move of each live value)
+   and returns trailing pages of paged storage, whose references stay valid
+   for every value that did not move. With a change log the whole shrink
+   runs at once and ends with a checkpoint, so a log never spans one.
+*/
+
+// Compacts into [0, size()) and releases everything above in one call
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::shrinkToFit(const KeyRemap& remap) {
+    finishShrink();
+    startShrink(this->elementCount, remap);
+    finishShrink();
+}
+
+// A shrink already in progress is completed first.
+// Throws std::invalid_argument if capacity is below the number of live elements.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::startShrink(size_t capacity, const KeyRemap& remap) {
+    if (capacity < this->elementCount) {
+        throw std::invalid_argument("Cannot shrink below the number of live elements.");
+    }
+    finishShrink();
+    finishResize();
+
+    // Pages are released whole, so values in the last kept page stay put
+    if constexpr (Storage::GrowsInPlace) {
+        size_t pageSize = Storage::PageSize;
+        capacity = (capacity + pageSize - 1) / pageSize * pageSize;
+    }
+    if (capacity >= this->data.capacity()) return;
+
+    shrinkInProgress = true;
+    shrinkTarget = capacity;
+    shrinkCursor = capacity;
+    shrinkRemap = remap;
+
+    if (capacity == 0) {
+        this->pool = this->poolUpTo(-1);
+    } else {
+        this->pool.restore(0, static_cast<Key>(capacity), static_cast<Key>(capacity - 1));
+    }
+    for (size_t slot = capacity; slot-- > 0;) {
+        if (!this->valid.test(slot)) this->pool.push(static_cast<Key>(slot), this->data);
+    }
+
+    if (changeLog) {
+        finishShrink();
+    }
+}
+
+// Moves every value still above the target and releases its slots
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::finishShrink() {
+    compactSlots(std::numeric_limits<size_t>::max());
+}
+
+// Returns whether a shrink is in progress
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isShrinkInProgress() const {
+    return shrinkInProgress;
+}
+
+// Keys change without the caller asking, so a remap callback is required.
+// Throws std::invalid_argument for a missing remap or an occupancy outside (0, 1).
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableAutoShrink(const KeyRemap& remap, double occupancy, size_t minCapacity) {
+    if (!remap) {
+        throw std::invalid_argument("Automatic shrinking needs a remap callback.");
+    }
+    if (!(occupancy > 0.0 && occupancy < 1.0)) {
+        throw std::invalid_argument("Shrink occupancy must be in (0, 1).");
+    }
+    autoShrinkEnabled = true;
+    autoShrinkRemap = remap;
+    shrinkOccupancy = occupancy;
+    shrinkFloor = minCapacity;
+}
+
+// A shrink already in progress keeps its own callback
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableAutoShrink() {
+    autoShrinkEnabled = false;
+    autoShrinkRemap = nullptr;
+}
+
+// Returns whether shrinks start automatically
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isAutoShrinkEnabled() const {
+    return autoShrinkEnabled;
+}
+
+// Walks the live slots above the target from the cursor; completes the
+// shrink once none is left
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::compactSlots(size_t slots) {
+    if (!shrinkInProgress) return;
+
+    size_t capacity = this->valid.size();
+    size_t from = this->valid.findNext(shrinkCursor);
+    for (size_t moved = 0; from < capacity && moved < slots; ++moved) {
+        if (this->pool.empty()) {
+            cancelShrink();
+            return;
+        }
+        relocateSlot(from);
+        shrinkCursor = from + 1;
+        from = this->valid.findNext(shrinkCursor);
+    }
+
+    if (from >= capacity) {
+        completeShrink();
+    }
+}
+
+// The value is moved before the old slot is destroyed, so a throwing move
+// hands the key back and leaves the value where it was
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::relocateSlot(size_t from) {
+    Key to = this->pool.pop(this->data);
+    try {
+        this->data.construct(to, std::move_if_noexcept(this->data[from]));
+    } catch (...) {
+        this->pool.push(to, this->data);
+        throw;
+    }
+    this->data.destroy(from);
+    this->valid.reset(from);
+    this->valid.set(to);
+
+    // Compaction waits for the shrink to finish, so no checkpoint falls inside it
+    Key oldKey = keyOf(from);
+    Key newKey = keyOf(to);
+    for (KeyArrayListener<T, Key>* listener : listeners) {
+        listener->onMove(oldKey, newKey, this->data[to]);
+    }
+    if (shrinkRemap) {
+        shrinkRemap(oldKey, newKey);
+    }
+}
+
+// Only free slots remain above the target. Contiguous storage moves the live
+// values into a buffer of the target size; paged storage drops its tail pages.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::completeShrink() {
+    size_t capacity = shrinkTarget;
+
+    // Every released slot is free, so its generation is even
+    if constexpr (Storage::HasGenerations) {
+        for (size_t i = capacity; i < this->data.capacity(); ++i) {
+            generationFloor = std::max(generationFloor, this->data.generation(i));
+        }
+    }
+
+    if constexpr (Storage::GrowsInPlace) {
+        this->data.shrink(capacity);
+    } else {
+        SlotBuffer shrunk(capacity, getResource());
+
+        size_t i = this->valid.findNext(0);
+        try {
+            for (; i < capacity; i = this->valid.findNext(i + 1)) {
+                shrunk.construct(i, std::move_if_noexcept(this->data[i]));
+            }
+        } catch (...) {
+            for (size_t j = this->valid.findNext(0); j < i; j = this->valid.findNext(j + 1)) {
+                shrunk.destroy(j);
+            }
+            throw;
+        }
+        shrunk.copyGenerations(this->data, 0, capacity);
+        this->pool.copyLinks(this->data, shrunk);
+
+        this->data.destroyLive(this->valid);
+        this->data = std::move(shrunk);
+    }
+    this->valid.resize(capacity);
+    this->lastKey = static_cast<std::ptrdiff_t>(capacity) - 1;
+
+    shrinkInProgress = false;
+    shrinkRemap = nullptr;
+
+    if (changeLog) {
+        checkpoint();
+    }
+}
+
+// Keys below the target keep their free-list order; the free slots above
+// it are linked in behind them. A target of 0 left the pool's cursor past
+// key 0, so the sweep is moved back to include it.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::cancelShrink() {
+    shrinkInProgress = false;
+    shrinkRemap = nullptr;
+    if (shrinkTarget == 0) {
+        this->pool.restore(0, 0, 0);
+    }
+    this->pool.reclaim(static_cast<Key>(this->lastKey), this->data, [this](Key key) { return !this->valid.test(key); });
+}
+
+// The new capacity sits midway between the shrink and resize occupancies, so
+// neither a few inserts nor a few removes trigger the opposite operation
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::maybeStartShrink() {
+    if (!autoShrinkEnabled || shrinkInProgress || copyInProgress || background) return;
+
+    size_t capacity = this->data.capacity();
+    if (capacity <= shrinkFloor) return;
+    if (static_cast<double>(this->elementCount) >= shrinkOccupancy * static_cast<double>(capacity)) return;
+
+    double occupancy = (shrinkOccupancy + std::max(shrinkOccupancy, resizeThreshold)) / 2;
+    size_t target = static_cast<size_t>(static_cast<double>(this->elementCount) / occupancy) + 1;
+    startShrink(std::max(target, shrinkFloor), autoShrinkRemap);
+}
+
+
+/* =========================================================================
+   Overflow Queue Management
+   =========================================================================
    These methods provide access to an optional queue that stores values
    when the structure is full and dynamic resizing is not enabled.
    This gives the user control over overflow behavior without data loss.
+
+   A bounded queue is reserved up front and then never allocates; when it
+   is full, a new value is rejected or the oldest one is dropped. With
+   admission enabled the queue is an admission stage: every key remove()
+   frees goes to the head of the queue right away.
 */
 
 // Enables the overflow queue.
 // Values will be pushed into this queue if insert is called when full.
-template <typename T>
-void KeyArray<T>::enableQueue() {
+// A bound set before is kept.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableQueue() {
     queueEnabled = true;
 }
 
+// Enables a bounded queue and reserves room for all of it.
+// Throws std::invalid_argument if more values than `limit` are already queued.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableQueue(size_t limit, OverflowPolicy policy) {
+    if (limit != 0 && limit < overflowQueue.size()) {
+        throw std::invalid_argument("Queue limit is below the number of queued values.");
+    }
+    overflowQueue.reserve(limit);
+    queueEnabled = true;
+    queueLimit = limit;
+    overflowPolicy = policy;
+}
+
 // Disables the overflow queue.
 // Further insertions when full will throw an exception unless resizing is enabled.
-template <typename T>
-void KeyArray<T>::disableQueue() {
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableQueue() {
     queueEnabled = false;
 }
 
-// Clears the overflow queue by swapping it with an empty instance.
-template <typename T>
-void KeyArray<T>::clearQueue() {
-    std::queue<T> empty;
+// Clears the overflow queue by swapping it with an empty instance in the same resource.
+// A bounded queue keeps its reserved ring instead.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::clearQueue() {
+    if (queueLimit != 0) {
+        overflowQueue.clear();
+        return;
+    }
+    OverflowQueue empty = emptyQueue();
     std::swap(overflowQueue, empty);
 }
 
 // Returns the number of elements currently in the overflow queue.
-template <typename T>
-size_t KeyArray<T>::getQueueSize() const {
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::getQueueSize() const {
     return overflowQueue.size();
 }
 
 // Returns a modifiable reference to the overflow queue.
-template <typename T>
-std::queue<T>& KeyArray<T>::getQueue() {
+template <typename T, typename Storage, typename Order, typename Key>
+typename KeyArray<T, Storage, Order, Key>::OverflowQueue& KeyArray<T, Storage, Order, Key>::getQueue() {
     return overflowQueue;
 }
 
 // Returns a const reference to the overflow queue.
-template <typename T>
-const std::queue<T>& KeyArray<T>::getQueue() const {
+template <typename T, typename Storage, typename Order, typename Key>
+const typename KeyArray<T, Storage, Order, Key>::OverflowQueue& KeyArray<T, Storage, Order, Key>::getQueue() const {
     return overflowQueue;
 }
 
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::getQueueLimit() const {
+    return queueLimit;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+OverflowPolicy KeyArray<T, Storage, Order, Key>::getOverflowPolicy() const {
+    return overflowPolicy;
+}
+
+// Takes the key the pool hands out next (with LifoKeyOrder, the last one freed).
+// The value is moved out of the queue only once its slot is built, so a
+// throwing constructor leaves it queued.
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArray<T, Storage, Order, Key>::admitQueued() {
+    CopyGuard guard(*this);
+    if (overflowQueue.empty() || this->pool.empty()) return Queued;
+
+    SlotLinks<KeyArray> links{this};
+    KEYARRAY_STAT(++(this->pool.hasRecycled() ? statsRecorder.totals.recycledKeys : statsRecorder.totals.freshKeys);)
+    Key actualKey = this->pool.pop(links);
+    try {
+        bufferOf(actualKey).construct(actualKey, std::move_if_noexcept(overflowQueue.front()));
+    } catch (...) {
+        this->pool.push(actualKey, links);
+        throw;
+    }
+    overflowQueue.pop();
+    touchSlot(actualKey);
+    bitsOf(actualKey).set(actualKey);
+    ++this->elementCount;
+
+    Key key = keyOf(actualKey);
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onAdmit(key, bufferOf(actualKey)[actualKey]); });
+    return key;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::drainQueue() {
+    size_t admitted = 0;
+    while (admitQueued() != Queued) ++admitted;
+    return admitted;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::enableAdmission(const KeyAdmit& admitted) {
+    admissionEnabled = true;
+    admitCallback = admitted;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::disableAdmission() {
+    admissionEnabled = false;
+    admitCallback = nullptr;
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::isAdmissionEnabled() const {
+    return admissionEnabled;
+}
+
+// A full bounded queue rejects before anything changes, or reports and drops
+// its head first (so a change log replays the drop before the push)
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename... Args>
+void KeyArray<T, Storage, Order, Key>::enqueue(Args&&... args) {
+    if (queueLimit != 0 && overflowQueue.size() >= queueLimit) {
+        if (overflowPolicy == OverflowPolicy::Reject) {
+            throw std::runtime_error("Overflow queue is full.");
+        }
+        notify([&](KeyArrayListener<T, Key>& listener) { listener.onDrop(overflowQueue.front()); });
+        overflowQueue.pop();
+    }
+    overflowQueue.emplace(std::forward<Args>(args)...);
+    KEYARRAY_STAT(statsRecorder.totals.queueHighWater = std::max(statsRecorder.totals.queueHighWater, overflowQueue.size());)
+    notifyQueued(overflowQueue.back());
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArray<T, Storage, Order, Key>::queueAccepts(size_t count) const {
+    return queueLimit == 0 || overflowPolicy == OverflowPolicy::DropOldest ||
+           count <= queueLimit - std::min(queueLimit, overflowQueue.size());
+}
+
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::admitAfterRemove() {
+    if (!admissionEnabled || overflowQueue.empty()) return;
+
+    Key key = admitQueued();
+    if (key != Queued && admitCallback) {
+        admitCallback(key, (*this)[key]);
+    }
+}
+
 // ──────────────────────────────────────────────
 // Basic Metadata and Manipulation
 // ──────────────────────────────────────────────
 
 // Sets the name of the current KeyArray instance
-template <typename T>
-void KeyArray<T>::setName(const std::string& newName) {
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::setName(const std::string& newName) {
     name = newName;
 }
 
 // Gets the name of the current KeyArray instance
-template <typename T>
-std::string KeyArray<T>::getName() const {
+template <typename T, typename Storage, typename Order, typename Key>
+std::string KeyArray<T, Storage, Order, Key>::getName() const {
     return name;
 }
 
 // Swaps the values of two keys, if both are valid
-template <typename T>
-void KeyArray<T>::swap(int key1, int key2) {
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::swap(Key key1, Key key2) {
     if (!hasKey(key1) || !hasKey(key2)) {
         throw std::invalid_argument("One or both keys are invalid.");
     }
-    std::swap(this->data[key1 - this->offset], this->data[key2 - this->offset]);
+    CopyGuard guard(*this);
+    size_t index1 = slotOf(key1);
+    size_t index2 = slotOf(key2);
+    std::swap(bufferOf(index1)[index1], bufferOf(index2)[index2]);
+    touchSlot(index1);
+    touchSlot(index2);
+    notify([&](KeyArrayListener<T, Key>& listener) { listener.onSwap(key1, key2); });
 }
 
-// Saves the KeyArray's state to a file (including metadata and overflow queue)
-template <typename T>
-void KeyArray<T>::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
+// Saves the KeyArray's state to a binary snapshot file
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+void KeyArray<T, Storage, Order, Key>::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
     if (!file.is_open()) {
         throw std::runtime_error("Unable to open file for saving.");
     }
 
-    file << "version: 2.0\n";
-    file << "name: " << (name.empty() ? "(unnamed)" : name) << '\n';
-    file << "offset: " << offset << '\n';
-    file << "lastKey: " << this->lastKey << '\n';
-    file << "dynamicResizing: " << (resizingEnabled ? "true" : "false") << '\n';
-    file << "queueEnabled: " << (queueEnabled ? "true" : "false") << '\n';
-    file << "queueSize: " << overflowQueue.size() << '\n';
+    saveSnapshot<Serializer>(file);
+
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Unable to write snapshot file.");
+    }
+}
+
+// Writes header, name, bitmap and free list, then the values and the queue:
+// raw values as one sizeof(T) cell per slot, other types through Serializer
+// as a self-delimiting stream (their byte counts in the header stay 0).
+// A resize in progress is flattened into a single key range.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+void KeyArray<T, Storage, Order, Key>::saveSnapshot(std::ostream& os) const {
+    writeSnapshot<Serializer>(os, false);
+}
+
+// Shared by saveSnapshot and the change log, which identifies its base by digest
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+uint64_t KeyArray<T, Storage, Order, Key>::writeSnapshot(std::ostream& os, bool withDigest) const {
+    constexpr bool Raw = Serializer::Raw;
+    static_assert(!Raw || std::is_trivially_copyable_v<T>, "Raw snapshots need trivially copyable values");
+
+    size_t capacity = static_cast<size_t>(this->lastKey + 1);
+
+    KeyArraySnapshotHeader header = {};
+    std::memcpy(header.magic, KeyArraySnapshotHeader::Magic, sizeof(header.magic));
+    header.version = KeyArraySnapshotHeader::Version;
+    header.flags = (resizingEnabled ? KeyArraySnapshotHeader::ResizingEnabled : 0) |
+                   (queueEnabled ? KeyArraySnapshotHeader::QueueEnabled : 0) |
+                   (Raw ? KeyArraySnapshotHeader::RawValues : 0);
+    header.valueSize = Raw ? static_cast<uint32_t>(sizeof(T)) : 0;
+    header.valueAlign = static_cast<uint32_t>(Raw ? std::max<size_t>(8, alignof(T)) : 8);
+    header.nameLength = name.size();
+    header.offset = offset;
+    header.capacity = capacity;
+    header.elementCount = this->elementCount;
+    header.freeCount = this->pool.recycledCount();
+    header.queueCount = overflowQueue.size();
+    header.poolMin = this->pool.getMinValue();
+    header.poolNext = this->pool.getCurrentValue();
+    header.poolMax = this->pool.getMaxValue();
+    header.valueBytes = Raw ? capacity * sizeof(T) : 0;
+    header.queueBytes = Raw ? overflowQueue.size() * sizeof(T) : 0;
+
+    KeyArraySnapshotWriter out(os, withDigest);
+    out.writeValue(header);
+    out.write(name.data(), name.size());
+    out.pad(8);
+
+    // One bitmap over the whole key range, even while two buffers are in use
+    OccupancyBitmap merged(0, getResource());
+    if (copyInProgress) {
+        merged.assign(capacity);
+        for (size_t i = nextLive(0); i < endSlot(); i = nextLive(i + 1)) merged.set(i);
+    }
+    const OccupancyBitmap& live = copyInProgress ? merged : this->valid;
+    for (size_t w = 0; w < live.wordCount(); ++w) {
+        out.writeValue(live.word(w));
+    }
+
+    this->pool.forEachFree(SlotLinks<const KeyArray>{this}, [&](Key key) {
+        out.writeValue<int64_t>(static_cast<int64_t>(key));
+    });
+    out.pad(header.valueAlign);
 
-    file << "entries:\n";
-    for (int i = 0; i <= this->lastKey; ++i) {
-        if (this->valid[i]) {
-            file << (i + offset) << ' ' << this->data[i] << '\n';
+    if constexpr (Raw) {
+        alignas(T) static const unsigned char deadCell[sizeof(T)] = {};
+        for (size_t i = 0; i < capacity; ++i) {
+            out.write(live.test(i) ? static_cast<const void*>(&bufferOf(i)[i]) : deadCell, sizeof(T));
         }
+        out.pad(header.valueAlign);
+    } else {
+        live.forEachSet([&](size_t i) {
+            Serializer::write(out, bufferOf(i)[i]);
+        });
     }
 
-    file << "queueEntries:\n";
-    if (queueEnabled && !overflowQueue.empty()) {
-        std::queue<int> copy = overflowQueue;
-        while (!copy.empty()) {
-            file << copy.front() << '\n';
-            copy.pop();
+    for (size_t q = 0; q < overflowQueue.size(); ++q) {
+        if constexpr (Raw) {
+            out.write(&overflowQueue[q], sizeof(T));
+        } else {
+            Serializer::write(out, overflowQueue[q]);
         }
     }
 
-    file.close();
+    if (!os) {
+        throw std::runtime_error("Unable to write snapshot.");
+    }
+    return withDigest ? out.digest() : 0;
 }
 
-// Loads KeyArray's state from a file (including metadata and overflow queue)
-template <typename T>
-void KeyArray<T>::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
+// Reads the whole file with one read, then loads it from memory
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+void KeyArray<T, Storage, Order, Key>::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         throw std::runtime_error("Unable to open file for loading.");
     }
 
-    std::string versionLine;
-    std::getline(file, versionLine); // version: 2.0
+    std::vector<unsigned char> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        throw std::runtime_error("Unable to read snapshot file.");
+    }
+
+    loadSnapshot<Serializer>(bytes.data(), bytes.size());
+}
+
+// Rebuilds the array from a snapshot: the bitmap is copied in one memcpy, raw
+// values are copied cell by cell into their slots, the free list is relinked
+// in its saved order. Everything is built aside first, so a malformed snapshot
+// or a throwing value leaves this array unchanged.
+// Throws std::runtime_error if the snapshot is malformed or of another value format.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename Serializer>
+void KeyArray<T, Storage, Order, Key>::loadSnapshot(const void* bytes, size_t size) {
+    constexpr bool Raw = Serializer::Raw;
+
+    KeyArraySnapshotHeader header = readKeyArraySnapshotHeader(bytes, size);
+    KeyArraySnapshotLayout layout = KeyArraySnapshotLayout::of(header);
+    bool rawSnapshot = (header.flags & KeyArraySnapshotHeader::RawValues) != 0;
+    if (rawSnapshot != Raw || (Raw && header.valueSize != sizeof(T))) {
+        throw std::runtime_error("Snapshot value format does not match this KeyArray.");
+    }
 
-    std::string label;
-    file >> label >> name;
-    file >> label >> offset;
-    file >> label >> this->lastKey;
+    // The offset is stored as int64 (uint64 keys wrap into it and back), and
+    // offset + capacity must stay within the key type like it does on growth
+    Key savedOffset = static_cast<Key>(header.offset);
+    if (static_cast<int64_t>(savedOffset) != header.offset || header.capacity > KeyTraits<Key>::keysFrom(savedOffset)) {
+        throw std::runtime_error("Snapshot key range does not fit this KeyArray's key type.");
+    }
 
-    int effectiveSize = this->lastKey + 1;
-    this->data.resize(effectiveSize);
-    this->valid.resize(effectiveSize, false);
-    this->elementCount = 0;
-    this->pool.reset(offset, this->lastKey);
+    const unsigned char* base = static_cast<const unsigned char*>(bytes);
+    size_t capacity = static_cast<size_t>(header.capacity);
+
+    SlotBuffer loaded(capacity, getResource());
+    OccupancyBitmap bits(0, getResource());
+    bits.assignWords(capacity, base + layout.bitmapOffset);
+
+    // Values (and the queue behind them) are read sequentially
+    KeyArraySnapshotReader in(base + layout.valueOffset, size - layout.valueOffset);
+    size_t count = 0;
+    size_t i = bits.findNext(0);
+    try {
+        for (; i < capacity; i = bits.findNext(i + 1), ++count) {
+            if constexpr (Raw) {
+                KeyArraySnapshotReader cell(base + layout.valueOffset + i * sizeof(T), sizeof(T));
+                loaded.construct(i, cell.template readValue<T>());
+            } else {
+                loaded.construct(i, Serializer::read(in));
+            }
+        }
+    } catch (...) {
+        for (size_t j = bits.findNext(0); j < i; j = bits.findNext(j + 1)) loaded.destroy(j);
+        throw;
+    }
 
-    file >> label >> std::boolalpha >> resizingEnabled;
-    file >> label >> std::boolalpha >> queueEnabled;
+    OverflowQueue pending = emptyQueue();
+    BasicIntrusiveKeyPool<Order, Key> restoredPool;
+    try {
+        if (count != header.elementCount) {
+            throw std::runtime_error("Corrupt KeyArray snapshot: element count mismatch.");
+        }
+        if (queueLimit != 0 && header.queueCount > queueLimit) {
+            throw std::runtime_error("Snapshot queue exceeds the overflow queue limit.");
+        }
 
-    size_t queueSize = 0;
-    file >> label >> queueSize;
+        // Keys at or past the bump cursor are handed out next, so none may be
+        // live, unless the snapshot was saved mid-shrink (reclaimed below)
+        if (header.poolMax + 1 == static_cast<int64_t>(capacity) &&
+            bits.findNext(static_cast<size_t>(header.poolNext)) < capacity) {
+            throw std::runtime_error("Corrupt KeyArray snapshot: live key past the pool range.");
+        }
 
-    std::string entriesLabel;
-    file >> entriesLabel; // entries:
+        if constexpr (Raw) {
+            KeyArraySnapshotReader queueIn(base + layout.queueOffset, size - layout.queueOffset);
+            for (uint64_t q = 0; q < header.queueCount; ++q) pending.push(queueIn.template readValue<T>());
+        } else {
+            for (uint64_t q = 0; q < header.queueCount; ++q) pending.push(Serializer::read(in));
+        }
 
-    int key;
-    T value;
+        // The saved list is in pop order; refilling reproduces it. Version 3
+        // stored its entries in 32 bits
+        restoredPool.restore(static_cast<Key>(header.poolMin), static_cast<Key>(header.poolNext),
+                             static_cast<Key>(header.poolMax));
+        bool narrow = KeyArraySnapshotHeader::freeKeySize(header.version) == sizeof(int32_t);
+        KeyArraySnapshotReader freeIn(base + layout.freeListOffset,
+                                      header.freeCount * KeyArraySnapshotHeader::freeKeySize(header.version));
+        std::vector<Key> freeKeys(static_cast<size_t>(header.freeCount));
+        for (Key& key : freeKeys) {
+            int64_t saved = narrow ? freeIn.readValue<int32_t>() : freeIn.readValue<int64_t>();
+            if (saved < header.poolMin || saved >= header.poolNext || static_cast<size_t>(saved) >= capacity ||
+                bits.test(static_cast<size_t>(saved))) {
+                throw std::runtime_error("Corrupt KeyArray snapshot: invalid free key.");
+            }
+            key = static_cast<Key>(saved);
+        }
+        restoredPool.refill(freeKeys.begin(), freeKeys.end(), loaded);
 
-    while (file >> key) {
-        if (key == -1) break; // Separator between entries and queue
-        file >> value;
-        int actualIndex = key - offset;
-        if (actualIndex >= 0 && actualIndex < static_cast<int>(this->data.size())) {
-            this->data[actualIndex] = value;
-            this->valid[actualIndex] = true;
-            ++this->elementCount;
+        // Saved mid-shrink: the pool stopped short of the capacity, so the free
+        // slots above its range are reopened instead of finishing the shrink
+        if (header.poolMax + 1 < static_cast<int64_t>(capacity)) {
+            restoredPool.reclaim(static_cast<Key>(capacity - 1), loaded, [&](Key key) { return !bits.test(key); });
         }
+    } catch (...) {
+        loaded.destroyLive(bits);
+        throw;
     }
 
-    std::string queueLabel;
-    file >> queueLabel; // queueEntries:
+    // Commit; the old keys are tracked under the old offset, listeners see the new one
+    replaceContents(std::move(loaded), std::move(bits), restoredPool, count);
+    name.assign(reinterpret_cast<const char*>(base + layout.nameOffset), static_cast<size_t>(header.nameLength));
+    offset = savedOffset;
+    resizingEnabled = (header.flags & KeyArraySnapshotHeader::ResizingEnabled) != 0;
+    queueEnabled = (header.flags & KeyArraySnapshotHeader::QueueEnabled) != 0;
+    overflowQueue = std::move(pending);
+    announceContents();
+}
+
+// Drops the current contents, including any resize in progress
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::replaceContents(SlotBuffer&& loaded, OccupancyBitmap&& bits,
+                                                       const BasicIntrusiveKeyPool<Order, Key>& restoredPool, size_t count) {
+    cancelBackgroundResize();
+    markLiveChanged();
+    newData.destroyLive(newValid);
+    newData = SlotBuffer(0, getResource());
+    newValid.clear();
+    copyInProgress = false;
+    copyIndex = 0;
+    shrinkInProgress = false;
+    shrinkRemap = nullptr;
+    this->data.destroyLive(this->valid);
+
+    size_t capacity = bits.size();
+    this->data = std::move(loaded);
+    this->valid = std::move(bits);
+    this->pool = restoredPool;
+    this->lastKey = static_cast<std::ptrdiff_t>(capacity) - 1;
+    this->elementCount = count;
+}
 
-    while (file >> key) {
-        overflowQueue.push(key);
+// Walks both buffers of a resize in progress
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::markLiveChanged() {
+    if (!dirtyTracker) return;
+
+    for (size_t i = nextLive(0); i < endSlot(); i = nextLive(i + 1)) {
+        dirtyTracker->mark(keyOf(i));
     }
+}
 
-    file.close();
+// The change log is not told: it starts over from a fresh base snapshot instead
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::announceContents() {
+    for (KeyArrayListener<T, Key>* listener : listeners) {
+        if (listener == changeLog.get()) continue;
+        listener->onClear();
+        this->valid.forEachSet([&](size_t index) {
+            listener->onInsert(keyOf(index), this->data[index]);
+        });
+    }
+    if (changeLog) {
+        checkpoint();
+    }
 }
 
 /* =========================================================================
    Structural Info & Iterators
    =========================================================================
    These methods expose basic structural information about the KeyArray
-   and provide STL-compatible iterators for traversing the underlying data.
+   and provide STL-compatible iterators over the live (key, value) pairs.
 */
 
 // Returns the offset of the key space (i.e., the first logical key)
-template <typename T>
-int KeyArray<T>::getOffset() const {
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArray<T, Storage, Order, Key>::getOffset() const {
     return offset;
 }
 
 // Returns the last valid key (inclusive upper bound for the logical key range)
-template <typename T>
-int KeyArray<T>::getMaxKeyBound() const {
-    return offset + this->lastKey;
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArray<T, Storage, Order, Key>::getMaxKeyBound() const {
+    return static_cast<Key>(offset + static_cast<Key>(this->lastKey));
 }
 
-// Returns a modifiable iterator to the beginning of the internal data array
-template <typename T>
-auto KeyArray<T>::begin() {
-    return this->data.begin();
+// Includes the slots of a resize or shrink in progress
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArray<T, Storage, Order, Key>::getCapacity() const {
+    return static_cast<size_t>(this->lastKey + 1);
 }
 
-// Returns a modifiable iterator to the end of the internal data array
-template <typename T>
-auto KeyArray<T>::end() {
-    return this->data.end();
+// The slot buffer's resource; every other buffer shares it
+template <typename T, typename Storage, typename Order, typename Key>
+std::pmr::memory_resource* KeyArray<T, Storage, Order, Key>::getResource() const {
+    return this->data.resource();
 }
 
-// Returns a const iterator to the beginning of the internal data array
-template <typename T>
-auto KeyArray<T>::begin() const {
-    return this->data.begin();
+// Counters come from the recorder; the rest is read off the array as it is.
+// A background copy is reported at the size the helper allocates: the grown
+// buffer and its flags, plus the dirty flags over the buffer being copied.
+// Those are computed from the capacities, since the helper may still be
+// allocating them.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayStats KeyArray<T, Storage, Order, Key>::getStats() const {
+    KeyArrayStats stats;
+    KEYARRAY_STAT(stats = statsRecorder.totals;)
+
+    stats.queueSize = overflowQueue.size();
+    stats.size = this->elementCount;
+    stats.capacity = getCapacity();
+    stats.occupancy = stats.capacity ? static_cast<double>(stats.size) / static_cast<double>(stats.capacity) : 0.0;
+
+    size_t handedOut = static_cast<size_t>(this->pool.getCurrentValue() - this->pool.getMinValue());
+    stats.fragmentation = handedOut ? static_cast<double>(this->pool.recycledCount()) / static_cast<double>(handedOut) : 0.0;
+
+    stats.dataBytes = this->data.bytes() + this->valid.bytes();
+    stats.resizeBytes = newData.bytes() + newValid.bytes();
+    if (background) {
+        auto bitmapBytes = [](size_t bits) {
+            return (bits + OccupancyBitmap::WordBits - 1) / OccupancyBitmap::WordBits * sizeof(uint64_t);
+        };
+        size_t slotBytes = this->data.bytes() / background->capacity;
+        stats.resizeBytes += background->targetCapacity * slotBytes + bitmapBytes(background->targetCapacity) +
+                             bitmapBytes(background->capacity);
+    }
+    stats.queueBytes = overflowQueue.capacity() * sizeof(T);
+    return stats;
 }
 
-// Returns a const iterator to the end of the internal data array
-template <typename T>
-auto KeyArray<T>::end() const {
-    return this->data.end();
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArray<T, Storage, Order, Key>::resetStats() {
+    KEYARRAY_STAT(statsRecorder.totals = KeyArrayStats();)
+}
+
+// Returns a modifiable iterator to the first live (key, value) pair
+template <typename T, typename Storage, typename Order, typename Key>
+auto KeyArray<T, Storage, Order, Key>::begin() {
+    return LiveIterator<false>(this, nextLive(0));
+}
+
+// Returns a modifiable iterator past the last live pair
+template <typename T, typename Storage, typename Order, typename Key>
+auto KeyArray<T, Storage, Order, Key>::end() {
+    return LiveIterator<false>(this, endSlot());
+}
+
+// Returns a const iterator to the first live (key, value) pair
+template <typename T, typename Storage, typename Order, typename Key>
+auto KeyArray<T, Storage, Order, Key>::begin() const {
+    return LiveIterator<true>(this, nextLive(0));
+}
+
+// Returns a const iterator past the last live pair
+template <typename T, typename Storage, typename Order, typename Key>
+auto KeyArray<T, Storage, Order, Key>::end() const {
+    return LiveIterator<true>(this, endSlot());
 }
 
 
@@ -676,6 +3913,26 @@ auto KeyArray<T>::end() const {
 
 
 
-    
+// Prints the live (key, value) pairs of both buffers in ascending key order
+template <typename T, typename Storage, typename Order, typename Key>
+std::ostream& operator<<(std::ostream& os, const KeyArray<T, Storage, Order, Key>& array) {
+    os << "KeyArray (Size: " << array.size() << ") [";
+    for (size_t i = array.nextLive(0); i < array.endSlot(); i = array.nextLive(i + 1)) {
+        os << "(" << +array.keyOf(i) << ": " << array.bufferOf(i)[i] << ") ";
+    }
+    os << "]";
+    return os;
+}
+
+
+
+// KeyArray whose slots carry generation counters, enabling KeyHandle lookups
+template <typename T>
+using GenerationalKeyArray = KeyArray<T, SlotStorage<T, true>>;
+
+// KeyArray on paged storage: growth never moves elements, so references stay valid
+template <typename T, bool Generational = false>
+using PagedKeyArray = KeyArray<T, PagedSlotStorage<T, Generational>>;
+
 
 #endif // KEYARRAY_HPP
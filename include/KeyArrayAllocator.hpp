@@ -0,0 +1,66 @@
+// KeyArrayAllocator: Memory-resource allocator shared by KeyArray buffers
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYALLOCATOR_HPP
+#define KEYARRAYALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+
+/**
+ * @brief KeyArrayAllocator allocates from a std::pmr::memory_resource
+ *        (an arena, a pool, a shared-memory or hugepage resource).
+ *
+ *        Unlike std::pmr::polymorphic_allocator it propagates on copy, move
+ *        and swap: every buffer of a KeyArray travels with its resource, so
+ *        a moved or assigned array never frees into the wrong resource, and
+ *        a copy allocates from the same resource as its source.
+ *
+ *        A null resource means std::pmr::get_default_resource(), i.e.
+ *        new/delete unless the program replaced it.
+ */
+template <typename U>
+class KeyArrayAllocator {
+public:
+
+    using value_type = U;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    // Allocates from `resource` (the default resource if null)
+    KeyArrayAllocator(std::pmr::memory_resource* resource = nullptr) noexcept
+        : source(resource ? resource : std::pmr::get_default_resource()) {}
+
+    template <typename V>
+    KeyArrayAllocator(const KeyArrayAllocator<V>& other) noexcept : source(other.resource()) {}
+
+    U* allocate(size_t n) {
+        return static_cast<U*>(source->allocate(n * sizeof(U), alignof(U)));
+    }
+
+    void deallocate(U* pointer, size_t n) noexcept {
+        source->deallocate(pointer, n * sizeof(U), alignof(U));
+    }
+
+    // Returns the resource behind this allocator
+    std::pmr::memory_resource* resource() const noexcept { return source; }
+
+    template <typename V>
+    bool operator==(const KeyArrayAllocator<V>& other) const noexcept {
+        return source == other.resource() || source->is_equal(*other.resource());
+    }
+
+    template <typename V>
+    bool operator!=(const KeyArrayAllocator<V>& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    std::pmr::memory_resource* source;
+};
+
+
+#endif // KEYARRAYALLOCATOR_HPP
@@ -4,21 +4,42 @@
 #ifndef KEYARRAYBASE_HPP
 #define KEYARRAYBASE_HPP
 
-#include "KeyPool.hpp"
+#include "IntrusiveKeyPool.hpp"
+#include "OccupancyBitmap.hpp"
+#include "SlotStorage.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 #include <optional>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
-template <typename T>
+template <typename T, typename Storage = SlotStorage<T>, typename Order = LifoKeyOrder, typename Key = int>
 class KeyArrayBase {
 public:
 
+    // The integer type of keys (see KeyTraits.hpp)
+    using KeyType = Key;
+
     // ───────────────────────────────────────────────────────────── //
     // 🔹 Construction
     // ───────────────────────────────────────────────────────────── //
 
-    // Constructs a key array with keys ranging from 0 to limitKey - 1
-    KeyArrayBase(int limitKey = 100);
+    // Constructs a key array with keys ranging from 0 to limitKey - 1, allocating
+    // from `resource` (the default resource if null)
+    KeyArrayBase(Key limitKey = 100, std::pmr::memory_resource* resource = nullptr);
+
+    // Copies every live element into freshly allocated slots
+    KeyArrayBase(const KeyArrayBase& other);
+    KeyArrayBase& operator=(const KeyArrayBase& other);
+
+    // Takes over the slot storage of another array
+    KeyArrayBase(KeyArrayBase&& other) noexcept;
+    KeyArrayBase& operator=(KeyArrayBase&& other) noexcept;
+
+    // Destroys all live elements
+    virtual ~KeyArrayBase();
 
 
     // ───────────────────────────────────────────────────────────── //
@@ -26,10 +47,17 @@ public:
     // ───────────────────────────────────────────────────────────── //
 
     // Inserts a value into the next available key and returns the key
-    virtual int insert(const T& value);
+    virtual Key insert(const T& value);
+
+    // Moves a value into the next available key and returns the key
+    virtual Key insert(T&& value);
+
+    // Constructs a value in place at the next available key and returns the key
+    template <typename... Args>
+    Key emplace(Args&&... args);
 
     // Removes the value associated with the given key
-    virtual void remove(int key);
+    virtual void remove(Key key);
 
 
     // ───────────────────────────────────────────────────────────── //
@@ -37,7 +65,7 @@ public:
     // ───────────────────────────────────────────────────────────── //
 
     // Returns true if the given key is valid and currently in use
-    virtual bool hasKey(int key) const;
+    virtual bool hasKey(Key key) const;
 
     // Returns true if the given value exists in the structure (linear search)
     virtual bool contains(const T& value) const;
@@ -48,10 +76,10 @@ public:
     // ───────────────────────────────────────────────────────────── //
 
     // Returns a reference to the value at the given key
-    virtual T& at(int key);
+    virtual T& at(Key key);
 
     // Returns a const reference to the value at the given key
-    virtual const T& at(int key) const;
+    virtual const T& at(Key key) const;
 
 
     // ───────────────────────────────────────────────────────────── //
@@ -73,31 +101,70 @@ public:
     virtual void clear();
 
     // Prints the structure to the output stream
-    template<typename U>
-    friend std::ostream& operator<<(std::ostream& os, const KeyArrayBase<U>& array);
+    template <typename U, typename S, typename O, typename K>
+    friend std::ostream& operator<<(std::ostream& os, const KeyArrayBase<U, S, O, K>& array);
 
 
 
 
 protected:
+    // -------------------------
+    // Derived Construction
+    // -------------------------
+
+    // The storage policy with free-list links as wide as a key
+    using SlotBuffer = typename Storage::template WithLink<Key>;
+
+    // Key pool over slots [0, last]; exhausted for last = -1, which a
+    // reversed range cannot express for unsigned keys
+    static BasicIntrusiveKeyPool<Order, Key> poolUpTo(std::ptrdiff_t last);
+
+    // Number of slots from 0 that the pool has handed out since its last
+    // reset; no slot at or past it is live (outside a shrink in progress)
+    size_t usedSlots() const;
+
+    // Destroys the elements below slot `used`, clears their flags and resets
+    // the key pool in place, all in O(used / 64 + live): nothing is freed
+    // and the rest of the capacity is never touched
+    void clearSlots(size_t used);
+
+    // Tag for the copy constructor that leaves free-list links to the caller
+    struct WithoutLinks {};
+
+    // Copies the live elements and metadata of another array, but not the
+    // free-list links (for derived classes whose links span extra storage)
+    KeyArrayBase(const KeyArrayBase& other, WithoutLinks);
+
+
+    // -------------------------
+    // Non-virtual Fast Path
+    // -------------------------
+
+    // Returns true if the slot index is in range and live. Unlike hasKey this
+    // never dispatches virtually, so derived key mappings cannot affect it.
+    bool isLive(size_t index) const noexcept;
+
+
     // -------------------------
     // Core Storage and Metadata
     // -------------------------
 
-    // The highest key allowed (inclusive upper bound)
-    int lastKey;
+    // The highest key allowed (inclusive upper bound), as a slot index;
+    // -1 when there are no slots
+    std::ptrdiff_t lastKey;
 
     // Number of active (valid) elements in the structure
     size_t elementCount;
 
-    // Underlying data storage for elements
-    std::vector<T> data;
+    // Underlying slot storage for elements (constructed only while valid)
+    SlotBuffer data;
 
-    // Parallel validity flags for each key
-    std::vector<bool> valid;
+    // Parallel validity flags for each key, packed into 64-bit words
+    OccupancyBitmap valid;
 
-    // Key pool for managing available keys (reuse and allocation)
-    KeyPool pool;
+    // Key pool for managing available keys (reuse and allocation); recycled
+    // keys are reused in Order and linked through the free slots of `data`
+    BasicIntrusiveKeyPool<Order, Key> pool;
 
 };
 
@@ -106,57 +173,164 @@ protected:
 
 
 // ===============================
-// KeyArrayBase<T>: Implementations
+// KeyArrayBase<T, Storage, Order, Key>: Implementations
 // ===============================
 
-template <typename T>
-KeyArrayBase<T>::KeyArrayBase(int limitKey)
-    : lastKey(limitKey - 1), elementCount(0) {
-    
-    data.resize(lastKey + 1);
-    valid.resize(lastKey + 1, false);
-    pool = KeyPool(0, lastKey);
+// Allocates raw slots only; no element is constructed until it is inserted.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>::KeyArrayBase(Key limitKey, std::pmr::memory_resource* resource)
+    : lastKey(static_cast<std::ptrdiff_t>(limitKey) - 1), elementCount(0), data(limitKey, resource), valid(0, resource) {
+
+    valid.assign(lastKey + 1);
+    pool = poolUpTo(lastKey);
+}
+
+// Copy-constructs the live elements of another array.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>::KeyArrayBase(const KeyArrayBase& other)
+    : KeyArrayBase(other, WithoutLinks{}) {
+
+    pool.copyLinks(other.data, data);
+}
+
+// Copy-constructs the live elements only; recycled keys keep their pool state.
+// The copy allocates from the same memory resource.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>::KeyArrayBase(const KeyArrayBase& other, WithoutLinks)
+    : lastKey(other.lastKey), elementCount(other.elementCount),
+      data(other.data.capacity(), other.data.resource()), valid(other.valid), pool(other.pool) {
+
+    data.copyLive(other.data, valid);
+}
+
+// Copy-assigns through a temporary so a throwing copy leaves this array intact.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>& KeyArrayBase<T, Storage, Order, Key>::operator=(const KeyArrayBase& other) {
+    if (this != &other) {
+        KeyArrayBase copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+// Steals the storage of another array, leaving it empty with no capacity.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>::KeyArrayBase(KeyArrayBase&& other) noexcept
+    : lastKey(other.lastKey), elementCount(other.elementCount),
+      data(std::move(other.data)), valid(std::move(other.valid)), pool(std::move(other.pool)) {
+
+    other.lastKey = -1;
+    other.elementCount = 0;
+    other.valid.clear();
+    other.pool = poolUpTo(-1);
+}
+
+// Releases the current elements and steals the storage of another array.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>& KeyArrayBase<T, Storage, Order, Key>::operator=(KeyArrayBase&& other) noexcept {
+    if (this != &other) {
+        data.destroyLive(valid);
+
+        lastKey = other.lastKey;
+        elementCount = other.elementCount;
+        data = std::move(other.data);
+        valid = std::move(other.valid);
+        pool = std::move(other.pool);
+
+        other.lastKey = -1;
+        other.elementCount = 0;
+        other.valid.clear();
+        other.pool = poolUpTo(-1);
+    }
+    return *this;
+}
+
+// Destroys all live elements; the raw slots are released by SlotStorage.
+template <typename T, typename Storage, typename Order, typename Key>
+KeyArrayBase<T, Storage, Order, Key>::~KeyArrayBase() {
+    data.destroyLive(valid);
 }
 
 // Inserts a new value into the structure and returns its assigned key.
 // Throws std::runtime_error if no keys are available.
-template <typename T>
-int KeyArrayBase<T>::insert(const T& value) {
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArrayBase<T, Storage, Order, Key>::insert(const T& value) {
+    return emplace(value);
+}
+
+// Moves a new value into the structure and returns its assigned key.
+// Throws std::runtime_error if no keys are available.
+template <typename T, typename Storage, typename Order, typename Key>
+Key KeyArrayBase<T, Storage, Order, Key>::insert(T&& value) {
+    return emplace(std::move(value));
+}
+
+// Constructs a new value directly in its slot and returns its assigned key.
+// Throws std::runtime_error if no keys are available. If the constructor
+// throws, the key is handed back to the pool and the structure is unchanged.
+template <typename T, typename Storage, typename Order, typename Key>
+template <typename... Args>
+Key KeyArrayBase<T, Storage, Order, Key>::emplace(Args&&... args) {
     if (pool.empty()) {
         throw std::runtime_error("KeyPool is empty. No available keys.");
     }
 
-    int key = pool.pop();
-    data[key] = value;
-    valid[key] = true;
+    Key key = pool.pop(data);
+    try {
+        data.construct(key, std::forward<Args>(args)...);
+    } catch (...) {
+        pool.push(key, data);
+        throw;
+    }
+    valid.set(key);
     ++elementCount;
     return key;
 }
 
-// Removes the element associated with the given key.
+// Removes and destroys the element associated with the given key.
 // Throws std::out_of_range if the key is not valid or inactive.
-template <typename T>
-void KeyArrayBase<T>::remove(int key) {
-    if (!hasKey(key)) {
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArrayBase<T, Storage, Order, Key>::remove(Key key) {
+    if (!isLive(static_cast<size_t>(key))) {
         throw std::out_of_range("Key is not valid or not in use");
     }
 
-    valid[key] = false;
+    data.destroy(key);
+    valid.reset(key);
     --elementCount;
-    pool.push(key);
+    pool.push(key, data);
 }
 
 // Checks if a given key is within range and currently holds a valid value.
-template <typename T>
-bool KeyArrayBase<T>::hasKey(int key) const {
-    return key >= 0 && key <= lastKey && valid[key];
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArrayBase<T, Storage, Order, Key>::hasKey(Key key) const {
+    return isLive(static_cast<size_t>(key));
+}
+
+// Builds the pool an array of lastKey + 1 slots starts with
+template <typename T, typename Storage, typename Order, typename Key>
+BasicIntrusiveKeyPool<Order, Key> KeyArrayBase<T, Storage, Order, Key>::poolUpTo(std::ptrdiff_t last) {
+    BasicIntrusiveKeyPool<Order, Key> fresh(0, 0);
+    if (last < 0) {
+        fresh.restore(0, 1, 0);
+    } else {
+        fresh.reset(0, static_cast<Key>(last));
+    }
+    return fresh;
+}
+
+// Negative keys wrap to huge indices, so one unsigned compare covers both bounds.
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArrayBase<T, Storage, Order, Key>::isLive(size_t index) const noexcept {
+    return index < valid.size() && valid.test(index);
 }
 
 // Performs a linear search to check if the given value exists in the structure.
-template <typename T>
-bool KeyArrayBase<T>::contains(const T& value) const {
-    for (int i = 0; i <= lastKey; ++i) {
-        if (valid[i] && data[i] == value) {
+// Only live slots are compared; empty words of the bitmap are skipped whole.
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArrayBase<T, Storage, Order, Key>::contains(const T& value) const {
+    for (size_t i = valid.findNext(0); i < valid.size(); i = valid.findNext(i + 1)) {
+        if (data[i] == value) {
             return true;
         }
     }
@@ -165,9 +339,9 @@ bool KeyArrayBase<T>::contains(const T& value) const {
 
 // Returns a modifiable reference to the value at the given key.
 // Throws std::out_of_range if the key is invalid or unused.
-template <typename T>
-T& KeyArrayBase<T>::at(int key) {
-    if (!hasKey(key)) {
+template <typename T, typename Storage, typename Order, typename Key>
+T& KeyArrayBase<T, Storage, Order, Key>::at(Key key) {
+    if (!isLive(static_cast<size_t>(key))) {
         throw std::out_of_range("Invalid key");
     }
     return data[key];
@@ -175,44 +349,59 @@ T& KeyArrayBase<T>::at(int key) {
 
 // Returns a constant reference to the value at the given key.
 // Throws std::out_of_range if the key is invalid or unused.
-template <typename T>
-const T& KeyArrayBase<T>::at(int key) const {
-    if (!hasKey(key)) {
+template <typename T, typename Storage, typename Order, typename Key>
+const T& KeyArrayBase<T, Storage, Order, Key>::at(Key key) const {
+    if (!isLive(static_cast<size_t>(key))) {
         throw std::out_of_range("Invalid key");
     }
     return data[key];
 }
 
 // Returns the number of currently stored elements in the structure.
-template <typename T>
-size_t KeyArrayBase<T>::size() const {
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArrayBase<T, Storage, Order, Key>::size() const {
     return elementCount;
 }
 
 // Returns true if the structure contains no elements.
-template <typename T>
-bool KeyArrayBase<T>::empty() const {
+template <typename T, typename Storage, typename Order, typename Key>
+bool KeyArrayBase<T, Storage, Order, Key>::empty() const {
     return elementCount == 0;
 }
 
-// Clears all elements in the structure and resets the key pool.
-template <typename T>
-void KeyArrayBase<T>::clear() {
-    data = std::vector<T>(lastKey + 1);
-    valid = std::vector<bool>(lastKey + 1, false);
+// Destroys all elements and resets the key pool, keeping the allocated slots.
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArrayBase<T, Storage, Order, Key>::clear() {
+    clearSlots(usedSlots());
+}
+
+// Keys are slot indices here, so the bump cursor bounds every live slot
+template <typename T, typename Storage, typename Order, typename Key>
+size_t KeyArrayBase<T, Storage, Order, Key>::usedSlots() const {
+    return std::min(static_cast<size_t>(pool.getCurrentValue()), data.capacity());
+}
+
+// Only the words below `used` can hold set bits, so per-frame tables that
+// clear often pay for the slots they filled, not for their capacity
+template <typename T, typename Storage, typename Order, typename Key>
+void KeyArrayBase<T, Storage, Order, Key>::clearSlots(size_t used) {
+    data.destroyLive(valid, used);
+    valid.clearBelow(used);
     elementCount = 0;
-    pool = KeyPool(0, lastKey);
+    if (lastKey < 0) {
+        pool = poolUpTo(lastKey);
+    } else {
+        pool.reset(0, static_cast<Key>(lastKey));
+    }
 }
 
 // Prints the contents of the structure to the given output stream.
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const KeyArrayBase<T>& array) {
+template <typename T, typename Storage, typename Order, typename Key>
+std::ostream& operator<<(std::ostream& os, const KeyArrayBase<T, Storage, Order, Key>& array) {
     os << "KeyArrayBase (Size: " << array.size() << ") [";
-    for (int i = 0; i <= array.lastKey; ++i) {
-        if (array.valid[i]) {
-            os << "(" << i << ": " << array.data[i] << ") ";
-        }
-    }
+    array.valid.forEachSet([&](size_t i) {
+        os << "(" << i << ": " << array.data[i] << ") ";
+    });
     os << "]";
     return os;
 }
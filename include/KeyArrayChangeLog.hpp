@@ -0,0 +1,421 @@
+// KeyArrayChangeLog: Append-only change log for incremental persistence
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYCHANGELOG_HPP
+#define KEYARRAYCHANGELOG_HPP
+
+#include "KeyArrayListener.hpp"
+#include "KeyArraySnapshot.hpp"
+#include "KeyTraits.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Group-commit and compaction settings of a change log
+struct KeyArrayLogPolicy {
+    // Commit once this many records are buffered
+    size_t commitRecords = 256;
+
+    // Commit the buffer once it is older than this (checked on append); 0 = on count alone
+    std::chrono::milliseconds commitInterval{ 10 };
+
+    // Ask for compaction (a fresh snapshot) once the log exceeds this many bytes; 0 = never
+    size_t compactBytes = size_t(64) << 20;
+};
+
+
+/**
+ * @brief KeyArrayChangeLogBase is the value-independent half of a change
+ *        log: the file, the group-commit buffer and the records that carry
+ *        no value. KeyArray holds its log through this class, so arrays whose
+ *        values cannot be serialized never instantiate a Serializer.
+ *
+ *        File layout: a header naming the snapshot the log applies to (by
+ *        digest), followed by records of
+ *            uint32 length | uint8 type | int64 key | payload
+ *        A torn record at the end (a crash mid-write) is ignored on replay.
+ *        Keys of any Key type are stored in the int64 field (unsigned ones
+ *        wrap into it and back). Logs of the first format, whose keys were
+ *        int32, are still replayed.
+ *
+ *        commit() flushes to the OS; it does not fsync.
+ */
+template <typename T, typename Key = int>
+class KeyArrayChangeLogBase : public KeyArrayListener<T, Key> {
+public:
+
+    // Record types
+    enum class Record : uint8_t { Insert = 1, Remove = 2, Update = 3, Swap = 4, Clear = 5, Admit = 6, Drop = 7 };
+
+    // Identifies change log files
+    static constexpr char Magic[8] = { 'K', 'E', 'Y', 'A', 'L', 'O', 'G', '2' };
+
+    // Identifies logs of the first format, with int32 keys
+    static constexpr char MagicV1[8] = { 'K', 'E', 'Y', 'A', 'L', 'O', 'G', '1' };
+
+    // Commits whatever is still buffered
+    ~KeyArrayChangeLogBase() override;
+
+    KeyArrayChangeLogBase(const KeyArrayChangeLogBase&) = delete;
+    KeyArrayChangeLogBase& operator=(const KeyArrayChangeLogBase&) = delete;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Recording (KeyArrayListener)
+    // ──────────────────────────────────────────────
+
+    void onRemove(Key key, const T& value) override;
+    void onSwap(Key key1, Key key2) override;
+    void onAdmit(Key key, const T& value) override;
+    void onDrop(const T& value) override;
+    void onClear() override;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Commit and Compaction
+    // ──────────────────────────────────────────────
+
+    // Writes all buffered records to the file and flushes it
+    void commit();
+
+    // Starts over for a new base snapshot, dropping every record
+    void restart(uint64_t baseDigest);
+
+    // Returns true once the committed log has outgrown the compaction limit
+    bool needsCompaction() const;
+
+    // Returns the number of bytes written to the file (excluding the buffer)
+    size_t committedBytes() const;
+
+    // Returns the number of records waiting in the buffer
+    size_t pendingRecords() const;
+
+
+protected:
+
+    // Creates (or truncates) the log for the snapshot with the given digest
+    KeyArrayChangeLogBase(const std::string& path, uint64_t baseDigest, const KeyArrayLogPolicy& policy);
+
+    // Starts a record; returns the buffer position of its length field
+    size_t beginRecord(Record type, Key key);
+
+    // Patches the record length and commits if the policy says so
+    void endRecord(size_t start);
+
+    // Records not yet written
+    std::string buffer;
+
+private:
+
+    // Log file path
+    std::string path;
+
+    // Open log file
+    std::ofstream file;
+
+    // Group-commit and compaction settings
+    KeyArrayLogPolicy policy;
+
+    // Number of records in the buffer
+    size_t pending = 0;
+
+    // Bytes written to the file so far
+    size_t committed = 0;
+
+    // Time of the first pending record (only read with a commit interval)
+    std::chrono::steady_clock::time_point lastCommit;
+};
+
+
+/**
+ * @brief KeyArrayChangeLog records the mutations of a KeyArray as compact
+ *        binary records appended to a log file, so a checkpoint costs
+ *        O(changes) instead of O(table). Records are buffered in memory and
+ *        written together (group commit) once the policy says so.
+ *
+ *        Values are written with Serializer (see KeyArraySnapshot.hpp).
+ */
+template <typename T, typename Serializer = KeyArraySerializer<T>, typename Key = int>
+class KeyArrayChangeLog final : public KeyArrayChangeLogBase<T, Key> {
+public:
+
+    using Record = typename KeyArrayChangeLogBase<T, Key>::Record;
+
+    // Creates (or truncates) the log for the snapshot with the given digest
+    KeyArrayChangeLog(const std::string& path, uint64_t baseDigest, const KeyArrayLogPolicy& policy = {});
+
+    void onInsert(Key key, const T& value) override;
+    void onUpdate(Key key, const T& value) override;
+
+    // Applies the records of a log to an array loaded from the snapshot with
+    // the given digest. A log written for another snapshot is skipped (it is
+    // already contained in a newer one). Returns the number of records applied.
+    // Throws std::runtime_error if the records do not match the array.
+    template <typename Array>
+    static size_t replay(const std::string& path, uint64_t baseDigest, Array& array);
+
+private:
+
+    // Appends a value record
+    void writeValueRecord(Record type, Key key, const T& value);
+};
+
+
+// ===============================
+// KeyArrayChangeLogBase<T, Key>: Implementations
+// ===============================
+
+template <typename T, typename Key>
+KeyArrayChangeLogBase<T, Key>::KeyArrayChangeLogBase(const std::string& path, uint64_t baseDigest,
+                                                     const KeyArrayLogPolicy& policy)
+    : path(path), policy(policy) {
+    restart(baseDigest);
+}
+
+template <typename T, typename Key>
+KeyArrayChangeLogBase<T, Key>::~KeyArrayChangeLogBase() {
+    try {
+        commit();
+    } catch (...) {
+        // Destructors must not throw; the records are lost like on a crash
+    }
+}
+
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::onRemove(Key key, const T&) {
+    endRecord(beginRecord(Record::Remove, key));
+}
+
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::onSwap(Key key1, Key key2) {
+    size_t start = beginRecord(Record::Swap, key1);
+    KeyArraySnapshotWriter(buffer).writeValue<int64_t>(static_cast<int64_t>(key2));
+    endRecord(start);
+}
+
+// The value is already in the log, as the insert that queued it
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::onAdmit(Key key, const T&) {
+    endRecord(beginRecord(Record::Admit, key));
+}
+
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::onDrop(const T&) {
+    endRecord(beginRecord(Record::Drop, 0));
+}
+
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::onClear() {
+    endRecord(beginRecord(Record::Clear, 0));
+}
+
+// One write and one flush for the whole group
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::commit() {
+    if (!buffer.empty()) {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        committed += buffer.size();
+        buffer.clear();
+    }
+    pending = 0;
+    file.flush();
+
+    if (!file) {
+        throw std::runtime_error("Unable to write change log.");
+    }
+}
+
+// Truncates the file and writes a header for the new base
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::restart(uint64_t baseDigest) {
+    if (file.is_open()) file.close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open change log.");
+    }
+
+    buffer.clear();
+    pending = 0;
+    committed = 0;
+
+    KeyArraySnapshotWriter out(buffer);
+    out.write(Magic, sizeof(Magic));
+    out.writeValue(baseDigest);
+    commit();
+}
+
+template <typename T, typename Key>
+bool KeyArrayChangeLogBase<T, Key>::needsCompaction() const {
+    return policy.compactBytes != 0 && committed >= policy.compactBytes;
+}
+
+template <typename T, typename Key>
+size_t KeyArrayChangeLogBase<T, Key>::committedBytes() const {
+    return committed;
+}
+
+template <typename T, typename Key>
+size_t KeyArrayChangeLogBase<T, Key>::pendingRecords() const {
+    return pending;
+}
+
+// The length field is filled in by endRecord
+template <typename T, typename Key>
+size_t KeyArrayChangeLogBase<T, Key>::beginRecord(Record type, Key key) {
+    if (pending == 0 && policy.commitInterval.count() != 0) lastCommit = std::chrono::steady_clock::now();
+
+    size_t start = buffer.size();
+    KeyArraySnapshotWriter out(buffer);
+    out.writeValue<uint32_t>(0);
+    out.writeValue(static_cast<uint8_t>(type));
+    out.writeValue<int64_t>(static_cast<int64_t>(key));
+    return start;
+}
+
+// Commits on the record count first; the clock is only read when the count
+// leaves the group open and the policy sets a commit interval
+template <typename T, typename Key>
+void KeyArrayChangeLogBase<T, Key>::endRecord(size_t start) {
+    uint32_t length = static_cast<uint32_t>(buffer.size() - start - sizeof(uint32_t));
+    std::memcpy(&buffer[start], &length, sizeof(length));
+
+    if (++pending >= policy.commitRecords) {
+        commit();
+    } else if (policy.commitInterval.count() != 0 &&
+               std::chrono::steady_clock::now() - lastCommit >= policy.commitInterval) {
+        commit();
+    }
+}
+
+
+// ===============================
+// KeyArrayChangeLog<T, Serializer, Key>: Implementations
+// ===============================
+
+template <typename T, typename Serializer, typename Key>
+KeyArrayChangeLog<T, Serializer, Key>::KeyArrayChangeLog(const std::string& path, uint64_t baseDigest,
+                                                    const KeyArrayLogPolicy& policy)
+    : KeyArrayChangeLogBase<T, Key>(path, baseDigest, policy) {}
+
+template <typename T, typename Serializer, typename Key>
+void KeyArrayChangeLog<T, Serializer, Key>::onInsert(Key key, const T& value) {
+    writeValueRecord(Record::Insert, key, value);
+}
+
+template <typename T, typename Serializer, typename Key>
+void KeyArrayChangeLog<T, Serializer, Key>::onUpdate(Key key, const T& value) {
+    writeValueRecord(Record::Update, key, value);
+}
+
+template <typename T, typename Serializer, typename Key>
+void KeyArrayChangeLog<T, Serializer, Key>::writeValueRecord(Record type, Key key, const T& value) {
+    size_t start = this->beginRecord(type, key);
+    KeyArraySnapshotWriter out(this->buffer);
+    if constexpr (Serializer::Raw) {
+        out.write(&value, sizeof(T));
+    } else {
+        Serializer::write(out, value);
+    }
+    this->endRecord(start);
+}
+
+// Reads the whole log, then applies records in order. Inserts are replayed
+// through the array's own key allocation, which reproduces the logged keys
+// because the snapshot restores the pool exactly; a mismatch means the log
+// and snapshot do not belong together. Admissions and drops of the overflow
+// queue are records of their own, so the array must replay with neither
+// happening by itself (KeyArray::recover sees to that).
+template <typename T, typename Serializer, typename Key>
+template <typename Array>
+size_t KeyArrayChangeLog<T, Serializer, Key>::replay(const std::string& path, uint64_t baseDigest, Array& array) {
+    constexpr const char* Magic = KeyArrayChangeLogBase<T, Key>::Magic;
+    constexpr const char* MagicV1 = KeyArrayChangeLogBase<T, Key>::MagicV1;
+    constexpr size_t MagicSize = sizeof(KeyArrayChangeLogBase<T, Key>::Magic);
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return 0;
+
+    std::vector<unsigned char> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        throw std::runtime_error("Unable to read change log.");
+    }
+
+    if (bytes.size() < MagicSize + sizeof(uint64_t) ||
+        (std::memcmp(bytes.data(), Magic, MagicSize) != 0 && std::memcmp(bytes.data(), MagicV1, MagicSize) != 0)) {
+        throw std::runtime_error("Not a KeyArray change log.");
+    }
+    bool narrow = std::memcmp(bytes.data(), MagicV1, MagicSize) == 0;
+    uint64_t digest;
+    std::memcpy(&digest, bytes.data() + MagicSize, sizeof(digest));
+    if (digest != baseDigest) return 0;
+
+    auto readKey = [narrow](KeyArraySnapshotReader& in) {
+        return narrow ? static_cast<Key>(in.readValue<int32_t>()) : static_cast<Key>(in.readValue<int64_t>());
+    };
+    auto readValue = [](KeyArraySnapshotReader& in) {
+        if constexpr (Serializer::Raw) {
+            return in.template readValue<T>();
+        } else {
+            return Serializer::read(in);
+        }
+    };
+
+    size_t applied = 0;
+    size_t position = MagicSize + sizeof(uint64_t);
+    while (bytes.size() - position >= sizeof(uint32_t)) {
+        uint32_t length;
+        std::memcpy(&length, bytes.data() + position, sizeof(length));
+        position += sizeof(length);
+        if (bytes.size() - position < length) break; // torn tail
+
+        KeyArraySnapshotReader in(bytes.data() + position, length);
+        position += length;
+
+        Record type = static_cast<Record>(in.readValue<uint8_t>());
+        Key key = readKey(in);
+        switch (type) {
+            case Record::Insert:
+                if (array.insert(readValue(in)) != key) {
+                    throw std::runtime_error("Change log does not match the snapshot.");
+                }
+                break;
+            case Record::Remove:
+                array.remove(key);
+                break;
+            case Record::Update:
+                array.update(key, readValue(in));
+                break;
+            case Record::Swap:
+                array.swap(key, readKey(in));
+                break;
+            case Record::Admit:
+                if (array.admitQueued() != key) {
+                    throw std::runtime_error("Change log does not match the snapshot.");
+                }
+                break;
+            case Record::Drop:
+                if (array.getQueueSize() == 0) {
+                    throw std::runtime_error("Change log does not match the snapshot.");
+                }
+                array.getQueue().pop();
+                break;
+            case Record::Clear:
+                array.clear();
+                break;
+            default:
+                throw std::runtime_error("Corrupt change log record.");
+        }
+        ++applied;
+    }
+    return applied;
+}
+
+
+#endif // KEYARRAYCHANGELOG_HPP
@@ -0,0 +1,175 @@
+// KeyArrayDirtyTracker: Changed-key set for incremental replication
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYDIRTYTRACKER_HPP
+#define KEYARRAYDIRTYTRACKER_HPP
+
+#include "KeyArrayListener.hpp"
+#include "KeyTraits.hpp"
+#include "OccupancyBitmap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief KeyArrayDirtyTracker remembers which keys changed since it was last
+ *        drained: one bit per key, set by every mutation it hears about as a
+ *        KeyArrayListener. A key changed many times is reported once, so a
+ *        drain costs O(changed + keys / 64), whatever the write rate.
+ *
+ *        It does not remember what changed: the owner reads the current
+ *        value (or its absence) when draining. A clear names no keys, so
+ *        the owner marks its live keys itself before clearing (KeyArray
+ *        does this); onClear alone changes nothing.
+ *
+ *        Keys below the offset given at construction (after a load that
+ *        moved the key range) are kept in a short list beside the bits.
+ *        Queued values have no key, so KeyArray does not report them here;
+ *        the key a queued value is admitted to is marked instead.
+ */
+template <typename T, typename Key = int>
+class KeyArrayDirtyTracker final : public KeyArrayListener<T, Key> {
+public:
+
+    // Tracks keys from `offset` up, with bits for `capacity` keys reserved
+    explicit KeyArrayDirtyTracker(Key offset = 0, size_t capacity = 0);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Maintenance (KeyArrayListener)
+    // ──────────────────────────────────────────────
+
+    void onInsert(Key key, const T& value) override;
+    void onRemove(Key key, const T& value) override;
+    void onUpdate(Key key, const T& value) override;
+    void onSwap(Key key1, Key key2) override;
+    void onMove(Key from, Key to, const T& value) override;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Tracking
+    // ──────────────────────────────────────────────
+
+    // Marks a key changed
+    void mark(Key key);
+
+    // Calls fn(key) once for every marked key, in ascending order, then
+    // unmarks them all. If fn throws, every key stays marked.
+    template <typename Fn>
+    void drain(Fn&& fn);
+
+    // Returns the number of marked keys
+    size_t size() const;
+
+    // Returns true if no key is marked
+    bool empty() const;
+
+
+private:
+
+    // One bit per key from offset up, grown on demand
+    OccupancyBitmap dirty;
+
+    // Marked keys below offset, unsorted (rare, so searched linearly)
+    std::vector<Key> below;
+
+    // Key of bit 0
+    Key offset;
+
+    // Number of set bits
+    size_t marked = 0;
+};
+
+
+//
+// ░░ Implementation of KeyArrayDirtyTracker ░░
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Key>
+KeyArrayDirtyTracker<T, Key>::KeyArrayDirtyTracker(Key offset, size_t capacity)
+    : dirty(capacity), offset(offset) {}
+
+
+// 🔹 Maintenance
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Key>
+void KeyArrayDirtyTracker<T, Key>::onInsert(Key key, const T&) {
+    mark(key);
+}
+
+
+template <typename T, typename Key>
+void KeyArrayDirtyTracker<T, Key>::onRemove(Key key, const T&) {
+    mark(key);
+}
+
+
+template <typename T, typename Key>
+void KeyArrayDirtyTracker<T, Key>::onUpdate(Key key, const T&) {
+    mark(key);
+}
+
+
+template <typename T, typename Key>
+void KeyArrayDirtyTracker<T, Key>::onSwap(Key key1, Key key2) {
+    mark(key1);
+    mark(key2);
+}
+
+
+template <typename T, typename Key>
+void KeyArrayDirtyTracker<T, Key>::onMove(Key from, Key to, const T&) {
+    mark(from);
+    mark(to);
+}
+
+
+// 🔹 Tracking
+// ────────────────────────────────────────────────────────────────
+
+// The bitmap doubles, so growing to a key past its end is amortized O(1)
+template <typename T, typename Key>
+void KeyArrayDirtyTracker<T, Key>::mark(Key key) {
+    if (key < offset) {
+        if (std::find(below.begin(), below.end(), key) == below.end()) below.push_back(key);
+        return;
+    }
+    size_t bit = KeyTraits<Key>::slotOf(key, offset);
+    if (bit >= dirty.size()) {
+        dirty.resize(std::max(bit + 1, dirty.size() * 2));
+    }
+    if (!dirty.test(bit)) {
+        dirty.set(bit);
+        ++marked;
+    }
+}
+
+
+// Keys below the offset come first, so the whole sequence ascends
+template <typename T, typename Key>
+template <typename Fn>
+void KeyArrayDirtyTracker<T, Key>::drain(Fn&& fn) {
+    std::sort(below.begin(), below.end());
+    for (Key key : below) fn(key);
+    dirty.forEachSet([&](size_t bit) { fn(static_cast<Key>(offset + static_cast<Key>(bit))); });
+
+    below.clear();
+    dirty.clearAll();
+    marked = 0;
+}
+
+
+template <typename T, typename Key>
+size_t KeyArrayDirtyTracker<T, Key>::size() const {
+    return marked + below.size();
+}
+
+
+template <typename T, typename Key>
+bool KeyArrayDirtyTracker<T, Key>::empty() const {
+    return marked == 0 && below.empty();
+}
+
+
+#endif // KEYARRAYDIRTYTRACKER_HPP
@@ -0,0 +1,232 @@
+// KeyArrayEpoch: Epoch-based reclamation for concurrent KeyArrays (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYEPOCH_HPP
+#define KEYARRAYEPOCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief KeyArrayEpoch defers freeing memory that lock-free readers may
+ *        still be looking at (RCU-style epochs).
+ *
+ *        A reader wraps its accesses in a Guard, which publishes the current
+ *        global epoch in the thread's own record: one load, one store and a
+ *        fence, no loop and no shared write, so entering is wait-free.
+ *        A writer that unpublishes an object (e.g. swaps in a new buffer)
+ *        hands the old one to retire(), which stamps it with the epoch and
+ *        advances the global epoch. The object is freed once every reader
+ *        that entered at or before that epoch has left.
+ *
+ *        Records are claimed per thread on first use, kept in a lock-free
+ *        list that never shrinks, and released for reuse at thread exit.
+ *        Retiring is rare (once per resize) and takes a mutex.
+ */
+class KeyArrayEpoch {
+public:
+
+    // ──────────────────────────────────────────────
+    // 🔹 Read-Side Critical Section
+    // ──────────────────────────────────────────────
+
+    // Keeps every object retired from now on alive until it is destroyed
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Reclamation (writers)
+    // ──────────────────────────────────────────────
+
+    // Deletes `object` once no reader can still see it
+    template <typename U>
+    static void retire(U* object);
+
+    // Frees every retired object that no reader can see any more
+    static void reclaim();
+
+    // Returns the number of objects waiting to be freed
+    static size_t pending();
+
+
+private:
+
+    // One thread's published epoch (0 while outside any guard)
+    struct alignas(64) Record {
+        std::atomic<uint64_t> epoch{ 0 };
+        std::atomic<bool> inUse{ false };
+        Record* next = nullptr;
+    };
+
+    // Per-thread state: the claimed record and the guard nesting depth
+    struct ThreadState {
+        Record* record = nullptr;
+        unsigned depth = 0;
+        ~ThreadState();
+    };
+
+    // A retired object with the epoch it was retired in
+    struct Retired {
+        uint64_t epoch;
+        void* object;
+        void (*deleter)(void*);
+    };
+
+    // Deletes an object through its original type
+    template <typename U>
+    static void destroy(void* object);
+
+    // Returns this thread's state, claiming a record on first use
+    static ThreadState& local();
+
+    // Returns the smallest epoch published by any reader
+    static uint64_t oldestReader();
+
+    // Frees what every reader has left behind (mutex held)
+    static void reclaimLocked();
+
+    // Global epoch (starts at 1 so 0 can mean "not reading")
+    inline static std::atomic<uint64_t> globalEpoch{ 1 };
+
+    // All records ever claimed
+    inline static std::atomic<Record*> records{ nullptr };
+
+    // Guards the retired list
+    inline static std::mutex retiredMutex;
+
+    // Objects waiting for readers to leave
+    inline static std::vector<Retired> retired;
+};
+
+
+//
+// ░░ Implementation of KeyArrayEpoch ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Read-Side Critical Section
+// ────────────────────────────────────────────────────────────────
+
+// The fence orders the published epoch before every load the reader makes,
+// so a writer scanning after its swap either sees this reader or the reader
+// sees the swapped pointer. Reading an epoch advanced by a retire (acquire)
+// also means reading every pointer swapped before it.
+inline KeyArrayEpoch::Guard::Guard() {
+    ThreadState& state = local();
+    if (state.depth++ == 0) {
+        state.record->epoch.store(globalEpoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+
+inline KeyArrayEpoch::Guard::~Guard() {
+    ThreadState& state = local();
+    if (--state.depth == 0) {
+        state.record->epoch.store(0, std::memory_order_release);
+    }
+}
+
+
+// 🔹 Reclamation
+// ────────────────────────────────────────────────────────────────
+
+// Readers that loaded the old pointer published an epoch <= the stamp
+template <typename U>
+void KeyArrayEpoch::retire(U* object) {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    uint64_t epoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+    retired.push_back({ epoch, object, &KeyArrayEpoch::destroy<U> });
+    reclaimLocked();
+}
+
+
+template <typename U>
+void KeyArrayEpoch::destroy(void* object) {
+    delete static_cast<U*>(object);
+}
+
+
+inline void KeyArrayEpoch::reclaim() {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    reclaimLocked();
+}
+
+
+inline size_t KeyArrayEpoch::pending() {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    return retired.size();
+}
+
+
+// Frees every entry stamped before the oldest epoch still published
+inline void KeyArrayEpoch::reclaimLocked() {
+    uint64_t oldest = oldestReader();
+    auto done = std::stable_partition(retired.begin(), retired.end(),
+                                      [&](const Retired& entry) { return entry.epoch >= oldest; });
+    std::vector<Retired> freed(done, retired.end());
+    retired.erase(done, retired.end());
+    for (const Retired& entry : freed) {
+        entry.deleter(entry.object);
+    }
+}
+
+
+// 🔹 Records
+// ────────────────────────────────────────────────────────────────
+
+// A reader entering after this scan reads an epoch newer than every stamp so far
+inline uint64_t KeyArrayEpoch::oldestReader() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (Record* record = records.load(std::memory_order_acquire); record; record = record->next) {
+        uint64_t epoch = record->epoch.load(std::memory_order_acquire);
+        if (epoch != 0) oldest = std::min(oldest, epoch);
+    }
+    return oldest;
+}
+
+
+// Reuses a record left by an exited thread before allocating a new one
+inline KeyArrayEpoch::ThreadState& KeyArrayEpoch::local() {
+    thread_local ThreadState state;
+    if (state.record) return state;
+
+    for (Record* record = records.load(std::memory_order_acquire); record; record = record->next) {
+        bool expected = false;
+        if (record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            state.record = record;
+            return state;
+        }
+    }
+
+    Record* record = new Record;
+    record->inUse.store(true, std::memory_order_relaxed);
+    record->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                          std::memory_order_relaxed)) {}
+    state.record = record;
+    return state;
+}
+
+
+inline KeyArrayEpoch::ThreadState::~ThreadState() {
+    if (record) {
+        record->epoch.store(0, std::memory_order_release);
+        record->inUse.store(false, std::memory_order_release);
+    }
+}
+
+
+#endif // KEYARRAYEPOCH_HPP
@@ -0,0 +1,228 @@
+// KeyArrayIndex: Optional value-to-key hash index for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYINDEX_HPP
+#define KEYARRAYINDEX_HPP
+
+#include "KeyArrayListener.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief KeyArrayIndex is a secondary index that keeps itself current as a
+ *        KeyArrayListener. KeyArray holds its index through this class, so
+ *        the hash and equality types stay out of the array's own type.
+ *
+ *        Lookups receive the array they index, so the index stores no
+ *        pointer back to it and survives moving the array.
+ */
+template <typename T, typename Array, typename Key = int>
+class KeyArrayIndex : public KeyArrayListener<T, Key> {
+public:
+
+    // Returns some key holding the value, or std::nullopt
+    virtual std::optional<Key> find(const T& value, const Array& array) const = 0;
+
+    // Returns an empty index of the same type (for copying the array)
+    virtual std::unique_ptr<KeyArrayIndex> cloneEmpty() const = 0;
+
+    // Returns the number of indexed keys
+    virtual size_t size() const = 0;
+};
+
+
+/**
+ * @brief KeyArrayHashIndex maps hash(value) to the keys holding a value with
+ *        that hash. Values are not copied: a lookup hashes the probe, then
+ *        compares it against the array's own values for the keys in that
+ *        bucket, so a probe costs O(1) plus the number of keys sharing its hash.
+ *
+ *        A second map remembers each key's hash, because onUpdate only sees
+ *        the new value and the stale entry has to be found without the old one.
+ *        Values in the overflow queue have no key and are never reported to it.
+ */
+template <typename T, typename Array, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>, typename Key = int>
+class KeyArrayHashIndex final : public KeyArrayIndex<T, Array, Key> {
+public:
+
+    explicit KeyArrayHashIndex(const Hash& hash = Hash(), const Equal& equal = Equal());
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Maintenance (KeyArrayListener)
+    // ──────────────────────────────────────────────
+
+    void onInsert(Key key, const T& value) override;
+    void onRemove(Key key, const T& value) override;
+    void onUpdate(Key key, const T& value) override;
+    void onSwap(Key key1, Key key2) override;
+    void onMove(Key from, Key to, const T& value) override;
+    void onClear() override;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Lookup
+    // ──────────────────────────────────────────────
+
+    std::optional<Key> find(const T& value, const Array& array) const override;
+    std::unique_ptr<KeyArrayIndex<T, Array, Key>> cloneEmpty() const override;
+    size_t size() const override;
+
+
+private:
+
+    // Hashes are already spread by Hash; the map uses them as they are
+    struct Identity {
+        size_t operator()(size_t hash) const noexcept { return hash; }
+    };
+
+    // Adds a (hash, key) entry
+    void link(size_t hash, Key key);
+
+    // Drops the (hash, key) entry
+    void unlink(size_t hash, Key key);
+
+    Hash hash;
+    Equal equal;
+
+    // hash(value) -> keys whose value has that hash
+    std::unordered_multimap<size_t, Key, Identity> keysByHash;
+
+    // key -> hash of its current value
+    std::unordered_map<Key, size_t> hashOfKey;
+};
+
+
+//
+// ░░ Implementation of KeyArrayHashIndex ░░
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+KeyArrayHashIndex<T, Array, Hash, Equal, Key>::KeyArrayHashIndex(const Hash& hash, const Equal& equal)
+    : hash(hash), equal(equal) {}
+
+
+// 🔹 Maintenance
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::onInsert(Key key, const T& value) {
+    size_t h = hash(value);
+    hashOfKey[key] = h;
+    link(h, key);
+}
+
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::onRemove(Key key, const T& value) {
+    (void)value;
+    auto it = hashOfKey.find(key);
+    if (it == hashOfKey.end()) return;
+    unlink(it->second, key);
+    hashOfKey.erase(it);
+}
+
+
+// The stale entry is found through the remembered hash, then re-linked
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::onUpdate(Key key, const T& value) {
+    auto it = hashOfKey.find(key);
+    if (it == hashOfKey.end()) return;
+    size_t h = hash(value);
+    if (h == it->second) return;
+    unlink(it->second, key);
+    it->second = h;
+    link(h, key);
+}
+
+
+// The keys keep their entries; only the hashes trade places
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::onSwap(Key key1, Key key2) {
+    auto first = hashOfKey.find(key1);
+    auto second = hashOfKey.find(key2);
+    if (first == hashOfKey.end() || second == hashOfKey.end()) return;
+    if (first->second == second->second) return;
+
+    unlink(first->second, key1);
+    unlink(second->second, key2);
+    std::swap(first->second, second->second);
+    link(first->second, key1);
+    link(second->second, key2);
+}
+
+
+// The value is unchanged, so its hash is carried over to the new key
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::onMove(Key from, Key to, const T& value) {
+    (void)value;
+    auto it = hashOfKey.find(from);
+    if (it == hashOfKey.end()) return;
+    size_t h = it->second;
+    unlink(h, from);
+    hashOfKey.erase(it);
+    hashOfKey[to] = h;
+    link(h, to);
+}
+
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::onClear() {
+    keysByHash.clear();
+    hashOfKey.clear();
+}
+
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::link(size_t h, Key key) {
+    keysByHash.emplace(h, key);
+}
+
+
+// Scans only the keys sharing this hash
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+void KeyArrayHashIndex<T, Array, Hash, Equal, Key>::unlink(size_t h, Key key) {
+    auto range = keysByHash.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == key) {
+            keysByHash.erase(it);
+            return;
+        }
+    }
+}
+
+
+// 🔹 Lookup
+// ────────────────────────────────────────────────────────────────
+
+// Equal hashes are confirmed against the array's value
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+std::optional<Key> KeyArrayHashIndex<T, Array, Hash, Equal, Key>::find(const T& value, const Array& array) const {
+    auto range = keysByHash.equal_range(hash(value));
+    for (auto it = range.first; it != range.second; ++it) {
+        const T* candidate = array.try_get(it->second);
+        if (candidate && equal(*candidate, value)) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+std::unique_ptr<KeyArrayIndex<T, Array, Key>> KeyArrayHashIndex<T, Array, Hash, Equal, Key>::cloneEmpty() const {
+    return std::make_unique<KeyArrayHashIndex>(hash, equal);
+}
+
+
+template <typename T, typename Array, typename Hash, typename Equal, typename Key>
+size_t KeyArrayHashIndex<T, Array, Hash, Equal, Key>::size() const {
+    return hashOfKey.size();
+}
+
+
+#endif // KEYARRAYINDEX_HPP
@@ -0,0 +1,53 @@
+// KeyArrayListener: Mutation notifications for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYLISTENER_HPP
+#define KEYARRAYLISTENER_HPP
+
+/**
+ * @brief KeyArrayListener receives every mutation of the KeyArray it is
+ *        attached to (see KeyArray::addListener); change logs, indexes and
+ *        dirty trackers are built on it. Keys are external keys (offset
+ *        applied), of the array's key type. Values that went to the overflow
+ *        queue are reported with key KeyTraits<Key>::Queued (-1 for signed
+ *        keys); leaving it again is reported by onAdmit or onDrop.
+ *
+ *        Listeners are called synchronously, after the mutation succeeded
+ *        (onRemove: just before the value is destroyed). Every callback but
+ *        onMove and onAdmit defaults to doing nothing.
+ */
+template <typename T, typename Key = int>
+class KeyArrayListener {
+public:
+
+    virtual ~KeyArrayListener() = default;
+
+    // A value was inserted at the given key (Queued if it was queued)
+    virtual void onInsert(Key key, const T& value) { (void)key; (void)value; }
+
+    // The value at the given key is about to be removed
+    virtual void onRemove(Key key, const T& value) { (void)key; (void)value; }
+
+    // The value at the given key was modified in place
+    virtual void onUpdate(Key key, const T& value) { (void)key; (void)value; }
+
+    // The values of two keys were swapped
+    virtual void onSwap(Key key1, Key key2) { (void)key1; (void)key2; }
+
+    // A value moved to another key by a shrink (defaults to an insert at `to`
+    // followed by a remove at `from`, which a change log replays as such)
+    virtual void onMove(Key from, Key to, const T& value) { onInsert(to, value); onRemove(from, value); }
+
+    // The head of the overflow queue moved into the given key (defaults to an
+    // insert at that key)
+    virtual void onAdmit(Key key, const T& value) { onInsert(key, value); }
+
+    // The head of the overflow queue was dropped to make room (drop-oldest policy)
+    virtual void onDrop(const T& value) { (void)value; }
+
+    // All elements were dropped (clear, or a load that replaced the contents)
+    virtual void onClear() {}
+};
+
+
+#endif // KEYARRAYLISTENER_HPP
@@ -0,0 +1,537 @@
+// KeyArrayScan: Vectorized and parallel scan kernels for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYSCAN_HPP
+#define KEYARRAYSCAN_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Define KEYARRAY_NO_SIMD to build the scalar kernels only
+#if !defined(KEYARRAY_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define KEYARRAY_SCAN_X86 1
+#include <immintrin.h>
+#elif !defined(KEYARRAY_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define KEYARRAY_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+// When scans of a KeyArray go parallel
+struct KeyArrayScanPolicy {
+    // Split a scan across threads once the array spans this many slots; 0 = never
+    size_t parallelSlots = size_t(1) << 22;
+
+    // Threads per parallel scan (0 = std::thread::hardware_concurrency())
+    unsigned threads = 0;
+};
+
+
+/**
+ * @brief KeyArrayScan holds the kernels behind KeyArray's value scans.
+ *
+ *        matchEqual compares a run of up to 64 consecutive slots against one
+ *        value and returns a bit per slot, the same layout as an
+ *        OccupancyBitmap word, so the caller masks it with the live bits in
+ *        one AND. Arithmetic types of 4 or 8 bytes use AVX-512 or AVX2 when
+ *        the CPU has them (checked once at run time, GCC/Clang on x86) or
+ *        NEON on AArch64; everything else uses the scalar loop. limitLevel
+ *        caps the instruction set, down to the scalar loop.
+ *
+ *        parallelChunks splits a range of bitmap words across threads, and
+ *        executeChunks across an executor. Chunks start on whole cache lines
+ *        of the bitmap (LineWords words, 512 slots), so no two threads write
+ *        to the same line of the bitmap or, for values of a power-of-two size,
+ *        of the slots.
+ */
+class KeyArrayScan {
+public:
+
+    // Instruction set behind the vector kernels
+    enum class Level { Scalar, AVX2, AVX512, NEON };
+
+    // Bitmap words per 64-byte cache line; chunks are multiples of it
+    static constexpr size_t LineWords = 64 / sizeof(uint64_t);
+
+    // Whether matchEqual has a vector kernel for T
+    template <typename T>
+    static constexpr bool Vectorized = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                                       (sizeof(T) == 4 || sizeof(T) == 8);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Kernels
+    // ──────────────────────────────────────────────
+
+    // Returns bit i set for every i < count with values[i] == value (count <= 64)
+    template <typename T>
+    static uint64_t matchEqual(const T* values, size_t count, const T& value);
+
+    // Returns the instruction set the kernels use: the one chosen on this CPU,
+    // lowered to the limit set by limitLevel
+    static Level level();
+
+    // Caps the kernels at `highest` for every thread (Scalar turns them off,
+    // AVX2 keeps an AVX-512 CPU off its wide kernels); returns the previous cap
+    static Level limitLevel(Level highest);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Parallel Driver
+    // ──────────────────────────────────────────────
+
+    // Returns the thread count a scan of `slots` slots should use (1 = serial)
+    static unsigned threadsFor(size_t slots, const KeyArrayScanPolicy& policy);
+
+    // Returns the thread count of an explicitly parallel call, whatever the size
+    static unsigned threadsOf(const KeyArrayScanPolicy& policy);
+
+    // Runs fn(chunk, firstWord, lastWord) over `threads` contiguous chunks of
+    // [0, words), the calling thread taking chunk 0; rethrows the first exception
+    template <typename Fn>
+    static void parallelChunks(size_t words, unsigned threads, Fn&& fn);
+
+    // Same over at most `chunks` chunks run by an executor: a callable taking
+    // std::function<void()> tasks (a thread pool's submit, say), the calling
+    // thread taking chunk 0 and waiting for the rest, or a std::execution
+    // policy (include <execution> to pass one); rethrows the first exception
+    template <typename Executor, typename Fn>
+    static void executeChunks(Executor&& executor, size_t words, unsigned chunks, Fn&& fn);
+
+
+private:
+
+    // Returns the instruction set chosen on this CPU
+    static Level detectedLevel();
+
+    // The cap set by limitLevel; the highest enumerator means none
+    static std::atomic<Level>& levelLimit();
+
+    // Words per chunk when [0, words) is split `chunks` ways, rounded up to whole lines
+    static size_t chunkWords(size_t words, unsigned chunks);
+
+    // Kernels for one lane width; each handles the whole vectors of a run,
+    // ORs their bits into mask and returns the number of slots covered
+#if defined(KEYARRAY_SCAN_X86)
+    static size_t avx2Match32(const void* values, size_t count, uint32_t bits, uint64_t& mask);
+    static size_t avx2Match64(const void* values, size_t count, uint64_t bits, uint64_t& mask);
+    static size_t avx2MatchFloat(const float* values, size_t count, float value, uint64_t& mask);
+    static size_t avx2MatchDouble(const double* values, size_t count, double value, uint64_t& mask);
+    static size_t avx512Match32(const void* values, size_t count, uint32_t bits, uint64_t& mask);
+    static size_t avx512Match64(const void* values, size_t count, uint64_t bits, uint64_t& mask);
+    static size_t avx512MatchFloat(const float* values, size_t count, float value, uint64_t& mask);
+    static size_t avx512MatchDouble(const double* values, size_t count, double value, uint64_t& mask);
+#elif defined(KEYARRAY_SCAN_NEON)
+    static size_t neonMatch32(const void* values, size_t count, uint32_t bits, uint64_t& mask);
+    static size_t neonMatch64(const void* values, size_t count, uint64_t bits, uint64_t& mask);
+    static size_t neonMatchFloat(const float* values, size_t count, float value, uint64_t& mask);
+    static size_t neonMatchDouble(const double* values, size_t count, double value, uint64_t& mask);
+#endif
+
+    // Picks the kernel for T; returns the number of slots it covered
+    template <typename T>
+    static size_t vectorMatch(const T* values, size_t count, const T& value, uint64_t& mask);
+};
+
+
+//
+// ░░ Implementation of KeyArrayScan ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Kernels
+// ────────────────────────────────────────────────────────────────
+
+// The vector kernel covers whole vectors; the scalar loop finishes the rest
+template <typename T>
+uint64_t KeyArrayScan::matchEqual(const T* values, size_t count, const T& value) {
+    uint64_t mask = 0;
+    size_t i = 0;
+    if constexpr (Vectorized<T>) {
+        i = vectorMatch(values, count, value, mask);
+    }
+    for (; i < count; ++i) {
+        mask |= uint64_t(values[i] == value) << i;
+    }
+    return mask;
+}
+
+
+// Integers compare bitwise; floating point keeps operator== (NaN never
+// matches, -0.0 == 0.0)
+template <typename T>
+size_t KeyArrayScan::vectorMatch(const T* values, size_t count, const T& value, uint64_t& mask) {
+#if defined(KEYARRAY_SCAN_X86)
+    Level current = level();
+    if (current == Level::Scalar) return 0;
+    bool wide = current == Level::AVX512;
+
+    if constexpr (std::is_same_v<T, float>) {
+        return wide ? avx512MatchFloat(values, count, value, mask) : avx2MatchFloat(values, count, value, mask);
+    } else if constexpr (std::is_same_v<T, double>) {
+        return wide ? avx512MatchDouble(values, count, value, mask) : avx2MatchDouble(values, count, value, mask);
+    } else if constexpr (sizeof(T) == 4) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return wide ? avx512Match32(values, count, bits, mask) : avx2Match32(values, count, bits, mask);
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return wide ? avx512Match64(values, count, bits, mask) : avx2Match64(values, count, bits, mask);
+    }
+#elif defined(KEYARRAY_SCAN_NEON)
+    if (level() == Level::Scalar) return 0;
+
+    if constexpr (std::is_same_v<T, float>) {
+        return neonMatchFloat(values, count, value, mask);
+    } else if constexpr (std::is_same_v<T, double>) {
+        return neonMatchDouble(values, count, value, mask);
+    } else if constexpr (sizeof(T) == 4) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return neonMatch32(values, count, bits, mask);
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return neonMatch64(values, count, bits, mask);
+    }
+#else
+    (void)values;
+    (void)count;
+    (void)value;
+    (void)mask;
+    return 0;
+#endif
+}
+
+
+#if defined(KEYARRAY_SCAN_X86)
+
+// Resolved once; __builtin_cpu_supports also checks that the OS saves the registers
+inline KeyArrayScan::Level KeyArrayScan::detectedLevel() {
+    static const Level detected = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return Level::AVX512;
+        if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+        return Level::Scalar;
+    }();
+    return detected;
+}
+
+
+// 8 lanes per compare, one movemask bit per lane
+__attribute__((target("avx2")))
+inline size_t KeyArrayScan::avx2Match32(const void* values, size_t count, uint32_t bits, uint64_t& mask) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    __m256i needle = _mm256_set1_epi32(static_cast<int>(bits));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i * 4));
+        __m256 equal = _mm256_castsi256_ps(_mm256_cmpeq_epi32(lanes, needle));
+        mask |= uint64_t(static_cast<unsigned>(_mm256_movemask_ps(equal))) << i;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx2")))
+inline size_t KeyArrayScan::avx2Match64(const void* values, size_t count, uint64_t bits, uint64_t& mask) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    __m256i needle = _mm256_set1_epi64x(static_cast<long long>(bits));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i * 8));
+        __m256d equal = _mm256_castsi256_pd(_mm256_cmpeq_epi64(lanes, needle));
+        mask |= uint64_t(static_cast<unsigned>(_mm256_movemask_pd(equal))) << i;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx2")))
+inline size_t KeyArrayScan::avx2MatchFloat(const float* values, size_t count, float value, uint64_t& mask) {
+    __m256 needle = _mm256_set1_ps(value);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 equal = _mm256_cmp_ps(_mm256_loadu_ps(values + i), needle, _CMP_EQ_OQ);
+        mask |= uint64_t(static_cast<unsigned>(_mm256_movemask_ps(equal))) << i;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx2")))
+inline size_t KeyArrayScan::avx2MatchDouble(const double* values, size_t count, double value, uint64_t& mask) {
+    __m256d needle = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d equal = _mm256_cmp_pd(_mm256_loadu_pd(values + i), needle, _CMP_EQ_OQ);
+        mask |= uint64_t(static_cast<unsigned>(_mm256_movemask_pd(equal))) << i;
+    }
+    return i;
+}
+
+
+// 16 lanes per compare straight into a mask register
+__attribute__((target("avx512f")))
+inline size_t KeyArrayScan::avx512Match32(const void* values, size_t count, uint32_t bits, uint64_t& mask) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    __m512i needle = _mm512_set1_epi32(static_cast<int>(bits));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i lanes = _mm512_loadu_si512(bytes + i * 4);
+        mask |= uint64_t(_mm512_cmpeq_epi32_mask(lanes, needle)) << i;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx512f")))
+inline size_t KeyArrayScan::avx512Match64(const void* values, size_t count, uint64_t bits, uint64_t& mask) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    __m512i needle = _mm512_set1_epi64(static_cast<long long>(bits));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i lanes = _mm512_loadu_si512(bytes + i * 8);
+        mask |= uint64_t(_mm512_cmpeq_epi64_mask(lanes, needle)) << i;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx512f")))
+inline size_t KeyArrayScan::avx512MatchFloat(const float* values, size_t count, float value, uint64_t& mask) {
+    __m512 needle = _mm512_set1_ps(value);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        mask |= uint64_t(_mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), needle, _CMP_EQ_OQ)) << i;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx512f")))
+inline size_t KeyArrayScan::avx512MatchDouble(const double* values, size_t count, double value, uint64_t& mask) {
+    __m512d needle = _mm512_set1_pd(value);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        mask |= uint64_t(_mm512_cmp_pd_mask(_mm512_loadu_pd(values + i), needle, _CMP_EQ_OQ)) << i;
+    }
+    return i;
+}
+
+#elif defined(KEYARRAY_SCAN_NEON)
+
+// NEON is part of every AArch64 CPU, so nothing is detected at run time
+inline KeyArrayScan::Level KeyArrayScan::detectedLevel() {
+    return Level::NEON;
+}
+
+
+// Compare lanes are all-ones or zero: AND with the lane weights, then add across
+inline size_t KeyArrayScan::neonMatch32(const void* values, size_t count, uint32_t bits, uint64_t& mask) {
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    uint32x4_t needle = vdupq_n_u32(bits);
+    uint32x4_t weight = vld1q_u32(weights);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t equal = vceqq_u32(vreinterpretq_u32_u8(vld1q_u8(bytes + i * 4)), needle);
+        mask |= uint64_t(vaddvq_u32(vandq_u32(equal, weight))) << i;
+    }
+    return i;
+}
+
+
+inline size_t KeyArrayScan::neonMatch64(const void* values, size_t count, uint64_t bits, uint64_t& mask) {
+    static const uint64_t weights[2] = { 1, 2 };
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    uint64x2_t needle = vdupq_n_u64(bits);
+    uint64x2_t weight = vld1q_u64(weights);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t equal = vceqq_u64(vreinterpretq_u64_u8(vld1q_u8(bytes + i * 8)), needle);
+        mask |= vaddvq_u64(vandq_u64(equal, weight)) << i;
+    }
+    return i;
+}
+
+
+inline size_t KeyArrayScan::neonMatchFloat(const float* values, size_t count, float value, uint64_t& mask) {
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    float32x4_t needle = vdupq_n_f32(value);
+    uint32x4_t weight = vld1q_u32(weights);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t equal = vceqq_f32(vld1q_f32(values + i), needle);
+        mask |= uint64_t(vaddvq_u32(vandq_u32(equal, weight))) << i;
+    }
+    return i;
+}
+
+
+inline size_t KeyArrayScan::neonMatchDouble(const double* values, size_t count, double value, uint64_t& mask) {
+    static const uint64_t weights[2] = { 1, 2 };
+    float64x2_t needle = vdupq_n_f64(value);
+    uint64x2_t weight = vld1q_u64(weights);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t equal = vceqq_f64(vld1q_f64(values + i), needle);
+        mask |= vaddvq_u64(vandq_u64(equal, weight)) << i;
+    }
+    return i;
+}
+
+#else
+
+inline KeyArrayScan::Level KeyArrayScan::detectedLevel() {
+    return Level::Scalar;
+}
+
+#endif
+
+
+// The x86 levels are ordered Scalar < AVX2 < AVX512; NEON is either on or off
+inline KeyArrayScan::Level KeyArrayScan::level() {
+    Level detected = detectedLevel();
+    Level limit = levelLimit().load(std::memory_order_relaxed);
+    if (detected == Level::NEON) return limit == Level::Scalar ? Level::Scalar : detected;
+    return std::min(detected, limit);
+}
+
+
+inline KeyArrayScan::Level KeyArrayScan::limitLevel(Level highest) {
+    return levelLimit().exchange(highest, std::memory_order_relaxed);
+}
+
+
+inline std::atomic<KeyArrayScan::Level>& KeyArrayScan::levelLimit() {
+    static std::atomic<Level> limit{ Level::NEON };
+    return limit;
+}
+
+
+// 🔹 Parallel Driver
+// ────────────────────────────────────────────────────────────────
+
+// Arrays below the threshold stay on the calling thread: starting threads
+// costs more than scanning them
+inline unsigned KeyArrayScan::threadsFor(size_t slots, const KeyArrayScanPolicy& policy) {
+    if (policy.parallelSlots == 0 || slots < policy.parallelSlots) return 1;
+    return threadsOf(policy);
+}
+
+
+inline unsigned KeyArrayScan::threadsOf(const KeyArrayScanPolicy& policy) {
+    unsigned threads = policy.threads ? policy.threads : std::thread::hardware_concurrency();
+    return std::max(1u, threads);
+}
+
+
+inline size_t KeyArrayScan::chunkWords(size_t words, unsigned chunks) {
+    size_t per = (words + std::max(1u, chunks) - 1) / std::max(1u, chunks);
+    return std::max<size_t>(LineWords, (per + LineWords - 1) / LineWords * LineWords);
+}
+
+
+// Chunks are contiguous and in order, so chunk c covers lower slots than chunk c + 1
+template <typename Fn>
+void KeyArrayScan::parallelChunks(size_t words, unsigned threads, Fn&& fn) {
+    size_t per = chunkWords(words, threads);
+    threads = static_cast<unsigned>(std::max<size_t>(1, (words + per - 1) / per));
+
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    auto run = [&](unsigned chunk) {
+        size_t first = std::min(words, chunk * per);
+        size_t last = std::min(words, first + per);
+        try {
+            fn(chunk, first, last);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    for (unsigned chunk = 1; chunk < threads; ++chunk) {
+        workers.emplace_back(run, chunk);
+    }
+    run(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+
+
+// An executor's tasks count down under a lock, so the caller may return (and
+// free the latch) right after the last one signals. A submit that throws
+// leaves the chunks not handed out undone; the ones already running finish first.
+template <typename Executor, typename Fn>
+void KeyArrayScan::executeChunks(Executor&& executor, size_t words, unsigned chunks, Fn&& fn) {
+    size_t per = chunkWords(words, chunks);
+    chunks = static_cast<unsigned>(std::max<size_t>(1, (words + per - 1) / per));
+
+    std::vector<std::exception_ptr> errors(chunks);
+    auto run = [&](unsigned chunk) {
+        size_t first = std::min(words, chunk * per);
+        size_t last = std::min(words, first + per);
+        try {
+            fn(chunk, first, last);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    if constexpr (std::is_invocable_v<Executor&, std::function<void()>>) {
+        std::mutex lock;
+        std::condition_variable finished;
+        unsigned pending = chunks - 1;
+
+        std::exception_ptr submitError;
+        for (unsigned chunk = 1; chunk < chunks; ++chunk) {
+            try {
+                executor(std::function<void()>([&, chunk] {
+                    run(chunk);
+                    std::lock_guard<std::mutex> hold(lock);
+                    if (--pending == 0) finished.notify_all();
+                }));
+            } catch (...) {
+                submitError = std::current_exception();
+                std::lock_guard<std::mutex> hold(lock);
+                pending -= chunks - chunk;
+                break;
+            }
+        }
+        if (!submitError) run(0);
+
+        std::unique_lock<std::mutex> hold(lock);
+        finished.wait(hold, [&] { return pending == 0; });
+        if (submitError) std::rethrow_exception(submitError);
+    } else {
+        std::vector<unsigned> ids(chunks);
+        std::iota(ids.begin(), ids.end(), 0u);
+        std::for_each(std::forward<Executor>(executor), ids.begin(), ids.end(), run);
+    }
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+
+#endif // KEYARRAYSCAN_HPP
@@ -0,0 +1,517 @@
+// KeyArraySnapshot: Binary snapshot format for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYSNAPSHOT_HPP
+#define KEYARRAYSNAPSHOT_HPP
+
+#include "OccupancyBitmap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief A KeyArray snapshot is one flat, versioned binary image:
+ *
+ *            header | name | occupancy bitmap | free list | values | queue
+ *
+ *        Every section starts 8-byte aligned and the value block is aligned
+ *        for T, so a snapshot mapped at a page boundary (mmap) can be read in
+ *        place with KeyArraySnapshotView. Integers are stored in native byte
+ *        order; snapshots are meant for the machine (or ABI) that wrote them.
+ *
+ *        For trivially copyable T the value block is the raw slot image, one
+ *        sizeof(T) cell per slot (dead cells are zero), and loading does no
+ *        parsing at all. Other types are written through KeyArraySerializer<T>,
+ *        which users specialize; std::string is provided.
+ */
+
+// ──────────────────────────────────────────────
+// 🔹 Format
+// ──────────────────────────────────────────────
+
+// Fixed-size snapshot header
+struct KeyArraySnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t valueSize;     // sizeof(T) for raw value blocks, 0 otherwise
+    uint32_t valueAlign;    // alignment of the value block
+    uint64_t nameLength;
+    int64_t offset;
+    uint64_t capacity;      // slots in the bitmap and raw value block
+    uint64_t elementCount;
+    uint64_t freeCount;     // keys in the free list section
+    uint64_t queueCount;
+    int64_t poolMin;
+    int64_t poolNext;
+    int64_t poolMax;
+    uint64_t valueBytes;    // raw blocks only; serialized blocks are
+    uint64_t queueBytes;    // self-delimiting and leave these 0
+
+    // Identifies snapshot files
+    static constexpr char Magic[8] = { 'K', 'E', 'Y', 'A', 'R', 'R', 'A', 'Y' };
+
+    // Current format version (the text format of saveToFile was 2.0)
+    static constexpr uint32_t Version = 4;
+
+    // Oldest version still read; version 3 stored free keys in 32 bits
+    static constexpr uint32_t MinVersion = 3;
+
+    // Returns the bytes of one free-list entry in the given version
+    static constexpr size_t freeKeySize(uint32_t version) {
+        return version >= 4 ? sizeof(int64_t) : sizeof(int32_t);
+    }
+
+    // Flag bits
+    static constexpr uint32_t ResizingEnabled = 1u << 0;
+    static constexpr uint32_t QueueEnabled = 1u << 1;
+    static constexpr uint32_t RawValues = 1u << 2;
+};
+
+static_assert(std::is_trivially_copyable_v<KeyArraySnapshotHeader>, "Snapshot header must be raw bytes");
+
+
+// Byte offsets of every section, derived from the header
+struct KeyArraySnapshotLayout {
+    size_t nameOffset;
+    size_t bitmapOffset;
+    size_t freeListOffset;
+    size_t valueOffset;
+    size_t queueOffset;
+    size_t totalSize;
+
+    // Computes the layout of a snapshot with the given header.
+    // Throws std::runtime_error if a section would end past the size_t range.
+    static KeyArraySnapshotLayout of(const KeyArraySnapshotHeader& header);
+
+    // Rounds a byte offset up to a multiple of `alignment` (a power of two).
+    // Throws std::runtime_error if the result does not fit a size_t.
+    static size_t alignUp(uint64_t offset, uint64_t alignment);
+
+    // Returns a + b or a * b; throws std::runtime_error if it does not fit a size_t
+    static size_t checkedAdd(uint64_t a, uint64_t b);
+    static size_t checkedMul(uint64_t a, uint64_t b);
+};
+
+
+// Reads and validates the header of a snapshot held in memory: besides the
+// magic and a version from MinVersion to Version, every size field must agree with the others (a raw
+// value block holds exactly capacity cells), the key pool must lie within
+// the capacity (0 <= poolMin <= poolNext <= poolMax + 1 <= capacity; an
+// empty array's exhausted pool is (0, 1, 0)) and every section must fit.
+// Throws std::runtime_error if the bytes are not a complete snapshot.
+inline KeyArraySnapshotHeader readKeyArraySnapshotHeader(const void* bytes, size_t size);
+
+
+// ──────────────────────────────────────────────
+// 🔹 Byte Streams
+// ──────────────────────────────────────────────
+
+/**
+ * @brief Sequential writer used by serializers; counts what it writes and,
+ *        on request, keeps a 64-bit FNV-1a digest of it.
+ */
+class KeyArraySnapshotWriter {
+public:
+
+    // Writes to the given stream
+    explicit KeyArraySnapshotWriter(std::ostream& os, bool withDigest = false);
+
+    // Appends to the given buffer
+    explicit KeyArraySnapshotWriter(std::string& buffer);
+
+    // Writes raw bytes
+    void write(const void* bytes, size_t size);
+
+    // Writes a trivially copyable value as raw bytes
+    template <typename U>
+    void writeValue(const U& value);
+
+    // Writes zero bytes up to the next multiple of `alignment`
+    void pad(size_t alignment);
+
+    // Returns the number of bytes written so far
+    size_t written() const;
+
+    // Returns the digest of the bytes written so far (if enabled)
+    uint64_t digest() const;
+
+private:
+    std::ostream* os = nullptr;
+    std::string* buffer = nullptr;
+    size_t count = 0;
+    bool withDigest = false;
+    uint64_t hash = 0;
+};
+
+
+// Returns the 64-bit FNV-1a digest of a block, continuing from `hash`
+inline uint64_t keyArrayDigest(const void* bytes, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+
+/**
+ * @brief Bounds-checked sequential reader over a block of memory.
+ */
+class KeyArraySnapshotReader {
+public:
+
+    // Reads from [bytes, bytes + size)
+    KeyArraySnapshotReader(const void* bytes, size_t size);
+
+    // Copies the next `size` bytes out; throws std::runtime_error past the end
+    void read(void* out, size_t size);
+
+    // Reads a trivially copyable value from raw bytes
+    template <typename U>
+    U readValue();
+
+    // Skips the next `size` bytes and returns where they start
+    const unsigned char* skip(size_t size);
+
+private:
+    const unsigned char* cursor;
+    const unsigned char* end;
+};
+
+
+// ──────────────────────────────────────────────
+// 🔹 Serializer Hook
+// ──────────────────────────────────────────────
+
+/**
+ * @brief Serializer used for snapshot values. Trivially copyable types are
+ *        stored raw. For any other type, specialize it with
+ *            static constexpr bool Raw = false;
+ *            static void write(KeyArraySnapshotWriter& out, const T& value);
+ *            static T read(KeyArraySnapshotReader& in);
+ */
+template <typename T, typename Enable = void>
+struct KeyArraySerializer {
+    static constexpr bool Raw = std::is_trivially_copyable_v<T>;
+};
+
+// Strings are stored as a 64-bit length followed by their bytes
+template <>
+struct KeyArraySerializer<std::string> {
+    static constexpr bool Raw = false;
+    static void write(KeyArraySnapshotWriter& out, const std::string& value);
+    static std::string read(KeyArraySnapshotReader& in);
+};
+
+
+// ──────────────────────────────────────────────
+// 🔹 Zero-Copy View
+// ──────────────────────────────────────────────
+
+/**
+ * @brief Read-only view of a raw snapshot in memory, typically an mmap of
+ *        the file. Nothing is copied: lookups test the bitmap and return
+ *        references straight into the mapped value block.
+ *        The bytes must outlive the view and be aligned for T
+ *        (any page-aligned mapping is).
+ */
+template <typename T>
+class KeyArraySnapshotView {
+    static_assert(std::is_trivially_copyable_v<T>, "Zero-copy views need trivially copyable values");
+
+public:
+
+    // Wraps a snapshot; throws std::runtime_error if it is malformed, not a
+    // raw snapshot of T, or misaligned
+    KeyArraySnapshotView(const void* bytes, size_t size);
+
+    // Returns true if the given key is in use
+    bool hasKey(int key) const noexcept;
+
+    // Returns the value at the given key; throws std::out_of_range if unused
+    const T& at(int key) const;
+
+    // Returns a pointer to the value, or nullptr if the key is not in use
+    const T* try_get(int key) const noexcept;
+
+    // Returns the number of stored elements
+    size_t size() const;
+
+    // Returns the offset of the key space
+    int getOffset() const;
+
+    // Returns the maximum usable key (inclusive upper bound)
+    int getMaxKeyBound() const;
+
+    // Returns the stored name
+    std::string getName() const;
+
+private:
+
+    // Maps a key to its slot; keys below the offset wrap to huge values
+    size_t slotOf(int key) const noexcept;
+
+    KeyArraySnapshotHeader header;
+    const unsigned char* base;
+    KeyArraySnapshotLayout layout;
+};
+
+
+// ===============================
+// Layout and Header: Implementations
+// ===============================
+
+inline size_t KeyArraySnapshotLayout::alignUp(uint64_t offset, uint64_t alignment) {
+    return static_cast<size_t>(checkedAdd(offset, alignment - 1) & ~(alignment - 1));
+}
+
+inline size_t KeyArraySnapshotLayout::checkedAdd(uint64_t a, uint64_t b) {
+    constexpr uint64_t Limit = std::numeric_limits<size_t>::max();
+    if (a > Limit || b > Limit - a) {
+        throw std::runtime_error("Corrupt KeyArray snapshot: section sizes overflow.");
+    }
+    return static_cast<size_t>(a + b);
+}
+
+inline size_t KeyArraySnapshotLayout::checkedMul(uint64_t a, uint64_t b) {
+    constexpr uint64_t Limit = std::numeric_limits<size_t>::max();
+    if (a != 0 && b > Limit / a) {
+        throw std::runtime_error("Corrupt KeyArray snapshot: section sizes overflow.");
+    }
+    return static_cast<size_t>(a * b);
+}
+
+// Sections follow each other in file order, each padded as documented above
+inline KeyArraySnapshotLayout KeyArraySnapshotLayout::of(const KeyArraySnapshotHeader& header) {
+    uint64_t words = header.capacity / OccupancyBitmap::WordBits + (header.capacity % OccupancyBitmap::WordBits != 0);
+
+    KeyArraySnapshotLayout layout;
+    layout.nameOffset = sizeof(KeyArraySnapshotHeader);
+    layout.bitmapOffset = alignUp(checkedAdd(layout.nameOffset, header.nameLength), 8);
+    layout.freeListOffset = checkedAdd(layout.bitmapOffset, checkedMul(words, sizeof(uint64_t)));
+    layout.valueOffset = alignUp(checkedAdd(layout.freeListOffset,
+                                            checkedMul(header.freeCount, KeyArraySnapshotHeader::freeKeySize(header.version))),
+                                 header.valueAlign);
+    layout.queueOffset = alignUp(checkedAdd(layout.valueOffset, header.valueBytes), header.valueAlign);
+    layout.totalSize = checkedAdd(layout.queueOffset, header.queueBytes);
+    return layout;
+}
+
+// Checks the magic, the version, that the fields agree and that every section
+// fits in `size`. The capacity is bounded by int64 so the pool fields compare
+// as signed values; whether it fits a key type is up to the loader.
+inline KeyArraySnapshotHeader readKeyArraySnapshotHeader(const void* bytes, size_t size) {
+    KeyArraySnapshotHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Snapshot is truncated.");
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if (std::memcmp(header.magic, KeyArraySnapshotHeader::Magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a KeyArray snapshot.");
+    }
+    if (header.version < KeyArraySnapshotHeader::MinVersion || header.version > KeyArraySnapshotHeader::Version) {
+        throw std::runtime_error("Unsupported KeyArray snapshot version.");
+    }
+    if (header.valueAlign == 0 || (header.valueAlign & (header.valueAlign - 1)) != 0 ||
+        header.elementCount > header.capacity || header.freeCount > header.capacity - header.elementCount ||
+        header.capacity > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) ||
+        header.nameLength > size) {
+        throw std::runtime_error("Corrupt KeyArray snapshot header.");
+    }
+
+    // Raw blocks hold one cell per slot and per queued value; serialized ones
+    // are self-delimiting and record no byte counts
+    if (header.flags & KeyArraySnapshotHeader::RawValues) {
+        if (header.valueSize == 0 ||
+            header.valueBytes != KeyArraySnapshotLayout::checkedMul(header.capacity, header.valueSize) ||
+            header.queueBytes != KeyArraySnapshotLayout::checkedMul(header.queueCount, header.valueSize)) {
+            throw std::runtime_error("Corrupt KeyArray snapshot: value block size mismatch.");
+        }
+    } else if (header.valueBytes != 0 || header.queueBytes != 0) {
+        throw std::runtime_error("Corrupt KeyArray snapshot: value block size mismatch.");
+    }
+
+    // Compared as signed values, so no field can wrap into range
+    int64_t keys = header.capacity == 0 ? 1 : static_cast<int64_t>(header.capacity);
+    if (header.poolMax < -1 || header.poolMax >= keys || header.poolMin < 0 ||
+        header.poolMin > header.poolNext || header.poolNext > header.poolMax + 1 ||
+        (header.capacity == 0 && header.poolNext != header.poolMax + 1)) {
+        throw std::runtime_error("Corrupt KeyArray snapshot: key pool outside the capacity.");
+    }
+
+    if (KeyArraySnapshotLayout::of(header).totalSize > size) {
+        throw std::runtime_error("Snapshot is truncated.");
+    }
+    return header;
+}
+
+
+// ===============================
+// Byte Streams: Implementations
+// ===============================
+
+inline KeyArraySnapshotWriter::KeyArraySnapshotWriter(std::ostream& os, bool withDigest)
+    : os(&os), withDigest(withDigest), hash(keyArrayDigest(nullptr, 0)) {}
+
+inline KeyArraySnapshotWriter::KeyArraySnapshotWriter(std::string& buffer)
+    : buffer(&buffer) {}
+
+inline void KeyArraySnapshotWriter::write(const void* bytes, size_t size) {
+    if (os) {
+        os->write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+    } else {
+        buffer->append(static_cast<const char*>(bytes), size);
+    }
+    if (withDigest) hash = keyArrayDigest(bytes, size, hash);
+    count += size;
+}
+
+template <typename U>
+void KeyArraySnapshotWriter::writeValue(const U& value) {
+    static_assert(std::is_trivially_copyable_v<U>, "writeValue needs a trivially copyable type");
+    write(&value, sizeof(U));
+}
+
+inline void KeyArraySnapshotWriter::pad(size_t alignment) {
+    static const char zeros[64] = {};
+    size_t padding = KeyArraySnapshotLayout::alignUp(count, alignment) - count;
+    while (padding > 0) {
+        size_t chunk = std::min(padding, sizeof(zeros));
+        write(zeros, chunk);
+        padding -= chunk;
+    }
+}
+
+inline size_t KeyArraySnapshotWriter::written() const {
+    return count;
+}
+
+inline uint64_t KeyArraySnapshotWriter::digest() const {
+    return hash;
+}
+
+inline uint64_t keyArrayDigest(const void* bytes, size_t size, uint64_t hash) {
+    const unsigned char* byte = static_cast<const unsigned char*>(bytes);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ byte[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline KeyArraySnapshotReader::KeyArraySnapshotReader(const void* bytes, size_t size)
+    : cursor(static_cast<const unsigned char*>(bytes)), end(cursor + size) {}
+
+inline void KeyArraySnapshotReader::read(void* out, size_t size) {
+    std::memcpy(out, skip(size), size);
+}
+
+template <typename U>
+U KeyArraySnapshotReader::readValue() {
+    static_assert(std::is_trivially_copyable_v<U>, "readValue needs a trivially copyable type");
+    alignas(U) unsigned char bytes[sizeof(U)];
+    read(bytes, sizeof(U));
+    return *std::launder(reinterpret_cast<U*>(bytes));
+}
+
+inline const unsigned char* KeyArraySnapshotReader::skip(size_t size) {
+    if (static_cast<size_t>(end - cursor) < size) {
+        throw std::runtime_error("Snapshot is truncated.");
+    }
+    const unsigned char* start = cursor;
+    cursor += size;
+    return start;
+}
+
+
+// ===============================
+// KeyArraySerializer<std::string>: Implementations
+// ===============================
+
+inline void KeyArraySerializer<std::string>::write(KeyArraySnapshotWriter& out, const std::string& value) {
+    out.writeValue<uint64_t>(value.size());
+    out.write(value.data(), value.size());
+}
+
+inline std::string KeyArraySerializer<std::string>::read(KeyArraySnapshotReader& in) {
+    uint64_t length = in.readValue<uint64_t>();
+    const unsigned char* chars = in.skip(static_cast<size_t>(length));
+    return std::string(reinterpret_cast<const char*>(chars), static_cast<size_t>(length));
+}
+
+
+// ===============================
+// KeyArraySnapshotView<T>: Implementations
+// ===============================
+
+template <typename T>
+KeyArraySnapshotView<T>::KeyArraySnapshotView(const void* bytes, size_t size)
+    : header(readKeyArraySnapshotHeader(bytes, size)),
+      base(static_cast<const unsigned char*>(bytes)),
+      layout(KeyArraySnapshotLayout::of(header)) {
+
+    if (!(header.flags & KeyArraySnapshotHeader::RawValues) || header.valueSize != sizeof(T)) {
+        throw std::runtime_error("Snapshot does not hold raw values of this type.");
+    }
+    if (reinterpret_cast<uintptr_t>(base + layout.valueOffset) % alignof(T) != 0) {
+        throw std::runtime_error("Snapshot value block is misaligned.");
+    }
+}
+
+// Bitmap words are read bytewise, so only the value block needs alignment
+template <typename T>
+bool KeyArraySnapshotView<T>::hasKey(int key) const noexcept {
+    size_t index = slotOf(key);
+    if (index >= header.capacity) return false;
+
+    uint64_t word;
+    std::memcpy(&word, base + layout.bitmapOffset + (index / OccupancyBitmap::WordBits) * sizeof(uint64_t),
+                sizeof(word));
+    return (word >> (index % OccupancyBitmap::WordBits)) & 1u;
+}
+
+template <typename T>
+const T& KeyArraySnapshotView<T>::at(int key) const {
+    const T* value = try_get(key);
+    if (!value) {
+        throw std::out_of_range("Invalid key in KeyArray snapshot");
+    }
+    return *value;
+}
+
+template <typename T>
+const T* KeyArraySnapshotView<T>::try_get(int key) const noexcept {
+    if (!hasKey(key)) return nullptr;
+    return std::launder(reinterpret_cast<const T*>(base + layout.valueOffset) + slotOf(key));
+}
+
+template <typename T>
+size_t KeyArraySnapshotView<T>::size() const {
+    return static_cast<size_t>(header.elementCount);
+}
+
+template <typename T>
+int KeyArraySnapshotView<T>::getOffset() const {
+    return static_cast<int>(header.offset);
+}
+
+template <typename T>
+int KeyArraySnapshotView<T>::getMaxKeyBound() const {
+    return static_cast<int>(header.offset + static_cast<int64_t>(header.capacity) - 1);
+}
+
+template <typename T>
+std::string KeyArraySnapshotView<T>::getName() const {
+    return std::string(reinterpret_cast<const char*>(base + layout.nameOffset), header.nameLength);
+}
+
+template <typename T>
+size_t KeyArraySnapshotView<T>::slotOf(int key) const noexcept {
+    return static_cast<unsigned>(key) - static_cast<unsigned>(header.offset);
+}
+
+
+#endif // KEYARRAYSNAPSHOT_HPP
@@ -0,0 +1,702 @@
+// KeyArraySoA: Structure-of-arrays KeyArray for aggregate values (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYSOA_HPP
+#define KEYARRAYSOA_HPP
+
+#include "IntrusiveKeyPool.hpp"
+#include "KeyArrayScan.hpp"
+#include "KeyArraySpan.hpp"
+#include "OccupancyBitmap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief KeyArraySoA stores an aggregate T column by column: each listed
+ *        member gets its own contiguous array, indexed by the same slot and
+ *        handed out by one IntrusiveKeyPool. A scan that reads one or two
+ *        fields then loads only those columns instead of whole structs.
+ *
+ *        The field list is a set of member pointers:
+ *            KeyArraySoA<Order, &Order::px, &Order::qty, &Order::id> orders(1024);
+ *            int key = orders.insert(order);
+ *            orders.at(key).get<&Order::qty>() += 10;
+ *            Order copy = orders.at(key);
+ *            for (double px : orders.column<&Order::px>()) ...
+ *
+ *        Members that are not listed are not stored (load() leaves them
+ *        default). Fields must be default-constructible: every column holds
+ *        a value in every slot, so column spans are plain arrays, and a
+ *        removed key's fields are reset to their default. Free-list links
+ *        live in a separate int array, so no column is padded.
+ *
+ *        Growth (enableDynamicResizing) reallocates every column at once;
+ *        references and spans are invalidated, keys are not. A KeyArraySoA
+ *        can be moved but not copied.
+ */
+template <typename T, auto... Members>
+class KeyArraySoA {
+    static_assert(sizeof...(Members) > 0, "KeyArraySoA needs at least one member");
+
+    // Splits a data member pointer into its class and field type
+    template <typename M>
+    struct MemberOf;
+
+    template <typename C, typename U>
+    struct MemberOf<U C::*> {
+        using Class = C;
+        using Type = U;
+    };
+
+    static_assert((std::is_same_v<typename MemberOf<decltype(Members)>::Class, T> && ...),
+                  "Every member must be a data member of T");
+
+public:
+
+    // Field type of a listed member
+    template <auto Member>
+    using FieldType = typename MemberOf<decltype(Member)>::Type;
+
+    // Column position of a listed member
+    template <auto Member>
+    static constexpr size_t columnIndex();
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Row Proxy
+    // ─────────────────────────────────────────────────────────────
+
+    // One key's fields, read and written in place through the columns
+    template <bool Const>
+    class RowRef {
+    public:
+        using owner_type = std::conditional_t<Const, const KeyArraySoA*, KeyArraySoA*>;
+
+        RowRef(owner_type owner, size_t slot) : owner(owner), slot(slot) {}
+
+        // Returns a reference to one field
+        template <auto Member>
+        auto& get() const { return std::get<columnIndex<Member>()>(owner->columns)[slot]; }
+
+        // Returns the key of this row
+        int key() const { return static_cast<int>(slot) + owner->offset; }
+
+        // Gathers the listed fields into a T
+        T load() const { return owner->gather(slot); }
+        operator T() const { return load(); }
+
+        // Scatters every listed field of a T into this row
+        template <bool C = Const, typename = std::enable_if_t<!C>>
+        const RowRef& operator=(const T& value) const {
+            owner->scatter(slot, value);
+            return *this;
+        }
+
+    private:
+        owner_type owner;
+        size_t slot;
+    };
+
+    using Row = RowRef<false>;
+    using ConstRow = RowRef<true>;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Construction & Initialization
+    // ─────────────────────────────────────────────────────────────
+
+    // Constructs keys 0 to limitKey - 1
+    explicit KeyArraySoA(int limitKey = 100, const std::string& name = "");
+
+    // Constructs keys from min(a, b) to max(a, b) - 1
+    KeyArraySoA(int a, int b, const std::string& name = "");
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Core Functionality
+    // ─────────────────────────────────────────────────────────────
+
+    // Scatters the listed fields of a value into the columns; returns the assigned key
+    int insert(const T& value);
+
+    // Moves the listed fields of a value into the columns; returns the assigned key
+    int insert(T&& value);
+
+    // Resets the key's fields to their default and recycles the key
+    void remove(int key);
+
+    // Checks if a given key is currently in use
+    bool hasKey(int key) const;
+
+    // Returns a row proxy for a live key; throws std::out_of_range otherwise
+    Row at(int key);
+    ConstRow at(int key) const;
+
+    // Returns one field of a live key; throws std::out_of_range otherwise
+    template <auto Member>
+    FieldType<Member>& get(int key);
+
+    template <auto Member>
+    const FieldType<Member>& get(int key) const;
+
+    // Resets every field and key
+    void clear();
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Columns
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the column of a member over every slot (index = key - offset)
+    template <auto Member>
+    KeyArraySpan<FieldType<Member>> column();
+
+    template <auto Member>
+    KeyArraySpan<const FieldType<Member>> column() const;
+
+    // Returns the live slots, one bit per column index
+    const OccupancyBitmap& occupancy() const;
+
+    // Calls fn(key, field) for every live key, touching only that column
+    template <auto Member, typename Fn>
+    void forEachLive(Fn&& fn) const;
+
+    // Counts the live keys whose field equals value (vectorized for arithmetic fields)
+    template <auto Member>
+    size_t count(const FieldType<Member>& value) const;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Dynamic Resizing
+    // ─────────────────────────────────────────────────────────────
+
+    // Doubles every column when the keys run out
+    void enableDynamicResizing();
+
+    // Throws once the keys run out
+    void disableDynamicResizing();
+
+    // Returns whether the columns grow on demand
+    bool isDynamicResizingEnabled() const;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Accessors
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the number of live keys
+    size_t size() const;
+
+    // Returns true if no key is live
+    bool empty() const;
+
+    // Returns the number of slots per column
+    size_t capacity() const;
+
+    // Returns the offset of the key space
+    int getOffset() const;
+
+    // Returns the maximum usable key (inclusive upper bound)
+    int getMaxKeyBound() const;
+
+    // Gets the name of this instance
+    std::string getName() const;
+
+    // Sets the name of this instance
+    void setName(const std::string& newName);
+
+    // Prints every live key with its listed fields
+    template <typename U, auto... M>
+    friend std::ostream& operator<<(std::ostream& os, const KeyArraySoA<U, M...>& array);
+
+
+private:
+
+    // One member's values, value-initialized in every slot (a plain array even for bool)
+    template <typename U>
+    struct Column {
+        std::unique_ptr<U[]> values;
+
+        explicit Column(size_t capacity) : values(new U[capacity]()) {}
+        U& operator[](size_t slot) { return values[slot]; }
+        const U& operator[](size_t slot) const { return values[slot]; }
+
+        // Reallocates to `to` slots, keeping the first `from`
+        void grow(size_t from, size_t to);
+    };
+
+    // Free-list links for the key pool, kept beside the columns
+    struct Links {
+        std::vector<int>* next;
+        int nextFree(size_t index) const { return (*next)[index]; }
+        void setNextFree(size_t index, int value) const { (*next)[index] = value; }
+    };
+
+    // True if two member pointers name the same member
+    template <auto A, auto B>
+    static constexpr bool sameMember();
+
+    // Converts an external key to a slot index
+    size_t slotOf(int key) const noexcept;
+
+    // Returns the slot of a live key; throws std::out_of_range otherwise
+    size_t liveSlot(int key) const;
+
+    // Returns a pool over slots [0, capacity), empty for a capacity of 0
+    static IntrusiveKeyPool poolOf(size_t capacity);
+
+    // Pops a key, growing the columns if allowed
+    size_t acquireSlot();
+
+    // Copies (or moves) the listed fields of value into a slot
+    template <typename Value, size_t... I>
+    void scatter(size_t slot, Value&& value, std::index_sequence<I...>);
+    void scatter(size_t slot, const T& value);
+
+    // Builds a T from a slot's fields
+    template <size_t... I>
+    T gather(size_t slot, std::index_sequence<I...>) const;
+    T gather(size_t slot) const;
+
+    // Resets a slot's fields to their defaults
+    template <size_t... I>
+    void resetSlot(size_t slot, std::index_sequence<I...>);
+
+    // Inserts through scatter, recycling the key if a field throws
+    template <typename Value>
+    int insertValue(Value&& value);
+
+    // Grows every column to newCapacity slots
+    template <size_t... I>
+    void growColumns(size_t newCapacity, std::index_sequence<I...>);
+
+    using Indices = std::index_sequence_for<decltype(Members)...>;
+
+    // One array per listed member
+    std::tuple<Column<FieldType<Members>>...> columns;
+
+    // Free-list link of every slot (meaningful only while it is free)
+    std::vector<int> links;
+
+    // Live slots
+    OccupancyBitmap valid;
+
+    // Key allocator over slots [0, capacity)
+    IntrusiveKeyPool pool;
+
+    // Number of live keys
+    size_t elementCount = 0;
+
+    // Logical key offset
+    int offset;
+
+    // Optional human-readable identifier
+    std::string name;
+
+    // Whether the columns grow when the keys run out
+    bool resizingEnabled = false;
+};
+
+
+//
+// ░░ Implementation of KeyArraySoA ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Members
+// ────────────────────────────────────────────────────────────────
+
+// Member pointers of different types never name the same member
+template <typename T, auto... Members>
+template <auto A, auto B>
+constexpr bool KeyArraySoA<T, Members...>::sameMember() {
+    if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+        return A == B;
+    } else {
+        return false;
+    }
+}
+
+
+template <typename T, auto... Members>
+template <auto Member>
+constexpr size_t KeyArraySoA<T, Members...>::columnIndex() {
+    constexpr bool matches[] = { sameMember<Member, Members>()... };
+    for (size_t i = 0; i < sizeof...(Members); ++i) {
+        if (matches[i]) return i;
+    }
+    return sizeof...(Members);
+}
+
+
+// 🔹 Construction
+// ────────────────────────────────────────────────────────────────
+
+// Every column is filled with defaults up front, so spans never see raw memory
+template <typename T, auto... Members>
+KeyArraySoA<T, Members...>::KeyArraySoA(int limitKey, const std::string& name)
+    : columns(Column<FieldType<Members>>(static_cast<size_t>(std::max(0, limitKey)))...),
+      links(static_cast<size_t>(std::max(0, limitKey))), valid(static_cast<size_t>(std::max(0, limitKey))),
+      pool(poolOf(static_cast<size_t>(std::max(0, limitKey)))), offset(0), name(name) {}
+
+
+template <typename T, auto... Members>
+KeyArraySoA<T, Members...>::KeyArraySoA(int a, int b, const std::string& name)
+    : KeyArraySoA(std::max(a, b) - std::min(a, b), name) {
+    offset = std::min(a, b);
+}
+
+
+// 🔹 Core Functionality
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, auto... Members>
+int KeyArraySoA<T, Members...>::insert(const T& value) {
+    return insertValue(value);
+}
+
+
+template <typename T, auto... Members>
+int KeyArraySoA<T, Members...>::insert(T&& value) {
+    return insertValue(std::move(value));
+}
+
+
+// A field that throws leaves the slot reset and the key back in the pool
+template <typename T, auto... Members>
+template <typename Value>
+int KeyArraySoA<T, Members...>::insertValue(Value&& value) {
+    size_t slot = acquireSlot();
+    try {
+        scatter(slot, std::forward<Value>(value), Indices{});
+    } catch (...) {
+        resetSlot(slot, Indices{});
+        Links freeLinks{ &links };
+        pool.push(static_cast<int>(slot), freeLinks);
+        throw;
+    }
+    valid.set(slot);
+    ++elementCount;
+    return static_cast<int>(slot) + offset;
+}
+
+
+template <typename T, auto... Members>
+void KeyArraySoA<T, Members...>::remove(int key) {
+    size_t slot = slotOf(key);
+    if (slot >= valid.size() || !valid.test(slot)) {
+        throw std::out_of_range("Key is not valid or not in use");
+    }
+    resetSlot(slot, Indices{});
+    valid.reset(slot);
+    --elementCount;
+    Links freeLinks{ &links };
+    pool.push(static_cast<int>(slot), freeLinks);
+}
+
+
+template <typename T, auto... Members>
+bool KeyArraySoA<T, Members...>::hasKey(int key) const {
+    size_t slot = slotOf(key);
+    return slot < valid.size() && valid.test(slot);
+}
+
+
+template <typename T, auto... Members>
+typename KeyArraySoA<T, Members...>::Row KeyArraySoA<T, Members...>::at(int key) {
+    return Row(this, liveSlot(key));
+}
+
+
+template <typename T, auto... Members>
+typename KeyArraySoA<T, Members...>::ConstRow KeyArraySoA<T, Members...>::at(int key) const {
+    return ConstRow(this, liveSlot(key));
+}
+
+
+template <typename T, auto... Members>
+template <auto Member>
+typename KeyArraySoA<T, Members...>::template FieldType<Member>& KeyArraySoA<T, Members...>::get(int key) {
+    return std::get<columnIndex<Member>()>(columns)[liveSlot(key)];
+}
+
+
+template <typename T, auto... Members>
+template <auto Member>
+const typename KeyArraySoA<T, Members...>::template FieldType<Member>& KeyArraySoA<T, Members...>::get(int key) const {
+    return std::get<columnIndex<Member>()>(columns)[liveSlot(key)];
+}
+
+
+// Keeps the capacity; every field goes back to its default
+template <typename T, auto... Members>
+void KeyArraySoA<T, Members...>::clear() {
+    valid.forEachSet([&](size_t slot) { resetSlot(slot, Indices{}); });
+    valid.clearAll();
+    pool = poolOf(valid.size());
+    elementCount = 0;
+}
+
+
+// 🔹 Columns
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, auto... Members>
+template <auto Member>
+KeyArraySpan<typename KeyArraySoA<T, Members...>::template FieldType<Member>> KeyArraySoA<T, Members...>::column() {
+    return { std::get<columnIndex<Member>()>(columns).values.get(), valid.size() };
+}
+
+
+template <typename T, auto... Members>
+template <auto Member>
+KeyArraySpan<const typename KeyArraySoA<T, Members...>::template FieldType<Member>>
+KeyArraySoA<T, Members...>::column() const {
+    return { std::get<columnIndex<Member>()>(columns).values.get(), valid.size() };
+}
+
+
+template <typename T, auto... Members>
+const OccupancyBitmap& KeyArraySoA<T, Members...>::occupancy() const {
+    return valid;
+}
+
+
+template <typename T, auto... Members>
+template <auto Member, typename Fn>
+void KeyArraySoA<T, Members...>::forEachLive(Fn&& fn) const {
+    const auto& values = std::get<columnIndex<Member>()>(columns);
+    valid.forEachSet([&](size_t slot) { fn(static_cast<int>(slot) + offset, values[slot]); });
+}
+
+
+// A column is a plain array, so each bitmap word covers one kernel run
+template <typename T, auto... Members>
+template <auto Member>
+size_t KeyArraySoA<T, Members...>::count(const FieldType<Member>& value) const {
+    const auto& values = std::get<columnIndex<Member>()>(columns);
+    size_t total = 0;
+    for (size_t word = 0; word < valid.wordCount(); ++word) {
+        uint64_t live = valid.word(word);
+        if (live == 0) continue;
+
+        size_t base = word * OccupancyBitmap::WordBits;
+        size_t run = std::min(OccupancyBitmap::WordBits, valid.size() - base);
+        total += OccupancyBitmap::popCount(KeyArrayScan::matchEqual(values.values.get() + base, run, value) & live);
+    }
+    return total;
+}
+
+
+// 🔹 Dynamic Resizing
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, auto... Members>
+void KeyArraySoA<T, Members...>::enableDynamicResizing() {
+    resizingEnabled = true;
+}
+
+
+template <typename T, auto... Members>
+void KeyArraySoA<T, Members...>::disableDynamicResizing() {
+    resizingEnabled = false;
+}
+
+
+template <typename T, auto... Members>
+bool KeyArraySoA<T, Members...>::isDynamicResizingEnabled() const {
+    return resizingEnabled;
+}
+
+
+// Doubling keeps growth amortized O(1) per insert
+template <typename T, auto... Members>
+size_t KeyArraySoA<T, Members...>::acquireSlot() {
+    if (pool.empty()) {
+        if (!resizingEnabled) {
+            throw std::runtime_error("KeyPool is empty. No available keys.");
+        }
+        size_t capacity = valid.size();
+        size_t limit = static_cast<size_t>(std::numeric_limits<int>::max()) - static_cast<size_t>(std::max(0, offset));
+        if (capacity >= limit) {
+            throw std::length_error("KeyArraySoA cannot grow beyond the int key range");
+        }
+        size_t newCapacity = std::min(limit, std::max<size_t>(1, capacity * 2));
+        growColumns(newCapacity, Indices{});
+        links.resize(newCapacity);
+        valid.resize(newCapacity);
+        if (capacity == 0) {
+            pool = poolOf(newCapacity);
+        } else {
+            pool.extend(static_cast<int>(newCapacity) - 1);
+        }
+    }
+    Links freeLinks{ &links };
+    return static_cast<size_t>(pool.pop(freeLinks));
+}
+
+
+// IntrusiveKeyPool(0, -1) would sort its bounds into [-1, 0] and hand out
+// key -1, so an empty pool starts with its bump cursor past key 0
+template <typename T, auto... Members>
+IntrusiveKeyPool KeyArraySoA<T, Members...>::poolOf(size_t capacity) {
+    IntrusiveKeyPool fresh(0, 0);
+    if (capacity == 0) {
+        fresh.restore(0, 1, 0);
+    } else {
+        fresh.reset(0, static_cast<int>(capacity - 1));
+    }
+    return fresh;
+}
+
+
+// A column that throws leaves the others larger than needed, which is harmless:
+// the capacity is the bitmap's
+template <typename T, auto... Members>
+template <size_t... I>
+void KeyArraySoA<T, Members...>::growColumns(size_t newCapacity, std::index_sequence<I...>) {
+    (std::get<I>(columns).grow(valid.size(), newCapacity), ...);
+}
+
+
+// Fields are moved unless their move may throw, then copied
+template <typename T, auto... Members>
+template <typename U>
+void KeyArraySoA<T, Members...>::Column<U>::grow(size_t from, size_t to) {
+    std::unique_ptr<U[]> grown(new U[to]());
+    for (size_t slot = 0; slot < from; ++slot) {
+        grown[slot] = std::move_if_noexcept(values[slot]);
+    }
+    values = std::move(grown);
+}
+
+
+// 🔹 Field Transfer
+// ────────────────────────────────────────────────────────────────
+
+// An rvalue T has each listed member moved out
+template <typename T, auto... Members>
+template <typename Value, size_t... I>
+void KeyArraySoA<T, Members...>::scatter(size_t slot, Value&& value, std::index_sequence<I...>) {
+    ((std::get<I>(columns)[slot] = std::forward<Value>(value).*Members), ...);
+}
+
+
+template <typename T, auto... Members>
+void KeyArraySoA<T, Members...>::scatter(size_t slot, const T& value) {
+    scatter(slot, value, Indices{});
+}
+
+
+template <typename T, auto... Members>
+template <size_t... I>
+T KeyArraySoA<T, Members...>::gather(size_t slot, std::index_sequence<I...>) const {
+    T value{};
+    ((value.*Members = std::get<I>(columns)[slot]), ...);
+    return value;
+}
+
+
+template <typename T, auto... Members>
+T KeyArraySoA<T, Members...>::gather(size_t slot) const {
+    return gather(slot, Indices{});
+}
+
+
+template <typename T, auto... Members>
+template <size_t... I>
+void KeyArraySoA<T, Members...>::resetSlot(size_t slot, std::index_sequence<I...>) {
+    ((std::get<I>(columns)[slot] = FieldType<Members>{}), ...);
+}
+
+
+// 🔹 Keys
+// ────────────────────────────────────────────────────────────────
+
+// Keys below the offset wrap around to huge indices and fail the range check
+template <typename T, auto... Members>
+size_t KeyArraySoA<T, Members...>::slotOf(int key) const noexcept {
+    return static_cast<size_t>(static_cast<long long>(key) - offset);
+}
+
+
+template <typename T, auto... Members>
+size_t KeyArraySoA<T, Members...>::liveSlot(int key) const {
+    size_t slot = slotOf(key);
+    if (slot >= valid.size() || !valid.test(slot)) {
+        throw std::out_of_range("Invalid key in KeyArraySoA");
+    }
+    return slot;
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, auto... Members>
+size_t KeyArraySoA<T, Members...>::size() const {
+    return elementCount;
+}
+
+
+template <typename T, auto... Members>
+bool KeyArraySoA<T, Members...>::empty() const {
+    return elementCount == 0;
+}
+
+
+template <typename T, auto... Members>
+size_t KeyArraySoA<T, Members...>::capacity() const {
+    return valid.size();
+}
+
+
+template <typename T, auto... Members>
+int KeyArraySoA<T, Members...>::getOffset() const {
+    return offset;
+}
+
+
+template <typename T, auto... Members>
+int KeyArraySoA<T, Members...>::getMaxKeyBound() const {
+    return offset + static_cast<int>(valid.size()) - 1;
+}
+
+
+template <typename T, auto... Members>
+std::string KeyArraySoA<T, Members...>::getName() const {
+    return name;
+}
+
+
+template <typename T, auto... Members>
+void KeyArraySoA<T, Members...>::setName(const std::string& newName) {
+    name = newName;
+}
+
+
+// Prints "(key: field, field, ...)" per live key
+template <typename T, auto... Members>
+std::ostream& operator<<(std::ostream& os, const KeyArraySoA<T, Members...>& array) {
+    os << "KeyArraySoA (Size: " << array.size() << ") [";
+    array.valid.forEachSet([&](size_t slot) {
+        os << "(" << (static_cast<int>(slot) + array.offset) << ":";
+        const char* separator = " ";
+        std::apply([&](const auto&... column) { ((os << separator << column[slot], separator = ", "), ...); },
+                   array.columns);
+        os << ") ";
+    });
+    os << "]";
+    return os;
+}
+
+
+#endif // KEYARRAYSOA_HPP
@@ -0,0 +1,35 @@
+// KeyArraySpan: Contiguous view over a run of values (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYSPAN_HPP
+#define KEYARRAYSPAN_HPP
+
+#include <cstddef>
+
+/**
+ * @brief KeyArraySpan is a view of a contiguous run of values. For
+ *        KeyArraySoA it is one column: every slot of the key space, live or
+ *        not (dead slots hold a default-constructed field; pair it with
+ *        occupancy() to tell them apart). For DenseKeyArray it is the
+ *        packed live values, or their keys, with no gaps.
+ */
+template <typename U>
+class KeyArraySpan {
+public:
+
+    KeyArraySpan(U* first, size_t count) : first(first), count(count) {}
+
+    U* data() const { return first; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    U& operator[](size_t slot) const { return first[slot]; }
+    U* begin() const { return first; }
+    U* end() const { return first + count; }
+
+private:
+    U* first;
+    size_t count;
+};
+
+
+#endif // KEYARRAYSPAN_HPP
@@ -0,0 +1,180 @@
+// KeyArrayStats: Optional runtime statistics for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYARRAYSTATS_HPP
+#define KEYARRAYSTATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Statistics are compiled in only when KEYARRAY_STATS is defined
+ *        (for every translation unit alike: the define changes the layout
+ *        of KeyArray). Without it the counting statements vanish and
+ *        KeyArray::getStats() reports only what the array knows anyway:
+ *        size, capacity, occupancy, fragmentation and memory.
+ *
+ *        With it, KeyArray counts key allocations, resizes and queue usage,
+ *        and times one in every 2^KEYARRAY_STATS_SAMPLE_SHIFT calls (64 by
+ *        default) of insert, remove and at into power-of-two histograms.
+ */
+#if defined(KEYARRAY_STATS)
+#define KEYARRAY_STAT(...) __VA_ARGS__
+#else
+#define KEYARRAY_STAT(...)
+#endif
+
+#ifndef KEYARRAY_STATS_SAMPLE_SHIFT
+#define KEYARRAY_STATS_SAMPLE_SHIFT 6
+#endif
+
+
+/**
+ * @brief Latencies of the sampled calls of one operation. Bucket b counts
+ *        calls that took [2^b, 2^(b+1)) nanoseconds (bucket 0 also holds 0).
+ */
+struct KeyArrayLatencyStats {
+
+    static constexpr size_t BucketCount = 40;
+
+    std::array<uint64_t, BucketCount> buckets{};
+
+    // Number of timed calls
+    uint64_t samples = 0;
+
+    // Slowest timed call
+    uint64_t maxNanoseconds = 0;
+
+    // Adds one timed call
+    void record(uint64_t nanoseconds);
+
+    // Returns the upper bound of the bucket holding the q-th quantile (0 if empty)
+    uint64_t quantile(double q) const;
+};
+
+
+/**
+ * @brief Snapshot returned by KeyArray::getStats(), plain data for a metrics
+ *        exporter. Counters cover the array's lifetime (or the time since
+ *        resetStats()) and stay zero unless KEYARRAY_STATS is defined.
+ */
+struct KeyArrayStats {
+
+    // Whether the counters below were compiled in
+    static constexpr bool Enabled =
+#if defined(KEYARRAY_STATS)
+        true;
+#else
+        false;
+#endif
+
+    // 🔹 Keys
+    uint64_t recycledKeys = 0;      // keys taken from the free list
+    uint64_t freshKeys = 0;         // keys taken from the never-used range
+
+    // 🔹 Resizing
+    uint64_t resizes = 0;           // growths started (incremental, background, in place or one-step)
+    uint64_t copySteps = 0;         // incremental migration steps
+    uint64_t slotsMigrated = 0;     // slots covered by those steps
+    uint64_t forcedDrains = 0;      // inserts that finished a pending resize synchronously
+
+    // 🔹 Overflow queue
+    size_t queueSize = 0;
+    size_t queueHighWater = 0;      // largest queue size seen
+
+    // 🔹 Occupancy (always filled)
+    size_t size = 0;
+    size_t capacity = 0;
+    double occupancy = 0.0;         // size / capacity
+    double fragmentation = 0.0;     // freed keys / keys ever handed out (holes in the used range)
+
+    // 🔹 Memory (always filled)
+    size_t dataBytes = 0;           // current slot buffer and its bitmap
+    size_t resizeBytes = 0;         // buffer being filled by a resize, if any
+    size_t queueBytes = 0;          // overflow queue buffer
+
+    // 🔹 Sampled latencies
+    KeyArrayLatencyStats insertLatency;
+    KeyArrayLatencyStats removeLatency;
+    KeyArrayLatencyStats atLatency;
+};
+
+
+/**
+ * @brief The counters a KeyArray keeps under KEYARRAY_STATS. sample() returns
+ *        a scope that times the enclosing call on every 2^SampleShift-th use.
+ */
+class KeyArrayStatsRecorder {
+public:
+
+    static constexpr unsigned SampleShift = KEYARRAY_STATS_SAMPLE_SHIFT;
+
+    using Clock = std::chrono::steady_clock;
+
+    // Records the time between its construction and destruction, if armed
+    class Scope {
+    public:
+        explicit Scope(KeyArrayLatencyStats* into) : target(into) {
+            if (target) start = Clock::now();
+        }
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        KeyArrayLatencyStats* target;
+        Clock::time_point start;
+    };
+
+    // Arms a scope for every 2^SampleShift-th call
+    Scope sample(KeyArrayLatencyStats& into) {
+        return Scope(((ticks++ & ((uint64_t(1) << SampleShift) - 1)) == 0) ? &into : nullptr);
+    }
+
+    // Counter part of the snapshot
+    KeyArrayStats totals;
+
+private:
+
+    // Calls seen by sample(), over all operations
+    uint64_t ticks = 0;
+};
+
+
+// ===============================
+// Implementations
+// ===============================
+
+inline void KeyArrayLatencyStats::record(uint64_t nanoseconds) {
+    size_t bucket = 0;
+    for (uint64_t rest = nanoseconds >> 1; rest != 0 && bucket + 1 < BucketCount; rest >>= 1) ++bucket;
+    ++buckets[bucket];
+    ++samples;
+    if (nanoseconds > maxNanoseconds) maxNanoseconds = nanoseconds;
+}
+
+// Rank q * (samples - 1) + 1, counted from the fastest bucket
+inline uint64_t KeyArrayLatencyStats::quantile(double q) const {
+    if (samples == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(samples - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BucketCount; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            uint64_t bound = (uint64_t(2) << b) - 1;
+            return bound < maxNanoseconds ? bound : maxNanoseconds;
+        }
+    }
+    return maxNanoseconds;
+}
+
+inline KeyArrayStatsRecorder::Scope::~Scope() {
+    if (!target) return;
+    Clock::duration elapsed = Clock::now() - start;
+    target->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+
+#endif // KEYARRAYSTATS_HPP
@@ -0,0 +1,96 @@
+// KeyHandle: Generational handles for KeyArray keys
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYHANDLE_HPP
+#define KEYHANDLE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief BasicKeyHandle packs a slot index and a generation into one word.
+ *        A generational KeyArray bumps the generation of a slot on every
+ *        insert and remove, so a handle that outlived its element no longer
+ *        matches and is rejected by hasKey/at/remove, even after the key
+ *        has been recycled.
+ *
+ *        Only the low (bits - IndexBits) bits of the generation are kept;
+ *        a stale handle is caught unless the slot was reused an exact
+ *        multiple of 2^(bits - IndexBits) times in the meantime.
+ */
+template <typename Word, unsigned IndexBits>
+class BasicKeyHandle {
+    static_assert(std::is_unsigned_v<Word>, "Handle word must be an unsigned integer");
+    static_assert(IndexBits > 0 && IndexBits < std::numeric_limits<Word>::digits,
+                  "Index bits must leave room for a generation");
+
+public:
+
+    // Number of generation bits stored in the handle
+    static constexpr unsigned GenerationBits = std::numeric_limits<Word>::digits - IndexBits;
+
+    // Largest slot index a handle can address
+    static constexpr Word MaxIndex = (Word(1) << IndexBits) - 1;
+
+    // Mask applied to slot generations before comparing them with a handle
+    static constexpr Word GenerationMask = Word(~Word(0)) >> IndexBits;
+
+    // ──────────────────────────────────────────────
+    // 🔹 Construction
+    // ──────────────────────────────────────────────
+
+    // Constructs a null handle, which never matches a live element
+    constexpr BasicKeyHandle() = default;
+
+    // Constructs a handle from a slot index and that slot's generation
+    constexpr BasicKeyHandle(Word index, Word generation)
+        : bits((generation & GenerationMask) << IndexBits | (index & MaxIndex)) {}
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the slot index (relative to the array offset)
+    constexpr Word index() const { return bits & MaxIndex; }
+
+    // Returns the stored (truncated) generation
+    constexpr Word generation() const { return bits >> IndexBits; }
+
+    // Returns the packed representation
+    constexpr Word raw() const { return bits; }
+
+    // Returns true unless this is a null handle
+    constexpr explicit operator bool() const { return bits != 0; }
+
+    // Recreates a handle from its packed representation
+    static constexpr BasicKeyHandle fromRaw(Word raw) {
+        BasicKeyHandle handle;
+        handle.bits = raw;
+        return handle;
+    }
+
+    constexpr bool operator==(const BasicKeyHandle& other) const { return bits == other.bits; }
+    constexpr bool operator!=(const BasicKeyHandle& other) const { return bits != other.bits; }
+
+
+private:
+
+    // Generation in the high bits, index in the low bits; live generations
+    // are odd, so a zero word is never a valid handle
+    Word bits = 0;
+};
+
+
+// 32-bit handle: up to 1M slots, 4096 generations
+using KeyHandle32 = BasicKeyHandle<uint32_t, 20>;
+
+// 64-bit handle: up to 4G slots, 4G generations
+using KeyHandle64 = BasicKeyHandle<uint64_t, 32>;
+
+// Default handle type
+using KeyHandle = KeyHandle64;
+
+
+#endif // KEYHANDLE_HPP
@@ -0,0 +1,199 @@
+// KeyMagazine: Per-thread key cache over a ConcurrentKeyPool (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYMAGAZINE_HPP
+#define KEYMAGAZINE_HPP
+
+#include "ConcurrentKeyPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Sizing of a KeyMagazine
+struct KeyMagazinePolicy {
+    // Keys moved between the magazine and the shared pool per refill or flush
+    size_t batchSize = 64;
+};
+
+
+/**
+ * @brief KeyMagazine is a small per-thread stack of keys in front of a shared
+ *        ConcurrentKeyPool, as in the magazine layer of slab allocators.
+ *        Pops and pushes are served locally; the shared pool is only touched
+ *        once per batchSize keys, with one batched pop or push.
+ *
+ *        The magazine holds at most 2 * batchSize keys: when it fills up, the
+ *        older half goes back to the pool, so a thread that only frees keys
+ *        never hoards them. Keys parked in a magazine are invisible to other
+ *        threads; flush() or flushIfIdle() hands them back.
+ *
+ *        A KeyMagazine belongs to one thread at a time and must not outlive
+ *        its pool.
+ */
+class KeyMagazine {
+public:
+
+    // ──────────────────────────────────────────────
+    // 🔹 Constructors
+    // ──────────────────────────────────────────────
+
+    // Creates an empty magazine over a shared pool
+    explicit KeyMagazine(ConcurrentKeyPool& pool, const KeyMagazinePolicy& policy = {});
+
+    // Returns every cached key to the pool
+    ~KeyMagazine();
+
+    // Moving hands the cached keys to the new magazine
+    KeyMagazine(KeyMagazine&& other) noexcept;
+    KeyMagazine(const KeyMagazine&) = delete;
+    KeyMagazine& operator=(const KeyMagazine&) = delete;
+    KeyMagazine& operator=(KeyMagazine&&) = delete;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Key Management
+    // ──────────────────────────────────────────────
+
+    // Pops a cached key, refilling from the pool when empty; returns false if none is left
+    bool tryPop(int& key);
+
+    // Pops a key; throws std::out_of_range if none is left
+    int pop();
+
+    // Caches a freed key, returning a batch to the pool when full
+    void push(int key);
+
+    // Returns every cached key to the pool
+    void flush();
+
+    // Flushes if no key was popped or pushed since the previous call; returns true if it did
+    bool flushIfIdle();
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the number of keys cached locally
+    size_t cached() const;
+
+    // Returns the shared pool behind this magazine
+    ConcurrentKeyPool& getPool() const;
+
+
+private:
+
+    // Shared pool
+    ConcurrentKeyPool* pool;
+
+    // Keys per refill or flush
+    size_t batchSize;
+
+    // Cached keys (top at the back)
+    std::vector<int> keys;
+
+    // Operations since the last idle check
+    uint64_t operations = 0;
+};
+
+
+//
+// ░░ Implementation of KeyMagazine ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Constructors
+// ────────────────────────────────────────────────────────────────
+
+// Reserves the full magazine up front, so the hot path never allocates
+inline KeyMagazine::KeyMagazine(ConcurrentKeyPool& pool, const KeyMagazinePolicy& policy)
+    : pool(&pool), batchSize(policy.batchSize) {
+    if (batchSize == 0) {
+        throw std::invalid_argument("Magazine batch size must be positive");
+    }
+    keys.reserve(2 * batchSize);
+}
+
+
+inline KeyMagazine::~KeyMagazine() {
+    if (pool) flush();
+}
+
+
+inline KeyMagazine::KeyMagazine(KeyMagazine&& other) noexcept
+    : pool(other.pool), batchSize(other.batchSize), keys(std::move(other.keys)),
+      operations(other.operations) {
+    other.pool = nullptr;
+    other.keys.clear();
+}
+
+
+// 🔹 Key Management
+// ────────────────────────────────────────────────────────────────
+
+// One batched pop from the shared pool per batchSize local pops
+inline bool KeyMagazine::tryPop(int& key) {
+    ++operations;
+    if (keys.empty()) {
+        keys.resize(batchSize);
+        keys.resize(pool->popBatch(keys.data(), batchSize));
+        if (keys.empty()) return false;
+    }
+    key = keys.back();
+    keys.pop_back();
+    return true;
+}
+
+
+// Retrieves the next available key
+inline int KeyMagazine::pop() {
+    int key;
+    if (!tryPop(key)) throw std::out_of_range("No more keys available");
+    return key;
+}
+
+
+// The older half goes back, so the most recently freed (cache-hot) keys stay local
+inline void KeyMagazine::push(int key) {
+    ++operations;
+    if (keys.size() == 2 * batchSize) {
+        pool->pushBatch(keys.data(), batchSize);
+        keys.erase(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(batchSize));
+    }
+    keys.push_back(key);
+}
+
+
+// Returns all cached keys in one batch
+inline void KeyMagazine::flush() {
+    if (!keys.empty()) {
+        pool->pushBatch(keys.data(), keys.size());
+        keys.clear();
+    }
+}
+
+
+// Meant to be called periodically by the owning thread (e.g. from its idle
+// loop); counting operations keeps the clock off the hot path
+inline bool KeyMagazine::flushIfIdle() {
+    bool idle = operations == 0 && !keys.empty();
+    if (idle) flush();
+    operations = 0;
+    return idle;
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+inline size_t KeyMagazine::cached() const {
+    return keys.size();
+}
+
+
+inline ConcurrentKeyPool& KeyMagazine::getPool() const {
+    return *pool;
+}
+
+
+#endif // KEYMAGAZINE_HPP
@@ -0,0 +1,410 @@
+// KeyOrder: Orders in which IntrusiveKeyPool reuses freed keys
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYORDER_HPP
+#define KEYORDER_HPP
+
+#include "KeyTraits.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief A key order holds the recycled keys of a BasicIntrusiveKeyPool and
+ *        decides which one is reused next. The pool only falls back to its
+ *        bump range once the order is empty. Every order is a template over
+ *        its key type (int for the plain names, e.g. LifoKeyOrder) and provides:
+ *            template <Links> Key  take(const Links&);        // next key (not empty)
+ *            template <Links> void put(Key key, Links&);      // a freed key
+ *            bool empty() const;  size_t size() const;  void clear();
+ *            template <From, To> void copyLinks(const From&, To&) const;
+ *            template <Links, Fn> void forEach(const Links&, Fn&&) const;  // in take order
+ *            static constexpr bool TakesNewestFirst;
+ *            template <K> using Rebind;                       // same order over key type K
+ *
+ *        The linked orders thread their list through the free slots (`Links`,
+ *        see IntrusiveKeyPool.hpp) and own no memory; LowestKeyOrder keeps a
+ *        bitmap of its own instead.
+ */
+
+
+/**
+ * @brief LifoKeyOrder reuses the most recently freed key first: its slot is
+ *        the one most likely still in cache. Under churn, live keys scatter
+ *        over the whole key range.
+ */
+template <typename Key = int>
+class BasicLifoKeyOrder {
+public:
+
+    // The same order over another key type
+    template <typename K>
+    using Rebind = BasicLifoKeyOrder<K>;
+
+    // Keys put last are taken first
+    static constexpr bool TakesNewestFirst = true;
+
+    template <typename Links>
+    Key take(const Links& links);
+
+    template <typename Links>
+    void put(Key key, Links& links);
+
+    bool empty() const { return head == NoKey; }
+    size_t size() const { return count; }
+    void clear() { head = NoKey; count = 0; }
+
+    template <typename FromLinks, typename ToLinks>
+    void copyLinks(const FromLinks& from, ToLinks& to) const;
+
+    template <typename Links, typename Fn>
+    void forEach(const Links& links, Fn&& fn) const;
+
+private:
+
+    // Marks the end of the list
+    static constexpr Key NoKey = KeyTraits<Key>::NoKey;
+
+    // Most recently freed key
+    Key head = NoKey;
+
+    // Number of linked keys
+    size_t count = 0;
+};
+
+
+/**
+ * @brief FifoKeyOrder reuses the least recently freed key first, so a key
+ *        stays unused for as long as possible after it was freed: a stale
+ *        copy of it is more likely to be caught (and, with generations, the
+ *        counter wraps much later). Put links the key behind the tail slot.
+ */
+template <typename Key = int>
+class BasicFifoKeyOrder {
+public:
+
+    // The same order over another key type
+    template <typename K>
+    using Rebind = BasicFifoKeyOrder<K>;
+
+    // Keys put first are taken first
+    static constexpr bool TakesNewestFirst = false;
+
+    template <typename Links>
+    Key take(const Links& links);
+
+    template <typename Links>
+    void put(Key key, Links& links);
+
+    bool empty() const { return head == NoKey; }
+    size_t size() const { return count; }
+    void clear() { head = tail = NoKey; count = 0; }
+
+    template <typename FromLinks, typename ToLinks>
+    void copyLinks(const FromLinks& from, ToLinks& to) const;
+
+    template <typename Links, typename Fn>
+    void forEach(const Links& links, Fn&& fn) const;
+
+private:
+
+    // Marks the end of the list
+    static constexpr Key NoKey = KeyTraits<Key>::NoKey;
+
+    // Least recently freed key (taken next)
+    Key head = NoKey;
+
+    // Most recently freed key (linked to by the next put)
+    Key tail = NoKey;
+
+    // Number of linked keys
+    size_t count = 0;
+};
+
+
+/**
+ * @brief LowestKeyOrder always reuses the lowest free key, which keeps live
+ *        keys packed at the bottom of the range (dense scans, and a shrink
+ *        with little to move). Free keys are bits of a hierarchical bitmap:
+ *        each level has one bit per non-empty word of the level below, so
+ *        finding the lowest key reads one word per level, O(log64 n).
+ *        Costs about one bit per key of memory; no slot is written.
+ */
+template <typename Key = int>
+class BasicLowestKeyOrder {
+public:
+
+    // The same order over another key type
+    template <typename K>
+    using Rebind = BasicLowestKeyOrder<K>;
+
+    // Order does not depend on when keys were put
+    static constexpr bool TakesNewestFirst = false;
+
+    template <typename Links>
+    Key take(const Links& links);
+
+    template <typename Links>
+    void put(Key key, Links& links);
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    void clear();
+
+    template <typename FromLinks, typename ToLinks>
+    void copyLinks(const FromLinks& from, ToLinks& to) const;
+
+    template <typename Links, typename Fn>
+    void forEach(const Links& links, Fn&& fn) const;
+
+private:
+
+    static constexpr unsigned WordBits = 64;
+
+    // Returns the index of the lowest set bit of a non-zero word
+    static unsigned lowestBit(uint64_t word);
+
+    // Makes room for keys below `keys`, rebuilding the upper levels
+    void reserve(size_t keys);
+
+    // Zeroes word w of the given level and the words below it that it marks
+    void clearWord(size_t level, size_t w);
+
+    // levels[0] has one bit per key; the last level is a single word
+    std::vector<std::vector<uint64_t>> levels;
+
+    // Number of free keys
+    size_t count = 0;
+};
+
+// The int-keyed orders
+using LifoKeyOrder = BasicLifoKeyOrder<int>;
+using FifoKeyOrder = BasicFifoKeyOrder<int>;
+using LowestKeyOrder = BasicLowestKeyOrder<int>;
+
+
+//
+// ░░ Implementation of BasicLifoKeyOrder ░░
+// ────────────────────────────────────────────────────────────────
+
+// Unlinks the head of the list
+template <typename Key>
+template <typename Links>
+Key BasicLifoKeyOrder<Key>::take(const Links& links) {
+    Key key = head;
+    head = links.nextFree(key);
+    --count;
+    return key;
+}
+
+
+// Links the key in front of the head, through its own slot
+template <typename Key>
+template <typename Links>
+void BasicLifoKeyOrder<Key>::put(Key key, Links& links) {
+    links.setNextFree(key, head);
+    head = key;
+    ++count;
+}
+
+
+// Re-writes each link of the list into the other storage
+template <typename Key>
+template <typename FromLinks, typename ToLinks>
+void BasicLifoKeyOrder<Key>::copyLinks(const FromLinks& from, ToLinks& to) const {
+    for (Key key = head; key != NoKey; key = from.nextFree(key)) {
+        to.setNextFree(key, from.nextFree(key));
+    }
+}
+
+
+// Visits the list from the head
+template <typename Key>
+template <typename Links, typename Fn>
+void BasicLifoKeyOrder<Key>::forEach(const Links& links, Fn&& fn) const {
+    for (Key key = head; key != NoKey; key = links.nextFree(key)) {
+        fn(key);
+    }
+}
+
+
+//
+// ░░ Implementation of BasicFifoKeyOrder ░░
+// ────────────────────────────────────────────────────────────────
+
+// Unlinks the head of the queue
+template <typename Key>
+template <typename Links>
+Key BasicFifoKeyOrder<Key>::take(const Links& links) {
+    Key key = head;
+    head = links.nextFree(key);
+    if (head == NoKey) tail = NoKey;
+    --count;
+    return key;
+}
+
+
+// Terminates the key's own link, then appends it behind the tail
+template <typename Key>
+template <typename Links>
+void BasicFifoKeyOrder<Key>::put(Key key, Links& links) {
+    links.setNextFree(key, NoKey);
+    if (tail == NoKey) {
+        head = key;
+    } else {
+        links.setNextFree(tail, key);
+    }
+    tail = key;
+    ++count;
+}
+
+
+// Re-writes each link of the queue, including the tail's terminator
+template <typename Key>
+template <typename FromLinks, typename ToLinks>
+void BasicFifoKeyOrder<Key>::copyLinks(const FromLinks& from, ToLinks& to) const {
+    for (Key key = head; key != NoKey; key = from.nextFree(key)) {
+        to.setNextFree(key, from.nextFree(key));
+    }
+}
+
+
+// Visits the queue from the head
+template <typename Key>
+template <typename Links, typename Fn>
+void BasicFifoKeyOrder<Key>::forEach(const Links& links, Fn&& fn) const {
+    for (Key key = head; key != NoKey; key = links.nextFree(key)) {
+        fn(key);
+    }
+}
+
+
+//
+// ░░ Implementation of BasicLowestKeyOrder ░░
+// ────────────────────────────────────────────────────────────────
+
+// Descends from the single top word, one lowest bit per level, then clears the
+// key and every word above that went empty with it
+template <typename Key>
+template <typename Links>
+Key BasicLowestKeyOrder<Key>::take(const Links&) {
+    size_t index = 0;
+    for (size_t level = levels.size(); level-- > 0;) {
+        index = index * WordBits + lowestBit(levels[level][index]);
+    }
+
+    size_t bit = index;
+    for (std::vector<uint64_t>& words : levels) {
+        uint64_t& word = words[bit / WordBits];
+        word &= ~(uint64_t(1) << (bit % WordBits));
+        if (word != 0) break;
+        bit /= WordBits;
+    }
+    --count;
+    return static_cast<Key>(index);
+}
+
+
+// Sets the key and marks its word non-empty on each level until one already was
+template <typename Key>
+template <typename Links>
+void BasicLowestKeyOrder<Key>::put(Key key, Links&) {
+    size_t bit = static_cast<size_t>(key);
+    if (levels.empty() || bit >= levels[0].size() * WordBits) {
+        reserve(bit + 1);
+    }
+
+    for (std::vector<uint64_t>& words : levels) {
+        uint64_t& word = words[bit / WordBits];
+        bool wasEmpty = word == 0;
+        word |= uint64_t(1) << (bit % WordBits);
+        if (!wasEmpty) break;
+        bit /= WordBits;
+    }
+    ++count;
+}
+
+
+// Keeps the memory for the next keys. The upper levels lead to the non-zero
+// words, so only those are zeroed: O(free keys), not O(key capacity)
+template <typename Key>
+void BasicLowestKeyOrder<Key>::clear() {
+    if (count != 0) clearWord(levels.size() - 1, 0);
+    count = 0;
+}
+
+
+// Zeroes a word and, below the key level, every word its bits mark
+template <typename Key>
+void BasicLowestKeyOrder<Key>::clearWord(size_t level, size_t w) {
+    uint64_t word = levels[level][w];
+    levels[level][w] = 0;
+    if (level == 0) return;
+    for (; word != 0; word &= word - 1) {
+        clearWord(level - 1, w * WordBits + lowestBit(word));
+    }
+}
+
+
+// Nothing lives in the slots
+template <typename Key>
+template <typename FromLinks, typename ToLinks>
+void BasicLowestKeyOrder<Key>::copyLinks(const FromLinks&, ToLinks&) const {}
+
+
+// Visits free keys in ascending order, which is also take order
+template <typename Key>
+template <typename Links, typename Fn>
+void BasicLowestKeyOrder<Key>::forEach(const Links&, Fn&& fn) const {
+    if (levels.empty()) return;
+
+    const std::vector<uint64_t>& keys = levels[0];
+    for (size_t w = 0; w < keys.size(); ++w) {
+        for (uint64_t word = keys[w]; word != 0; word &= word - 1) {
+            fn(static_cast<Key>(w * WordBits + lowestBit(word)));
+        }
+    }
+}
+
+
+template <typename Key>
+unsigned BasicLowestKeyOrder<Key>::lowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned index = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+
+// Doubles the key capacity at least, so puts of rising keys rebuild rarely;
+// the upper levels are recomputed from the key level
+template <typename Key>
+void BasicLowestKeyOrder<Key>::reserve(size_t keys) {
+    size_t current = levels.empty() ? 0 : levels[0].size();
+    size_t words = std::max((keys + WordBits - 1) / WordBits, current * 2);
+
+    std::vector<uint64_t> bottom = levels.empty() ? std::vector<uint64_t>() : std::move(levels[0]);
+    bottom.resize(words, 0);
+
+    levels.clear();
+    levels.push_back(std::move(bottom));
+    while (levels.back().size() > 1) {
+        const std::vector<uint64_t>& below = levels.back();
+        std::vector<uint64_t> above((below.size() + WordBits - 1) / WordBits, 0);
+        for (size_t w = 0; w < below.size(); ++w) {
+            if (below[w] != 0) above[w / WordBits] |= uint64_t(1) << (w % WordBits);
+        }
+        levels.push_back(std::move(above));
+    }
+}
+
+
+#endif // KEYORDER_HPP
@@ -4,12 +4,19 @@
 #ifndef KEYPOOL_HPP
 #define KEYPOOL_HPP
 
+#include "KeyTraits.hpp"
 #include <stack>
 #include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
-class KeyPool {
+/**
+ * @brief BasicKeyPool hands out keys of type Key (see KeyTraits.hpp) from a
+ *        range, reusing recycled keys from a stack first. KeyPool is the
+ *        int-keyed pool; a uint16_t pool halves the stack of recycled keys.
+ */
+template <typename Key = int>
+class BasicKeyPool {
 public:
 
     // ──────────────────────────────────────────────
@@ -17,10 +24,10 @@ public:
     // ──────────────────────────────────────────────
 
     // Constructs a key pool with keys ranging from 0 to maxKey (inclusive)
-    explicit KeyPool(int maxKey = 99);
+    explicit BasicKeyPool(Key maxKey = 99);
 
     // Constructs a key pool with sorted range from min(value1, value2) to max(value1, value2)
-    KeyPool(int value1, int value2);
+    BasicKeyPool(Key value1, Key value2);
 
 
     // ──────────────────────────────────────────────
@@ -28,19 +35,20 @@ public:
     // ──────────────────────────────────────────────
 
     // Pops the next available key from the pool
-    int pop();
+    Key pop();
 
     // Pushes a key back into the pool
-    void push(int value);
+    void push(Key value);
 
     // Checks if the pool is empty
     bool empty() const;
 
-    // Doubles the maximum value (used for dynamic growth strategies)
+    // Doubles the maximum value (used for dynamic growth strategies); throws
+    // std::length_error once the range already ends at KeyTraits<Key>::MaxKey
     void increaseMaxValue();
 
     // Resets the pool with a new key range
-    void reset(int newStart = 0, int newEnd = 99);
+    void reset(Key newStart = 0, Key newEnd = 99);
 
 
     // ──────────────────────────────────────────────
@@ -48,10 +56,10 @@ public:
     // ──────────────────────────────────────────────
 
     // Returns the current value for next available key
-    int getCurrentValue() const;
+    Key getCurrentValue() const;
 
     // Returns the maximum allowed key
-    int getMaxValue() const;
+    Key getMaxValue() const;
 
 
     // ──────────────────────────────────────────────
@@ -59,22 +67,27 @@ public:
     // ──────────────────────────────────────────────
 
     // Prints key pool metadata to stream
-    friend std::ostream& operator<<(std::ostream& os, const KeyPool& pool);
+    template <typename K>
+    friend std::ostream& operator<<(std::ostream& os, const BasicKeyPool<K>& pool);
 
 
 private:
 
     // The next available key to assign
-    int nextKey;
+    Key nextKey;
+
+    // The lowest key of the range
+    Key minKey;
 
     // The maximum key that can be assigned
-    int maxKey;
+    Key maxKey;
 
     // Stack of recycled keys
-    std::stack<int> pool;
+    std::stack<Key> pool;
 };
 
-#endif // KEYPOOL_HPP
+// The int-keyed pool
+using KeyPool = BasicKeyPool<int>;
 
 
 //
@@ -84,16 +97,19 @@ private:
 // 🔹 Constructors
 // ────────────────────────────────────────────────────────────────
 
-// Constructs a key pool from 0 to maxInclusive (default range)
-KeyPool::KeyPool(int maxInclusive)
-    : nextKey(0), maxKey(maxInclusive) {}
+// Constructs a key pool from 0 to maxInclusive (default range), clamped to the key type
+template <typename Key>
+BasicKeyPool<Key>::BasicKeyPool(Key maxInclusive)
+    : nextKey(0), minKey(0), maxKey(std::min(maxInclusive, KeyTraits<Key>::MaxKey)) {}
 
 
 // Constructs a key pool from min(value1, value2) to max(value1, value2)
-KeyPool::KeyPool(int value1, int value2) {
+template <typename Key>
+BasicKeyPool<Key>::BasicKeyPool(Key value1, Key value2) {
     if (value1 > value2) std::swap(value1, value2);
     nextKey = value1;
-    maxKey = value2;
+    minKey = value1;
+    maxKey = std::min(value2, KeyTraits<Key>::MaxKey);
 }
 
 
@@ -101,9 +117,10 @@ KeyPool::KeyPool(int value1, int value2) {
 // ────────────────────────────────────────────────────────────────
 
 // Retrieves the next available key from the pool
-int KeyPool::pop() {
+template <typename Key>
+Key BasicKeyPool<Key>::pop() {
     if (!pool.empty()) {
-        int value = pool.top();
+        Key value = pool.top();
         pool.pop();
         return value;
     }
@@ -112,33 +129,43 @@ int KeyPool::pop() {
 }
 
 
-// Recycles a key back into the pool (only if in valid range)
-void KeyPool::push(int value) {
-    if (value >= nextKey && value <= maxKey) {
+// Recycles a key back into the pool (only if it was already issued)
+template <typename Key>
+void BasicKeyPool<Key>::push(Key value) {
+    if (value >= minKey && value < nextKey) {
         pool.push(value);
     }
 }
 
 
 // Returns true if there are no keys available
-bool KeyPool::empty() const {
+template <typename Key>
+bool BasicKeyPool<Key>::empty() const {
     return pool.empty() && nextKey > maxKey;
 }
 
 
-// Doubles the maximum key value (used for dynamic growth)
-void KeyPool::increaseMaxValue() {
-    maxKey *= 2;
+// Doubles the maximum key value (used for dynamic growth), stopping at the
+// largest key the type allows
+template <typename Key>
+void BasicKeyPool<Key>::increaseMaxValue() {
+    constexpr Key Limit = KeyTraits<Key>::MaxKey;
+    if (maxKey >= Limit) {
+        throw std::length_error("KeyPool cannot grow beyond its key type");
+    }
+    maxKey = maxKey > Limit / 2 ? Limit : std::max<Key>(1, static_cast<Key>(maxKey * 2));
 }
 
 
 // Resets the key pool with a new range
-void KeyPool::reset(int newStart, int newEnd) {
+template <typename Key>
+void BasicKeyPool<Key>::reset(Key newStart, Key newEnd) {
     if (newStart > newEnd) std::swap(newStart, newEnd);
-    std::stack<int> empty;
+    std::stack<Key> empty;
     std::swap(pool, empty);
     nextKey = newStart;
-    maxKey = newEnd;
+    minKey = newStart;
+    maxKey = std::min(newEnd, KeyTraits<Key>::MaxKey);
 }
 
 
@@ -146,13 +173,15 @@ void KeyPool::reset(int newStart, int newEnd) {
 // ────────────────────────────────────────────────────────────────
 
 // Returns the current value of the next key
-int KeyPool::getCurrentValue() const {
+template <typename Key>
+Key BasicKeyPool<Key>::getCurrentValue() const {
     return nextKey;
 }
 
 
 // Returns the upper bound key value
-int KeyPool::getMaxValue() const {
+template <typename Key>
+Key BasicKeyPool<Key>::getMaxValue() const {
     return maxKey;
 }
 
@@ -160,10 +189,12 @@ int KeyPool::getMaxValue() const {
 // 🔹 Debug Output
 // ────────────────────────────────────────────────────────────────
 
-// Outputs key pool state to an output stream
-std::ostream& operator<<(std::ostream& os, const KeyPool& pool) {
-    os << "KeyPool: Current Value = " << pool.nextKey << ", Max Value = " << pool.maxKey;
+// Outputs key pool state to an output stream (keys print as numbers, also for 8-bit types)
+template <typename Key>
+std::ostream& operator<<(std::ostream& os, const BasicKeyPool<Key>& pool) {
+    os << "KeyPool: Current Value = " << +pool.nextKey << ", Max Value = " << +pool.maxKey;
     return os;
 }
 
 
+#endif // KEYPOOL_HPP
@@ -0,0 +1,51 @@
+// KeyTraits: Properties of the integer type used for keys
+// Author: Eli (Eliyahu) Shif
+
+#ifndef KEYTRAITS_HPP
+#define KEYTRAITS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief KeyTraits<Key> describes a key type for the pools and arrays that
+ *        take one as a template parameter (int unless given): uint16_t
+ *        for compact per-object tables, uint32_t or uint64_t for tables
+ *        past 2^31 slots, or any other integer type.
+ *
+ *        The largest value of the type is never handed out as a key, so a
+ *        pool's bump cursor can step past its last key without wrapping.
+ *        Growth that would need more keys than the type can name throws
+ *        std::length_error instead of overflowing.
+ */
+template <typename Key>
+struct KeyTraits {
+    static_assert(std::is_integral_v<Key> && !std::is_same_v<Key, bool>, "Keys must be an integer type");
+
+    // Highest key a pool ever hands out
+    static constexpr Key MaxKey = std::numeric_limits<Key>::max() - 1;
+
+    // Marks the end of a free list; never a valid key
+    static constexpr Key NoKey = std::is_signed_v<Key> ? std::numeric_limits<Key>::min()
+                                                       : std::numeric_limits<Key>::max();
+
+    // Returned instead of a key for a value that went to the overflow queue
+    static constexpr Key Queued = std::is_signed_v<Key> ? Key(-1) : std::numeric_limits<Key>::max();
+
+    // Maps key - offset to a slot index. The subtraction is unsigned, so keys
+    // below the offset wrap to huge indices and one compare rejects both ends
+    static constexpr size_t slotOf(Key key, Key offset) noexcept {
+        return static_cast<size_t>(static_cast<unsigned long long>(key) - static_cast<unsigned long long>(offset));
+    }
+
+    // Number of keys from `first` to MaxKey, capped at the size_t range
+    static constexpr size_t keysFrom(Key first) noexcept {
+        unsigned long long count = static_cast<unsigned long long>(MaxKey) - static_cast<unsigned long long>(first) + 1;
+        return count > std::numeric_limits<size_t>::max() ? std::numeric_limits<size_t>::max() : static_cast<size_t>(count);
+    }
+};
+
+
+#endif // KEYTRAITS_HPP
@@ -0,0 +1,301 @@
+// OccupancyBitmap: Word-packed validity flags for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef OCCUPANCYBITMAP_HPP
+#define OCCUPANCYBITMAP_HPP
+
+#include "KeyArrayAllocator.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief OccupancyBitmap stores one bit per slot in 64-bit words.
+ *        Scans skip empty words entirely and jump to the next set bit
+ *        with count-trailing-zeros, so walking the live slots costs
+ *        O(live + size / 64) instead of O(size).
+ *
+ *        Invariant: bits past size() in the last word are always zero.
+ */
+class OccupancyBitmap {
+public:
+
+    // Number of bits stored per word
+    static constexpr size_t WordBits = 64;
+
+    // ──────────────────────────────────────────────
+    // 🔹 Construction
+    // ──────────────────────────────────────────────
+
+    // Constructs a bitmap of the given size with all bits cleared, allocating from resource
+    explicit OccupancyBitmap(size_t bits = 0, std::pmr::memory_resource* resource = nullptr);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Bit Access
+    // ──────────────────────────────────────────────
+
+    // Returns true if the bit at the given index is set
+    bool test(size_t index) const;
+
+    // Sets the bit at the given index
+    void set(size_t index);
+
+    // Clears the bit at the given index
+    void reset(size_t index);
+
+    // Sets every bit in [first, last), a whole word at a time
+    void setRange(size_t first, size_t last);
+
+    // Resizes the bitmap to the given size and clears every bit
+    void assign(size_t bits);
+
+    // Resizes the bitmap to the given size, keeping the bits below it
+    void resize(size_t bits);
+
+    // Resizes the bitmap and copies its words from raw memory in one memcpy
+    void assignWords(size_t bits, const void* source);
+
+    // Clears every bit, keeping the size
+    void clearAll();
+
+    // Clears every bit below `end`, keeping the size; O(end / 64)
+    void clearBelow(size_t end);
+
+    // Drops all bits and the backing words
+    void clear();
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Scanning
+    // ──────────────────────────────────────────────
+
+    // Returns the first set bit at or after `from`, or size() if there is none
+    size_t findNext(size_t from) const;
+
+    // Calls fn(index) for every set bit in ascending order
+    template <typename Fn>
+    void forEachSet(Fn&& fn) const;
+
+    // Calls fn(index) for every set bit below `end` in ascending order
+    template <typename Fn>
+    void forEachSetBelow(size_t end, Fn&& fn) const;
+
+    // Returns the index of the lowest set bit of a non-zero word
+    static unsigned countTrailingZeros(uint64_t word);
+
+    // Returns the index of the highest set bit of a non-zero word
+    static unsigned highestBit(uint64_t word);
+
+    // Returns the number of set bits of a word
+    static unsigned popCount(uint64_t word);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the number of bits
+    size_t size() const;
+
+    // Returns the number of backing words
+    size_t wordCount() const;
+
+    // Returns the backing word at the given word index
+    uint64_t word(size_t wordIndex) const;
+
+    // Returns the bytes held by the backing words
+    size_t bytes() const;
+
+    // Returns the memory resource the words live in
+    std::pmr::memory_resource* resource() const;
+
+
+private:
+
+    // Packed occupancy words, bit i of word w is slot w * 64 + i
+    std::vector<uint64_t, KeyArrayAllocator<uint64_t>> words;
+
+    // Number of valid bits
+    size_t bitCount;
+};
+
+
+// ===============================
+// OccupancyBitmap: Implementations
+// ===============================
+
+inline OccupancyBitmap::OccupancyBitmap(size_t bits, std::pmr::memory_resource* resource)
+    : words((bits + WordBits - 1) / WordBits, 0, KeyArrayAllocator<uint64_t>(resource)), bitCount(bits) {}
+
+inline bool OccupancyBitmap::test(size_t index) const {
+    return (words[index / WordBits] >> (index % WordBits)) & 1u;
+}
+
+inline void OccupancyBitmap::set(size_t index) {
+    words[index / WordBits] |= uint64_t(1) << (index % WordBits);
+}
+
+inline void OccupancyBitmap::reset(size_t index) {
+    words[index / WordBits] &= ~(uint64_t(1) << (index % WordBits));
+}
+
+// Fills the partial head and tail words with masks and the middle words whole.
+inline void OccupancyBitmap::setRange(size_t first, size_t last) {
+    if (first >= last) return;
+
+    size_t firstWord = first / WordBits;
+    size_t lastWord = (last - 1) / WordBits;
+    uint64_t headMask = ~uint64_t(0) << (first % WordBits);
+    uint64_t tailMask = ~uint64_t(0) >> (WordBits - 1 - (last - 1) % WordBits);
+
+    if (firstWord == lastWord) {
+        words[firstWord] |= headMask & tailMask;
+        return;
+    }
+    words[firstWord] |= headMask;
+    std::fill(words.begin() + firstWord + 1, words.begin() + lastWord, ~uint64_t(0));
+    words[lastWord] |= tailMask;
+}
+
+inline void OccupancyBitmap::assign(size_t bits) {
+    words.assign((bits + WordBits - 1) / WordBits, 0);
+    bitCount = bits;
+}
+
+// Bits past the new size in the last word are masked off to keep the invariant.
+inline void OccupancyBitmap::resize(size_t bits) {
+    words.resize((bits + WordBits - 1) / WordBits, 0);
+    bitCount = bits;
+    if (bits % WordBits != 0) {
+        words.back() &= ~uint64_t(0) >> (WordBits - bits % WordBits);
+    }
+}
+
+// The source may be unaligned; bits past the size are masked off afterwards.
+inline void OccupancyBitmap::assignWords(size_t bits, const void* source) {
+    words.resize((bits + WordBits - 1) / WordBits);
+    bitCount = bits;
+    if (!words.empty()) {
+        std::memcpy(words.data(), source, words.size() * sizeof(uint64_t));
+    }
+    resize(bits);
+}
+
+inline void OccupancyBitmap::clearAll() {
+    std::fill(words.begin(), words.end(), 0);
+}
+
+// Whole words are zeroed; the word holding `end` keeps its bits from `end` up
+inline void OccupancyBitmap::clearBelow(size_t end) {
+    end = std::min(end, bitCount);
+    size_t full = end / WordBits;
+    std::fill(words.begin(), words.begin() + static_cast<std::ptrdiff_t>(full), 0);
+    if (end % WordBits != 0) {
+        words[full] &= ~uint64_t(0) << (end % WordBits);
+    }
+}
+
+inline void OccupancyBitmap::clear() {
+    words.clear();
+    bitCount = 0;
+}
+
+// Masks off the bits below `from` in its word, then skips zero words.
+inline size_t OccupancyBitmap::findNext(size_t from) const {
+    if (from >= bitCount) return bitCount;
+
+    size_t w = from / WordBits;
+    uint64_t bits = words[w] & (~uint64_t(0) << (from % WordBits));
+    while (bits == 0) {
+        if (++w >= words.size()) return bitCount;
+        bits = words[w];
+    }
+    return w * WordBits + countTrailingZeros(bits);
+}
+
+// Visits set bits word by word, peeling the lowest set bit each round.
+template <typename Fn>
+void OccupancyBitmap::forEachSet(Fn&& fn) const {
+    for (size_t w = 0; w < words.size(); ++w) {
+        uint64_t bits = words[w];
+        while (bits != 0) {
+            fn(w * WordBits + countTrailingZeros(bits));
+            bits &= bits - 1;
+        }
+    }
+}
+
+// Stops at the word holding `end`, masking off its bits from `end` up
+template <typename Fn>
+void OccupancyBitmap::forEachSetBelow(size_t end, Fn&& fn) const {
+    end = std::min(end, bitCount);
+    size_t last = (end + WordBits - 1) / WordBits;
+    for (size_t w = 0; w < last; ++w) {
+        uint64_t bits = words[w];
+        if (w + 1 == last && end % WordBits != 0) {
+            bits &= (uint64_t(1) << (end % WordBits)) - 1;
+        }
+        while (bits != 0) {
+            fn(w * WordBits + countTrailingZeros(bits));
+            bits &= bits - 1;
+        }
+    }
+}
+
+inline unsigned OccupancyBitmap::countTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+inline unsigned OccupancyBitmap::highestBit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(63 - __builtin_clzll(word));
+#endif
+}
+
+inline unsigned OccupancyBitmap::popCount(uint64_t word) {
+#if defined(_MSC_VER)
+    return static_cast<unsigned>(__popcnt64(word));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#endif
+}
+
+inline size_t OccupancyBitmap::size() const {
+    return bitCount;
+}
+
+inline size_t OccupancyBitmap::wordCount() const {
+    return words.size();
+}
+
+inline uint64_t OccupancyBitmap::word(size_t wordIndex) const {
+    return words[wordIndex];
+}
+
+inline size_t OccupancyBitmap::bytes() const {
+    return words.capacity() * sizeof(uint64_t);
+}
+
+inline std::pmr::memory_resource* OccupancyBitmap::resource() const {
+    return words.get_allocator().resource();
+}
+
+
+#endif // OCCUPANCYBITMAP_HPP
@@ -0,0 +1,371 @@
+// OverflowRing: Circular overflow queue for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef OVERFLOWRING_HPP
+#define OVERFLOWRING_HPP
+
+#include "KeyArrayAllocator.hpp"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// What a bounded overflow queue does with a value that arrives while it is full
+enum class OverflowPolicy {
+    Reject,     // the insert throws and the queue is left as it was
+    DropOldest  // the head of the queue is dropped to make room
+};
+
+
+/**
+ * @brief OverflowRing is a FIFO of values kept in one circular buffer, with
+ *        the front/back/push/pop interface of std::queue. A push only
+ *        allocates when the buffer is full, so a queue reserved up to its
+ *        bound (see KeyArray::enableQueue) never allocates again.
+ *
+ *        The capacity is a power of two and grows by doubling; values are
+ *        moved over in queue order. The buffer comes from a
+ *        std::pmr::memory_resource and moves with it.
+ */
+template <typename T>
+class OverflowRing {
+public:
+
+    // ──────────────────────────────────────────────
+    // 🔹 Construction
+    // ──────────────────────────────────────────────
+
+    // Creates an empty ring allocating from `resource` (nothing is allocated yet)
+    explicit OverflowRing(std::pmr::memory_resource* resource = nullptr);
+
+    // Copies the values in order, into a buffer of the same capacity and resource
+    OverflowRing(const OverflowRing& other);
+    OverflowRing& operator=(const OverflowRing& other);
+
+    // Takes over the buffer and its resource
+    OverflowRing(OverflowRing&& other) noexcept;
+    OverflowRing& operator=(OverflowRing&& other) noexcept;
+
+    // Destroys the queued values and frees the buffer
+    ~OverflowRing();
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Queue Operations
+    // ──────────────────────────────────────────────
+
+    // Appends a value behind the back
+    void push(const T& value);
+    void push(T&& value);
+
+    // Constructs a value behind the back
+    template <typename... Args>
+    T& emplace(Args&&... args);
+
+    // Destroys the front value (the queue must not be empty)
+    void pop();
+
+    // Destroys every value, keeping the buffer
+    void clear();
+
+    // Makes room for `count` values without further allocation
+    void reserve(size_t count);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Oldest and newest values (the queue must not be empty)
+    T& front();
+    const T& front() const;
+    T& back();
+    const T& back() const;
+
+    // Returns the value `position` places behind the front
+    T& operator[](size_t position);
+    const T& operator[](size_t position) const;
+
+    bool empty() const;
+    size_t size() const;
+
+    // Returns the number of values the buffer holds before it grows
+    size_t capacity() const;
+
+    // Returns the memory resource the buffer lives in
+    std::pmr::memory_resource* resource() const;
+
+
+private:
+
+    // Raw storage for one value
+    struct Cell {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    // Returns the value stored in a cell
+    static T& valueOf(Cell& cell);
+    static const T& valueOf(const Cell& cell);
+
+    // Returns the cell `position` places behind the front
+    Cell& cellAt(size_t position) const;
+
+    // Moves the values into a buffer of `newCapacity` cells; `tail` (if given)
+    // builds the value behind them first, so it may refer to a queued value
+    template <typename Build>
+    void reallocate(size_t newCapacity, Build&& tail);
+
+    // Destroys the values and frees the buffer
+    void release() noexcept;
+
+    // Source of the buffer
+    KeyArrayAllocator<Cell> allocator;
+
+    // Circular buffer of `cellCount` cells (zero or a power of two)
+    Cell* cells = nullptr;
+    size_t cellCount = 0;
+
+    // Cell index of the front value
+    size_t head = 0;
+
+    // Number of queued values
+    size_t count = 0;
+};
+
+
+// ===============================
+// OverflowRing<T>: Implementations
+// ===============================
+
+template <typename T>
+OverflowRing<T>::OverflowRing(std::pmr::memory_resource* resource) : allocator(resource) {}
+
+// The copy is compacted to start at cell 0
+template <typename T>
+OverflowRing<T>::OverflowRing(const OverflowRing& other) : allocator(other.allocator) {
+    if (other.cellCount == 0) return;
+
+    cells = allocator.allocate(other.cellCount);
+    cellCount = other.cellCount;
+    try {
+        for (; count < other.count; ++count) {
+            ::new (static_cast<void*>(cells[count].bytes)) T(other[count]);
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+// Copies aside first, so a throwing copy leaves this ring intact
+template <typename T>
+OverflowRing<T>& OverflowRing<T>::operator=(const OverflowRing& other) {
+    if (this != &other) {
+        OverflowRing copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+template <typename T>
+OverflowRing<T>::OverflowRing(OverflowRing&& other) noexcept
+    : allocator(other.allocator), cells(other.cells), cellCount(other.cellCount),
+      head(other.head), count(other.count) {
+    other.cells = nullptr;
+    other.cellCount = 0;
+    other.head = 0;
+    other.count = 0;
+}
+
+template <typename T>
+OverflowRing<T>& OverflowRing<T>::operator=(OverflowRing&& other) noexcept {
+    if (this != &other) {
+        release();
+        allocator = other.allocator;
+        cells = other.cells;
+        cellCount = other.cellCount;
+        head = other.head;
+        count = other.count;
+        other.cells = nullptr;
+        other.cellCount = 0;
+        other.head = 0;
+        other.count = 0;
+    }
+    return *this;
+}
+
+template <typename T>
+OverflowRing<T>::~OverflowRing() {
+    release();
+}
+
+
+// 🔹 Queue Operations
+// ────────────────────────────────────────────────────────────────
+
+template <typename T>
+void OverflowRing<T>::push(const T& value) {
+    emplace(value);
+}
+
+template <typename T>
+void OverflowRing<T>::push(T&& value) {
+    emplace(std::move(value));
+}
+
+// A full buffer doubles, with the new value built before the old ones move
+template <typename T>
+template <typename... Args>
+T& OverflowRing<T>::emplace(Args&&... args) {
+    if (count == cellCount) {
+        reallocate(cellCount ? cellCount * 2 : 8, [&](void* cell) {
+            ::new (cell) T(std::forward<Args>(args)...);
+        });
+    } else {
+        ::new (static_cast<void*>(cellAt(count).bytes)) T(std::forward<Args>(args)...);
+    }
+    ++count;
+    return back();
+}
+
+template <typename T>
+void OverflowRing<T>::pop() {
+    valueOf(cells[head]).~T();
+    head = (head + 1) & (cellCount - 1);
+    --count;
+}
+
+template <typename T>
+void OverflowRing<T>::clear() {
+    while (count > 0) pop();
+    head = 0;
+}
+
+// Rounds up to a power of two so positions wrap with a mask
+template <typename T>
+void OverflowRing<T>::reserve(size_t wanted) {
+    if (wanted <= cellCount) return;
+
+    size_t newCapacity = 8;
+    while (newCapacity < wanted) newCapacity *= 2;
+    reallocate(newCapacity, nullptr);
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+template <typename T>
+T& OverflowRing<T>::front() {
+    return valueOf(cells[head]);
+}
+
+template <typename T>
+const T& OverflowRing<T>::front() const {
+    return valueOf(cells[head]);
+}
+
+template <typename T>
+T& OverflowRing<T>::back() {
+    return valueOf(cellAt(count - 1));
+}
+
+template <typename T>
+const T& OverflowRing<T>::back() const {
+    return valueOf(cellAt(count - 1));
+}
+
+template <typename T>
+T& OverflowRing<T>::operator[](size_t position) {
+    return valueOf(cellAt(position));
+}
+
+template <typename T>
+const T& OverflowRing<T>::operator[](size_t position) const {
+    return valueOf(cellAt(position));
+}
+
+template <typename T>
+bool OverflowRing<T>::empty() const {
+    return count == 0;
+}
+
+template <typename T>
+size_t OverflowRing<T>::size() const {
+    return count;
+}
+
+template <typename T>
+size_t OverflowRing<T>::capacity() const {
+    return cellCount;
+}
+
+template <typename T>
+std::pmr::memory_resource* OverflowRing<T>::resource() const {
+    return allocator.resource();
+}
+
+
+// 🔹 Internals
+// ────────────────────────────────────────────────────────────────
+
+template <typename T>
+T& OverflowRing<T>::valueOf(Cell& cell) {
+    return *std::launder(reinterpret_cast<T*>(cell.bytes));
+}
+
+template <typename T>
+const T& OverflowRing<T>::valueOf(const Cell& cell) {
+    return *std::launder(reinterpret_cast<const T*>(cell.bytes));
+}
+
+template <typename T>
+typename OverflowRing<T>::Cell& OverflowRing<T>::cellAt(size_t position) const {
+    return cells[(head + position) & (cellCount - 1)];
+}
+
+// Values move with move_if_noexcept; if building any of them throws, the new
+// buffer is given back and this ring is unchanged
+template <typename T>
+template <typename Build>
+void OverflowRing<T>::reallocate(size_t newCapacity, Build&& tail) {
+    Cell* grown = allocator.allocate(newCapacity);
+
+    bool withTail = false;
+    size_t moved = 0;
+    try {
+        if constexpr (!std::is_same_v<std::decay_t<Build>, std::nullptr_t>) {
+            tail(static_cast<void*>(grown[count].bytes));
+            withTail = true;
+        }
+        for (; moved < count; ++moved) {
+            ::new (static_cast<void*>(grown[moved].bytes)) T(std::move_if_noexcept(valueOf(cellAt(moved))));
+        }
+    } catch (...) {
+        for (size_t i = 0; i < moved; ++i) valueOf(grown[i]).~T();
+        if (withTail) valueOf(grown[count]).~T();
+        allocator.deallocate(grown, newCapacity);
+        throw;
+    }
+
+    for (size_t i = 0; i < count; ++i) valueOf(cellAt(i)).~T();
+    if (cells) allocator.deallocate(cells, cellCount);
+
+    cells = grown;
+    cellCount = newCapacity;
+    head = 0;
+}
+
+template <typename T>
+void OverflowRing<T>::release() noexcept {
+    for (size_t i = 0; i < count; ++i) valueOf(cellAt(i)).~T();
+    if (cells) allocator.deallocate(cells, cellCount);
+    cells = nullptr;
+    cellCount = 0;
+    head = 0;
+    count = 0;
+}
+
+
+#endif // OVERFLOWRING_HPP
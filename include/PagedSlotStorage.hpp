@@ -0,0 +1,401 @@
+// PagedSlotStorage: Segmented slot storage with stable addresses for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef PAGEDSLOTSTORAGE_HPP
+#define PAGEDSLOTSTORAGE_HPP
+
+#include "OccupancyBitmap.hpp"
+#include "SlotStorage.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief PagedSlotStorage is a drop-in alternative to SlotStorage made of
+ *        fixed-size pages of 2^PageShift raw slots. Slot i lives in page
+ *        i >> PageShift at offset i & (PageSize - 1), so a lookup costs one
+ *        extra indirection through the page table.
+ *
+ *        Growing only appends pages: no value is ever copied or moved, the
+ *        old slots are never held twice during a resize, and references and
+ *        pointers to an element stay valid for the element's whole lifetime.
+ *        KeyArray detects this through GrowsInPlace and grows by calling
+ *        grow() instead of migrating into a second buffer. The growth policy
+ *        is KeyArray's: it still doubles the capacity (allocated in whole
+ *        pages), so paging saves the copy, not the doubling.
+ *        Shrinking likewise only returns trailing pages (see shrink()).
+ *
+ *        Pages and the page table come from a std::pmr::memory_resource
+ *        (the default resource unless one is given). Free-list links are of
+ *        type Link, as in SlotStorage.
+ */
+template <typename T, bool Generational = false, unsigned PageShift = 10, typename Link = int>
+class PagedSlotStorage {
+    static_assert(PageShift > 0 && PageShift < 31, "Page size must be between 2 and 2^30 slots");
+
+public:
+
+    // True if slots carry a generation counter
+    static constexpr bool HasGenerations = Generational;
+
+    // The same storage with free-list links of type K
+    template <typename K>
+    using WithLink = PagedSlotStorage<T, Generational, PageShift, K>;
+
+    // True if grow() adds capacity without relocating existing slots
+    static constexpr bool GrowsInPlace = true;
+
+    // Number of slots per page
+    static constexpr size_t PageSize = size_t(1) << PageShift;
+
+    // ──────────────────────────────────────────────
+    // 🔹 Construction
+    // ──────────────────────────────────────────────
+
+    // Allocates enough pages for `capacity` slots from `resource` without constructing any value
+    explicit PagedSlotStorage(size_t capacity = 0, std::pmr::memory_resource* resource = nullptr);
+
+    // Frees every page (live values must have been destroyed by the owner)
+    ~PagedSlotStorage();
+
+    // Storage is move-only; copying requires knowing which slots are live
+    PagedSlotStorage(PagedSlotStorage&& other) noexcept;
+    PagedSlotStorage& operator=(PagedSlotStorage&& other) noexcept;
+    PagedSlotStorage(const PagedSlotStorage&) = delete;
+    PagedSlotStorage& operator=(const PagedSlotStorage&) = delete;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Slot Lifetime
+    // ──────────────────────────────────────────────
+
+    // Constructs a value in place at the given slot
+    template <typename... Args>
+    T& construct(size_t index, Args&&... args);
+
+    // Destroys the value at the given slot, leaving raw storage behind
+    void destroy(size_t index);
+
+    // Destroys every slot flagged as live (only those below `end`, if given)
+    void destroyLive(const OccupancyBitmap& live, size_t end = std::numeric_limits<size_t>::max());
+
+    // Copy-constructs every live slot of `other` into this storage
+    void copyLive(const PagedSlotStorage& other, const OccupancyBitmap& live);
+
+    // Raises the capacity to at least `capacity` slots by appending pages
+    void grow(size_t capacity);
+
+    // Lowers the capacity to `capacity` slots, returning the pages past it
+    // (slots at or above it must be empty)
+    void shrink(size_t capacity);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the value at the given slot (must be live)
+    T& operator[](size_t index);
+    const T& operator[](size_t index) const;
+
+    // Returns the number of slots
+    size_t capacity() const;
+
+    // Returns the bytes held by the pages and the page table
+    size_t bytes() const;
+
+    // Returns the memory resource the pages live in
+    std::pmr::memory_resource* resource() const;
+
+    // Returns slots [index, index + count) as a plain array of T (live or not, for
+    // vectorized scans), or nullptr if a slot holds more than a T or the run crosses a
+    // page. Slots never constructed read as zero bytes; mask the result with the live bits
+    const T* valueRun(size_t index, size_t count) const;
+
+    // Returns the generation of the given slot (generational storage only)
+    uint32_t generation(size_t index) const;
+
+    // Copies the generations of slots [first, last) from another storage
+    void copyGenerations(const PagedSlotStorage& other, size_t first, size_t last);
+
+    // Sets the generation of slots [first, last) (no-op without generations)
+    void fillGenerations(size_t first, size_t last, uint32_t generation);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Free-List Links
+    // ──────────────────────────────────────────────
+
+    // Reads the free-list link stored in an empty slot
+    Link nextFree(size_t index) const;
+
+    // Stores a free-list link in an empty slot
+    void setNextFree(size_t index, Link next);
+
+    // Copies the raw link bytes of an empty slot from another storage
+    void copyLink(const PagedSlotStorage& other, size_t index);
+
+
+private:
+
+    using Slot = StorageSlot<T, Generational, Link>;
+
+    // Returns the raw slot at the given index
+    Slot& slot(size_t index);
+    const Slot& slot(size_t index) const;
+
+    // Returns every page to the resource
+    void release() noexcept;
+
+    // Source of the pages
+    KeyArrayAllocator<Slot> allocator;
+
+    // Page table; pages never move once allocated
+    std::vector<Slot*, KeyArrayAllocator<Slot*>> pages;
+
+    // Number of usable slots (the last page may be partly unused)
+    size_t count;
+};
+
+
+// ===============================
+// PagedSlotStorage<T, Generational, PageShift, Link>: Implementations
+// ===============================
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+PagedSlotStorage<T, Generational, PageShift, Link>::PagedSlotStorage(size_t capacity, std::pmr::memory_resource* resource)
+    : allocator(resource), pages(KeyArrayAllocator<Slot*>(resource)), count(0) {
+    try {
+        grow(capacity);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+PagedSlotStorage<T, Generational, PageShift, Link>::~PagedSlotStorage() {
+    release();
+}
+
+// The page table's allocator propagates, so pages and table move with their resource
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+PagedSlotStorage<T, Generational, PageShift, Link>::PagedSlotStorage(PagedSlotStorage&& other) noexcept
+    : allocator(other.allocator), pages(std::move(other.pages)), count(other.count) {
+    other.pages.clear();
+    other.count = 0;
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+PagedSlotStorage<T, Generational, PageShift, Link>&
+PagedSlotStorage<T, Generational, PageShift, Link>::operator=(PagedSlotStorage&& other) noexcept {
+    if (this != &other) {
+        release();
+        allocator = other.allocator;
+        pages = std::move(other.pages);
+        count = other.count;
+        other.pages.clear();
+        other.count = 0;
+    }
+    return *this;
+}
+
+// Constructs a value in place; the slot must currently be empty.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+template <typename... Args>
+T& PagedSlotStorage<T, Generational, PageShift, Link>::construct(size_t index, Args&&... args) {
+    Slot& target = slot(index);
+    T* value = ::new (static_cast<void*>(target.bytes)) T(std::forward<Args>(args)...);
+    if constexpr (Generational) ++target.generation;
+    return *value;
+}
+
+// Runs the destructor of the value held at the given slot.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::destroy(size_t index) {
+    (*this)[index].~T();
+    if constexpr (Generational) ++slot(index).generation;
+}
+
+// Destroys all live values. Trivially destructible types skip the scan,
+// unless generations have to be bumped.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::destroyLive(const OccupancyBitmap& live, size_t end) {
+    if constexpr (Generational || !std::is_trivially_destructible_v<T>) {
+        live.forEachSetBelow(std::min(end, count), [this](size_t i) {
+            destroy(i);
+        });
+    }
+}
+
+// Copies the live values of another storage into the same slots here,
+// along with every generation. If a copy throws, the values copied so far
+// are destroyed again.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::copyLive(const PagedSlotStorage& other,
+                                                            const OccupancyBitmap& live) {
+    size_t limit = std::min(live.size(), count);
+    size_t i = live.findNext(0);
+    try {
+        for (; i < limit; i = live.findNext(i + 1)) {
+            construct(i, other[i]);
+        }
+    } catch (...) {
+        for (size_t j = live.findNext(0); j < i; j = live.findNext(j + 1)) {
+            destroy(j);
+        }
+        throw;
+    }
+
+    if constexpr (Generational) {
+        copyGenerations(other, 0, std::min(count, other.count));
+    }
+}
+
+// Appends zero-generation pages (zeroed throughout when valueRun exposes
+// them to the vector scans); existing pages and their values stay put.
+// Never shrinks.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::grow(size_t capacity) {
+    size_t pageCount = (capacity + PageSize - 1) >> PageShift;
+    pages.reserve(pageCount);
+    while (pages.size() < pageCount) {
+        Slot* page = allocator.allocate(PageSize);
+        std::uninitialized_default_construct_n(page, PageSize);
+        if constexpr (sizeof(Slot) == sizeof(T)) {
+            std::memset(static_cast<void*>(page), 0, PageSize * sizeof(Slot));
+        }
+        if constexpr (Generational) {
+            for (size_t i = 0; i < PageSize; ++i) page[i].generation = 0;
+        }
+        pages.push_back(page);
+    }
+    count = std::max(count, capacity);
+}
+
+// Pages below the new capacity and their values stay put. Never grows.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::shrink(size_t capacity) {
+    size_t pageCount = (capacity + PageSize - 1) >> PageShift;
+    while (pages.size() > pageCount) {
+        allocator.deallocate(pages.back(), PageSize);
+        pages.pop_back();
+    }
+    count = std::min(count, capacity);
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+T& PagedSlotStorage<T, Generational, PageShift, Link>::operator[](size_t index) {
+    return *std::launder(reinterpret_cast<T*>(slot(index).bytes));
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+const T& PagedSlotStorage<T, Generational, PageShift, Link>::operator[](size_t index) const {
+    return *std::launder(reinterpret_cast<const T*>(slot(index).bytes));
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+size_t PagedSlotStorage<T, Generational, PageShift, Link>::capacity() const {
+    return count;
+}
+
+// Whole pages count, the unused tail of the last one included
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+size_t PagedSlotStorage<T, Generational, PageShift, Link>::bytes() const {
+    return pages.size() * PageSize * sizeof(Slot) + pages.capacity() * sizeof(Slot*);
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+std::pmr::memory_resource* PagedSlotStorage<T, Generational, PageShift, Link>::resource() const {
+    return allocator.resource();
+}
+
+// Slots are trivially destructible, so pages are simply returned
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::release() noexcept {
+    for (Slot* page : pages) {
+        allocator.deallocate(page, PageSize);
+    }
+    pages.clear();
+    count = 0;
+}
+
+// A page of plain slots is laid out exactly like a T[]
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+const T* PagedSlotStorage<T, Generational, PageShift, Link>::valueRun(size_t index, size_t count) const {
+    if constexpr (sizeof(Slot) == sizeof(T)) {
+        if (count == 0 || (index >> PageShift) != ((index + count - 1) >> PageShift)) return nullptr;
+        return reinterpret_cast<const T*>(slot(index).bytes);
+    } else {
+        (void)index;
+        (void)count;
+        return nullptr;
+    }
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+uint32_t PagedSlotStorage<T, Generational, PageShift, Link>::generation(size_t index) const {
+    static_assert(Generational, "generation() requires generational PagedSlotStorage");
+    return slot(index).generation;
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::copyGenerations(const PagedSlotStorage& other,
+                                                                   size_t first, size_t last) {
+    if constexpr (Generational) {
+        for (size_t i = first; i < last; ++i) slot(i).generation = other.slot(i).generation;
+    }
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::fillGenerations(size_t first, size_t last, uint32_t generation) {
+    if constexpr (Generational) {
+        for (size_t i = first; i < last; ++i) slot(i).generation = generation;
+    } else {
+        (void)first;
+        (void)last;
+        (void)generation;
+    }
+}
+
+// Links live in the raw bytes of dead slots, so they are copied bytewise.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+Link PagedSlotStorage<T, Generational, PageShift, Link>::nextFree(size_t index) const {
+    Link next;
+    std::memcpy(&next, slot(index).bytes, sizeof(Link));
+    return next;
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::setNextFree(size_t index, Link next) {
+    std::memcpy(slot(index).bytes, &next, sizeof(Link));
+}
+
+// The slot may never have held a link; copying its bytes is still harmless.
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+void PagedSlotStorage<T, Generational, PageShift, Link>::copyLink(const PagedSlotStorage& other, size_t index) {
+    std::memcpy(slot(index).bytes, other.slot(index).bytes, sizeof(Link));
+}
+
+// Page lookup: high bits select the page, low bits the slot within it
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+typename PagedSlotStorage<T, Generational, PageShift, Link>::Slot&
+PagedSlotStorage<T, Generational, PageShift, Link>::slot(size_t index) {
+    return pages[index >> PageShift][index & (PageSize - 1)];
+}
+
+template <typename T, bool Generational, unsigned PageShift, typename Link>
+const typename PagedSlotStorage<T, Generational, PageShift, Link>::Slot&
+PagedSlotStorage<T, Generational, PageShift, Link>::slot(size_t index) const {
+    return pages[index >> PageShift][index & (PageSize - 1)];
+}
+
+
+#endif // PAGEDSLOTSTORAGE_HPP
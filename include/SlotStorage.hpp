@@ -0,0 +1,356 @@
+// SlotStorage: Uninitialized slot storage for KeyArray
+// Author: Eli (Eliyahu) Shif
+
+#ifndef SLOTSTORAGE_HPP
+#define SLOTSTORAGE_HPP
+
+#include "KeyArrayAllocator.hpp"
+#include "OccupancyBitmap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+/**
+ * @brief One raw slot, suitably sized and aligned for either T or a
+ *        free-list link of type Link (the key type). The generational layout
+ *        adds a 32-bit counter next to the value, so checking it touches the
+ *        value's cache line.
+ */
+template <typename T, bool Generational, typename Link = int>
+struct StorageSlot {
+    alignas(T) alignas(Link) unsigned char bytes[std::max(sizeof(T), sizeof(Link))];
+};
+
+template <typename T, typename Link>
+struct StorageSlot<T, true, Link> {
+    uint32_t generation;
+    alignas(T) alignas(Link) unsigned char bytes[std::max(sizeof(T), sizeof(Link))];
+};
+
+
+/**
+ * @brief SlotStorage is a fixed-capacity array of raw, uninitialized slots.
+ *        Values are constructed in place on insert and destroyed on removal.
+ *        The storage itself does not know which slots are live: the owner
+ *        tracks liveness and passes it in wherever every live value is touched.
+ *
+ *        An empty slot can carry a free-list link instead of a value, which
+ *        lets IntrusiveKeyPool recycle keys without memory of its own.
+ *
+ *        With Generational = true every slot also carries a generation that
+ *        is bumped on each construct and destroy (odd while live), which is
+ *        what KeyHandle validation compares against.
+ *
+ *        Links are of type Link, the key type of the owning pool; a
+ *        uint16_t link lets a slot of a 2-byte T stay 2 bytes. WithLink<K>
+ *        names the same storage with K-sized links.
+ *
+ *        The slot array is allocated from a std::pmr::memory_resource
+ *        (the default resource unless one is given) and moves with it.
+ */
+template <typename T, bool Generational = false, typename Link = int>
+class SlotStorage {
+public:
+
+    // True if slots carry a generation counter
+    static constexpr bool HasGenerations = Generational;
+
+    // The same storage with free-list links of type K
+    template <typename K>
+    using WithLink = SlotStorage<T, Generational, K>;
+
+    // Growing means reallocating (see PagedSlotStorage for in-place growth)
+    static constexpr bool GrowsInPlace = false;
+
+    // ──────────────────────────────────────────────
+    // 🔹 Construction
+    // ──────────────────────────────────────────────
+
+    // Allocates room for `capacity` slots from `resource` without constructing any value
+    explicit SlotStorage(size_t capacity = 0, std::pmr::memory_resource* resource = nullptr);
+
+    // Frees the slot array (live values must have been destroyed by the owner)
+    ~SlotStorage();
+
+    // Storage is move-only; copying requires knowing which slots are live
+    SlotStorage(SlotStorage&& other) noexcept;
+    SlotStorage& operator=(SlotStorage&& other) noexcept;
+    SlotStorage(const SlotStorage&) = delete;
+    SlotStorage& operator=(const SlotStorage&) = delete;
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Slot Lifetime
+    // ──────────────────────────────────────────────
+
+    // Constructs a value in place at the given slot
+    template <typename... Args>
+    T& construct(size_t index, Args&&... args);
+
+    // Destroys the value at the given slot, leaving raw storage behind
+    void destroy(size_t index);
+
+    // Destroys every slot flagged as live (only those below `end`, if given)
+    void destroyLive(const OccupancyBitmap& live, size_t end = std::numeric_limits<size_t>::max());
+
+    // Copy-constructs every live slot of `other` into this storage
+    void copyLive(const SlotStorage& other, const OccupancyBitmap& live);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Accessors
+    // ──────────────────────────────────────────────
+
+    // Returns the value at the given slot (must be live)
+    T& operator[](size_t index);
+    const T& operator[](size_t index) const;
+
+    // Returns the number of slots
+    size_t capacity() const;
+
+    // Returns the bytes of slot memory held
+    size_t bytes() const;
+
+    // Returns the memory resource the slots live in
+    std::pmr::memory_resource* resource() const;
+
+    // Returns slots [index, index + count) as a plain array of T (live or not, for
+    // vectorized scans), or nullptr if a slot holds more than a T. Slots never
+    // constructed read as zero bytes; mask the result with the live bits
+    const T* valueRun(size_t index, size_t count) const;
+
+    // Returns the generation of the given slot (generational storage only)
+    uint32_t generation(size_t index) const;
+
+    // Copies the generations of slots [first, last) from another storage
+    void copyGenerations(const SlotStorage& other, size_t first, size_t last);
+
+    // Sets the generation of slots [first, last) (no-op without generations)
+    void fillGenerations(size_t first, size_t last, uint32_t generation);
+
+
+    // ──────────────────────────────────────────────
+    // 🔹 Free-List Links
+    // ──────────────────────────────────────────────
+
+    // Reads the free-list link stored in an empty slot
+    Link nextFree(size_t index) const;
+
+    // Stores a free-list link in an empty slot
+    void setNextFree(size_t index, Link next);
+
+    // Copies the raw link bytes of an empty slot from another storage
+    void copyLink(const SlotStorage& other, size_t index);
+
+
+private:
+
+    using Slot = StorageSlot<T, Generational, Link>;
+
+    // Returns the slot array to the resource
+    void release() noexcept;
+
+    // Source of the slot array
+    KeyArrayAllocator<Slot> allocator;
+
+    // Raw slot array (default-initialized, zeroed when valueRun exposes it)
+    Slot* slots;
+
+    // Number of slots in the array
+    size_t count;
+};
+
+
+// ===============================
+// SlotStorage<T, Generational, Link>: Implementations
+// ===============================
+
+// Generation counters start at zero; value bytes are left uninitialized,
+// except where valueRun hands them to the vector scans, which read dead slots
+// too: those start zeroed.
+template <typename T, bool Generational, typename Link>
+SlotStorage<T, Generational, Link>::SlotStorage(size_t capacity, std::pmr::memory_resource* resource)
+    : allocator(resource), slots(nullptr), count(capacity) {
+
+    if (capacity) {
+        slots = allocator.allocate(capacity);
+        std::uninitialized_default_construct_n(slots, capacity);
+        if constexpr (sizeof(Slot) == sizeof(T)) {
+            std::memset(static_cast<void*>(slots), 0, capacity * sizeof(Slot));
+        }
+    }
+    if constexpr (Generational) {
+        for (size_t i = 0; i < count; ++i) slots[i].generation = 0;
+    }
+}
+
+template <typename T, bool Generational, typename Link>
+SlotStorage<T, Generational, Link>::~SlotStorage() {
+    release();
+}
+
+// The resource moves with the slots, so they are always freed where they came from
+template <typename T, bool Generational, typename Link>
+SlotStorage<T, Generational, Link>::SlotStorage(SlotStorage&& other) noexcept
+    : allocator(other.allocator), slots(other.slots), count(other.count) {
+    other.slots = nullptr;
+    other.count = 0;
+}
+
+template <typename T, bool Generational, typename Link>
+SlotStorage<T, Generational, Link>& SlotStorage<T, Generational, Link>::operator=(SlotStorage&& other) noexcept {
+    if (this != &other) {
+        release();
+        allocator = other.allocator;
+        slots = other.slots;
+        count = other.count;
+        other.slots = nullptr;
+        other.count = 0;
+    }
+    return *this;
+}
+
+// Constructs a value in place; the slot must currently be empty.
+template <typename T, bool Generational, typename Link>
+template <typename... Args>
+T& SlotStorage<T, Generational, Link>::construct(size_t index, Args&&... args) {
+    T* value = ::new (static_cast<void*>(slots[index].bytes)) T(std::forward<Args>(args)...);
+    if constexpr (Generational) ++slots[index].generation;
+    return *value;
+}
+
+// Runs the destructor of the value held at the given slot.
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::destroy(size_t index) {
+    (*this)[index].~T();
+    if constexpr (Generational) ++slots[index].generation;
+}
+
+// Destroys all live values. Trivially destructible types skip the scan,
+// unless generations have to be bumped.
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::destroyLive(const OccupancyBitmap& live, size_t end) {
+    if constexpr (Generational || !std::is_trivially_destructible_v<T>) {
+        live.forEachSetBelow(std::min(end, count), [this](size_t i) {
+            destroy(i);
+        });
+    }
+}
+
+// Copies the live values of another storage into the same slots here,
+// along with every generation. If a copy throws, the values copied so far
+// are destroyed again.
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::copyLive(const SlotStorage& other, const OccupancyBitmap& live) {
+    size_t limit = std::min(live.size(), count);
+    size_t i = live.findNext(0);
+    try {
+        for (; i < limit; i = live.findNext(i + 1)) {
+            construct(i, other[i]);
+        }
+    } catch (...) {
+        for (size_t j = live.findNext(0); j < i; j = live.findNext(j + 1)) {
+            destroy(j);
+        }
+        throw;
+    }
+
+    if constexpr (Generational) {
+        copyGenerations(other, 0, std::min(count, other.count));
+    }
+}
+
+template <typename T, bool Generational, typename Link>
+T& SlotStorage<T, Generational, Link>::operator[](size_t index) {
+    return *std::launder(reinterpret_cast<T*>(slots[index].bytes));
+}
+
+template <typename T, bool Generational, typename Link>
+const T& SlotStorage<T, Generational, Link>::operator[](size_t index) const {
+    return *std::launder(reinterpret_cast<const T*>(slots[index].bytes));
+}
+
+template <typename T, bool Generational, typename Link>
+size_t SlotStorage<T, Generational, Link>::capacity() const {
+    return count;
+}
+
+template <typename T, bool Generational, typename Link>
+size_t SlotStorage<T, Generational, Link>::bytes() const {
+    return count * sizeof(Slot);
+}
+
+template <typename T, bool Generational, typename Link>
+std::pmr::memory_resource* SlotStorage<T, Generational, Link>::resource() const {
+    return allocator.resource();
+}
+
+// Slots are trivially destructible, so the array is simply returned
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::release() noexcept {
+    if (slots) allocator.deallocate(slots, count);
+    slots = nullptr;
+}
+
+// Slots without generations or padding are laid out exactly like a T[]
+template <typename T, bool Generational, typename Link>
+const T* SlotStorage<T, Generational, Link>::valueRun(size_t index, size_t count) const {
+    (void)count;
+    if constexpr (sizeof(Slot) == sizeof(T)) {
+        return reinterpret_cast<const T*>(slots[index].bytes);
+    } else {
+        return nullptr;
+    }
+}
+
+template <typename T, bool Generational, typename Link>
+uint32_t SlotStorage<T, Generational, Link>::generation(size_t index) const {
+    static_assert(Generational, "generation() requires generational SlotStorage");
+    return slots[index].generation;
+}
+
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::copyGenerations(const SlotStorage& other, size_t first, size_t last) {
+    if constexpr (Generational) {
+        for (size_t i = first; i < last; ++i) slots[i].generation = other.slots[i].generation;
+    }
+}
+
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::fillGenerations(size_t first, size_t last, uint32_t generation) {
+    if constexpr (Generational) {
+        for (size_t i = first; i < last; ++i) slots[i].generation = generation;
+    } else {
+        (void)first;
+        (void)last;
+        (void)generation;
+    }
+}
+
+// Links live in the raw bytes of dead slots, so they are copied bytewise.
+template <typename T, bool Generational, typename Link>
+Link SlotStorage<T, Generational, Link>::nextFree(size_t index) const {
+    Link next;
+    std::memcpy(&next, slots[index].bytes, sizeof(Link));
+    return next;
+}
+
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::setNextFree(size_t index, Link next) {
+    std::memcpy(slots[index].bytes, &next, sizeof(Link));
+}
+
+// The slot may never have held a link; copying its bytes is still harmless.
+template <typename T, bool Generational, typename Link>
+void SlotStorage<T, Generational, Link>::copyLink(const SlotStorage& other, size_t index) {
+    std::memcpy(slots[index].bytes, other.slots[index].bytes, sizeof(Link));
+}
+
+
+#endif // SLOTSTORAGE_HPP
@@ -0,0 +1,462 @@
+// StaticKeyArray: Fixed-capacity, heap-free KeyArray (Header)
+// Author: Eli (Eliyahu) Shif
+
+#ifndef STATICKEYARRAY_HPP
+#define STATICKEYARRAY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief StaticKeyArray<T, N> is a KeyArray whose capacity is fixed at
+ *        compile time. Everything lives inline in the object: the values in
+ *        a std::array<T, N>, occupancy in N bits of 64-bit words, and the
+ *        free list in an array of the smallest index type that can name N
+ *        slots. It has no virtual functions and never allocates, so a small
+ *        table embeds directly in its owner, e.g.
+ *            struct Connection { StaticKeyArray<Stream*, 256> streams; };
+ *
+ *        Every member function is constexpr, so a table can be built and
+ *        queried in a constant expression when T is a literal type:
+ *            constexpr auto table = [] {
+ *                StaticKeyArray<int, 8> a;
+ *                a.insert(4); a.insert(2);
+ *                return a;
+ *            }();
+ *            static_assert(table.at(1) == 2);
+ *
+ *        Keys run from 0 to N - 1 and freed keys are reused newest first, as
+ *        in KeyArray. Every slot holds a T at all times (T must be default-
+ *        constructible and assignable): insert assigns into the slot and
+ *        remove assigns T{} back. Inserting into a full table throws
+ *        std::runtime_error; there is no resizing or overflow queue.
+ */
+template <typename T, size_t N>
+class StaticKeyArray {
+    static_assert(N > 0, "StaticKeyArray needs at least one key");
+    static_assert(N <= static_cast<size_t>(std::numeric_limits<int>::max()), "Keys must fit an int");
+    static_assert(std::is_default_constructible_v<T>, "StaticKeyArray slots are default-constructed");
+
+public:
+
+    // Free-list link type: the smallest unsigned type holding every slot plus an end marker
+    using Link = std::conditional_t<(N < 0xFF), uint8_t,
+                 std::conditional_t<(N < 0xFFFF), uint16_t, uint32_t>>;
+
+    // Number of occupancy words
+    static constexpr size_t WordCount = (N + 63) / 64;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Construction
+    // ─────────────────────────────────────────────────────────────
+
+    // Constructs an empty table with every key free
+    constexpr StaticKeyArray() = default;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Core Functionality
+    // ─────────────────────────────────────────────────────────────
+
+    // Copies a value into the next available key and returns the key
+    constexpr int insert(const T& value);
+
+    // Moves a value into the next available key and returns the key
+    constexpr int insert(T&& value);
+
+    // Constructs a value from args at the next available key and returns the key
+    template <typename... Args>
+    constexpr int emplace(Args&&... args);
+
+    // Resets the key's value to T{} and recycles the key
+    constexpr void remove(int key);
+
+    // Checks if a given key is currently in use
+    constexpr bool hasKey(int key) const noexcept;
+
+    // Checks if a given value exists in the structure (linear search)
+    constexpr bool contains(const T& value) const;
+
+    // Access a value by key; throws std::out_of_range if the key is not in use
+    constexpr T& at(int key);
+    constexpr const T& at(int key) const;
+
+    // Access a live key without any check (undefined if the key is not live)
+    constexpr T& operator[](int key) noexcept;
+    constexpr const T& operator[](int key) const noexcept;
+
+    // Returns a pointer to the value, or nullptr if the key is not in use
+    constexpr T* try_get(int key) noexcept;
+    constexpr const T* try_get(int key) const noexcept;
+
+    // Swaps the values of two live keys
+    constexpr void swap(int key1, int key2);
+
+    // Removes every value and frees every key
+    constexpr void clear();
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Accessors
+    // ─────────────────────────────────────────────────────────────
+
+    // Returns the number of live keys
+    constexpr size_t size() const noexcept;
+
+    // Returns true if no key is live
+    constexpr bool empty() const noexcept;
+
+    // Returns true if every key is live
+    constexpr bool full() const noexcept;
+
+    // Returns the number of keys, N
+    static constexpr size_t capacity() noexcept { return N; }
+
+    // Returns the maximum usable key (inclusive upper bound)
+    static constexpr int getMaxKeyBound() noexcept { return static_cast<int>(N) - 1; }
+
+    // Returns the occupancy word at the given word index (bit i is key word * 64 + i)
+    constexpr uint64_t word(size_t wordIndex) const noexcept;
+
+    // Calls fn(key, value) for every live key in ascending order
+    template <typename Fn>
+    constexpr void forEachLive(Fn&& fn);
+
+    template <typename Fn>
+    constexpr void forEachLive(Fn&& fn) const;
+
+
+    // ─────────────────────────────────────────────────────────────
+    // 🔹 Iteration
+    // ─────────────────────────────────────────────────────────────
+
+    // Forward iterator over live (key, value) pairs in ascending key order
+    template <bool Const>
+    class LiveIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<int, std::conditional_t<Const, const T&, T&>>;
+        using reference = value_type;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using owner_type = std::conditional_t<Const, const StaticKeyArray*, StaticKeyArray*>;
+
+        constexpr LiveIterator() = default;
+        constexpr LiveIterator(owner_type owner, size_t index) : owner(owner), index(index) {}
+
+        constexpr reference operator*() const { return { static_cast<int>(index), owner->values[index] }; }
+        constexpr LiveIterator& operator++() { index = owner->nextLive(index + 1); return *this; }
+        constexpr LiveIterator operator++(int) { LiveIterator tmp = *this; ++*this; return tmp; }
+        constexpr bool operator==(const LiveIterator& other) const { return index == other.index; }
+        constexpr bool operator!=(const LiveIterator& other) const { return index != other.index; }
+
+    private:
+        owner_type owner = nullptr;
+        size_t index = 0;
+    };
+
+    constexpr LiveIterator<false> begin() { return { this, nextLive(0) }; }
+    constexpr LiveIterator<false> end() { return { this, N }; }
+    constexpr LiveIterator<true> begin() const { return { this, nextLive(0) }; }
+    constexpr LiveIterator<true> end() const { return { this, N }; }
+
+    // Prints the structure to the output stream
+    template <typename U, size_t M>
+    friend std::ostream& operator<<(std::ostream& os, const StaticKeyArray<U, M>& array);
+
+
+private:
+
+    // Marks the end of the free list
+    static constexpr Link NoLink = std::numeric_limits<Link>::max();
+
+    // Converts a key to a slot index; negative keys wrap past N
+    static constexpr size_t slotOf(int key) noexcept { return static_cast<size_t>(key); }
+
+    // Returns true if the slot is below N and live
+    constexpr bool isLive(size_t slot) const noexcept;
+
+    // Returns the slot of a live key; throws std::out_of_range otherwise
+    constexpr size_t liveSlot(int key) const;
+
+    // Takes the next free slot (newest freed first, then never used)
+    constexpr size_t acquireSlot();
+
+    // Returns the first live slot at or after `from`, or N
+    constexpr size_t nextLive(size_t from) const noexcept;
+
+    // Returns the index of the lowest set bit of a non-zero word (constexpr de Bruijn lookup)
+    static constexpr unsigned lowestBit(uint64_t word) noexcept;
+
+    // Values, one per key; free slots hold T{}
+    std::array<T, N> values{};
+
+    // Live slots, bit i of word w is key w * 64 + i
+    std::array<uint64_t, WordCount> live{};
+
+    // Next free slot of every freed slot (meaningful only while it is free)
+    std::array<Link, N> links{};
+
+    // Most recently freed slot, or NoLink
+    Link freeHead = NoLink;
+
+    // Slots at or above this have never been used
+    size_t nextFresh = 0;
+
+    // Number of live keys
+    size_t elementCount = 0;
+};
+
+
+//
+// ░░ Implementation of StaticKeyArray ░░
+// ────────────────────────────────────────────────────────────────
+
+// 🔹 Core Functionality
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, size_t N>
+constexpr int StaticKeyArray<T, N>::insert(const T& value) {
+    size_t slot = acquireSlot();
+    values[slot] = value;
+    return static_cast<int>(slot);
+}
+
+
+template <typename T, size_t N>
+constexpr int StaticKeyArray<T, N>::insert(T&& value) {
+    size_t slot = acquireSlot();
+    values[slot] = std::move(value);
+    return static_cast<int>(slot);
+}
+
+
+// The value is built before a key is taken, so a throwing constructor changes nothing
+template <typename T, size_t N>
+template <typename... Args>
+constexpr int StaticKeyArray<T, N>::emplace(Args&&... args) {
+    return insert(T(std::forward<Args>(args)...));
+}
+
+
+template <typename T, size_t N>
+constexpr void StaticKeyArray<T, N>::remove(int key) {
+    size_t slot = liveSlot(key);
+    values[slot] = T{};
+    live[slot / 64] &= ~(uint64_t{ 1 } << (slot % 64));
+    links[slot] = freeHead;
+    freeHead = static_cast<Link>(slot);
+    --elementCount;
+}
+
+
+template <typename T, size_t N>
+constexpr bool StaticKeyArray<T, N>::hasKey(int key) const noexcept {
+    return isLive(slotOf(key));
+}
+
+
+template <typename T, size_t N>
+constexpr bool StaticKeyArray<T, N>::contains(const T& value) const {
+    for (size_t slot = nextLive(0); slot < N; slot = nextLive(slot + 1)) {
+        if (values[slot] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+template <typename T, size_t N>
+constexpr T& StaticKeyArray<T, N>::at(int key) {
+    return values[liveSlot(key)];
+}
+
+
+template <typename T, size_t N>
+constexpr const T& StaticKeyArray<T, N>::at(int key) const {
+    return values[liveSlot(key)];
+}
+
+
+template <typename T, size_t N>
+constexpr T& StaticKeyArray<T, N>::operator[](int key) noexcept {
+    return values[slotOf(key)];
+}
+
+
+template <typename T, size_t N>
+constexpr const T& StaticKeyArray<T, N>::operator[](int key) const noexcept {
+    return values[slotOf(key)];
+}
+
+
+template <typename T, size_t N>
+constexpr T* StaticKeyArray<T, N>::try_get(int key) noexcept {
+    size_t slot = slotOf(key);
+    return isLive(slot) ? &values[slot] : nullptr;
+}
+
+
+template <typename T, size_t N>
+constexpr const T* StaticKeyArray<T, N>::try_get(int key) const noexcept {
+    size_t slot = slotOf(key);
+    return isLive(slot) ? &values[slot] : nullptr;
+}
+
+
+// Throws std::out_of_range if either key is not in use
+template <typename T, size_t N>
+constexpr void StaticKeyArray<T, N>::swap(int key1, int key2) {
+    size_t first = liveSlot(key1);
+    size_t second = liveSlot(key2);
+    T held = std::move(values[first]);
+    values[first] = std::move(values[second]);
+    values[second] = std::move(held);
+}
+
+
+// Only the slots ever used are reset; the rest still hold T{}
+template <typename T, size_t N>
+constexpr void StaticKeyArray<T, N>::clear() {
+    for (size_t slot = 0; slot < nextFresh; ++slot) {
+        values[slot] = T{};
+    }
+    for (size_t w = 0; w < WordCount; ++w) {
+        live[w] = 0;
+    }
+    freeHead = NoLink;
+    nextFresh = 0;
+    elementCount = 0;
+}
+
+
+// 🔹 Accessors
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, size_t N>
+constexpr size_t StaticKeyArray<T, N>::size() const noexcept {
+    return elementCount;
+}
+
+
+template <typename T, size_t N>
+constexpr bool StaticKeyArray<T, N>::empty() const noexcept {
+    return elementCount == 0;
+}
+
+
+template <typename T, size_t N>
+constexpr bool StaticKeyArray<T, N>::full() const noexcept {
+    return elementCount == N;
+}
+
+
+template <typename T, size_t N>
+constexpr uint64_t StaticKeyArray<T, N>::word(size_t wordIndex) const noexcept {
+    return live[wordIndex];
+}
+
+
+template <typename T, size_t N>
+template <typename Fn>
+constexpr void StaticKeyArray<T, N>::forEachLive(Fn&& fn) {
+    for (size_t slot = nextLive(0); slot < N; slot = nextLive(slot + 1)) {
+        fn(static_cast<int>(slot), values[slot]);
+    }
+}
+
+
+template <typename T, size_t N>
+template <typename Fn>
+constexpr void StaticKeyArray<T, N>::forEachLive(Fn&& fn) const {
+    for (size_t slot = nextLive(0); slot < N; slot = nextLive(slot + 1)) {
+        fn(static_cast<int>(slot), values[slot]);
+    }
+}
+
+
+// 🔹 Slots
+// ────────────────────────────────────────────────────────────────
+
+template <typename T, size_t N>
+constexpr bool StaticKeyArray<T, N>::isLive(size_t slot) const noexcept {
+    return slot < N && (live[slot / 64] >> (slot % 64) & 1) != 0;
+}
+
+
+template <typename T, size_t N>
+constexpr size_t StaticKeyArray<T, N>::liveSlot(int key) const {
+    size_t slot = slotOf(key);
+    if (!isLive(slot)) {
+        throw std::out_of_range("Invalid key in StaticKeyArray");
+    }
+    return slot;
+}
+
+
+// Throws std::runtime_error if all N keys are live
+template <typename T, size_t N>
+constexpr size_t StaticKeyArray<T, N>::acquireSlot() {
+    size_t slot = 0;
+    if (freeHead != NoLink) {
+        slot = freeHead;
+        freeHead = links[slot];
+    } else if (nextFresh < N) {
+        slot = nextFresh++;
+    } else {
+        throw std::runtime_error("StaticKeyArray is full. No available keys.");
+    }
+    live[slot / 64] |= uint64_t{ 1 } << (slot % 64);
+    ++elementCount;
+    return slot;
+}
+
+
+// Empty words are skipped whole
+template <typename T, size_t N>
+constexpr size_t StaticKeyArray<T, N>::nextLive(size_t from) const noexcept {
+    if (from >= N) return N;
+    size_t w = from / 64;
+    uint64_t bits = live[w] & (~uint64_t{ 0 } << (from % 64));
+    while (bits == 0) {
+        if (++w == WordCount) return N;
+        bits = live[w];
+    }
+    return w * 64 + lowestBit(bits);
+}
+
+
+template <typename T, size_t N>
+constexpr unsigned StaticKeyArray<T, N>::lowestBit(uint64_t word) noexcept {
+    constexpr unsigned char table[64] = {
+         0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+    };
+    return table[((word & (~word + 1)) * 0x03F79D71B4CB0A89ull) >> 58];
+}
+
+
+// Prints "(key: value)" per live key
+template <typename T, size_t N>
+std::ostream& operator<<(std::ostream& os, const StaticKeyArray<T, N>& array) {
+    os << "StaticKeyArray (Size: " << array.size() << ") [";
+    array.forEachLive([&](int key, const T& value) {
+        os << "(" << key << ": " << value << ") ";
+    });
+    os << "]";
+    return os;
+}
+
+
+#endif // STATICKEYARRAY_HPP
@@ -0,0 +1,95 @@
+// KeyArray Allocator Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Every buffer of an array comes from its memory resource and
+// goes back to it, across growth, shrinking, the overflow queue, copies and moves.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <memory_resource>
+#include <string>
+
+// Forwards to new/delete and counts what is still outstanding
+struct CountingResource final : std::pmr::memory_resource {
+    size_t allocations = 0;
+    size_t outstanding = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+        KEYARRAY_CHECK(outstanding >= bytes);
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Installed as the default resource, so a buffer that ignores the array's
+// resource shows up here
+static CountingResource fallback;
+
+// Slots, bitmaps, the resize target and the overflow queue all allocate from
+// the resource, and everything is returned once the array is gone
+template <typename Array>
+static void buffersFromResource() {
+    CountingResource resource;
+    size_t fallbackAllocations = fallback.allocations;
+    {
+        Array array(4, &resource);
+        KEYARRAY_CHECK(array.getResource() == &resource);
+        array.enableDynamicResizing();
+        array.setCopyBudget(1);
+        for (int i = 0; i < 100; ++i) array.insert(std::to_string(i) + " long enough for the heap");
+        KEYARRAY_CHECK(resource.allocations > 0);
+
+        for (int key = 10; key < 100; ++key) array.remove(key);
+        if (array.isResizeInProgress()) array.switchToResizedData();
+        array.shrinkToFit();
+        array.disableDynamicResizing();
+        array.enableQueue();
+        while (array.getQueueSize() < 20) array.insert("queued");
+        array.clear();
+    }
+    KEYARRAY_CHECK(resource.outstanding == 0);
+    KEYARRAY_CHECK(fallback.allocations == fallbackAllocations);
+}
+
+// A copy allocates from its source's resource; moves and assignments carry
+// the buffers with their resource, so each resource gets back what it gave
+static void copiesAndMoves() {
+    CountingResource first;
+    CountingResource second;
+    {
+        KeyArray<int> a(64, &first);
+        KeyArray<int> b(16, &second);
+        for (int i = 0; i < 10; ++i) a.insert(i);
+
+        KeyArray<int> copy(a);
+        KEYARRAY_CHECK(copy.getResource() == &first && copy.at(9) == 9);
+        size_t before = second.outstanding;
+        b = copy;
+        KEYARRAY_CHECK(b.getResource() == &first && second.outstanding < before);
+
+        KeyArray<int> moved(std::move(a));
+        KEYARRAY_CHECK(moved.getResource() == &first && moved.at(3) == 3);
+        KeyArray<int> other(8, &second);
+        other = std::move(moved);
+        KEYARRAY_CHECK(other.getResource() == &first);
+    }
+    KEYARRAY_CHECK(first.outstanding == 0 && second.outstanding == 0);
+}
+
+int main() {
+    std::pmr::set_default_resource(&fallback);
+    buffersFromResource<KeyArray<std::string>>();
+    buffersFromResource<PagedKeyArray<std::string>>();
+    copiesAndMoves();
+    std::pmr::set_default_resource(nullptr);
+    return 0;
+}
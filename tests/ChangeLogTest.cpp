@@ -0,0 +1,106 @@
+// KeyArray Change Log Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Group commit by record count and by age, and checkpoints that
+// restart the log from a fresh base snapshot.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+static const std::string LogFile = "ChangeLogTest.log";
+static const std::string SnapshotFile = "ChangeLogTest.snap";
+
+// Returns the size of a file on disk
+static size_t fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return static_cast<size_t>(file.tellg());
+}
+
+// A group is committed once it holds commitRecords records, and not before
+static void commitByCount() {
+    KeyArrayLogPolicy policy;
+    policy.commitRecords = 4;
+    policy.commitInterval = std::chrono::milliseconds(0);
+    {
+        KeyArrayChangeLog<int> log(LogFile, 1, policy);
+        size_t header = log.committedBytes();
+        for (int i = 0; i < 3; ++i) log.onInsert(i, i);
+        KEYARRAY_CHECK(log.pendingRecords() == 3);
+        KEYARRAY_CHECK(log.committedBytes() == header);
+        KEYARRAY_CHECK(fileSize(LogFile) == header);
+
+        log.onInsert(3, 3);
+        KEYARRAY_CHECK(log.pendingRecords() == 0);
+        KEYARRAY_CHECK(log.committedBytes() > header);
+        KEYARRAY_CHECK(fileSize(LogFile) == log.committedBytes());
+
+        // Without a commit interval, age alone never commits
+        log.onRemove(0, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        log.onRemove(1, 1);
+        KEYARRAY_CHECK(log.pendingRecords() == 2);
+    }
+    std::remove(LogFile.c_str());
+}
+
+// A group older than commitInterval is committed by the next append
+static void commitByTime() {
+    KeyArrayLogPolicy policy;
+    policy.commitRecords = 1000;
+    policy.commitInterval = std::chrono::milliseconds(2);
+    {
+        KeyArrayChangeLog<int> log(LogFile, 1, policy);
+        log.onInsert(0, 0);
+        KEYARRAY_CHECK(log.pendingRecords() == 1);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        log.onInsert(1, 1);
+        KEYARRAY_CHECK(log.pendingRecords() == 0);
+        KEYARRAY_CHECK(fileSize(LogFile) == log.committedBytes());
+
+        // The next group's age counts from its own first record
+        log.onInsert(2, 2);
+        KEYARRAY_CHECK(log.pendingRecords() == 1);
+    }
+    std::remove(LogFile.c_str());
+}
+
+// A checkpoint writes the current contents as the new base and empties the log
+static void checkpoint() {
+    KeyArray<int> array(8);
+    KEYARRAY_CHECK_THROWS(array.checkpoint(), std::runtime_error);
+
+    array.insert(1);
+    array.enableChangeLog(SnapshotFile, LogFile);
+    array.commitChangeLog();
+    size_t emptyLog = fileSize(LogFile);
+    int key = array.insert(2);
+    array.insert(3);
+    array.commitChangeLog();
+    KEYARRAY_CHECK(fileSize(LogFile) > emptyLog);
+
+    array.checkpoint();
+    KEYARRAY_CHECK(fileSize(LogFile) == emptyLog);
+    array.remove(key);
+    array.update(0, 10);
+    array.disableChangeLog();
+
+    KeyArray<int> recovered(1);
+    KEYARRAY_CHECK(recovered.recover(SnapshotFile, LogFile) == 2);
+    KEYARRAY_CHECK(recovered.size() == 2 && !recovered.hasKey(key));
+    KEYARRAY_CHECK(recovered.at(0) == 10 && recovered.at(2) == 3);
+    std::remove(SnapshotFile.c_str());
+    std::remove(LogFile.c_str());
+}
+
+int main() {
+    commitByCount();
+    commitByTime();
+    checkpoint();
+    return 0;
+}
@@ -0,0 +1,256 @@
+// ConcurrentKeyArray Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Key ranges that match KeyArray's, empty arrays that grow,
+// inserts from several threads, reads during growth, and contended pops and
+// pushes on the pool and through per-thread magazines.
+
+#include "ConcurrentKeyArray.hpp"
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// (a, b) covers [min, max) like KeyArray(a, b); (n) covers [0, n)
+static void rangesMatchKeyArray() {
+    ConcurrentKeyArray<int> ranged(10, 20);
+    KeyArray<int> reference(10, 20);
+    KEYARRAY_CHECK(ranged.capacity() == reference.getCapacity());
+    KEYARRAY_CHECK(ranged.getOffset() == 10 && ranged.getMaxKeyBound() == 19);
+
+    ConcurrentKeyArray<int> reversed(20, 10);
+    KEYARRAY_CHECK(reversed.capacity() == 10);
+
+    ConcurrentKeyArray<int> limited(8);
+    KEYARRAY_CHECK(limited.capacity() == 8);
+    for (int i = 0; i < 8; ++i) KEYARRAY_CHECK(limited.insert(i) == i);
+    KEYARRAY_CHECK_THROWS(limited.insert(8), std::runtime_error);
+}
+
+// An empty range hands out no key until the array grows
+static void emptyArrays() {
+    ConcurrentKeyArray<std::string> empty(0);
+    KEYARRAY_CHECK(empty.capacity() == 0);
+    KEYARRAY_CHECK_THROWS(empty.insert("x"), std::runtime_error);
+    KEYARRAY_CHECK(empty.size() == 0);
+
+    empty.enableDynamicResizing();
+    KEYARRAY_CHECK(empty.insert("a") == 0);
+    KEYARRAY_CHECK(empty.insert("b") == 1);
+    KEYARRAY_CHECK(empty.at(0) == "a" && empty.at(1) == "b");
+
+    ConcurrentKeyArray<int> point(5, 5);
+    KEYARRAY_CHECK(point.capacity() == 0);
+    point.reserve(3);
+    KEYARRAY_CHECK(point.insert(1) == 5);
+}
+
+// Threads growing one array from empty get distinct keys
+static void concurrentGrowth() {
+    ConcurrentKeyArray<int> array(0);
+    array.enableDynamicResizing();
+
+    constexpr int Threads = 4;
+    constexpr int PerThread = 2000;
+    std::vector<std::vector<int>> keys(Threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < PerThread; ++i) keys[t].push_back(array.insert(t * PerThread + i));
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    std::set<int> seen;
+    for (int t = 0; t < Threads; ++t) {
+        for (int i = 0; i < PerThread; ++i) {
+            KEYARRAY_CHECK(seen.insert(keys[t][i]).second);
+            KEYARRAY_CHECK(array.at(keys[t][i]) == t * PerThread + i);
+        }
+    }
+    KEYARRAY_CHECK(array.size() == Threads * PerThread);
+
+    // With every reader gone, the directories retired by the growth are freed
+    KeyArrayEpoch::reclaim();
+    KEYARRAY_CHECK(KeyArrayEpoch::pending() == 0);
+}
+
+// Readers keep looking up published keys while one thread inserts and another
+// reserves one slot at a time, so directories are swapped and retired under
+// them; a directory freed too early is a use after free
+static void readersDuringGrowth() {
+    constexpr int Values = 6000;
+    constexpr int Readers = 2;
+    ConcurrentKeyArray<int> array(0);
+    array.enableDynamicResizing();
+    std::unique_ptr<std::atomic<int>[]> keys(new std::atomic<int>[Values]());
+    std::atomic<int> published{ 0 };
+    std::atomic<bool> done{ false };
+
+    // A retired directory waits for a reader that is still inside its guard
+    {
+        KeyArrayEpoch::Guard guard;
+        array.reserve(1);
+        array.reserve(2);
+        KEYARRAY_CHECK(KeyArrayEpoch::pending() > 0);
+    }
+    KeyArrayEpoch::reclaim();
+    KEYARRAY_CHECK(KeyArrayEpoch::pending() == 0);
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([&] {
+        for (int i = 0; i < Values; ++i) {
+            keys[i].store(array.insert(i), std::memory_order_relaxed);
+            published.store(i + 1, std::memory_order_release);
+        }
+    });
+    threads.emplace_back([&] {
+        for (int i = 0; i < 300; ++i) array.reserve(array.capacity() + 1);
+    });
+    for (int r = 0; r < Readers; ++r) {
+        threads.emplace_back([&, r] {
+            for (unsigned step = static_cast<unsigned>(r); !done.load(std::memory_order_relaxed); step += 7919) {
+                int count = published.load(std::memory_order_acquire);
+                if (count == 0) continue;
+                int i = static_cast<int>(step % static_cast<unsigned>(count));
+                int key = keys[i].load(std::memory_order_relaxed);
+                const int* value = array.try_get(key);
+                KEYARRAY_CHECK(value != nullptr && *value == i);
+                KEYARRAY_CHECK(array.hasKey(key) && array.at(key) == i);
+            }
+        });
+    }
+    threads[0].join();
+    threads[1].join();
+    done.store(true, std::memory_order_relaxed);
+    for (size_t t = 2; t < threads.size(); ++t) threads[t].join();
+
+    KEYARRAY_CHECK(array.size() == Values);
+    KeyArrayEpoch::reclaim();
+    KEYARRAY_CHECK(KeyArrayEpoch::pending() == 0);
+}
+
+// Checks out a key for the calling thread; fails if another thread holds it
+static void claim(std::atomic<int>* owners, int key, int thread) {
+    int previous = owners[key].exchange(thread + 1, std::memory_order_relaxed);
+    KEYARRAY_CHECK(previous == 0);
+}
+
+// Gives a claimed key back before it is pushed
+static void release(std::atomic<int>* owners, int key, int thread) {
+    int previous = owners[key].exchange(0, std::memory_order_relaxed);
+    KEYARRAY_CHECK(previous == thread + 1);
+}
+
+// Threads popping and pushing the same few keys keep the head changing under
+// every CAS, which is where an untagged stack hands a key out twice (ABA)
+static void poolContention() {
+    constexpr int Keys = 16;
+    constexpr int Threads = 4;
+    constexpr int Rounds = 20000;
+    ConcurrentKeyPool pool(0, Keys - 1);
+    std::unique_ptr<std::atomic<int>[]> owners(new std::atomic<int>[Keys]());
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&, t] {
+            int held[3];
+            for (int round = 0; round < Rounds; ++round) {
+                // Odd threads move keys in batches, so chains are detached and spliced too
+                size_t count = 0;
+                if (t % 2 == 0) {
+                    for (; count < 3 && pool.tryPop(held[count]); ++count) {}
+                } else {
+                    count = pool.popBatch(held, 3);
+                }
+                for (size_t i = 0; i < count; ++i) claim(owners.get(), held[i], t);
+                for (size_t i = 0; i < count; ++i) release(owners.get(), held[i], t);
+                if (t % 2 == 0) {
+                    for (size_t i = count; i > 0; --i) pool.push(held[i - 1]);
+                } else {
+                    pool.pushBatch(held, count);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    KEYARRAY_CHECK(pool.available() == Keys);
+    std::set<int> keys;
+    int key;
+    while (pool.tryPop(key)) KEYARRAY_CHECK(keys.insert(key).second);
+    KEYARRAY_CHECK(keys.size() == Keys && *keys.begin() == 0 && *keys.rbegin() == Keys - 1);
+}
+
+// Magazines refill and flush in batches while keys freed by one thread are
+// pushed into another thread's magazine; no key is ever cached twice
+static void magazineExchange() {
+    constexpr int Keys = 128;
+    constexpr int Threads = 4;
+    constexpr int Rounds = 2000;
+    ConcurrentKeyPool pool(0, Keys - 1);
+    std::unique_ptr<std::atomic<int>[]> owners(new std::atomic<int>[Keys]());
+    std::vector<std::vector<int>> mailboxes(Threads);
+    std::mutex mailboxLock;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&, t] {
+            KeyMagazinePolicy policy;
+            policy.batchSize = 8;
+            KeyMagazine magazine(pool, policy);
+            std::vector<int> held;
+            std::vector<int> received;
+            for (int round = 0; round < Rounds; ++round) {
+                // More keys than one refill brings, so the pool is hit several times
+                int key;
+                for (int i = 0; i < 1 + round % 24 && magazine.tryPop(key); ++i) {
+                    claim(owners.get(), key, t);
+                    held.push_back(key);
+                }
+                for (int freed : held) release(owners.get(), freed, t);
+
+                // Half stay with this thread, half are freed by the next one
+                size_t kept = held.size() / 2;
+                for (size_t i = 0; i < kept; ++i) magazine.push(held[i]);
+                {
+                    std::lock_guard<std::mutex> lock(mailboxLock);
+                    std::vector<int>& next = mailboxes[(t + 1) % Threads];
+                    next.insert(next.end(), held.begin() + static_cast<std::ptrdiff_t>(kept), held.end());
+                    received.swap(mailboxes[t]);
+                }
+                for (int freed : received) magazine.push(freed);
+                KEYARRAY_CHECK(magazine.cached() <= 2 * policy.batchSize);
+                held.clear();
+                received.clear();
+
+                if (round % 100 == 0) magazine.flush();
+                if (round % 7 == 0) magazine.flushIfIdle();
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    // Every magazine flushed on exit; what is left in transit goes back directly
+    for (const std::vector<int>& mailbox : mailboxes) pool.pushBatch(mailbox.data(), mailbox.size());
+    KEYARRAY_CHECK(pool.available() == Keys);
+    std::set<int> keys;
+    int key;
+    while (pool.tryPop(key)) KEYARRAY_CHECK(keys.insert(key).second);
+    KEYARRAY_CHECK(keys.size() == Keys);
+}
+
+int main() {
+    rangesMatchKeyArray();
+    emptyArrays();
+    concurrentGrowth();
+    readersDuringGrowth();
+    poolContention();
+    magazineExchange();
+    return 0;
+}
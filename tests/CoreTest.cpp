@@ -0,0 +1,343 @@
+// KeyArray Core Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Where values are built and destroyed: in place on insert, once
+// per remove, and never for slots that hold nothing.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Counts live instances and copies; has no default constructor, so no slot
+// can be built ahead of an insert
+struct Tracked {
+    static int live;
+    static int copies;
+
+    int id;
+
+    explicit Tracked(int id) : id(id) { ++live; }
+    Tracked(const Tracked& other) : id(other.id) { ++live; ++copies; }
+    Tracked(Tracked&& other) noexcept : id(other.id) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) noexcept = default;
+    ~Tracked() { --live; }
+
+    bool operator==(const Tracked& other) const { return id == other.id; }
+};
+
+int Tracked::live = 0;
+int Tracked::copies = 0;
+
+// emplace and insert(T&&) build the value in its slot without a copy; empty
+// slots hold no value at all
+static void inPlaceInsertion() {
+    Tracked::copies = 0;
+    {
+        KeyArray<Tracked> array(1000);
+        KEYARRAY_CHECK(Tracked::live == 0);
+
+        int key = array.emplace(7);
+        KEYARRAY_CHECK(array.at(key).id == 7);
+        array.insert(Tracked(8));
+        KEYARRAY_CHECK(Tracked::live == 2 && Tracked::copies == 0);
+
+        Tracked original(9);
+        array.insert(original);
+        KEYARRAY_CHECK(Tracked::copies == 1);
+    }
+    KEYARRAY_CHECK(Tracked::live == 0);
+}
+
+// remove destroys the value at once; growth moves values instead of copying them
+static void destructionAndGrowth() {
+    Tracked::copies = 0;
+    {
+        KeyArray<Tracked> array(4);
+        array.enableDynamicResizing();
+        for (int i = 0; i < 100; ++i) array.emplace(i);
+        KEYARRAY_CHECK(Tracked::live == 100 && Tracked::copies == 0);
+
+        for (int key = 0; key < 100; key += 2) array.remove(key);
+        KEYARRAY_CHECK(Tracked::live == 50);
+        for (int key = 1; key < 100; key += 2) KEYARRAY_CHECK(array.at(key).id == key);
+
+        array.clear();
+        KEYARRAY_CHECK(Tracked::live == 0);
+        array.emplace(1);
+    }
+    KEYARRAY_CHECK(Tracked::live == 0 && Tracked::copies == 0);
+}
+
+// The checked, unchecked and non-throwing accessors agree on live keys; only
+// at() throws, and try_get() returns nullptr below, above and on dead keys
+static void elementAccess() {
+    KeyArray<int> array(-10, 10);
+    for (int i = 0; i < 20; ++i) array.insert(i * 10);
+    array.remove(-3);
+
+    for (int key : { -10, -4, 0, 9 }) {
+        int expected = (key + 10) * 10;
+        KEYARRAY_CHECK(array.at(key) == expected && array[key] == expected);
+        KEYARRAY_CHECK(array.at_unchecked(key) == expected && *array.try_get(key) == expected);
+        KEYARRAY_CHECK(&array[key] == array.try_get(key) && &array.at_unchecked(key) == &array.at(key));
+    }
+    for (int key : { -11, -3, 10, 1000 }) {
+        KEYARRAY_CHECK(array.try_get(key) == nullptr);
+        KEYARRAY_CHECK_THROWS(array.at(key), std::out_of_range);
+    }
+
+    array[0] = 1;
+    *array.try_get(1) = 2;
+    array.at_unchecked(2) = 3;
+    const KeyArray<int>& view = array;
+    KEYARRAY_CHECK(view[0] == 1 && *view.try_get(1) == 2 && view.at_unchecked(2) == 3 && view.at(2) == 3);
+    KEYARRAY_CHECK(view.try_get(-3) == nullptr && view.try_get(-11) == nullptr);
+    KEYARRAY_CHECK_THROWS(view.at(-3), std::out_of_range);
+
+    // Unsigned keys below the offset wrap around to a slot far past the end
+    KeyArray<int, SlotStorage<int>, LifoKeyOrder, uint8_t> small(100, 109);
+    small.insert(5);
+    KEYARRAY_CHECK(small.try_get(99) == nullptr && small.try_get(0) == nullptr && *small.try_get(100) == 5);
+    KEYARRAY_CHECK_THROWS(small.at(99), std::out_of_range);
+}
+
+// The accessors find values on either side of an incremental resize
+static void accessDuringResize() {
+    KeyArray<int> array(8);
+    array.enableDynamicResizing();
+    array.setCopyBudget(1);
+    int key = 0;
+    while (!array.isResizeInProgress()) key = array.insert(key) + 1;
+    for (int i = 0; i < 4; ++i) key = array.insert(key) + 1;
+    KEYARRAY_CHECK(array.isResizeInProgress());
+
+    for (int k = 0; k < key; ++k) {
+        KEYARRAY_CHECK(array.at(k) == k && array[k] == k && *array.try_get(k) == k);
+    }
+    KEYARRAY_CHECK(array.try_get(key) == nullptr);
+}
+
+// insertBatch takes recycled keys first, then one fresh run, and writes
+// Queued for the values that overflow
+static void batchInsert() {
+    KeyArray<int> array(8);
+    for (int i = 0; i < 4; ++i) array.insert(i);
+    array.removeBatch({ 1, 3 });
+
+    std::vector<int> values{ 10, 11, 12, 13 };
+    std::vector<int> keys;
+    array.insertBatch(values.begin(), values.end(), std::back_inserter(keys));
+    KEYARRAY_CHECK((keys == std::vector<int>{ 3, 1, 4, 5 }));
+    for (size_t i = 0; i < keys.size(); ++i) KEYARRAY_CHECK(array.at(keys[i]) == values[i]);
+
+    array.enableQueue();
+    keys.clear();
+    array.insertBatch(values.begin(), values.end(), std::back_inserter(keys));
+    KEYARRAY_CHECK((keys == std::vector<int>{ 6, 7, -1, -1 }));
+    KEYARRAY_CHECK(array.size() == 8 && array.getQueueSize() == 2 && array.getQueue().front() == 12);
+
+    // A rejecting queue that cannot take the overflow fails before inserting anything
+    KeyArray<int> bounded(2);
+    bounded.enableQueue(1, OverflowPolicy::Reject);
+    KEYARRAY_CHECK_THROWS(bounded.insertBatch(values.begin(), values.end(), std::back_inserter(keys)), std::runtime_error);
+    KEYARRAY_CHECK(bounded.size() == 0 && bounded.getQueueSize() == 0);
+    KeyArray<int> full(2);
+    KEYARRAY_CHECK_THROWS(full.insertBatch(values.begin(), values.end(), std::back_inserter(keys)), std::runtime_error);
+}
+
+// A batch grows the array once to fit, and single-pass input inserts one value at a time
+static void batchGrowth() {
+    KeyArray<int> array(4);
+    array.enableDynamicResizing();
+    std::vector<int> values(100);
+    for (int i = 0; i < 100; ++i) values[i] = i * 2;
+    std::vector<int> keys(100);
+    auto end = array.insertBatch(values.begin(), values.end(), keys.begin());
+    KEYARRAY_CHECK(end == keys.end() && array.size() == 100 && array.getCapacity() >= 100);
+    for (int i = 0; i < 100; ++i) KEYARRAY_CHECK(keys[i] == i && array.at(i) == i * 2);
+
+    std::istringstream input("7 8 9");
+    keys.clear();
+    array.insertBatch(std::istream_iterator<int>(input), std::istream_iterator<int>(), std::back_inserter(keys));
+    KEYARRAY_CHECK((keys == std::vector<int>{ 100, 101, 102 }) && array.at(102) == 9);
+}
+
+// removeBatch takes iterators, containers and braced lists, and stops at the
+// first dead key with the keys before it removed
+static void batchRemove() {
+    KeyArray<int> array(20);
+    for (int i = 0; i < 20; ++i) array.insert(i);
+
+    std::vector<int> keys{ 0, 1, 2 };
+    array.removeBatch(keys.begin(), keys.end());
+    array.removeBatch(std::vector<int>{ 3, 4 });
+    array.removeBatch({ 5, 6 });
+    KEYARRAY_CHECK(array.size() == 13 && !array.hasKey(6) && array.hasKey(7));
+
+    KEYARRAY_CHECK_THROWS(array.removeBatch({ 7, 8, 0, 9 }), std::out_of_range);
+    KEYARRAY_CHECK(!array.hasKey(7) && !array.hasKey(8) && array.hasKey(9) && array.size() == 11);
+    KEYARRAY_CHECK_THROWS(array.removeBatch({ 20 }), std::out_of_range);
+}
+
+// Copying a negative value throws, so a load can fail partway through
+struct Fragile {
+    int value = 0;
+
+    Fragile(int value = 0) : value(value) {}
+    Fragile(const Fragile& other) : value(other.value) {
+        if (value < 0) throw std::runtime_error("fragile copy");
+    }
+    Fragile& operator=(const Fragile&) = default;
+
+    bool operator==(const Fragile& other) const { return value == other.value; }
+};
+
+// The range constructor and assign build values under keys offset, offset + 1,
+// ...; assign keeps a larger capacity and leaves the array unchanged on a throw
+static void bulkAssign() {
+    std::vector<int> values(100);
+    for (int i = 0; i < 100; ++i) values[i] = i * 3;
+    KeyArray<int> built(values.begin(), values.end());
+    KEYARRAY_CHECK(built.size() == 100 && built.getCapacity() == 100);
+    for (int key = 0; key < 100; ++key) KEYARRAY_CHECK(built.at(key) == key * 3);
+
+    std::istringstream input("4 5 6");
+    KeyArray<int> streamed{ std::istream_iterator<int>(input), std::istream_iterator<int>() };
+    KEYARRAY_CHECK(streamed.size() == 3 && streamed.at(2) == 6);
+
+    KeyArray<int> array(-5, 5);
+    for (int i = 0; i < 8; ++i) array.insert(i);
+    array.assign(values.begin(), values.begin() + 3);
+    KEYARRAY_CHECK(array.size() == 3 && array.getCapacity() == 10);
+    KEYARRAY_CHECK(array.at(-5) == 0 && array.at(-3) == 6 && !array.hasKey(-2));
+    KEYARRAY_CHECK(array.insert(1) == -2);
+    array.assign(values.begin(), values.end());
+    KEYARRAY_CHECK(array.size() == 100 && array.at(94) == 297);
+
+    KeyArray<Fragile> fragile(4);
+    fragile.insert(Fragile(1));
+    std::vector<Fragile> bad{ 2, 3, 4 };
+    bad.back().value = -1;
+    KEYARRAY_CHECK_THROWS(fragile.assign(bad.begin(), bad.end()), std::runtime_error);
+    KEYARRAY_CHECK(fragile.size() == 1 && fragile.at(0).value == 1 && fragile.getCapacity() == 4);
+}
+
+// assignKeyed places each value under its own key and frees the rest, lowest
+// first; a bad key leaves the array unchanged
+static void keyedAssign() {
+    KeyArray<std::string> array(4);
+    array.insert("old");
+    std::vector<std::pair<int, std::string>> entries{ { 7, "seven" }, { 2, "two" } };
+    array.assignKeyed(entries.begin(), entries.end());
+    KEYARRAY_CHECK(array.size() == 2 && array.getCapacity() == 8);
+    KEYARRAY_CHECK(array.at(7) == "seven" && array.at(2) == "two" && !array.hasKey(0));
+    KEYARRAY_CHECK(array.insert("a") == 0 && array.insert("b") == 1 && array.insert("c") == 3);
+
+    std::vector<std::pair<int, std::string>> duplicate{ { 1, "x" }, { 1, "y" } };
+    KEYARRAY_CHECK_THROWS(array.assignKeyed(duplicate.begin(), duplicate.end()), std::invalid_argument);
+    std::vector<std::pair<int, std::string>> outside{ { -1, "x" } };
+    KEYARRAY_CHECK_THROWS(array.assignKeyed(outside.begin(), outside.end()), std::out_of_range);
+    KEYARRAY_CHECK(array.size() == 5 && array.at(7) == "seven" && array.at(3) == "c");
+}
+
+// reserve grows in one step without dynamic resizing, never shrinks, and
+// finishes a resize in progress; keys and free keys survive
+static void reserveCapacity() {
+    KeyArray<int> array(4);
+    for (int i = 0; i < 4; ++i) array.insert(i);
+    array.remove(1);
+    array.reserve(100);
+    KEYARRAY_CHECK(array.getCapacity() == 100 && array.size() == 3 && array.at(3) == 3);
+    KEYARRAY_CHECK(array.insert(10) == 1 && array.insert(4) == 4);
+    array.reserve(10);
+    KEYARRAY_CHECK(array.getCapacity() == 100);
+
+    array.enableDynamicResizing();
+    array.setCopyBudget(1);
+    while (!array.isResizeInProgress()) array.insert(0);
+    array.reserve(150);
+    KEYARRAY_CHECK(!array.isResizeInProgress() && array.getCapacity() >= 150 && array.at(1) == 10);
+
+    KeyArray<int, SlotStorage<int>, LifoKeyOrder, uint8_t> small(4);
+    KEYARRAY_CHECK_THROWS(small.reserve(1000), std::length_error);
+    KEYARRAY_CHECK(small.getCapacity() == 4);
+}
+
+// clear destroys every value, keeps the capacity and hands out keys from the
+// offset again, also when few keys of a large capacity were ever used
+static void clearAndReuse() {
+    {
+        KeyArray<Tracked> array(-10, 999990);
+        for (int i = 0; i < 5; ++i) array.emplace(i);
+        array.remove(-8);
+        array.clear();
+        KEYARRAY_CHECK(Tracked::live == 0 && array.size() == 0 && array.getCapacity() == 1000000);
+        for (int key = -10; key < -5; ++key) KEYARRAY_CHECK(!array.hasKey(key) && array.try_get(key) == nullptr);
+        KEYARRAY_CHECK(array.emplace(7) == -10 && array.emplace(8) == -9 && array.emplace(9) == -8);
+        KEYARRAY_CHECK(array.size() == 3 && array.at(-8).id == 9);
+
+        array.enableQueue();
+        array.clear();
+        array.clear();
+        KEYARRAY_CHECK(Tracked::live == 0 && array.emplace(1) == -10);
+
+        // Keys placed directly, far above any handed out, are cleared too
+        std::vector<std::pair<int, Tracked>> entries{ { 900, Tracked(1) }, { 5, Tracked(2) } };
+        array.assignKeyed(entries.begin(), entries.end());
+        array.clear();
+        KEYARRAY_CHECK(Tracked::live == static_cast<int>(entries.size()) && !array.hasKey(900) && !array.hasKey(5));
+    }
+    KEYARRAY_CHECK(Tracked::live == 0);
+}
+
+// During a resize, clear destroys the values in both buffers and keeps the
+// larger one; during a shrink, the values still above the target
+static void clearWhileMoving() {
+    {
+        KeyArray<Tracked> array(64);
+        array.enableDynamicResizing();
+        array.setCopyBudget(1);
+        while (!array.isResizeInProgress()) array.emplace(0);
+        for (int i = 0; i < 4; ++i) array.emplace(0);
+        array.enableQueue();
+        array.clear();
+        KEYARRAY_CHECK(Tracked::live == 0 && !array.isResizeInProgress() && array.getCapacity() > 64);
+        for (int i = 0; i < 80; ++i) KEYARRAY_CHECK(array.emplace(i) == i);
+        for (int key = 0; key < 80; ++key) KEYARRAY_CHECK(array.at(key).id == key);
+        KEYARRAY_CHECK(Tracked::live == 80);
+    }
+    KEYARRAY_CHECK(Tracked::live == 0);
+
+    {
+        KeyArray<Tracked> array(100);
+        for (int i = 0; i < 100; ++i) array.emplace(i);
+        for (int key = 0; key < 90; ++key) array.remove(key);
+        array.startShrink(20);
+        KEYARRAY_CHECK(array.isShrinkInProgress());
+        array.clear();
+        KEYARRAY_CHECK(Tracked::live == 0 && !array.isShrinkInProgress());
+        KEYARRAY_CHECK(!array.hasKey(95) && array.emplace(0) == 0 && array.emplace(1) == 1);
+    }
+    KEYARRAY_CHECK(Tracked::live == 0);
+}
+
+int main() {
+    inPlaceInsertion();
+    destructionAndGrowth();
+    elementAccess();
+    accessDuringResize();
+    batchInsert();
+    batchGrowth();
+    batchRemove();
+    bulkAssign();
+    keyedAssign();
+    reserveCapacity();
+    clearAndReuse();
+    clearWhileMoving();
+    return 0;
+}
@@ -0,0 +1,62 @@
+// DenseKeyArray Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Swap-with-last compaction on remove and the key-to-position
+// remapping that keeps keys stable while values move.
+
+#include "DenseKeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// Removing a value moves the last one into its hole, so the values stay packed
+static void swapRemove() {
+    DenseKeyArray<std::string> array(8);
+    for (int i = 0; i < 5; ++i) array.insert("v" + std::to_string(i));
+
+    array.remove(1);
+    KEYARRAY_CHECK(array.values().size() == 4);
+    KEYARRAY_CHECK(array.values()[1] == "v4" && array.keys()[1] == 4);
+    KEYARRAY_CHECK(array.values()[3] == "v3" && array.keys()[3] == 3);
+
+    // Removing the last value moves nothing
+    array.remove(3);
+    KEYARRAY_CHECK(array.values().size() == 3);
+    KEYARRAY_CHECK(array.values()[0] == "v0" && array.values()[1] == "v4" && array.values()[2] == "v2");
+
+    array.remove(0);
+    array.remove(4);
+    array.remove(2);
+    KEYARRAY_CHECK(array.values().size() == 0 && array.empty());
+}
+
+// A moved value keeps its key: the key's entry follows it to its new position
+static void keyRemapping() {
+    DenseKeyArray<int, LifoKeyOrder, uint16_t> array(100, 110);
+    for (int i = 0; i < 6; ++i) array.insert(i * 10);
+
+    array.remove(101);
+    KEYARRAY_CHECK(array.indexOf(105) == 1);
+    KEYARRAY_CHECK(array.at(105) == 50);
+    array.remove(100);
+    KEYARRAY_CHECK(array.indexOf(104) == 0 && array.at(104) == 40);
+    KEYARRAY_CHECK_THROWS(array.indexOf(100), std::out_of_range);
+    KEYARRAY_CHECK(!array.hasKey(101) && array.try_get(101) == nullptr);
+
+    for (size_t position = 0; position < array.size(); ++position) {
+        KEYARRAY_CHECK(array.indexOf(array.keys()[position]) == position);
+        KEYARRAY_CHECK(array.at(array.keys()[position]) == array.values()[position]);
+    }
+
+    // A recycled key is appended at the end, whatever slot it names
+    uint16_t key = array.insert(99);
+    KEYARRAY_CHECK(key == 100);
+    KEYARRAY_CHECK(array.indexOf(key) == array.size() - 1);
+    KEYARRAY_CHECK(array.count(99) == 1 && !array.contains(10));
+}
+
+int main() {
+    swapRemove();
+    keyRemapping();
+    return 0;
+}
@@ -0,0 +1,61 @@
+// KeyArray Dirty Tracker Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Changed-key tracking next to the overflow queue.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <vector>
+
+template <typename Key>
+using TrackedArray = KeyArray<int, SlotStorage<int>, LifoKeyOrder, Key>;
+
+// Returns the keys collectChanges() reports, in order
+template <typename Key>
+static std::vector<Key> collect(TrackedArray<Key>& array) {
+    std::vector<Key> keys;
+    array.collectChanges([&](Key key, const int*) { keys.push_back(key); });
+    return keys;
+}
+
+// A queued value marks no key; the key it is admitted to is marked instead
+template <typename Key>
+static void queuedValuesMarkNoKey() {
+    TrackedArray<Key> array(2);
+    array.enableChangeTracking();
+    array.enableQueue();
+    array.enableAdmission();
+    array.insert(10);
+    array.insert(11);
+    KEYARRAY_CHECK(array.insert(12) == KeyTraits<Key>::Queued);
+    KEYARRAY_CHECK((collect(array) == std::vector<Key>{0, 1}));
+
+    array.insert(13);
+    KEYARRAY_CHECK(array.pendingChanges() == 0);
+
+    array.remove(1);
+    KEYARRAY_CHECK(array[1] == 12);
+    KEYARRAY_CHECK((collect(array) == std::vector<Key>{1}));
+}
+
+// Below a negative offset the Queued sentinel -1 is a real key, untouched by queueing
+static void queuedBelowNegativeOffset() {
+    TrackedArray<int> array(-2, 0);
+    array.enableChangeTracking();
+    array.enableQueue();
+    array.insert(10);
+    array.insert(11);
+    KEYARRAY_CHECK((collect(array) == std::vector<int>{-2, -1}));
+
+    array.insert(12);
+    KEYARRAY_CHECK(array.getQueueSize() == 1);
+    KEYARRAY_CHECK(array.pendingChanges() == 0);
+}
+
+int main() {
+    queuedValuesMarkNoKey<int>();
+    queuedValuesMarkNoKey<uint32_t>();
+    queuedValuesMarkNoKey<uint64_t>();
+    queuedBelowNegativeOffset();
+    return 0;
+}
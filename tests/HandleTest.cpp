@@ -0,0 +1,97 @@
+// KeyArray Handle Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Null, stale and recycled handles on generational arrays.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A null handle and a handle to a never-used slot match nothing
+static void nullHandles() {
+    GenerationalKeyArray<std::string> array(8);
+    KEYARRAY_CHECK(!array.hasKey(KeyHandle()));
+    KEYARRAY_CHECK(!array.hasKey(KeyHandle32()));
+    KEYARRAY_CHECK(!array.hasKey(KeyHandle(3, 0)));
+    KEYARRAY_CHECK_THROWS(array.at(KeyHandle()), std::out_of_range);
+
+    array.insert("a");
+    KEYARRAY_CHECK(!array.hasKey(KeyHandle()));
+    KEYARRAY_CHECK(array.hasKey(array.handleOf(0)));
+}
+
+// Removing a value stales its handle, also once the key is reused
+static void staleHandles() {
+    GenerationalKeyArray<std::string> array(8);
+    KeyHandle first = array.insertHandle("a");
+    array.remove(first);
+    KEYARRAY_CHECK(!array.hasKey(first));
+    KEYARRAY_CHECK(!array.hasKey(KeyHandle(first.index(), first.generation() + 1)));
+
+    KeyHandle second = array.insertHandle("b");
+    KEYARRAY_CHECK(second.index() == first.index());
+    KEYARRAY_CHECK(!array.hasKey(first));
+    KEYARRAY_CHECK(array.at(second) == "b");
+    KEYARRAY_CHECK_THROWS(array.remove(first), std::out_of_range);
+}
+
+// Handles to slots a shrink released stay stale once growth brings the slots back
+template <typename Array>
+static void staleAcrossShrink(size_t count, bool reserve) {
+    Array array(1);
+    array.enableDynamicResizing();
+    std::vector<KeyHandle> handles;
+    for (size_t i = 0; i < count; ++i) handles.push_back(array.insertHandle(std::to_string(i)));
+    for (size_t i = 1; i < count; ++i) array.remove(handles[i]);
+
+    array.shrinkToFit();
+    KEYARRAY_CHECK(array.getCapacity() < count);
+    if (reserve) {
+        array.reserve(count);
+    } else {
+        while (array.size() < count) array.insert("again");
+    }
+    KEYARRAY_CHECK(array.getCapacity() >= count);
+
+    for (size_t i = 1; i < count; ++i) {
+        KEYARRAY_CHECK(!array.hasKey(handles[i]));
+        KEYARRAY_CHECK_THROWS(array.at(handles[i]), std::out_of_range);
+    }
+    KEYARRAY_CHECK(array.at(handles[0]) == "0");
+
+    while (array.size() < count) array.insert("again");
+    for (size_t i = 1; i < count; ++i) KEYARRAY_CHECK(!array.hasKey(handles[i]));
+    for (size_t i = 0; i < count; ++i) {
+        KeyHandle handle = array.handleOf(static_cast<int>(i));
+        KEYARRAY_CHECK(array.hasKey(handle));
+    }
+}
+
+// Only a value that went to the queue gets a null handle, also when the key
+// range includes the Queued sentinel -1
+static void queuedHandles() {
+    GenerationalKeyArray<std::string> array(-2, 2);
+    array.enableQueue();
+    std::vector<KeyHandle> handles;
+    for (int i = 0; i < 4; ++i) handles.push_back(array.insertHandle(std::to_string(i)));
+    for (int i = 0; i < 4; ++i) {
+        KEYARRAY_CHECK(array.hasKey(handles[i]));
+        KEYARRAY_CHECK(array.at(handles[i]) == std::to_string(i));
+    }
+    KEYARRAY_CHECK(array.hasKey(-1));
+
+    KeyHandle queued = array.insertHandle("queued");
+    KEYARRAY_CHECK(queued == KeyHandle());
+    KEYARRAY_CHECK(array.getQueueSize() == 1);
+}
+
+int main() {
+    nullHandles();
+    staleHandles();
+    staleAcrossShrink<GenerationalKeyArray<std::string>>(256, false);
+    staleAcrossShrink<GenerationalKeyArray<std::string>>(256, true);
+    staleAcrossShrink<PagedKeyArray<std::string, true>>(3000, false);
+    queuedHandles();
+    return 0;
+}
@@ -0,0 +1,157 @@
+// KeyArray Iteration Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Walks over live elements only, in key order, across bitmap
+// words and resize buffers, with the iterator and the bulk and parallel
+// traversals.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Returns the keys the live iterator yields, checking each value on the way
+template <typename Array>
+static std::vector<int> liveKeys(Array& array) {
+    std::vector<int> keys;
+    for (auto [key, value] : array) {
+        KEYARRAY_CHECK(value == key * 10);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+// Only live keys are visited, in ascending order, also across empty words
+static void sparseIteration() {
+    KeyArray<int> empty(500);
+    KEYARRAY_CHECK(empty.begin() == empty.end());
+
+    KeyArray<int> array(500);
+    for (int i = 0; i < 500; ++i) array.insert(i * 10);
+    std::vector<int> expected;
+    for (int key = 0; key < 500; ++key) {
+        bool keep = key == 63 || key == 64 || key == 200 || key == 499 || (key >= 300 && key < 310);
+        if (keep) {
+            expected.push_back(key);
+        } else {
+            array.remove(key);
+        }
+    }
+    KEYARRAY_CHECK(liveKeys(array) == expected);
+
+    const KeyArray<int>& view = array;
+    std::vector<int> constKeys;
+    for (auto it = view.begin(); it != view.end(); ++it) constKeys.push_back((*it).first);
+    KEYARRAY_CHECK(constKeys == expected);
+}
+
+// Values are written through the iterator; keys carry the offset
+static void writesAndOffsets() {
+    KeyArray<int> array(-5, 5);
+    for (int i = 0; i < 10; ++i) array.insert(0);
+    array.remove(-2);
+    for (auto [key, value] : array) value = key * 10;
+
+    std::vector<int> keys = liveKeys(array);
+    KEYARRAY_CHECK(keys.size() == 9 && keys.front() == -5 && keys.back() == 4);
+    KEYARRAY_CHECK(!array.hasKey(-2));
+}
+
+// While a resize is in progress, values in the old and the new buffer are both visited
+static void iterationDuringResize() {
+    KeyArray<int> array(64);
+    array.enableDynamicResizing();
+    array.setCopyBudget(1);
+    int key = 0;
+    while (!array.isResizeInProgress()) key = array.insert(key * 10) + 1;
+    array.insert(key * 10);
+    KEYARRAY_CHECK(array.isResizeInProgress());
+
+    std::vector<int> keys = liveKeys(array);
+    KEYARRAY_CHECK(keys.size() == array.size());
+    for (size_t i = 0; i < keys.size(); ++i) KEYARRAY_CHECK(keys[i] == static_cast<int>(i));
+}
+
+// Keeps every 7th key and the edges of a few bitmap words of 3000
+static KeyArray<int> sparseArray() {
+    KeyArray<int> array(3000);
+    for (int i = 0; i < 3000; ++i) array.insert(i * 10);
+    for (int key = 0; key < 3000; ++key) {
+        if (key % 7 != 0 && key != 511 && key != 512 && key != 2999) array.remove(key);
+    }
+    return array;
+}
+
+// Appends keys in order; associative but not commutative, so any reordering shows
+static std::string joinKeys(std::string left, const std::string& right) {
+    return left + right;
+}
+
+// forEachLive and reduceLive visit what the iterator visits, in the same order
+static void bulkTraversal() {
+    KeyArray<int> array = sparseArray();
+    std::vector<int> expected = liveKeys(array);
+
+    std::vector<int> keys;
+    array.forEachLive([&](int key, int& value) {
+        keys.push_back(key);
+        value = key * 10;
+    });
+    KEYARRAY_CHECK(keys == expected);
+
+    std::string order = array.reduceLive(std::string(),
+        [](int key, const int&) { return std::to_string(key) + ","; }, joinKeys);
+    std::string joined;
+    for (int key : expected) joined += std::to_string(key) + ",";
+    KEYARRAY_CHECK(order == joined);
+    KEYARRAY_CHECK(array.reduceLive(size_t(0), [](int, const int&) { return size_t(1); }, std::plus<size_t>()) == array.size());
+
+    KeyArray<int> empty(100);
+    KEYARRAY_CHECK(empty.reduceLive(5, [](int, const int& value) { return value; }, std::plus<int>()) == 5);
+}
+
+// Parallel traversal through an inline executor and through std::thread
+// matches the serial result; chunk results combine in key order
+static void parallelTraversal() {
+    KeyArray<int> array = sparseArray();
+    KeyArrayScanPolicy policy;
+    policy.threads = 4;
+    array.setScanPolicy(policy);
+    std::string serial = array.reduceLive(std::string(),
+        [](int key, const int&) { return std::to_string(key) + ","; }, joinKeys);
+
+    auto runInline = [](std::function<void()> task) { task(); };
+    std::vector<std::thread> workers;
+    auto runOnThread = [&](std::function<void()> task) { workers.emplace_back(std::move(task)); };
+
+    array.parallelForEachLive(runInline, [](int key, int& value) { value = key * 3; });
+    array.parallelForEachLive(runOnThread, [](int key, int& value) { value += key; });
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+    array.forEachLive([](int key, const int& value) { KEYARRAY_CHECK(value == key * 4); });
+
+    const KeyArray<int>& view = array;
+    std::string parallel = view.parallelReduceLive(runOnThread, std::string(),
+        [](int key, const int&) { return std::to_string(key) + ","; }, joinKeys);
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+    KEYARRAY_CHECK(parallel == serial);
+    KEYARRAY_CHECK(view.parallelReduceLive(runInline, size_t(0), [](int, const int&) { return size_t(1); },
+                                           std::plus<size_t>()) == array.size());
+
+    // An exception from any chunk reaches the caller
+    KEYARRAY_CHECK_THROWS(view.parallelForEachLive(runInline, [](int key, const int&) {
+        if (key == 2999) throw std::runtime_error("last chunk");
+    }), std::runtime_error);
+}
+
+int main() {
+    sparseIteration();
+    writesAndOffsets();
+    iterationDuringResize();
+    bulkTraversal();
+    parallelTraversal();
+    return 0;
+}
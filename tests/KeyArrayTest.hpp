@@ -0,0 +1,38 @@
+// KeyArrayTest: Minimal checks shared by the KeyArray tests
+// Author: Eli (Eliyahu) Shif
+// Description: The tests build in Release too, so they cannot rely on
+// assert(); these macros always check and exit with a message on failure.
+
+#ifndef KEYARRAYTEST_HPP
+#define KEYARRAYTEST_HPP
+
+#include <cstdlib>
+#include <iostream>
+
+// Fails the test unless the condition holds
+#define KEYARRAY_CHECK(condition)                                                    \
+    do {                                                                             \
+        if (!(condition)) {                                                          \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: "           \
+                      << #condition << "\n";                                         \
+            std::exit(1);                                                            \
+        }                                                                            \
+    } while (false)
+
+// Fails the test unless the expression throws the given exception type
+#define KEYARRAY_CHECK_THROWS(expression, Exception)                                 \
+    do {                                                                             \
+        bool thrown = false;                                                         \
+        try {                                                                        \
+            (void)(expression);                                                      \
+        } catch (const Exception&) {                                                 \
+            thrown = true;                                                           \
+        }                                                                            \
+        if (!thrown) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #Exception     \
+                      << " from " << #expression << "\n";                            \
+            std::exit(1);                                                            \
+        }                                                                            \
+    } while (false)
+
+#endif // KEYARRAYTEST_HPP
@@ -0,0 +1,152 @@
+// KeyArray Key Order Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Which key a freed slot comes back as: the intrusive free list
+// threaded through free slots, and the LIFO, FIFO and lowest-first orders.
+
+#include "IntrusiveKeyPool.hpp"
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+// Free-list links kept in a plain array, one per key
+struct LinkArray {
+    std::vector<int> next;
+
+    int nextFree(size_t index) const { return next[index]; }
+    void setNextFree(size_t index, int key) { next[index] = key; }
+};
+
+// Freed keys come back newest first, before the range continues; only the
+// freed slots' links are written
+static void intrusiveFreeList() {
+    IntrusiveKeyPool pool(0, 7);
+    LinkArray links{ std::vector<int>(8, -7) };
+    for (int i = 0; i < 4; ++i) KEYARRAY_CHECK(pool.pop(links) == i);
+
+    pool.push(1, links);
+    pool.push(3, links);
+    KEYARRAY_CHECK(pool.hasRecycled() && pool.available() == 6);
+    for (int key : { 0, 2, 4, 5, 6, 7 }) KEYARRAY_CHECK(links.next[key] == -7);
+
+    KEYARRAY_CHECK(pool.pop(links) == 3);
+    KEYARRAY_CHECK(pool.pop(links) == 1);
+    KEYARRAY_CHECK(!pool.hasRecycled());
+    KEYARRAY_CHECK(pool.pop(links) == 4);
+}
+
+// An array reuses freed keys first, also keys freed in the old buffer while
+// a resize is moving slots to the new one
+static void recyclingAcrossResize() {
+    KeyArray<int> array(4);
+    array.enableDynamicResizing();
+    for (int i = 0; i < 4; ++i) array.insert(i);
+    array.remove(1);
+    array.remove(2);
+    KEYARRAY_CHECK(array.insert(20) == 2);
+    KEYARRAY_CHECK(array.insert(10) == 1);
+    KEYARRAY_CHECK(array.insert(4) == 4);
+
+    array.setCopyBudget(1);
+    while (!array.isResizeInProgress()) array.insert(0);
+    int last = array.insert(0);
+    KEYARRAY_CHECK(array.isResizeInProgress());
+    array.remove(last);
+    array.remove(0);
+    KEYARRAY_CHECK(array.insert(0) == 0);
+    KEYARRAY_CHECK(array.insert(0) == last);
+    array.switchToResizedData();
+    array.remove(3);
+    KEYARRAY_CHECK(array.insert(3) == 3);
+    KEYARRAY_CHECK(array.at(1) == 10 && array.at(2) == 20);
+}
+
+// Frees `removed` from a full array of 64 keys and returns the keys the next
+// inserts are handed, fresh ones included
+template <typename Order>
+static std::vector<int> reuseOrder(const std::vector<int>& removed, size_t inserts) {
+    KeyArray<int, SlotStorage<int>, Order> array(64);
+    array.enableDynamicResizing();
+    for (int i = 0; i < 60; ++i) array.insert(i);
+    for (int key : removed) array.remove(key);
+
+    std::vector<int> keys;
+    for (size_t i = 0; i < inserts; ++i) keys.push_back(array.insert(0));
+    return keys;
+}
+
+// LIFO hands back the newest free key, FIFO the oldest, Lowest the smallest;
+// all three go on to fresh keys once the freed ones are used
+static void reuseOrders() {
+    std::vector<int> removed{ 5, 40, 2, 17 };
+    KEYARRAY_CHECK((reuseOrder<LifoKeyOrder>(removed, 6) == std::vector<int>{ 17, 2, 40, 5, 60, 61 }));
+    KEYARRAY_CHECK((reuseOrder<FifoKeyOrder>(removed, 6) == std::vector<int>{ 5, 40, 2, 17, 60, 61 }));
+    KEYARRAY_CHECK((reuseOrder<LowestKeyOrder>(removed, 6) == std::vector<int>{ 2, 5, 17, 40, 60, 61 }));
+
+    // A key freed again while the others wait goes to the back of the FIFO
+    KeyArray<int, SlotStorage<int>, FifoKeyOrder> fifo(8);
+    for (int i = 0; i < 8; ++i) fifo.insert(i);
+    fifo.remove(3);
+    fifo.remove(6);
+    KEYARRAY_CHECK(fifo.insert(0) == 3);
+    fifo.remove(3);
+    KEYARRAY_CHECK(fifo.insert(0) == 6 && fifo.insert(0) == 3);
+}
+
+// The FIFO and Lowest orders keep their order while an incremental resize
+// moves slots, and after the switch re-writes the links into the new buffer
+template <typename Order>
+static void orderAcrossResize() {
+    KeyArray<int, SlotStorage<int>, Order> array(64);
+    array.enableDynamicResizing();
+    array.setCopyBudget(1);
+    int key = 0;
+    while (!array.isResizeInProgress()) key = array.insert(key) + 1;
+    KEYARRAY_CHECK(key > 40);
+
+    std::vector<int> removed{ key - 1, 3, key - 5, 30, 1 };
+    for (int k : removed) array.remove(k);
+    std::vector<int> expected = removed;
+    if constexpr (std::is_same_v<Order, LowestKeyOrder>) std::sort(expected.begin(), expected.end());
+
+    std::vector<int> keys{ array.insert(0), array.insert(0) };
+    array.switchToResizedData();
+    for (int i = 0; i < 3; ++i) keys.push_back(array.insert(0));
+    KEYARRAY_CHECK(keys == expected);
+    KEYARRAY_CHECK(array.insert(0) == key);
+}
+
+// Lowest-first stays ascending across the levels of its bitmap tree, from a
+// pool of its own and after a clear
+static void lowestAcrossLevels() {
+    BasicIntrusiveKeyPool<LowestKeyOrder> pool(0, 9999);
+    LinkArray links{ std::vector<int>(10000, -7) };
+    for (int i = 0; i < 10000; ++i) pool.pop(links);
+
+    std::vector<int> freed;
+    for (int key = 9999; key >= 0; key -= 37) freed.push_back(key);
+    for (int key : freed) pool.push(key, links);
+    std::sort(freed.begin(), freed.end());
+    for (int key : freed) KEYARRAY_CHECK(pool.pop(links) == key);
+    KEYARRAY_CHECK(pool.empty() && links.next[37] == -7);
+
+    KeyArray<int, SlotStorage<int>, LowestKeyOrder> array(5000);
+    for (int i = 0; i < 5000; ++i) array.insert(i);
+    array.remove(4999);
+    array.remove(64);
+    array.remove(4096);
+    KEYARRAY_CHECK(array.insert(0) == 64 && array.insert(0) == 4096 && array.insert(0) == 4999);
+    array.clear();
+    KEYARRAY_CHECK(array.insert(0) == 0 && array.insert(0) == 1);
+}
+
+int main() {
+    intrusiveFreeList();
+    recyclingAcrossResize();
+    reuseOrders();
+    orderAcrossResize<FifoKeyOrder>();
+    orderAcrossResize<LowestKeyOrder>();
+    lowestAcrossLevels();
+    return 0;
+}
@@ -0,0 +1,33 @@
+// KeyPool Tests
+// Author: Eli (Eliyahu) Shif
+// Description: The standalone stack-based pool: recycling order and growth limits.
+
+#include "KeyPool.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+// Recycled keys come back first, newest first, then the range continues
+static void recycling() {
+    KeyPool pool(5, 7);
+    KEYARRAY_CHECK(pool.pop() == 5 && pool.pop() == 6);
+    pool.push(5);
+    pool.push(6);
+    KEYARRAY_CHECK(pool.pop() == 6 && pool.pop() == 5);
+    KEYARRAY_CHECK(pool.pop() == 7);
+    KEYARRAY_CHECK(pool.empty());
+}
+
+// Growth stops at the last key the type can name
+static void growthLimit() {
+    BasicKeyPool<uint8_t> pool(200);
+    pool.increaseMaxValue();
+    KEYARRAY_CHECK(pool.getMaxValue() == KeyTraits<uint8_t>::MaxKey);
+    KEYARRAY_CHECK_THROWS(pool.increaseMaxValue(), std::length_error);
+}
+
+int main() {
+    recycling();
+    growthLimit();
+    return 0;
+}
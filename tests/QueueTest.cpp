@@ -0,0 +1,147 @@
+// KeyArray Overflow Queue Tests
+// Author: Eli (Eliyahu) Shif
+// Description: The overflow ring, bounded queue policies, admission of queued
+// values into freed and grown keys, and what listeners see of all of it.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Records every queue-related notification as text
+struct QueueEvents final : KeyArrayListener<std::string> {
+    std::vector<std::string> events;
+
+    void onInsert(int key, const std::string& value) override {
+        events.push_back("insert " + std::to_string(key) + " " + value);
+    }
+    void onAdmit(int key, const std::string& value) override {
+        events.push_back("admit " + std::to_string(key) + " " + value);
+    }
+    void onDrop(const std::string& value) override { events.push_back("drop " + value); }
+};
+
+// Long enough to live on the heap, so a value the ring fails to destroy leaks
+static std::string item(size_t i) {
+    return "queued value number " + std::to_string(i);
+}
+
+// The ring keeps FIFO order across wrap-around and growth, in power-of-two
+// capacities, and clear() destroys every value
+static void ringOrder() {
+    OverflowRing<std::string> ring;
+    KEYARRAY_CHECK(ring.empty() && ring.capacity() == 0);
+    for (size_t i = 0; i < 3; ++i) ring.push(item(i));
+    ring.pop();
+    ring.pop();
+    for (size_t i = 3; i < 9; ++i) ring.emplace(item(i));
+
+    KEYARRAY_CHECK(ring.size() == 7 && ring.capacity() == 8);
+    KEYARRAY_CHECK(ring.front() == item(2) && ring.back() == item(8));
+    for (size_t i = 0; i < ring.size(); ++i) KEYARRAY_CHECK(ring[i] == item(i + 2));
+
+    ring.push(item(9));
+    ring.push(item(10));
+    KEYARRAY_CHECK(ring.size() == 9 && ring.capacity() == 16);
+    for (size_t i = 0; i < ring.size(); ++i) KEYARRAY_CHECK(ring[i] == item(i + 2));
+
+    OverflowRing<std::string> copy(ring);
+    ring.clear();
+    KEYARRAY_CHECK(ring.empty() && ring.capacity() == 16);
+    ring.push(item(0));
+    KEYARRAY_CHECK(ring.size() == 1 && ring.front() == item(0));
+    KEYARRAY_CHECK(copy.size() == 9 && copy.front() == item(2) && copy[8] == item(10));
+    copy.pop();
+    copy.clear();
+    KEYARRAY_CHECK(copy.empty());
+
+    // A reserved ring fills up to its capacity without growing
+    OverflowRing<int> reserved;
+    reserved.reserve(5);
+    KEYARRAY_CHECK(reserved.capacity() == 8);
+    for (int i = 0; i < 8; ++i) reserved.push(i);
+    KEYARRAY_CHECK(reserved.capacity() == 8);
+}
+
+// A full bounded queue rejects without change, or drops its oldest value
+static void boundedQueue() {
+    KeyArray<std::string> rejecting(1);
+    rejecting.enableQueue(2, OverflowPolicy::Reject);
+    for (int i = 0; i < 3; ++i) rejecting.insert(std::to_string(i));
+    KEYARRAY_CHECK_THROWS(rejecting.insert("3"), std::runtime_error);
+    KEYARRAY_CHECK(rejecting.getQueueSize() == 2 && rejecting.getQueue().front() == "1");
+    size_t reserved = rejecting.getQueue().capacity();
+    rejecting.clearQueue();
+    KEYARRAY_CHECK(rejecting.getQueueSize() == 0 && rejecting.getQueue().capacity() == reserved);
+
+    KeyArray<std::string> dropping(1);
+    QueueEvents listener;
+    dropping.addListener(&listener);
+    dropping.enableQueue(2, OverflowPolicy::DropOldest);
+    for (int i = 0; i < 4; ++i) dropping.insert(std::to_string(i));
+    KEYARRAY_CHECK(dropping.getQueueSize() == 2);
+    KEYARRAY_CHECK(dropping.getQueue().front() == "2" && dropping.getQueue().back() == "3");
+    KEYARRAY_CHECK(listener.events.back() == "insert -1 3");
+    KEYARRAY_CHECK(listener.events[listener.events.size() - 2] == "drop 1");
+    KEYARRAY_CHECK_THROWS(dropping.enableQueue(1), std::invalid_argument);
+}
+
+// Once the array grows, drainQueue admits the queued values in FIFO order
+static void drainAfterGrowth() {
+    KeyArray<std::string> array(2);
+    array.enableQueue();
+    for (int i = 0; i < 5; ++i) array.insert(std::to_string(i));
+    KEYARRAY_CHECK(array.size() == 2 && array.getQueueSize() == 3);
+    KEYARRAY_CHECK(array.drainQueue() == 0);
+
+    array.reserve(4);
+    KEYARRAY_CHECK(array.drainQueue() == 2);
+    KEYARRAY_CHECK(array.at(2) == "2" && array.at(3) == "3");
+    KEYARRAY_CHECK(array.getQueueSize() == 1 && array.getQueue().front() == "4");
+
+    array.reserve(8);
+    KEYARRAY_CHECK(array.drainQueue() == 1);
+    KEYARRAY_CHECK(array.at(4) == "4" && array.getQueueSize() == 0);
+}
+
+// With admission, remove() hands the freed key to the head of the queue at once
+static void admissionOnRemove() {
+    KeyArray<std::string> array(2);
+    std::vector<std::string> admitted;
+    array.enableQueue();
+    array.enableAdmission([&](int key, const std::string& value) {
+        admitted.push_back(std::to_string(key) + " " + value);
+    });
+    for (int i = 0; i < 4; ++i) array.insert(std::to_string(i));
+
+    array.remove(0);
+    array.remove(1);
+    KEYARRAY_CHECK((admitted == std::vector<std::string>{ "0 2", "1 3" }));
+    KEYARRAY_CHECK(array.at(0) == "2" && array.at(1) == "3" && array.getQueueSize() == 0);
+
+    array.remove(0);
+    KEYARRAY_CHECK(admitted.size() == 2 && !array.hasKey(0));
+}
+
+// Listeners see a queued value as an insert at Queued, then as an admit at its key
+static void listenersSeeQueuedInserts() {
+    KeyArray<std::string> array(1);
+    QueueEvents listener;
+    array.addListener(&listener);
+    array.enableQueue();
+    array.insert("a");
+    array.insert("b");
+    array.remove(0);
+    array.drainQueue();
+    KEYARRAY_CHECK((listener.events == std::vector<std::string>{ "insert 0 a", "insert -1 b", "admit 0 b" }));
+}
+
+int main() {
+    ringOrder();
+    boundedQueue();
+    drainAfterGrowth();
+    admissionOnRemove();
+    listenersSeeQueuedInserts();
+    return 0;
+}
@@ -0,0 +1,212 @@
+// KeyArray Resize Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Inserts while a resize or a shrink is in progress, including
+// inserts of values that live in the array itself.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Long enough to live on the heap, so a moved-from copy is visibly empty
+static std::string valueFor(int i) {
+    return "value number " + std::to_string(i) + " of the resize test";
+}
+
+// Each insert migrates the next slot; copying the value in exactly that slot
+// must read it before it moves
+static void selfInsertDuringResize() {
+    KeyArray<std::string> array(8);
+    array.enableDynamicResizing();
+    array.setCopyBudget(1);
+
+    int count = 0;
+    while (!array.isResizeInProgress()) array.insert(valueFor(count++));
+
+    // The insert that started the resize migrated slot 0
+    for (int i = 1; i < count && array.isResizeInProgress(); ++i) {
+        int key = array.insert(array.at(i));
+        KEYARRAY_CHECK(array.at(key) == valueFor(i));
+        KEYARRAY_CHECK(array.at(i) == valueFor(i));
+    }
+}
+
+// An insert drains the resize when the pool is empty mid-copy (threshold 1)
+static void selfInsertWhileDraining() {
+    KeyArray<std::string> array(4);
+    array.enableDynamicResizing();
+    array.setResizeThreshold(1.0);
+    array.setCopyBudget(1);
+
+    for (int i = 0; i < 4; ++i) array.insert(valueFor(i));
+    for (int round = 0; round < 6; ++round) {
+        int key = array.insert(array.at(0));
+        KEYARRAY_CHECK(array.at(key) == valueFor(0));
+    }
+    KEYARRAY_CHECK(array.at(0) == valueFor(0));
+}
+
+// Each insert also relocates a value from above the shrink target
+static void selfInsertDuringShrink() {
+    KeyArray<std::string> array(16);
+    std::vector<int> keys;
+    for (int i = 0; i < 16; ++i) keys.push_back(array.insert(valueFor(i)));
+    for (int i = 0; i < 12; ++i) array.remove(keys[i]);
+
+    std::vector<std::pair<int, int>> moves;
+    array.startShrink(8, [&](int from, int to) { moves.push_back({from, to}); });
+    KEYARRAY_CHECK(array.isShrinkInProgress());
+
+    int key = array.insert(array.at(15));
+    KEYARRAY_CHECK(array.at(key) == valueFor(15));
+    array.finishShrink();
+    KEYARRAY_CHECK(array.getCapacity() == 8);
+    KEYARRAY_CHECK(array.size() == 5);
+}
+
+// An insert that takes the last free key below a shrink target cancels the
+// shrink instead of leaving the pool empty under the insert
+static void insertUsesLastKeyBelowTarget() {
+    for (bool batch : { false, true }) {
+        KeyArray<std::string> array(20);
+        array.enableDynamicResizing();
+        for (int i = 0; i < 6; ++i) array.insert(valueFor(i));
+        array.remove(3);
+        array.remove(4);
+        array.startShrink(4);
+
+        std::vector<int> keys;
+        if (batch) {
+            std::vector<std::string> values{ "x", "y" };
+            array.insertBatch(values.begin(), values.end(), std::back_inserter(keys));
+        } else {
+            keys.push_back(array.insert("x"));
+            keys.push_back(array.insert("y"));
+        }
+        KEYARRAY_CHECK(array.size() == 6);
+        KEYARRAY_CHECK(array.at(keys[0]) == "x" && array.at(keys[1]) == "y");
+        for (int key : { 0, 1, 2, 5 }) KEYARRAY_CHECK(array.at(key) == valueFor(key));
+        array.finishShrink();
+        KEYARRAY_CHECK(!array.isShrinkInProgress());
+        KEYARRAY_CHECK(array.getCapacity() >= 6);
+    }
+}
+
+// Growth from capacity 0 opens key 0 first, however the array got there
+template <typename Array>
+static void growthFromEmpty() {
+    Array grown(0);
+    grown.enableDynamicResizing();
+    for (int i = 0; i < 5; ++i) KEYARRAY_CHECK(grown.insert(i) == i);
+
+    Array reserved(0);
+    reserved.reserve(4);
+    KEYARRAY_CHECK(reserved.insert(7) == 0);
+
+    Array shrunk(16);
+    shrunk.enableDynamicResizing();
+    shrunk.remove(shrunk.insert(1));
+    shrunk.shrinkToFit();
+    KEYARRAY_CHECK(shrunk.getCapacity() == 0);
+    KEYARRAY_CHECK(shrunk.insert(2) == 0);
+    KEYARRAY_CHECK(shrunk.insert(3) == 1);
+    KEYARRAY_CHECK(shrunk.size() == 2);
+}
+
+// An insert during a shrink to 0 cancels it and still gets key 0
+static void insertDuringShrinkToEmpty() {
+    for (bool resizing : { false, true }) {
+        KeyArray<int> array(8);
+        if (resizing) array.enableDynamicResizing();
+        array.remove(array.insert(1));
+        array.startShrink(0);
+        KEYARRAY_CHECK(array.insert(2) == 0);
+        KEYARRAY_CHECK(array.insert(3) == 1);
+        KEYARRAY_CHECK(!array.isShrinkInProgress());
+        KEYARRAY_CHECK(array.getCapacity() == 8);
+    }
+}
+
+// A batch built from the array's own values during a resize
+static void selfBatchDuringResize() {
+    KeyArray<std::string> array(8);
+    array.enableDynamicResizing();
+    array.setCopyBudget(1);
+    for (int i = 0; i < 8; ++i) array.insert(valueFor(i));
+    array.insert(valueFor(8));
+    KEYARRAY_CHECK(array.isResizeInProgress());
+
+    std::vector<std::reference_wrapper<const std::string>> sources;
+    for (int i = 0; i < 4; ++i) sources.push_back(std::cref(array.at(i)));
+    std::vector<int> keys;
+    array.insertBatch(sources.begin(), sources.end(), std::back_inserter(keys));
+    for (int i = 0; i < 4; ++i) KEYARRAY_CHECK(array.at(keys[i]) == valueFor(i));
+}
+
+// A background copy may hand over at any insert, destroying the old buffer
+static void selfInsertDuringBackgroundResize() {
+    KeyArray<std::string> array(4);
+    array.enableDynamicResizing();
+    array.enableBackgroundResize();
+
+    array.insert(valueFor(0));
+    for (int i = 0; i < 2000; ++i) {
+        int key = array.insert(array.at(0));
+        KEYARRAY_CHECK(array.at(key) == valueFor(0));
+    }
+    KEYARRAY_CHECK(array.size() == 2001);
+}
+
+// switchToResizedData hands over to the buffer a background copy fills, with
+// values written during the copy carried over
+static void switchDuringBackgroundResize() {
+    KeyArray<std::string> array(4);
+    array.enableDynamicResizing();
+    array.enableBackgroundResize();
+    while (!array.isResizeInProgress()) array.insert(valueFor(static_cast<int>(array.size())));
+
+    size_t count = array.size();
+    array.update(0, "written");
+    array.switchToResizedData();
+    KEYARRAY_CHECK(!array.isResizeInProgress());
+    KEYARRAY_CHECK(array.getCapacity() == 8);
+    KEYARRAY_CHECK(array.size() == count);
+    KEYARRAY_CHECK(array.at(0) == "written");
+    for (size_t i = 1; i < count; ++i) KEYARRAY_CHECK(array.at(static_cast<int>(i)) == valueFor(static_cast<int>(i)));
+    KEYARRAY_CHECK_THROWS(array.switchToResizedData(), std::runtime_error);
+}
+
+// A background copy reports the buffers the helper allocates: the grown slots
+// and flags the handover keeps, plus one dirty flag per copied slot. The
+// uint8_t key caps the growth below twice the capacity.
+static void backgroundResizeBytes() {
+    KeyArray<int, SlotStorage<int>, LifoKeyOrder, uint8_t> array(200);
+    array.enableDynamicResizing();
+    array.enableBackgroundResize();
+    while (!array.isResizeInProgress()) array.insert(static_cast<int>(array.size()));
+
+    KeyArrayStats during = array.getStats();
+    array.switchToResizedData();
+    KeyArrayStats after = array.getStats();
+    KEYARRAY_CHECK(array.getCapacity() < 400);
+    KEYARRAY_CHECK(after.resizeBytes == 0);
+    KEYARRAY_CHECK(during.resizeBytes == after.dataBytes + (200 + 63) / 64 * sizeof(uint64_t));
+}
+
+int main() {
+    selfInsertDuringResize();
+    selfInsertWhileDraining();
+    selfInsertDuringShrink();
+    insertUsesLastKeyBelowTarget();
+    growthFromEmpty<KeyArray<int>>();
+    growthFromEmpty<PagedKeyArray<int>>();
+    insertDuringShrinkToEmpty();
+    selfBatchDuringResize();
+    selfInsertDuringBackgroundResize();
+    switchDuringBackgroundResize();
+    backgroundResizeBytes();
+    return 0;
+}
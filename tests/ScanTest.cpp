@@ -0,0 +1,154 @@
+// KeyArray Scan Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Vector scans over sparse arrays, whose dead slots the kernels read too,
+// checked against a scalar loop at every instruction set the CPU has.
+
+#include "KeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using Level = KeyArrayScan::Level;
+
+// The instruction sets this CPU runs, scalar first
+static std::vector<Level> levels() {
+    Level best = KeyArrayScan::level();
+    std::vector<Level> result{ Level::Scalar };
+    if (best == Level::AVX2 || best == Level::AVX512) result.push_back(Level::AVX2);
+    if (best != Level::Scalar) result.push_back(best);
+    return result;
+}
+
+// Deterministic picks from a pool of values, so a failure reproduces
+struct Picker {
+    uint32_t seed = 1;
+
+    size_t next(size_t bound) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % bound;
+    }
+};
+
+// Every kernel returns the scalar loop's mask, for runs of 0 to 64 slots at
+// unaligned starts, so whole vectors and the scalar tail are both covered
+template <typename T>
+static void kernelsMatchScalar(const std::vector<T>& pool) {
+    Picker picker;
+    std::vector<T> values(64 + 3);
+    for (Level level : levels()) {
+        KeyArrayScan::limitLevel(level);
+        KEYARRAY_CHECK(KeyArrayScan::level() == level);
+        for (int round = 0; round < 8; ++round) {
+            for (T& value : values) value = pool[picker.next(pool.size())];
+            for (const T& needle : pool) {
+                for (size_t start = 0; start < 4; ++start) {
+                    for (size_t count = 0; count <= 64; ++count) {
+                        uint64_t expected = 0;
+                        for (size_t i = 0; i < count; ++i) expected |= uint64_t(values[start + i] == needle) << i;
+                        KEYARRAY_CHECK(KeyArrayScan::matchEqual(values.data() + start, count, needle) == expected);
+                    }
+                }
+            }
+        }
+    }
+    KeyArrayScan::limitLevel(Level::NEON);
+}
+
+// count, find, contains and count_if agree with a loop over the live keys at
+// every level, for sizes that end mid-vector and mid-word
+template <typename T>
+static void arrayScansMatchScalar(const std::vector<T>& pool) {
+    Picker picker;
+    for (int size : { 1, 5, 63, 67, 300 }) {
+        KeyArray<T> array(size);
+        for (int i = 0; i < size; ++i) array.insert(pool[picker.next(pool.size())]);
+        for (int key = 0; key < size; ++key) {
+            if (picker.next(3) == 0) array.remove(key);
+        }
+
+        for (Level level : levels()) {
+            KeyArrayScan::limitLevel(level);
+            for (const T& needle : pool) {
+                size_t expected = 0;
+                int first = -1;
+                for (int key = 0; key < size; ++key) {
+                    if (!array.hasKey(key) || !(array.at(key) == needle)) continue;
+                    if (first < 0) first = key;
+                    ++expected;
+                }
+                KEYARRAY_CHECK(array.count(needle) == expected);
+                KEYARRAY_CHECK(array.contains(needle) == (first >= 0));
+                KEYARRAY_CHECK(first < 0 ? !array.find(needle) : *array.find(needle) == first);
+                KEYARRAY_CHECK(array.count_if([&](const T& value) { return value == needle; }) == expected);
+            }
+        }
+        KeyArrayScan::limitLevel(Level::NEON);
+    }
+}
+
+// Slots exposed to the vector kernels start as zero bytes, never-used ones included
+template <typename Storage>
+static void freshRunsAreZero() {
+    Storage storage(200);
+    for (size_t base = 0; base + 64 <= storage.capacity(); base += 64) {
+        const auto* values = storage.valueRun(base, 64);
+        KEYARRAY_CHECK(values != nullptr);
+        for (size_t i = 0; i < 64; ++i) KEYARRAY_CHECK(values[i] == 0);
+    }
+}
+
+// Only live slots match, whatever the dead ones around them hold
+template <typename Array>
+static void sparseMatches() {
+    Array array(300);
+    for (int i = 0; i < 300; ++i) array.insert(i % 3 == 0 ? 0 : 7);
+    for (int key = 0; key < 300; key += 2) array.remove(key);
+
+    size_t zeros = 0;
+    for (int key = 1; key < 300; key += 2) zeros += key % 3 == 0;
+    KEYARRAY_CHECK(array.count(0) == zeros);
+    KEYARRAY_CHECK(array.find(0) && *array.find(0) == 3);
+    KEYARRAY_CHECK(array.count(7) == 150 - zeros);
+    KEYARRAY_CHECK(!array.contains(1));
+
+    array.clear();
+    KEYARRAY_CHECK(array.count(0) == 0);
+    KEYARRAY_CHECK(!array.contains(0));
+}
+
+// Slots of a resize target that nothing reached yet scan as dead
+static void matchesDuringResize() {
+    KeyArray<int64_t> array(64);
+    array.enableDynamicResizing();
+    for (int i = 0; i < 64; ++i) array.insert(0);
+    array.insert(0);
+    KEYARRAY_CHECK(array.isResizeInProgress());
+    KEYARRAY_CHECK(array.count(0) == 65);
+    KEYARRAY_CHECK(!array.contains(1));
+}
+
+int main() {
+    freshRunsAreZero<SlotStorage<int>>();
+    freshRunsAreZero<SlotStorage<double>>();
+    freshRunsAreZero<PagedSlotStorage<int64_t>>();
+    sparseMatches<KeyArray<int>>();
+    sparseMatches<KeyArray<double>>();
+    sparseMatches<PagedKeyArray<int64_t>>();
+    matchesDuringResize();
+
+    // Near misses differ from the needle in one high or low bit; NaN never
+    // matches and -0.0 matches 0.0, as with operator==
+    kernelsMatchScalar<int>({ 0, 7, -1, (1 << 24) | 7, std::numeric_limits<int>::min() });
+    kernelsMatchScalar<uint32_t>({ 0u, 7u, 0x80000007u, ~0u });
+    kernelsMatchScalar<int64_t>({ 0, 7, (int64_t(1) << 32) | 7, -1, std::numeric_limits<int64_t>::min() });
+    kernelsMatchScalar<float>({ 0.0f, -0.0f, 1.5f, std::numeric_limits<float>::quiet_NaN(),
+                                std::numeric_limits<float>::infinity() });
+    kernelsMatchScalar<double>({ 0.0, -0.0, 1.5, std::numeric_limits<double>::quiet_NaN(),
+                                 std::numeric_limits<double>::infinity() });
+    arrayScansMatchScalar<int>({ 0, 7, (1 << 24) | 7 });
+    arrayScansMatchScalar<int64_t>({ 0, 7, (int64_t(1) << 32) | 7 });
+    arrayScansMatchScalar<float>({ 0.0f, -0.0f, 1.5f, std::numeric_limits<float>::quiet_NaN() });
+    arrayScansMatchScalar<double>({ 0.0, 1.5, std::numeric_limits<double>::quiet_NaN() });
+    return 0;
+}
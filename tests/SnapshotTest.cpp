@@ -0,0 +1,249 @@
+// KeyArray Snapshot Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Snapshot round trips, and rejection of corrupt headers
+// before anything is read past the end of the bytes.
+
+#include "KeyArray.hpp"
+#include "KeyArrayChangeLog.hpp"
+#include "KeyArraySnapshot.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+template <typename Array>
+static std::string snapshotOf(const Array& array) {
+    std::ostringstream os(std::ios::binary);
+    array.saveSnapshot(os);
+    return os.str();
+}
+
+// Loads a copy of `bytes` with one header field changed, then truncated to `size` bytes
+template <typename T>
+static void checkRejected(const std::string& bytes, const std::function<void(KeyArraySnapshotHeader&)>& corrupt,
+                          size_t size = std::string::npos) {
+    KeyArraySnapshotHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    corrupt(header);
+
+    std::string changed = bytes.substr(0, size);
+    std::memcpy(&changed[0], &header, sizeof(header));
+
+    KeyArray<T> target(4);
+    int key = target.insert(T());
+    KEYARRAY_CHECK_THROWS(target.loadSnapshot(changed.data(), changed.size()), std::runtime_error);
+    KEYARRAY_CHECK(target.size() == 1 && target.hasKey(key));
+}
+
+// Values, free-list order, offset, name and queue come back
+static void roundTrip() {
+    KeyArray<std::string> array(10, 20, "strings");
+    array.enableQueue();
+    for (int i = 0; i < 10; ++i) array.insert("v" + std::to_string(i));
+    array.insert("queued");
+    array.remove(13);
+    array.remove(17);
+
+    std::string bytes = snapshotOf(array);
+    KeyArray<std::string> loaded(1);
+    loaded.loadSnapshot(bytes.data(), bytes.size());
+    KEYARRAY_CHECK(loaded.getName() == "strings");
+    KEYARRAY_CHECK(loaded.getOffset() == 10);
+    KEYARRAY_CHECK(loaded.size() == 8 && loaded.getQueueSize() == 1);
+    KEYARRAY_CHECK(loaded.at(19) == "v9");
+    KEYARRAY_CHECK(loaded.insert("a") == 17);
+    KEYARRAY_CHECK(loaded.insert("b") == 13);
+}
+
+// Raw values, including an empty array and one saved mid-shrink
+static void rawRoundTrip() {
+    KeyArray<int> empty(0);
+    std::string bytes = snapshotOf(empty);
+    KeyArray<int> loaded(4);
+    loaded.loadSnapshot(bytes.data(), bytes.size());
+    KEYARRAY_CHECK(loaded.size() == 0 && loaded.getCapacity() == 0);
+
+    KeyArray<int> shrinking(16);
+    for (int i = 0; i < 16; ++i) shrinking.insert(i);
+    for (int i = 0; i < 12; ++i) shrinking.remove(i);
+    shrinking.startShrink(8);
+    KEYARRAY_CHECK(shrinking.isShrinkInProgress());
+    bytes = snapshotOf(shrinking);
+    loaded.loadSnapshot(bytes.data(), bytes.size());
+    KEYARRAY_CHECK(loaded.size() == 4 && loaded.at(15) == 15);
+    for (int i = 0; i < 12; ++i) loaded.insert(100 + i);
+    KEYARRAY_CHECK_THROWS(loaded.insert(0), std::runtime_error);
+
+    KeyArraySnapshotView<int> view(bytes.data(), bytes.size());
+    KEYARRAY_CHECK(view.size() == 4 && view.at(14) == 14 && !view.hasKey(3));
+}
+
+// Every size-bearing field is checked against the others
+static void corruptHeaders() {
+    KeyArray<int> ints(4);
+    for (int i = 0; i < 3; ++i) ints.insert(i);
+    ints.remove(1);
+    std::string raw = snapshotOf(ints);
+
+    // A raw value block shorter than one cell per slot, file cut to match
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.valueBytes = 0; }, raw.size() - 4 * sizeof(int));
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.valueBytes += 4; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.queueBytes = 4; });
+
+    // Pool ranges past the capacity, or live keys the pool would hand out again
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.poolMax = 100; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.poolMax = INT64_MAX; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.poolNext = 5; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.poolMin = -1; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.poolNext = 1; });
+
+    // Sizes whose sums overflow
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.nameLength = UINT64_MAX - 16; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.valueAlign = 1u << 31; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.freeCount = 4; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.elementCount = 4; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader& h) { h.version = 99; });
+    checkRejected<int>(raw, [](KeyArraySnapshotHeader&) {}, raw.size() - 1);
+
+    KeyArray<std::string> strings(4);
+    strings.insert("a");
+    std::string serialized = snapshotOf(strings);
+    checkRejected<std::string>(serialized, [](KeyArraySnapshotHeader& h) { h.valueBytes = 8; });
+    checkRejected<std::string>(serialized, [](KeyArraySnapshotHeader&) {}, serialized.size() - 1);
+}
+
+// Rewrites a current snapshot in version 3, whose free list held int32 entries
+static std::string asVersion3(const std::string& bytes) {
+    KeyArraySnapshotHeader header = readKeyArraySnapshotHeader(bytes.data(), bytes.size());
+    KeyArraySnapshotLayout layout = KeyArraySnapshotLayout::of(header);
+    header.version = 3;
+
+    std::string old(reinterpret_cast<const char*>(&header), sizeof(header));
+    old.append(bytes, layout.nameOffset, layout.freeListOffset - layout.nameOffset);
+    for (uint64_t i = 0; i < header.freeCount; ++i) {
+        int64_t key;
+        std::memcpy(&key, bytes.data() + layout.freeListOffset + i * sizeof(int64_t), sizeof(key));
+        int32_t narrow = static_cast<int32_t>(key);
+        old.append(reinterpret_cast<const char*>(&narrow), sizeof(narrow));
+    }
+    old.append(KeyArraySnapshotLayout::alignUp(old.size(), header.valueAlign) - old.size(), '\0');
+    old.append(bytes, layout.valueOffset, std::string::npos);
+    return old;
+}
+
+// Keys past the int range survive a snapshot: offset, free list and all
+template <typename Key>
+static void wideKeyRoundTrip(Key first) {
+    using Array = KeyArray<int, SlotStorage<int>, LifoKeyOrder, Key>;
+    Array array(first, static_cast<Key>(first + 16), "wide");
+    for (int i = 0; i < 16; ++i) array.insert(i);
+    array.remove(static_cast<Key>(first + 3));
+    array.remove(static_cast<Key>(first + 9));
+
+    std::string bytes = snapshotOf(array);
+    Array loaded(Key(1));
+    loaded.loadSnapshot(bytes.data(), bytes.size());
+    KEYARRAY_CHECK(loaded.getOffset() == first && loaded.size() == 14);
+    KEYARRAY_CHECK(loaded.at(static_cast<Key>(first + 15)) == 15);
+    KEYARRAY_CHECK(loaded.insert(20) == static_cast<Key>(first + 9));
+    KEYARRAY_CHECK(loaded.insert(21) == static_cast<Key>(first + 3));
+
+    // An int array cannot take keys from that range
+    KeyArray<int> narrow(4);
+    KEYARRAY_CHECK_THROWS(narrow.loadSnapshot(bytes.data(), bytes.size()), std::runtime_error);
+}
+
+// Version 3 snapshots, with their 32-bit free list, still load
+static void version3Loads() {
+    KeyArray<std::string> array(8);
+    for (int i = 0; i < 6; ++i) array.insert("v" + std::to_string(i));
+    array.remove(1);
+    array.remove(4);
+
+    std::string old = asVersion3(snapshotOf(array));
+    KeyArray<std::string> loaded(1);
+    loaded.loadSnapshot(old.data(), old.size());
+    KEYARRAY_CHECK(loaded.size() == 4 && loaded.at(5) == "v5");
+    KEYARRAY_CHECK(loaded.insert("a") == 4);
+    KEYARRAY_CHECK(loaded.insert("b") == 1);
+
+    KeyArray<int> ints(8);
+    for (int i = 0; i < 8; ++i) ints.insert(i);
+    ints.remove(2);
+    old = asVersion3(snapshotOf(ints));
+    KeyArraySnapshotView<int> view(old.data(), old.size());
+    KEYARRAY_CHECK(view.size() == 7 && view.at(7) == 7 && !view.hasKey(2));
+}
+
+// A change log of 64-bit keys replays onto its snapshot
+static void wideKeyChangeLog() {
+    using Array = KeyArray<int, SlotStorage<int>, LifoKeyOrder, uint64_t>;
+    const std::string snapshotFile = "SnapshotTest.wide.snap";
+    const std::string logFile = "SnapshotTest.wide.log";
+    uint64_t first = uint64_t(1) << 40;
+    {
+        Array array(first, first + 8);
+        array.insert(1);
+        array.enableChangeLog(snapshotFile, logFile);
+        uint64_t key = array.insert(2);
+        array.insert(3);
+        array.remove(key);
+        array.swap(first, first + 2);
+        array.disableChangeLog();
+    }
+
+    Array recovered(uint64_t(1));
+    KEYARRAY_CHECK(recovered.recover(snapshotFile, logFile) == 4);
+    KEYARRAY_CHECK(recovered.size() == 2 && !recovered.hasKey(first + 1));
+    KEYARRAY_CHECK(recovered.at(first) == 3 && recovered.at(first + 2) == 1);
+    std::remove(snapshotFile.c_str());
+    std::remove(logFile.c_str());
+}
+
+// Logs of the first format, with int32 keys, still replay
+static void version1ChangeLog() {
+    const std::string logFile = "SnapshotTest.v1.log";
+    uint64_t digest = 42;
+    std::string log(KeyArrayChangeLogBase<int>::MagicV1, sizeof(KeyArrayChangeLogBase<int>::MagicV1));
+    log.append(reinterpret_cast<const char*>(&digest), sizeof(digest));
+    auto record = [&](KeyArrayChangeLogBase<int>::Record type, int32_t key, const std::string& payload) {
+        uint32_t length = static_cast<uint32_t>(1 + sizeof(key) + payload.size());
+        uint8_t tag = static_cast<uint8_t>(type);
+        log.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        log.append(reinterpret_cast<const char*>(&tag), sizeof(tag));
+        log.append(reinterpret_cast<const char*>(&key), sizeof(key));
+        log += payload;
+    };
+    int32_t nine = 9;
+    int32_t other = 1;
+    record(KeyArrayChangeLogBase<int>::Record::Remove, 0, "");
+    record(KeyArrayChangeLogBase<int>::Record::Insert, 0, std::string(reinterpret_cast<const char*>(&nine), sizeof(nine)));
+    record(KeyArrayChangeLogBase<int>::Record::Swap, 0, std::string(reinterpret_cast<const char*>(&other), sizeof(other)));
+    std::ofstream(logFile, std::ios::binary) << log;
+
+    KeyArray<int> array(4);
+    array.insert(1);
+    array.insert(2);
+    KEYARRAY_CHECK(KeyArrayChangeLog<int>::replay(logFile, digest, array) == 3);
+    KEYARRAY_CHECK(array.at(0) == 2 && array.at(1) == 9);
+    std::remove(logFile.c_str());
+}
+
+int main() {
+    roundTrip();
+    rawRoundTrip();
+    corruptHeaders();
+    wideKeyRoundTrip<uint32_t>(3000000000u);
+    wideKeyRoundTrip<uint64_t>(uint64_t(1) << 40);
+    wideKeyRoundTrip<int64_t>(-(int64_t(1) << 40));
+    version3Loads();
+    wideKeyChangeLog();
+    version1ChangeLog();
+    return 0;
+}
@@ -0,0 +1,84 @@
+// KeyArraySoA Tests
+// Author: Eli (Eliyahu) Shif
+// Description: Column layout (one array per listed member, indexed by key) and
+// per-field access through get<>, the row proxy and column scans.
+
+#include "KeyArraySoA.hpp"
+#include "KeyArrayTest.hpp"
+#include <string>
+#include <vector>
+
+struct Order {
+    double px;
+    int qty;
+    std::string note;
+};
+
+// note is not listed, so it is not stored
+using Orders = KeyArraySoA<Order, &Order::px, &Order::qty>;
+
+// Each listed member has its own column over every slot, indexed by key - offset;
+// a removed key's fields are reset to their default
+static void columnLayout() {
+    Orders orders(10, 14);
+    int first = orders.insert(Order{ 1.5, 10, "dropped" });
+    int second = orders.insert(Order{ 2.5, 20, "dropped" });
+
+    KeyArraySpan<double> px = orders.column<&Order::px>();
+    KeyArraySpan<int> qty = orders.column<&Order::qty>();
+    KEYARRAY_CHECK(px.size() == 4 && qty.size() == 4);
+    KEYARRAY_CHECK(static_cast<const void*>(px.data()) != static_cast<const void*>(qty.data()));
+    KEYARRAY_CHECK(px[first - 10] == 1.5 && qty[first - 10] == 10);
+    KEYARRAY_CHECK(px[second - 10] == 2.5 && qty[second - 10] == 20);
+    KEYARRAY_CHECK(orders.occupancy().test(first - 10) && orders.occupancy().test(second - 10));
+
+    orders.remove(first);
+    KEYARRAY_CHECK(!orders.occupancy().test(first - 10));
+    KEYARRAY_CHECK(px[first - 10] == 0.0 && qty[first - 10] == 0);
+    KEYARRAY_CHECK(orders.at(second).load().note.empty());
+}
+
+// Fields are read and written one at a time, through get<> or the row proxy,
+// without touching the other columns
+static void fieldAccess() {
+    Orders orders(8);
+    int key = orders.insert(Order{ 9.0, 1, "" });
+
+    orders.get<&Order::qty>(key) += 4;
+    orders.at(key).get<&Order::px>() = 9.5;
+    KEYARRAY_CHECK(orders.get<&Order::qty>(key) == 5);
+    KEYARRAY_CHECK(orders.column<&Order::px>()[key] == 9.5);
+
+    Order copy = orders.at(key);
+    KEYARRAY_CHECK(copy.px == 9.5 && copy.qty == 5);
+    orders.at(key) = Order{ 3.0, 7, "" };
+    KEYARRAY_CHECK(orders.get<&Order::px>(key) == 3.0 && orders.get<&Order::qty>(key) == 7);
+    KEYARRAY_CHECK(orders.at(key).key() == key);
+}
+
+// Column scans see live keys only, and growth keeps each key's fields in place
+static void columnScans() {
+    Orders orders(0);
+    orders.enableDynamicResizing();
+    for (int i = 0; i < 100; ++i) orders.insert(Order{ 1.0 * (i % 4), i, "" });
+    for (int i = 0; i < 100; i += 2) orders.remove(i);
+
+    KEYARRAY_CHECK(orders.size() == 50 && orders.capacity() >= 100);
+    KEYARRAY_CHECK(orders.count<&Order::px>(1.0) == 25);
+    KEYARRAY_CHECK(orders.count<&Order::px>(2.0) == 0);
+    KEYARRAY_CHECK(orders.count<&Order::qty>(0) == 0);
+
+    std::vector<int> keys;
+    orders.forEachLive<&Order::qty>([&](int key, int qty) {
+        KEYARRAY_CHECK(qty == key);
+        keys.push_back(key);
+    });
+    KEYARRAY_CHECK(keys.size() == 50 && keys.front() == 1 && keys.back() == 99);
+}
+
+int main() {
+    columnLayout();
+    fieldAccess();
+    columnScans();
+    return 0;
+}
@@ -0,0 +1,119 @@
+// StaticKeyArray Tests
+// Author: Eli (Eliyahu) Shif
+// Description: The fixed-capacity table: use in constant expressions, the
+// full table, newest-first recycling and live iteration across words.
+
+#include "StaticKeyArray.hpp"
+#include "KeyArrayTest.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Built, changed and queried entirely at compile time
+constexpr auto table = [] {
+    StaticKeyArray<int, 8> array;
+    array.insert(10);
+    array.insert(11);
+    array.insert(12);
+    array.remove(1);
+    array.insert(21);
+    array.swap(0, 2);
+    return array;
+}();
+
+static_assert(table.size() == 3 && table.at(0) == 12 && table.at(1) == 21 && table.at(2) == 10);
+static_assert(table.hasKey(2) && !table.hasKey(3) && !table.hasKey(-1) && !table.hasKey(8));
+static_assert(table.try_get(3) == nullptr && table.contains(21) && !table.contains(11));
+static_assert(table.word(0) == 0b111 && StaticKeyArray<int, 8>::capacity() == 8);
+
+// Links are the smallest type that names every slot plus the end marker
+static_assert(std::is_same_v<StaticKeyArray<int, 254>::Link, uint8_t>);
+static_assert(std::is_same_v<StaticKeyArray<int, 255>::Link, uint16_t>);
+static_assert(std::is_same_v<StaticKeyArray<int, 70000>::Link, uint32_t>);
+
+// The sum of a table's live values, folded at compile time
+constexpr int liveSum() {
+    StaticKeyArray<int, 100> array;
+    for (int i = 0; i < 100; ++i) array.insert(i);
+    for (int key = 0; key < 100; key += 2) array.remove(key);
+    int sum = 0;
+    array.forEachLive([&](int, int value) { sum += value; });
+    return sum;
+}
+
+static_assert(liveSum() == 2500);
+
+// A full table throws on insert and stays unchanged; dead and out-of-range
+// keys throw from at() and remove()
+static void fullTable() {
+    StaticKeyArray<std::string, 3> array;
+    KEYARRAY_CHECK(array.empty() && !array.full());
+    for (int i = 0; i < 3; ++i) KEYARRAY_CHECK(array.emplace(3, 'a' + i) == i);
+    KEYARRAY_CHECK(array.full() && array.size() == 3);
+    KEYARRAY_CHECK_THROWS(array.insert("d"), std::runtime_error);
+    KEYARRAY_CHECK(array.size() == 3 && array.at(2) == "ccc");
+
+    array.remove(1);
+    KEYARRAY_CHECK(!array.full() && array.try_get(1) == nullptr);
+    KEYARRAY_CHECK_THROWS(array.at(1), std::out_of_range);
+    KEYARRAY_CHECK_THROWS(array.remove(1), std::out_of_range);
+    KEYARRAY_CHECK_THROWS(array.at(3), std::out_of_range);
+    KEYARRAY_CHECK_THROWS(array.at(-1), std::out_of_range);
+    KEYARRAY_CHECK(array.insert("d") == 1 && array.full());
+}
+
+// Freed keys come back newest first, before fresh keys; clear starts over
+// at key 0 and leaves no value behind
+static void recycling() {
+    StaticKeyArray<std::string, 200> array;
+    for (int i = 0; i < 150; ++i) array.insert(std::to_string(i));
+    array.remove(3);
+    array.remove(130);
+    array.remove(64);
+    KEYARRAY_CHECK(array.insert("x") == 64 && array.insert("y") == 130 && array.insert("z") == 3);
+    KEYARRAY_CHECK(array.insert("fresh") == 150);
+
+    array.clear();
+    KEYARRAY_CHECK(array.empty() && !array.hasKey(0) && array.begin() == array.end());
+    KEYARRAY_CHECK(array.insert("again") == 0 && array.insert("more") == 1);
+    KEYARRAY_CHECK(!array.contains("fresh") && !array.contains("149"));
+}
+
+// Iteration visits live keys in ascending order across occupancy words
+static void liveIteration() {
+    StaticKeyArray<int, 130> array;
+    for (int i = 0; i < 130; ++i) array.insert(i * 10);
+    std::vector<int> expected;
+    for (int key = 0; key < 130; ++key) {
+        if (key == 0 || key == 63 || key == 64 || key == 129) {
+            expected.push_back(key);
+        } else {
+            array.remove(key);
+        }
+    }
+
+    std::vector<int> keys;
+    for (auto [key, value] : array) {
+        KEYARRAY_CHECK(value == key * 10);
+        keys.push_back(key);
+    }
+    KEYARRAY_CHECK(keys == expected);
+
+    for (auto [key, value] : array) value = -key;
+    const StaticKeyArray<int, 130>& view = array;
+    keys.clear();
+    view.forEachLive([&](int key, const int& value) {
+        KEYARRAY_CHECK(value == -key);
+        keys.push_back(key);
+    });
+    KEYARRAY_CHECK(keys == expected && view.word(1) == 1 && view.word(2) == 2);
+}
+
+int main() {
+    fullTable();
+    recycling();
+    liveIteration();
+    return 0;
+}